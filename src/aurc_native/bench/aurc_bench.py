@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+"""Benchmark harness for aurc-native (`make bench` / `cmake --build . --target bench`).
+
+Runs a fixed corpus, plus modules and a manifest of growing size made by
+aurc-gen (tools/aurc_gen.c), through the compiler, the assembler and the VM:
+- compile latency per program, taken from `--stats-json` (the compiler's own
+  phase clock) next to the wall time of the whole process;
+- assembler throughput in MB/s on the large manifests;
+- run time of the produced images under `aurc-native run`, with each
+  program's output or exit status checked first.
+
+Every measurement gets warmup runs, then repetitions whose median is kept.
+Results go to a JSON file together with the regression threshold of every
+benchmark; given `--baseline` (an earlier results file), a median slower than
+the baseline's by more than its threshold fails the run.
+
+Usage:
+    python aurc_bench.py --compiler ./aurc-native --generator ./aurc-gen [--output results.json]
+                         [--baseline old.json] [--repetitions 5] [--warmup 1]
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import platform
+import statistics
+import subprocess
+import sys
+import time
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Callable, Dict, List
+
+ROOT = Path(__file__).resolve().parents[3]
+RESULTS_VERSION = 1
+
+# Allowed slowdown of a median against the baseline, per kind of benchmark.
+# Differences under NOISE_FLOOR_MS are never reported: the small programs
+# are dominated by process start-up.
+THRESHOLDS = {"compile": 0.15, "assemble": 0.15, "run": 0.10}
+NOISE_FLOOR_MS = 0.5
+
+# ---------------------------------------------------------------------------
+# Corpus
+# ---------------------------------------------------------------------------
+
+@dataclass
+class Program:
+    name: str
+    source: Path
+    stdin: str = ""
+    exit_status: int = 0
+    stdout: str = ""               # what the output must start with
+
+
+# Generated inputs: (name, aurc-gen arguments, exit status). The modules
+# grow tenfold and fivefold so the compile times chart the toolchain's
+# scaling; `deep` nests 200 blocks per function and the manifest feeds the
+# assembler ~10 MB. aurc-gen output depends only on its options, so each
+# module's exit status is fixed.
+GENERATED_MODULES = [
+    ("gen_100", ["--functions", "100"], 85),
+    ("gen_1000", ["--functions", "1000"], 103),
+    ("gen_5000", ["--functions", "5000"], 39),
+    ("gen_deep", ["--functions", "20", "--depth", "200"], 100),
+]
+GENERATED_MANIFESTS = [
+    ("gen_manifest_10mb", ["--words", "200000", "--labels", "20000", "--strings", "2000", "--shared", "64"]),
+]
+
+
+def generate(generator: str, kind: str, arguments: List[str], path: Path) -> None:
+    done = run([generator, kind, "-o", str(path)] + arguments)
+    if done.returncode != 0:
+        raise RuntimeError(f"aurc-gen {kind} {' '.join(arguments)} failed\n{done.stderr}")
+
+
+def corpus(work: Path, generator: str) -> List[Program]:
+    examples = ROOT / "examples"
+    pipeline = ROOT / "pipeline" / "examples"
+    programs = [
+        Program("hello_world", examples / "hello_world.aur", stdout="Hello World"),
+        Program("loop_sum", examples / "loop_sum.aur", exit_status=10),
+        Program("pi_calc", examples / "pi_calc.aur", exit_status=3141 & 255),
+        Program("shared_counter", pipeline / "shared_counter_test.aur", exit_status=20),
+        Program("thread_multi", pipeline / "thread_multi_test.aur", exit_status=30),
+        Program("pi_chudnovsky_20k", examples / "pi_chudnovsky.aur", stdin="20000\n", stdout="31415926535897932384"),
+    ]
+    for name, arguments, exit_status in GENERATED_MODULES:
+        path = work / f"{name}.aur"
+        generate(generator, "module", arguments, path)
+        programs.append(Program(name, path, exit_status=exit_status, stdout="line 0 of the synthetic module"))
+    return programs
+
+
+def bench_manifests(compiler: str, generator: str, work: Path, warmup: int, repetitions: int,
+                    results: Dict[str, Dict[str, object]]) -> None:
+    for name, arguments in GENERATED_MANIFESTS:
+        manifest = work / f"{name}.aurs"
+        generate(generator, "manifest", arguments, manifest)
+        assemble_benchmark(compiler, name, manifest, work, warmup, repetitions, results)
+
+# ---------------------------------------------------------------------------
+# Measurement
+# ---------------------------------------------------------------------------
+
+def run(command: List[str], stdin: str = "") -> subprocess.CompletedProcess:
+    return subprocess.run(command, input=stdin, capture_output=True, text=True)
+
+
+def sample(action: Callable[[], float], warmup: int, repetitions: int) -> List[float]:
+    for _ in range(warmup):
+        action()
+    return [action() for _ in range(repetitions)]
+
+
+def wall_ms(command: List[str], stdin: str = "") -> float:
+    start = time.perf_counter()
+    run(command, stdin)
+    return (time.perf_counter() - start) * 1e3
+
+
+def summary(kind: str, samples: List[float], **extra: object) -> Dict[str, object]:
+    result: Dict[str, object] = {
+        "kind": kind,
+        "median_ms": statistics.median(samples),
+        "min_ms": min(samples),
+        "max_ms": max(samples),
+        "samples_ms": samples,
+        "threshold": THRESHOLDS[kind],
+    }
+    result.update(extra)
+    return result
+
+
+def assemble_benchmark(compiler: str, name: str, manifest: Path, work: Path, warmup: int, repetitions: int,
+                       results: Dict[str, Dict[str, object]]) -> None:
+    manifest_bytes = manifest.stat().st_size
+    assemble = sample(lambda: wall_ms([compiler, "assemble", str(manifest), "-o", str(work / "assembled.bin")]),
+                      warmup, repetitions)
+    median = statistics.median(assemble)
+    results[f"assemble/{name}"] = summary(
+        "assemble", assemble, manifest_bytes=manifest_bytes, mb_per_s=manifest_bytes / 1e6 / (median / 1e3))
+
+
+def bench_program(compiler: str, program: Program, work: Path, warmup: int, repetitions: int,
+                  results: Dict[str, Dict[str, object]]) -> None:
+    image = work / f"{program.name}.bin"
+    manifest = work / f"{program.name}.aurs"
+    stats_path = work / f"{program.name}.stats.json"
+    compile_cmd = [compiler, "compile", str(program.source), "--emit-bin", str(image), "--stats-json", str(stats_path)]
+
+    done = run(compile_cmd + ["-o", str(manifest)])
+    if done.returncode != 0:
+        raise RuntimeError(f"{program.name}: compile failed\n{done.stdout}{done.stderr}")
+    done = run([compiler, "run", str(image)], program.stdin)
+    if (done.returncode != program.exit_status or not done.stdout.startswith(program.stdout)):
+        raise RuntimeError(f"{program.name}: exit status {done.returncode}, expected {program.exit_status}\n"
+                           f"{done.stdout[:400]}{done.stderr}")
+
+    in_process: List[float] = []
+
+    def compile_once() -> float:
+        elapsed = wall_ms(compile_cmd)
+        stats = json.loads(stats_path.read_text(encoding="utf-8"))
+        in_process.append(sum(phase["wall_ns"] for phase in stats["phases"].values()) / 1e6)
+        return elapsed
+
+    process = sample(compile_once, warmup, repetitions)
+    compile_ms = in_process[warmup:]
+    stats = json.loads(stats_path.read_text(encoding="utf-8"))
+    results[f"compile/{program.name}"] = summary(
+        "compile", compile_ms, process_median_ms=statistics.median(process), counters=stats["counters"])
+
+    assemble_benchmark(compiler, program.name, manifest, work, warmup, repetitions, results)
+
+    runs = sample(lambda: wall_ms([compiler, "run", str(image)], program.stdin), warmup, repetitions)
+    results[f"run/{program.name}"] = summary("run", runs)
+
+# ---------------------------------------------------------------------------
+# Baseline comparison
+# ---------------------------------------------------------------------------
+
+def regressions(results: Dict[str, Dict[str, object]], baseline_path: Path) -> List[str]:
+    baseline = json.loads(baseline_path.read_text(encoding="utf-8"))["benchmarks"]
+    found = []
+    for name, result in results.items():
+        old = baseline.get(name)
+        if old is None:
+            continue
+        new_ms = float(result["median_ms"])
+        old_ms = float(old["median_ms"])
+        limit = old_ms * (1.0 + float(result["threshold"]))
+        result["baseline_median_ms"] = old_ms
+        if new_ms > limit and new_ms - old_ms > NOISE_FLOOR_MS:
+            found.append(f"{name}: {new_ms:.3f} ms vs {old_ms:.3f} ms baseline (+{(new_ms / old_ms - 1) * 100:.1f}%, "
+                         f"threshold {float(result['threshold']) * 100:.0f}%)")
+    return found
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Benchmark aurc-native compile, assemble and run times")
+    parser.add_argument("--compiler", required=True, help="path to the aurc-native executable")
+    parser.add_argument("--generator", required=True, help="path to the aurc-gen executable")
+    parser.add_argument("--work-dir", type=Path, default=Path("bench-work"), help="scratch directory for outputs")
+    parser.add_argument("--output", type=Path, default=Path("bench-results.json"), help="results file to write")
+    parser.add_argument("--baseline", type=Path, help="earlier results file to check for regressions")
+    parser.add_argument("--repetitions", type=int, default=5)
+    parser.add_argument("--warmup", type=int, default=1)
+    args = parser.parse_args()
+
+    args.work_dir.mkdir(parents=True, exist_ok=True)
+    compiler = str(Path(args.compiler).resolve())
+    generator = str(Path(args.generator).resolve())
+    results: Dict[str, Dict[str, object]] = {}
+    for program in corpus(args.work_dir, generator):
+        bench_program(compiler, program, args.work_dir, args.warmup, args.repetitions, results)
+    bench_manifests(compiler, generator, args.work_dir, args.warmup, args.repetitions, results)
+
+    print(f"{'benchmark':32s} {'median ms':>11s} {'min ms':>9s}  notes")
+    for name, result in results.items():
+        notes = ""
+        if result["kind"] == "compile":
+            lines = result["counters"]["lines"]
+            notes = (f"process {result['process_median_ms']:.2f} ms, {lines} lines, "
+                     f"{result['median_ms'] / max(lines, 1) * 1e3:.2f} ms per 1k lines")
+        elif result["kind"] == "assemble":
+            notes = f"{result['mb_per_s']:.1f} MB/s over {result['manifest_bytes']} bytes"
+        print(f"{name:32s} {result['median_ms']:11.3f} {result['min_ms']:9.3f}  {notes}")
+
+    failures = regressions(results, args.baseline) if args.baseline else []
+    report = {
+        "version": RESULTS_VERSION,
+        "host": {"system": platform.system(), "machine": platform.machine()},
+        "warmup": args.warmup,
+        "repetitions": args.repetitions,
+        "noise_floor_ms": NOISE_FLOOR_MS,
+        "benchmarks": results,
+        "regressions": failures,
+    }
+    args.output.write_text(json.dumps(report, indent=2) + "\n", encoding="utf-8")
+    print(f"\nWrote results to {args.output}")
+    if failures:
+        print("\nRegressions:", *failures, sep="\n  ")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,35 @@
+#ifndef AURC_ARENA_H
+#define AURC_ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Bump allocator for data that lives as long as one compilation (tokens'
+ * decoded strings, AST nodes). Allocations are never freed individually;
+ * aurc_arena_free releases every chunk in one go, and aurc_arena_reset
+ * rewinds the arena so the next compilation reuses its chunks.
+ */
+
+typedef struct aurc_arena_chunk aurc_arena_chunk;
+
+typedef struct aurc_arena {
+    aurc_arena_chunk *head;
+    aurc_arena_chunk *spare;  /* emptied regular chunks waiting for reuse */
+    size_t chunk_size;       /* payload size of regular chunks */
+    size_t allocated;        /* bytes handed out, for diagnostics */
+} aurc_arena;
+
+void aurc_arena_init(aurc_arena *arena);
+void aurc_arena_free(aurc_arena *arena);
+/* Invalidates every allocation but keeps regular-sized chunks for the next round. */
+void aurc_arena_reset(aurc_arena *arena);
+
+/* Returns size bytes aligned for any object type, or NULL (after reporting) when out of memory. */
+void *aurc_arena_alloc(aurc_arena *arena, size_t size);
+void *aurc_arena_zalloc(aurc_arena *arena, size_t size);
+char *aurc_arena_strndup(aurc_arena *arena, const char *data, size_t len);
+
+#define AURC_ARENA_NEW(arena, type) ((type *)aurc_arena_zalloc((arena), sizeof(type)))
+#define AURC_ARENA_ARRAY(arena, type, count) ((type *)aurc_arena_zalloc((arena), sizeof(type) * (count)))
+
+#endif /* AURC_ARENA_H */
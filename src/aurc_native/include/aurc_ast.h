@@ -0,0 +1,258 @@
+#ifndef AURC_AST_H
+#define AURC_AST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aurc_arena.h"
+#include "aurc_source.h"
+
+/*
+ * Syntax tree produced by src/parser.c, mirroring the grammar accepted by
+ * pipeline/src/parser_v2.js. Every node lives in the arena passed to
+ * aurc_parse; names and string literals are views into the source text (or
+ * into the arena when escapes had to be decoded), so the source must stay
+ * open for as long as the tree is used. Sibling nodes (statements of a
+ * block, call arguments, parameters, ...) are chained through `next`.
+ */
+
+typedef enum aurc_type_kind {
+    AURC_TYPE_VOID = 0,
+    AURC_TYPE_INT,
+    AURC_TYPE_FLOAT,
+    AURC_TYPE_STRING,
+    AURC_TYPE_BOOL,
+    AURC_TYPE_THREAD,
+    AURC_TYPE_ARRAY
+} aurc_type_kind;
+
+typedef struct aurc_type {
+    aurc_type_kind kind;
+    aurc_type_kind elem;          /* element type when kind == AURC_TYPE_ARRAY */
+} aurc_type;
+
+typedef enum aurc_expr_kind {
+    AURC_EXPR_INT = 0,
+    AURC_EXPR_FLOAT,
+    AURC_EXPR_BOOL,
+    AURC_EXPR_STRING,
+    AURC_EXPR_VAR,
+    AURC_EXPR_UNARY,
+    AURC_EXPR_BINARY,
+    AURC_EXPR_CALL,               /* user functions and math builtins (sqrt, pow, ...) alike */
+    AURC_EXPR_CAST,
+    AURC_EXPR_INPUT,
+    AURC_EXPR_SPAWN,
+    AURC_EXPR_JOIN,               /* `join h`: the spawned function's return value */
+    AURC_EXPR_ATOMIC_LOAD,
+    AURC_EXPR_ARRAY,
+    AURC_EXPR_INDEX
+} aurc_expr_kind;
+
+typedef enum aurc_unary_op {
+    AURC_UN_NEG = 0,
+    AURC_UN_NOT,
+    AURC_UN_BITNOT
+} aurc_unary_op;
+
+typedef enum aurc_binary_op {
+    AURC_BIN_ADD = 0,
+    AURC_BIN_SUB,
+    AURC_BIN_MUL,
+    AURC_BIN_DIV,
+    AURC_BIN_MOD,
+    AURC_BIN_AND,
+    AURC_BIN_OR,
+    AURC_BIN_XOR,
+    AURC_BIN_SHL,
+    AURC_BIN_SHR,
+    AURC_BIN_EQ,
+    AURC_BIN_NE,
+    AURC_BIN_LT,
+    AURC_BIN_LE,
+    AURC_BIN_GT,
+    AURC_BIN_GE,
+    AURC_BIN_LOGICAL_AND,
+    AURC_BIN_LOGICAL_OR
+} aurc_binary_op;
+
+typedef struct aurc_expr aurc_expr;
+
+struct aurc_expr {
+    aurc_expr_kind kind;
+    uint32_t line;
+    uint32_t column;
+    aurc_expr *next;              /* next argument / array element */
+    union {
+        int64_t int_value;
+        double float_value;
+        int bool_value;
+        aurc_view string_value;
+        aurc_view name;           /* AURC_EXPR_VAR, AURC_EXPR_ATOMIC_LOAD, AURC_EXPR_JOIN */
+        struct {
+            aurc_unary_op op;
+            aurc_expr *operand;
+        } unary;
+        struct {
+            aurc_binary_op op;
+            aurc_expr *lhs;
+            aurc_expr *rhs;
+        } binary;
+        struct {
+            aurc_view callee;
+            aurc_expr *args;
+            size_t arg_count;
+        } call;                   /* AURC_EXPR_CALL, AURC_EXPR_SPAWN */
+        struct {
+            aurc_type target;
+            aurc_expr *operand;
+        } cast;
+        struct {
+            aurc_expr *items;
+            size_t count;
+        } array;
+        struct {
+            aurc_view array;
+            aurc_expr *index;
+        } index;
+    } as;
+};
+
+typedef struct aurc_stmt aurc_stmt;
+
+typedef struct aurc_block {
+    aurc_stmt *first;
+    size_t count;
+} aurc_block;
+
+typedef enum aurc_stmt_kind {
+    AURC_STMT_LET = 0,
+    AURC_STMT_ASSIGN,             /* `x = v;` or, with an index, `x[i] = v;` */
+    AURC_STMT_IF,
+    AURC_STMT_WHILE,
+    AURC_STMT_FOR,
+    AURC_STMT_BREAK,
+    AURC_STMT_CONTINUE,
+    AURC_STMT_REQUEST,            /* `request service name(...)`; `print(...)` is service "print" */
+    AURC_STMT_RETURN,
+    AURC_STMT_CALL,
+    AURC_STMT_JOIN,
+    AURC_STMT_ATOMIC
+} aurc_stmt_kind;
+
+typedef enum aurc_atomic_op {
+    AURC_ATOMIC_ADD = 0,
+    AURC_ATOMIC_SUB,
+    AURC_ATOMIC_FADD,
+    AURC_ATOMIC_STORE,
+    AURC_ATOMIC_LOAD,
+    AURC_ATOMIC_CAS
+} aurc_atomic_op;
+
+struct aurc_stmt {
+    aurc_stmt_kind kind;
+    uint32_t line;
+    uint32_t column;
+    aurc_stmt *next;
+    union {
+        struct {
+            aurc_view name;
+            aurc_type type;
+            aurc_expr *value;
+        } let;
+        struct {
+            aurc_view name;
+            aurc_expr *index;     /* NULL for plain assignment */
+            aurc_expr *value;
+        } assign;
+        struct {
+            aurc_expr *cond;
+            aurc_block then_block;
+            aurc_block else_block;
+            int has_else;
+        } if_stmt;
+        struct {
+            aurc_expr *cond;
+            aurc_block body;
+        } while_stmt;
+        struct {
+            aurc_view var;
+            aurc_expr *start;
+            aurc_expr *end;       /* exclusive */
+            aurc_expr *step;      /* NULL means 1 */
+            aurc_block body;
+        } for_stmt;
+        struct {
+            aurc_view service;
+            aurc_expr *args;
+            size_t arg_count;
+        } request;
+        aurc_expr *ret_value;     /* NULL for a bare `return;` */
+        aurc_expr *call;          /* AURC_EXPR_CALL node */
+        aurc_view join_handle;
+        struct {
+            aurc_atomic_op op;
+            aurc_view target;
+            aurc_expr *value;     /* add/sub/fadd/store operand, cas new value */
+            aurc_expr *expected;  /* cas only */
+        } atomic;
+    } as;
+};
+
+typedef struct aurc_param aurc_param;
+
+struct aurc_param {
+    aurc_view name;
+    aurc_type type;
+    aurc_param *next;
+};
+
+typedef struct aurc_function aurc_function;
+
+struct aurc_function {
+    aurc_view name;
+    uint32_t line;
+    uint32_t column;
+    aurc_param *params;
+    size_t param_count;
+    aurc_type return_type;        /* AURC_TYPE_VOID when `->` is omitted */
+    aurc_block body;
+    aurc_function *next;
+};
+
+typedef struct aurc_shared_decl aurc_shared_decl;
+
+struct aurc_shared_decl {
+    aurc_view name;
+    uint32_t line;
+    uint32_t column;
+    aurc_type type;
+    aurc_expr *init;
+    aurc_shared_decl *next;
+};
+
+typedef enum aurc_program_form {
+    AURC_PROGRAM_MODULE = 0,      /* module name { fn ... shared ... } */
+    AURC_PROGRAM_IMPLICIT,        /* top-level fn/shared without a module wrapper */
+    AURC_PROGRAM_FLAT             /* bare statement list */
+} aurc_program_form;
+
+typedef struct aurc_program {
+    aurc_program_form form;
+    aurc_view module_name;        /* "main" for implicit modules, empty for flat programs */
+    aurc_function *functions;
+    size_t function_count;
+    aurc_shared_decl *shared;
+    size_t shared_count;
+    aurc_block body;              /* flat programs only */
+} aurc_program;
+
+/* Lexes and parses source into out; all nodes come from arena. Reports "path:line:col" errors. */
+int aurc_parse(const char *path, aurc_view source, aurc_arena *arena, aurc_program *out);
+/* The parsing half of aurc_parse, over tokens from aurc_lex; the tree refers into them only through the source. */
+struct aurc_token_list;
+int aurc_parse_tokens(const char *path, const struct aurc_token_list *tokens, aurc_arena *arena, aurc_program *out);
+
+const aurc_function *aurc_program_find_function(const aurc_program *program, const char *name);
+
+#endif /* AURC_AST_H */
@@ -0,0 +1,43 @@
+#ifndef AURC_BATCH_H
+#define AURC_BATCH_H
+
+#include <stdio.h>
+
+#include "aurc_native.h"
+
+/*
+ * Multi-input front ends built on aurc_session.
+ *
+ * `compile-many <dir|list>` compiles every `*.aur` in a directory (sorted by
+ * name) or every path listed in a text file (one per line, `#` comments),
+ * naming outputs after each input's stem. Inputs are spread over a pool of
+ * worker threads (`-j N`, one per processor by default); diagnostics are
+ * still reported in input order.
+ *
+ * `--serve` reads one job per line (`<input.aur> [-o x.aurs] [--emit-bin
+ * x.bin] [--emit-exe x.exe] [-O0|-O1|-O2] [--target-cpu cpu] [--target-os os]
+ * [--shard-counters] [--time-report] [--stats-json x.json] [--cache-dir dir]`, the same options
+ * as `compile`) and answers each with
+ * `ok <input>` or `error <input>` on its own flushed line; diagnostics go to
+ * stderr. An empty line is ignored and `quit` or end of input stops the
+ * server.
+ */
+
+/*
+ * Parses `compile` options from argv[0..argc). Returns 0 on success; on error
+ * prints a message to stderr and returns 1.
+ */
+int aurc_parse_compile_options(int argc, char **argv, aurc_compile_options *options);
+
+/*
+ * argv holds the options after the list/dir operand: --out-dir <dir>, -j <n>,
+ * --aurs, --bin, --exe (named <stem>.exe for Windows, <stem> for Linux),
+ * -O0/-O1/-O2, --target-cpu <cpu>, --target-os <os>, --shard-counters,
+ * --time-report (one report per input, printed with its diagnostics),
+ * --cache-dir <dir> (one cache for all workers).
+ */
+int aurc_compile_many(const char *list_or_dir, int argc, char **argv);
+
+int aurc_serve(FILE *in, FILE *out);
+
+#endif /* AURC_BATCH_H */
@@ -0,0 +1,90 @@
+#ifndef AURC_BIGNUM_H
+#define AURC_BIGNUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aurc_pool.h"
+
+/*
+ * Arbitrary-precision integers behind the VM's bignum service
+ * (specs/pi_precision_roadmap.md levels 2-4). A number is a sign and a
+ * magnitude of 32-bit limbs, least significant first, with no leading zero
+ * limbs (zero has len 0 and is never negative). Limb arrays come from an
+ * aurc_bn_pool, the calling thread's cache in front of a shared aurc_pool
+ * (aurc_pool.h), so freed arrays wait in power-of-two size classes for the
+ * next number of that size; each thread passes its own.
+ *
+ * Multiplication picks schoolbook, Karatsuba, Toom-3 or a three-prime
+ * number-theoretic transform by operand size (thresholds in bignum.c).
+ * Division is Knuth's algorithm D, or a Newton reciprocal for large operands,
+ * and rounds toward zero like the ISA's `div` / `rem`; square roots and
+ * decimal output are divide-and-conquer on top of them. Results may alias
+ * operands. Functions returning int return 0, or 1 when out of memory
+ * (leaving the result unchanged).
+ */
+
+typedef aurc_pool_cache aurc_bn_pool;
+
+typedef struct aurc_bn {
+    uint32_t *limb;
+    size_t len;
+    size_t cap;             /* limbs in the pool array, 0 when limb is NULL */
+    int neg;
+} aurc_bn;
+
+/*
+ * Operations of the bignum service (svc 0x10 with the operation in operand
+ * 1), which takes handles or ints in r0 and r1 and answers in r0. The
+ * language reaches them as the builtins named by aurc_bn_op_name.
+ */
+typedef enum aurc_bn_op {
+    AURC_BN_FROM_INT = 0,   /* handle of int r0 */
+    AURC_BN_ADD,            /* handle of r0 op r1 */
+    AURC_BN_SUB,
+    AURC_BN_MUL,
+    AURC_BN_DIV,
+    AURC_BN_MOD,
+    AURC_BN_POW,            /* handle of r0 ** int r1 */
+    AURC_BN_SHL,            /* handle of r0 shifted by int r1 bits (floor for shr) */
+    AURC_BN_SHR,
+    AURC_BN_SQRT,           /* handle of floor(sqrt(r0)) */
+    AURC_BN_CMP,            /* -1, 0 or 1 */
+    AURC_BN_TO_INT,         /* low 64 bits of r0, two's complement */
+    AURC_BN_PRINT,          /* write r0 in decimal plus newline */
+    AURC_BN_FREE,           /* release handle r0 */
+    AURC_BN_OP_COUNT
+} aurc_bn_op;
+
+/* Builtin name of op ("bignum_mul"; "bignum" for AURC_BN_FROM_INT) and its operand count. */
+const char *aurc_bn_op_name(aurc_bn_op op);
+unsigned aurc_bn_op_arity(aurc_bn_op op);
+
+void aurc_bn_init(aurc_bn *x);
+/* Hands x's limbs back to the pool and leaves x zero. */
+void aurc_bn_clear(aurc_bn_pool *pool, aurc_bn *x);
+
+int aurc_bn_set_i64(aurc_bn_pool *pool, aurc_bn *x, int64_t value);
+int aurc_bn_copy(aurc_bn_pool *pool, aurc_bn *dst, const aurc_bn *src);
+int64_t aurc_bn_to_i64(const aurc_bn *x);
+int aurc_bn_cmp(const aurc_bn *a, const aurc_bn *b);
+static inline int aurc_bn_is_zero(const aurc_bn *x) {
+    return x->len == 0;
+}
+
+int aurc_bn_add(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, const aurc_bn *b);
+int aurc_bn_sub(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, const aurc_bn *b);
+int aurc_bn_mul(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, const aurc_bn *b);
+/* q = a / b and rem = a % b, either may be NULL; b must be non-zero. */
+int aurc_bn_divmod(aurc_bn_pool *pool, aurc_bn *q, aurc_bn *rem, const aurc_bn *a, const aurc_bn *b);
+int aurc_bn_pow(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, uint64_t exponent);
+int aurc_bn_shl(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, uint64_t bits);
+/* Arithmetic shift: rounds toward minus infinity like the ISA's `shr`. */
+int aurc_bn_shr(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, uint64_t bits);
+/* floor(sqrt(a)); a must not be negative. */
+int aurc_bn_sqrt(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a);
+
+/* Decimal digits of x with a leading '-' when negative, NUL-terminated, in a malloc'd buffer; NULL when out of memory. */
+char *aurc_bn_to_decimal(aurc_bn_pool *pool, const aurc_bn *x, size_t *len);
+
+#endif /* AURC_BIGNUM_H */
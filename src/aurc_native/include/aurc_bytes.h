@@ -0,0 +1,28 @@
+#ifndef AURC_BYTES_H
+#define AURC_BYTES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Growable byte buffer used for machine code, data sections and images. */
+typedef struct aurc_bytes {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} aurc_bytes;
+
+void aurc_bytes_init(aurc_bytes *buf);
+void aurc_bytes_free(aurc_bytes *buf);
+int aurc_bytes_reserve(aurc_bytes *buf, size_t extra);
+int aurc_bytes_append(aurc_bytes *buf, const void *data, size_t len);
+int aurc_bytes_append_u8(aurc_bytes *buf, uint8_t value);
+int aurc_bytes_append_le16(aurc_bytes *buf, uint16_t value);
+int aurc_bytes_append_le32(aurc_bytes *buf, uint32_t value);
+int aurc_bytes_append_le64(aurc_bytes *buf, uint64_t value);
+int aurc_bytes_append_zeros(aurc_bytes *buf, size_t count);
+void aurc_bytes_patch_le32(aurc_bytes *buf, size_t offset, uint32_t value);
+int aurc_bytes_write_file(const aurc_bytes *buf, const char *path);
+/* Adds execute permission wherever path is readable, like `chmod +x`; a no-op on Windows. */
+int aurc_make_executable(const char *path);
+
+#endif /* AURC_BYTES_H */
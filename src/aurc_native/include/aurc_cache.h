@@ -0,0 +1,52 @@
+#ifndef AURC_CACHE_H
+#define AURC_CACHE_H
+
+#include <stdint.h>
+
+#include "aurc_native.h"
+#include "aurc_source.h"
+
+/*
+ * Content-addressed compile cache (`--cache-dir <dir>`). An entry's key is
+ * the SHA-256 of the compiler's identity, the code generation switches and
+ * the source text, so the input's path does not matter and a rebuilt
+ * compiler never reuses an older one's output. Each output kind is
+ * stored as `<dir>/<key>.aurs|.bin|.exe`, written to a temporary name first
+ * and renamed into place, so compiles running in parallel (compile-many
+ * workers, or separate processes) may share one directory: readers see a
+ * whole file or none. An entry starts with a header holding the length and
+ * SHA-256 of the output after it; one that does not match is deleted and
+ * counts as a miss, so a damaged file is never handed out as output.
+ */
+
+#define AURC_CACHE_KEY_HEX 65  /* 64 digits plus NUL */
+
+typedef struct aurc_cache_key {
+    char hex[AURC_CACHE_KEY_HEX];
+} aurc_cache_key;
+
+#define AURC_CACHE_COMPILER_ID 32
+
+/*
+ * Identity of the running compiler: its build date and time together with
+ * the size and modification time of its executable (found through
+ * /proc/self/exe or GetModuleFileName, where available). Sessions compute it
+ * once and keep it.
+ */
+void aurc_cache_compiler_id(uint8_t id[AURC_CACHE_COMPILER_ID]);
+
+/* Fills key for source compiled with options by the compiler with that id. */
+void aurc_cache_key_for(const uint8_t compiler_id[AURC_CACHE_COMPILER_ID], const aurc_compile_options *options,
+                        aurc_view source, aurc_cache_key *key);
+
+/*
+ * Copies every output options asks for out of the cache. Returns 1 only when
+ * all of them were there and intact; a partial hit delivers nothing, and the
+ * compile goes ahead as usual and overwrites what was copied.
+ */
+int aurc_cache_fetch(const aurc_compile_options *options, const aurc_cache_key *key, aurc_compile_stats *stats);
+
+/* Stores the outputs a successful compile just wrote; failures only cost the cache entry, with a diagnostic. */
+void aurc_cache_store(const aurc_compile_options *options, const aurc_cache_key *key, aurc_compile_stats *stats);
+
+#endif /* AURC_CACHE_H */
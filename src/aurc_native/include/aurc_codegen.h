@@ -0,0 +1,34 @@
+#ifndef AURC_CODEGEN_H
+#define AURC_CODEGEN_H
+
+#include "aurc_emit.h"
+#include "aurc_ir.h"
+#include "aurc_x86.h"
+
+/*
+ * Backends consuming aurc_ir_program.
+ *
+ * The Minimal ISA backend writes to an aurc_isa_sink: a `.aurs` manifest for
+ * the assembler or, skipping it, the image directly (see aurc_emit.h). Every
+ * function keeps its locals in a stack frame (`sub sp, sp, #n`); IR values
+ * live in r2-r7 for their short lifetime, spilling to extra frame slots when
+ * more than six are live. r0 and r1 are scratch and carry service arguments;
+ * call arguments travel in r1..rN and results in r0, as in
+ * pipeline/src/codegen.js.
+ *
+ * The x86-64 backend feeds the PE32+ writer with Win64 code and a small
+ * runtime for the print services calling kernel32, or, with
+ * target->syscalls, the ELF64 writer with the same code and a runtime making
+ * raw Linux syscalls.
+ */
+
+typedef struct aurc_x86_target {
+    int vectorize;          /* -O2: reduction loops get a packed-lane preheader */
+    int avx2;               /* --target-cpu x86-64-v3: four lanes in ymm registers instead of SSE2's two */
+    int syscalls;           /* --target-os linux: write and exit_group instead of kernel32 imports */
+} aurc_x86_target;
+
+int aurc_codegen_isa(const aurc_ir_program *ir, aurc_isa_sink *sink);
+int aurc_codegen_x86(const aurc_ir_program *ir, const aurc_x86_target *target, aurc_x86_asm *as);
+
+#endif /* AURC_CODEGEN_H */
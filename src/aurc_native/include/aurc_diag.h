@@ -0,0 +1,22 @@
+#ifndef AURC_DIAG_H
+#define AURC_DIAG_H
+
+#include <stdarg.h>
+
+#include "aurc_bytes.h"
+
+/*
+ * Compiler diagnostics. Library code reports through these instead of
+ * writing to stderr directly, so a worker thread can collect one job's
+ * messages and the batch driver can print them in input order.
+ */
+
+void aurc_diag_printf(const char *fmt, ...);
+void aurc_diag_vprintf(const char *fmt, va_list args);
+/* perror() equivalent: "<prefix>: <strerror(errno)>". */
+void aurc_diag_perror(const char *prefix);
+
+/* Routes the calling thread's diagnostics into buf; NULL goes back to stderr. */
+void aurc_diag_capture(aurc_bytes *buf);
+
+#endif /* AURC_DIAG_H */
@@ -0,0 +1,88 @@
+#ifndef AURC_EMIT_H
+#define AURC_EMIT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "aurc_bytes.h"
+#include "aurc_ir.h"
+#include "aurc_source.h"
+
+/*
+ * Minimal ISA output sinks. The code generator describes an image as a stream
+ * of instruction words, labels and strings:
+ *
+ *   - the text sink renders it as a `.aurs` manifest the assembler accepts;
+ *   - the image sink packs it straight into an image buffer and back-patches
+ *     label operands itself, skipping the format/parse round trip.
+ *
+ * A word whose target is non-NULL carries the 0xFE label sentinel, or is an
+ * atomic word naming a shared slot, and gets the target's absolute address in
+ * imm32. Shared slots are declared up front and their labels stay unbound
+ * until the image is finished: they are laid out after everything else.
+ * Comments only matter to the text sink; generators should skip formatting
+ * them when wants_comments is 0.
+ *
+ * A string normally arrives as one `string` call. The code generator shares
+ * the bytes of a string that ends another one (aurc_codegen_isa), and then
+ * sends the longer string in pieces: `bytes` for each stretch before a label
+ * that points into it, `string` for the last stretch and its terminator.
+ */
+
+typedef struct aurc_isa_sink aurc_isa_sink;
+
+struct aurc_isa_sink {
+    void (*word)(aurc_isa_sink *sink, uint64_t word, const char *target, const char *comment);
+    void (*label)(aurc_isa_sink *sink, const char *name);
+    void (*string)(aurc_isa_sink *sink, aurc_view text);  /* bytes plus a NUL terminator */
+    void (*bytes)(aurc_isa_sink *sink, aurc_view text);   /* bytes alone */
+    void (*directive)(aurc_isa_sink *sink, const char *line);  /* manifest-only lines (header, org, blank) */
+    void (*shared)(aurc_isa_sink *sink, uint32_t id, const char *name, int64_t init, int sharded);  /* ids count up from 0 */
+    int wants_comments;
+    uint64_t word_count;  /* words received so far */
+    int failed;          /* sticky: set on write errors or when out of memory */
+};
+
+typedef struct aurc_isa_text_sink {
+    aurc_isa_sink base;
+    FILE *out;
+} aurc_isa_text_sink;
+
+typedef struct aurc_isa_label_fixup {
+    uint32_t offset;     /* start of the word in the image */
+    uint32_t label;      /* id in labels */
+} aurc_isa_label_fixup;
+
+typedef struct aurc_isa_image_sink {
+    aurc_isa_sink base;
+    aurc_bytes image;
+    aurc_interner labels;
+    uint32_t *addresses;       /* per label id, AURC_ISA_UNBOUND until defined */
+    uint32_t address_cap;
+    aurc_isa_label_fixup *fixups;
+    size_t fixup_count;
+    size_t fixup_cap;
+    uint32_t *shared_labels;   /* label id per shared slot */
+    int64_t *shared_inits;
+    uint32_t shared_count;
+    uint32_t shared_cap;
+    size_t code_end;           /* end of the last word */
+    size_t data_end;           /* end of the strings, before the shared slots */
+    size_t shared_base;
+} aurc_isa_image_sink;
+
+#define AURC_ISA_UNBOUND UINT32_MAX
+
+void aurc_isa_text_sink_init(aurc_isa_text_sink *sink, FILE *out);
+
+void aurc_isa_image_sink_init(aurc_isa_image_sink *sink);
+void aurc_isa_image_sink_free(aurc_isa_image_sink *sink);
+/* Lays out shared slots and patches every label operand; fails on undefined labels or an earlier error. */
+int aurc_isa_image_sink_finish(aurc_isa_image_sink *sink);
+/*
+ * Appends the finished image to out as an aurc_image.h container, the same
+ * bytes the assembler writes for the sink's manifest.
+ */
+int aurc_isa_image_sink_encode(aurc_isa_image_sink *sink, aurc_bytes *out);
+
+#endif /* AURC_EMIT_H */
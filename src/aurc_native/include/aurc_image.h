@@ -0,0 +1,123 @@
+#ifndef AURC_IMAGE_H
+#define AURC_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aurc_bytes.h"
+
+/*
+ * Versioned container for Minimal ISA images, written by the manifest
+ * assembler and the compiler's image sink and loaded by the VM. All header
+ * fields are little-endian; instruction words inside the code section stay
+ * big-endian (aurc_isa.h).
+ *
+ *   0   magic "AURCIMG\0"
+ *   8   u16 version (AURC_IMAGE_VERSION), u16 header size, u16 section count, u16 section entry size
+ *   16  u32 flags (0), u32 entry address, u32 address space (bytes of arena the image occupies),
+ *       u32 section table offset
+ *   32  reserved, zero up to the header size
+ *
+ * Each section table entry is six u32: kind, flags (0), address, size, file
+ * offset, alignment. Addresses are arena addresses, the ones imm32 operands
+ * hold, and the layout is the one the flat image always had:
+ *
+ *   code    [0, code size): instruction words, plus any data a hand-written
+ *           manifest places between them;
+ *   rodata  right after code: strings and other constant data;
+ *   shared  line-aligned ISA_SHARED_STRIDE slots with their initial values;
+ *   symbols, relocs: not loaded (address 0).
+ *
+ * Code starts on an AURC_IMAGE_ALIGN boundary of the file and rodata follows
+ * it without a gap, so the two form one read-only range the VM executes and
+ * reads in place from a mapping of the file: nothing is copied or decoded at
+ * start-up, and instances of one image share its pages. Only the shared
+ * section is copied into the VM's arena. The other sections start on
+ * AURC_IMAGE_ALIGN boundaries too.
+ *
+ * The symbol section is a u32 count followed by that many {u32 address, u32
+ * name offset} pairs, sorted by address then name, and the names, each
+ * NUL-terminated, offsets counted from the first name. The relocation
+ * section is a u32 count followed by {u32 offset, u32 kind} pairs sorted by
+ * offset: every place that holds an absolute address, so tools can rebase an
+ * image. The VM loads images at the address they were laid out for and
+ * never applies them.
+ */
+
+#define AURC_IMAGE_MAGIC "AURCIMG"   /* eight bytes with the NUL */
+#define AURC_IMAGE_VERSION 1u
+#define AURC_IMAGE_HEADER_SIZE 64u
+#define AURC_IMAGE_SECTION_ENTRY_SIZE 24u
+#define AURC_IMAGE_ALIGN 64u
+
+typedef enum aurc_image_section_kind {
+    AURC_SECTION_CODE = 1,
+    AURC_SECTION_RODATA = 2,
+    AURC_SECTION_SHARED = 3,
+    AURC_SECTION_SYMBOLS = 4,
+    AURC_SECTION_RELOCS = 5
+} aurc_image_section_kind;
+
+typedef enum aurc_image_reloc_kind {
+    AURC_RELOC_IMM32 = 1,   /* imm32 of the big-endian ISA word at offset (its last four bytes) */
+    AURC_RELOC_ABS64 = 2    /* little-endian 64-bit address at offset (`ref`) */
+} aurc_image_reloc_kind;
+
+typedef struct aurc_image_symbol {
+    const char *name;       /* not necessarily NUL-terminated */
+    size_t name_len;
+    uint32_t address;
+} aurc_image_symbol;
+
+typedef struct aurc_image_reloc {
+    uint32_t offset;
+    uint32_t kind;          /* aurc_image_reloc_kind */
+} aurc_image_reloc;
+
+/*
+ * What a producer hands aurc_image_encode: the flat image as the VM
+ * addresses it, with code in [0, code_size), constant data in
+ * [code_size, data_end) and, when shared_size is non-zero, shared slots in
+ * [shared_base, shared_base + shared_size) at the end. symbols and relocs are
+ * sorted in place.
+ */
+typedef struct aurc_image_layout {
+    const uint8_t *bytes;
+    size_t size;
+    size_t code_size;
+    size_t data_end;
+    size_t shared_base;
+    size_t shared_size;
+    aurc_image_symbol *symbols;
+    size_t symbol_count;
+    aurc_image_reloc *relocs;
+    size_t reloc_count;
+} aurc_image_layout;
+
+/* Appends the container for layout to out; fails with a diagnostic when it does not fit 32-bit addresses. */
+int aurc_image_encode(aurc_image_layout *layout, aurc_bytes *out);
+
+/* A container checked by aurc_image_parse; every pointer points into the parsed buffer. */
+typedef struct aurc_image_view {
+    uint32_t version;
+    uint32_t entry;
+    uint32_t address_space;
+    const uint8_t *rom;         /* code then rodata, addresses [0, rom_size) */
+    uint32_t rom_size;
+    uint32_t code_size;
+    const uint8_t *shared;      /* initial shared lines, NULL when there are none */
+    uint32_t shared_base;
+    uint32_t shared_size;
+    const uint8_t *symbols;     /* raw symbol section, NULL when absent */
+    uint32_t symbols_size;
+    const uint8_t *relocs;      /* raw relocation section, NULL when absent */
+    uint32_t relocs_size;
+} aurc_image_view;
+
+/* 1 when data starts with the container magic; anything else is an unstructured image. */
+int aurc_image_is_container(const uint8_t *data, size_t size);
+
+/* Validates the header and section table of the container in data; prints a diagnostic naming path on failure. */
+int aurc_image_parse(const uint8_t *data, size_t size, const char *path, aurc_image_view *view);
+
+#endif /* AURC_IMAGE_H */
@@ -0,0 +1,187 @@
+#ifndef AURC_IR_H
+#define AURC_IR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aurc_ast.h"
+#include "aurc_source.h"
+
+/*
+ * Mid-level IR between the AST and the ISA backend.
+ *
+ * Identifiers and string literals are interned once per program and referred
+ * to by 32-bit ids. Each function keeps its instructions struct-of-arrays, so
+ * a pass that only looks at opcodes touches one byte per instruction.
+ *
+ * Values are SSA: every instruction with a result defines a fresh value id
+ * (dst) that is never reassigned. Source-level variables are not values; they
+ * are numbered frame locals read and written with LOAD_LOCAL / STORE_LOCAL,
+ * the way an unpromoted alloca works. Promoting locals to values needs phi
+ * nodes, which this IR does not have yet. Until then a value never lives
+ * across a LABEL, so backends can allocate values in one linear walk.
+ */
+
+#define AURC_IR_NONE UINT32_MAX
+
+/* Deduplicating byte-string table handing out dense 32-bit ids. */
+typedef struct aurc_interner {
+    char *chars;            /* every entry, NUL-terminated, back to back */
+    size_t chars_len;
+    size_t chars_cap;
+    uint32_t *offsets;
+    uint32_t *lengths;
+    uint32_t count;
+    uint32_t cap;
+    uint32_t *slots;        /* open-addressed hash of id + 1; 0 marks an empty slot */
+    uint32_t slot_cap;
+} aurc_interner;
+
+void aurc_interner_init(aurc_interner *in);
+void aurc_interner_free(aurc_interner *in);
+/* Forgets every entry but keeps the storage. */
+void aurc_interner_reset(aurc_interner *in);
+/* Returns the id for text, adding it on first sight; AURC_IR_NONE when out of memory. */
+uint32_t aurc_intern(aurc_interner *in, aurc_view text);
+/* Returns the id for text or AURC_IR_NONE when it was never interned. */
+uint32_t aurc_interner_find(const aurc_interner *in, aurc_view text);
+
+static inline aurc_view aurc_interner_get(const aurc_interner *in, uint32_t id) {
+    aurc_view view = {in->chars + in->offsets[id], in->lengths[id]};
+    return view;
+}
+
+static inline const char *aurc_interner_cstr(const aurc_interner *in, uint32_t id) {
+    return in->chars + in->offsets[id];
+}
+
+typedef enum aurc_ir_op {
+    AURC_IR_CONST = 0,      /* dst = imm */
+    AURC_IR_STRING,         /* dst = address of string a */
+    AURC_IR_LOAD_LOCAL,     /* dst = local a */
+    AURC_IR_STORE_LOCAL,    /* local a = b */
+    AURC_IR_ADD,            /* dst = a op b */
+    AURC_IR_SUB,
+    AURC_IR_MUL,
+    AURC_IR_DIV,
+    AURC_IR_MOD,
+    AURC_IR_AND,
+    AURC_IR_OR,
+    AURC_IR_XOR,
+    AURC_IR_SHL,
+    AURC_IR_SHR,
+    AURC_IR_EQ,             /* dst = (a cmp b) ? 1 : 0 */
+    AURC_IR_NE,
+    AURC_IR_LT,
+    AURC_IR_LE,
+    AURC_IR_GT,
+    AURC_IR_GE,
+    AURC_IR_NEG,            /* dst = op a */
+    AURC_IR_NOT,            /* logical: dst = a == 0 */
+    AURC_IR_BITNOT,
+    AURC_IR_LABEL,          /* label imm */
+    AURC_IR_JUMP,           /* goto label imm */
+    AURC_IR_BR_EQ,          /* if (a cmp b) goto label imm */
+    AURC_IR_BR_NE,
+    AURC_IR_BR_LT,
+    AURC_IR_BR_LE,
+    AURC_IR_BR_GT,
+    AURC_IR_BR_GE,
+    AURC_IR_ARG,            /* argument imm of the next CALL or SPAWN is a */
+    AURC_IR_CALL,           /* dst = function a (index into program functions), imm arguments */
+    AURC_IR_RET,            /* return a (AURC_IR_NONE returns 0) */
+    AURC_IR_PRINT_INT,      /* write a as decimal plus newline */
+    AURC_IR_PRINT_STR,      /* write the NUL-terminated string at a */
+    AURC_IR_FLUSH,          /* write out what the prints so far left buffered */
+    AURC_IR_INPUT_INT,      /* dst = integer read from stdin */
+    AURC_IR_EXIT,           /* terminate the program with status a */
+    AURC_IR_SPAWN,          /* dst = handle of a new task running function a, imm arguments */
+    AURC_IR_JOIN,           /* dst = return value of the task with handle a, once it has finished */
+    AURC_IR_ATOMIC_LOAD,    /* dst = shared a */
+    AURC_IR_ATOMIC_STORE,   /* shared a = b */
+    AURC_IR_ATOMIC_ADD,     /* shared a += b */
+    AURC_IR_BIGNUM_UNARY,   /* dst = bignum operation imm (aurc_bn_op) of a */
+    AURC_IR_BIGNUM_BINARY,  /* dst = bignum operation imm of a, b */
+    AURC_IR_OP_COUNT
+} aurc_ir_op;
+
+typedef struct aurc_ir_code {
+    uint8_t *op;
+    uint32_t *dst;
+    uint32_t *a;
+    uint32_t *b;
+    int64_t *imm;
+    size_t count;
+    size_t cap;
+} aurc_ir_code;
+
+typedef struct aurc_ir_function {
+    uint32_t name;          /* symbol id */
+    uint32_t param_count;   /* parameters occupy locals 0 .. param_count - 1 */
+    uint32_t local_count;
+    uint32_t *local_names;  /* symbol id per local */
+    uint32_t local_cap;
+    uint32_t value_count;
+    uint32_t label_count;
+    int returns_value;
+    aurc_ir_code code;
+} aurc_ir_function;
+
+/* Program-wide word every task sees; only touched through the ATOMIC_* ops. Its index is its id. */
+typedef struct aurc_ir_shared {
+    uint32_t name;          /* symbol id */
+    int64_t init;
+    int sharded;            /* set by aurc_ir_shard_counters */
+} aurc_ir_shared;
+
+typedef struct aurc_ir_program {
+    aurc_interner symbols;
+    aurc_interner strings;
+    aurc_ir_function *functions;
+    uint32_t function_count;
+    uint32_t function_cap;
+    uint32_t entry;         /* index of main */
+    aurc_ir_shared *shared;
+    uint32_t shared_count;
+    uint32_t shared_cap;
+} aurc_ir_program;
+
+void aurc_ir_init(aurc_ir_program *ir);
+void aurc_ir_free(aurc_ir_program *ir);
+/* Empties ir for the next program, keeping function, code and interner buffers. */
+void aurc_ir_reset(aurc_ir_program *ir);
+
+/* Lowers a parsed program; reports "path:line:col" errors for constructs the backend cannot handle yet. */
+int aurc_ir_lower(const char *path, const aurc_program *program, aurc_ir_program *ir);
+
+/*
+ * Folds constants, threads jumps, deletes unreachable code, dead values and
+ * dead stores, and replaces counted loops over linear sums by their closed
+ * form in every function, then renumbers values densely (see ir_opt.c).
+ * Returns 1 only when out of memory.
+ */
+int aurc_ir_optimize(aurc_ir_program *ir);
+
+/*
+ * Marks every shared variable that is only ever read and added to (never
+ * atomic.store'd) as sharded: backends then keep one partial sum per worker
+ * and combine them on load, so adders stop contending for one cache line.
+ */
+void aurc_ir_shard_counters(aurc_ir_program *ir);
+
+#define AURC_IR_USES_A 1u
+#define AURC_IR_USES_B 2u
+
+const char *aurc_ir_op_name(aurc_ir_op op);
+int aurc_ir_op_has_dst(aurc_ir_op op);
+/* Which of a / b hold value ids (as opposed to locals, labels, functions or nothing). */
+unsigned aurc_ir_op_uses(aurc_ir_op op);
+static inline int aurc_ir_op_is_branch(aurc_ir_op op) {
+    return op >= AURC_IR_BR_EQ && op <= AURC_IR_BR_GE;
+}
+/* CALL and SPAWN both end an ARG run and pass arguments the same way. */
+static inline int aurc_ir_op_takes_args(aurc_ir_op op) {
+    return op == AURC_IR_CALL || op == AURC_IR_SPAWN;
+}
+
+#endif /* AURC_IR_H */
@@ -0,0 +1,184 @@
+#ifndef AURC_ISA_H
+#define AURC_ISA_H
+
+#include <stdint.h>
+
+/*
+ * Aurora Minimal ISA encoding shared by the compiler, the manifest assembler
+ * and the VM. See specs/aurora_minimal_isa.md §3.1 for the word layout:
+ *
+ *   [63:56] opcode  [55:48] op0  [47:40] op1  [39:32] op2  [31:0] imm32
+ *
+ * Words are stored big-endian in `bytes` directives and in assembled images.
+ * Opcodes, their mnemonics, operand kinds and effects all come from the
+ * table in aurc_opcodes.def.
+ */
+
+typedef enum isa_opcode {
+#define AURC_ISA_OPCODE(name, value, mnemonic, op0, op1, op2, effects) ISA_OPCODE_##name = value,
+#include "aurc_opcodes.def"
+#undef AURC_ISA_OPCODE
+} isa_opcode;
+
+typedef enum isa_register {
+    ISA_REG_R0 = 0,
+    ISA_REG_R1 = 1,
+    ISA_REG_R2 = 2,
+    ISA_REG_R3 = 3,
+    ISA_REG_R4 = 4,
+    ISA_REG_R5 = 5,
+    ISA_REG_R6 = 6,
+    ISA_REG_R7 = 7,
+    ISA_REG_SP = 8      /* stack pointer; only mov/add/sub address it directly */
+} isa_register;
+
+#define ISA_REGISTER_COUNT 8
+
+typedef enum isa_condition {
+    ISA_COND_EQ = 0x01,
+    ISA_COND_NE = 0x02,
+    ISA_COND_LT = 0x03,
+    ISA_COND_LE = 0x04,
+    ISA_COND_GT = 0x05,
+    ISA_COND_GE = 0x06
+} isa_condition;
+
+/* Service numbers selected by `svc` operand 0 (matches pipeline/src/codegen.js). */
+typedef enum isa_service {
+    ISA_SERVICE_WRITE = 0x01,
+    ISA_SERVICE_EXIT = 0x02,
+    ISA_SERVICE_PRINT_INT = 0x05,
+    ISA_SERVICE_INPUT_INT = 0x06,
+    ISA_SERVICE_FLUSH = 0x08,       /* write out the task's buffered stdout (0x03, 0x04, 0x07 are the pipeline's) */
+    ISA_SERVICE_BIGNUM = 0x10       /* operation op1 (aurc_bn_op) on r0, r1; result in r0 */
+} isa_service;
+
+enum {
+    ISA_OPERAND_UNUSED = 0x00,
+    ISA_OPERAND_LABEL = 0xFE,
+    ISA_OPERAND_IMMEDIATE = 0xFF
+};
+
+#define ISA_WORD_SIZE 8
+
+/* What an operand byte holds, per opcode (aurc_opcodes.def). */
+typedef enum isa_operand_kind {
+    ISA_OPERAND_KIND_NONE = 0,      /* unused */
+    ISA_OPERAND_KIND_REG,           /* r0-r7 or sp */
+    ISA_OPERAND_KIND_REG_IMM,       /* a register, or ISA_OPERAND_IMMEDIATE for imm32 */
+    ISA_OPERAND_KIND_REG_IMM_LABEL, /* either of those, or ISA_OPERAND_LABEL for the address in imm32 */
+    ISA_OPERAND_KIND_IMM,           /* ISA_OPERAND_IMMEDIATE: imm32 is the operand */
+    ISA_OPERAND_KIND_LABEL,         /* ISA_OPERAND_LABEL: imm32 is the target address */
+    ISA_OPERAND_KIND_COND,          /* isa_condition */
+    ISA_OPERAND_KIND_SERVICE,       /* isa_service */
+    ISA_OPERAND_KIND_BYTE,          /* the service's argument */
+    ISA_OPERAND_KIND_SLOT,          /* shared slot id (see below) */
+    ISA_OPERAND_KIND_FLAGS          /* ISA_ATOMIC_SHARDED */
+} isa_operand_kind;
+
+/* What running a word does beyond its operands, for passes that rewrite or compile code. */
+enum {
+    ISA_EFFECT_SETS_COMPARE = 1u << 0,  /* cmp: sets the flags cjmp tests */
+    ISA_EFFECT_READS_COMPARE = 1u << 1,
+    ISA_EFFECT_BRANCH = 1u << 2,        /* may continue at the address in imm32, inside the function */
+    ISA_EFFECT_RUNTIME = 1u << 3,       /* calls, returns, services, tasks, halt: needs the VM around it */
+    ISA_EFFECT_ATOMIC = 1u << 4         /* reads or writes a shared slot */
+};
+
+typedef struct isa_opcode_desc {
+    const char *mnemonic;           /* NULL for a byte that is no opcode */
+    uint8_t operands[3];            /* isa_operand_kind of op0, op1, op2 */
+    uint8_t effects;
+} isa_opcode_desc;
+
+/* Indexed by opcode byte, so decoding an opcode is one load (src/isa_opcodes.c). */
+extern const isa_opcode_desc isa_opcode_table[256];
+
+static inline const char *isa_mnemonic(uint8_t opcode) {
+    return isa_opcode_table[opcode].mnemonic;
+}
+
+static inline int isa_operand_valid(uint8_t kind, uint8_t operand) {
+    switch (kind) {
+        case ISA_OPERAND_KIND_REG:
+            return operand <= ISA_REG_SP;
+        case ISA_OPERAND_KIND_REG_IMM:
+            return operand <= ISA_REG_SP || operand == ISA_OPERAND_IMMEDIATE;
+        case ISA_OPERAND_KIND_REG_IMM_LABEL:
+            return operand <= ISA_REG_SP || operand == ISA_OPERAND_IMMEDIATE || operand == ISA_OPERAND_LABEL;
+        default:
+            return 1;   /* sentinels, conditions, services and slots are checked by whoever uses them */
+    }
+}
+
+/*
+ * Atomic words name their shared slot by id (op1 for atomic_load, op0 for the
+ * others, matching pipeline/src/codegen.js); the assembler writes the slot's
+ * absolute address into imm32 once `shared` directives are laid out.
+ *
+ * Each slot owns a whole ISA_SHARED_STRIDE-byte line (value in the first 8
+ * bytes, little-endian) starting on a line boundary, so tasks hammering
+ * different variables never share a cache line. A slot declared `sharded` is
+ * an add-only counter: its atomic words carry ISA_ATOMIC_SHARDED in op2 and
+ * the VM may keep per-worker partial sums that atomic_load adds up.
+ */
+#define ISA_SHARED_STRIDE 64u
+#define ISA_ATOMIC_SHARDED 0x01
+
+static inline int isa_is_atomic(uint8_t opcode) {
+    return (isa_opcode_table[opcode].effects & ISA_EFFECT_ATOMIC) != 0;
+}
+
+static inline uint8_t isa_atomic_slot(uint8_t opcode, uint8_t op0, uint8_t op1) {
+    return isa_opcode_table[opcode].operands[0] == ISA_OPERAND_KIND_SLOT ? op0 : op1;
+}
+
+typedef struct isa_instruction {
+    uint8_t opcode;
+    uint8_t op0;
+    uint8_t op1;
+    uint8_t op2;
+    uint32_t imm32;
+} isa_instruction;
+
+static inline uint64_t pack_instruction_word(uint8_t opcode, uint8_t op0, uint8_t op1, uint8_t op2, uint32_t imm32) {
+    uint64_t word = 0;
+    word |= (uint64_t)opcode << 56;
+    word |= (uint64_t)op0 << 48;
+    word |= (uint64_t)op1 << 40;
+    word |= (uint64_t)op2 << 32;
+    word |= (uint64_t)imm32;
+    return word;
+}
+
+static inline isa_instruction unpack_instruction_word(uint64_t word) {
+    isa_instruction insn;
+    insn.opcode = (uint8_t)(word >> 56);
+    insn.op0 = (uint8_t)(word >> 48);
+    insn.op1 = (uint8_t)(word >> 40);
+    insn.op2 = (uint8_t)(word >> 32);
+    insn.imm32 = (uint32_t)word;
+    return insn;
+}
+
+/* Whether every register operand of insn names a register (or a sentinel its kind allows). */
+static inline int isa_registers_valid(isa_instruction insn) {
+    const uint8_t *kinds = isa_opcode_table[insn.opcode].operands;
+    return isa_operand_valid(kinds[0], insn.op0) && isa_operand_valid(kinds[1], insn.op1) &&
+           isa_operand_valid(kinds[2], insn.op2);
+}
+
+/* Reads one big-endian instruction word from an image. */
+static inline uint64_t isa_read_word(const uint8_t *bytes) {
+    uint64_t word = 0;
+    for (int i = 0; i < ISA_WORD_SIZE; ++i) {
+        word = (word << 8) | bytes[i];
+    }
+    return word;
+}
+
+static inline int32_t isa_signed_imm(uint32_t imm32) {
+    return (int32_t)imm32;
+}
+
+#endif /* AURC_ISA_H */
@@ -0,0 +1,68 @@
+#ifndef AURC_JIT_H
+#define AURC_JIT_H
+
+#include <stdint.h>
+
+/*
+ * Second tier of the VM: compiles one hot loop of a Minimal ISA image to
+ * x86-64 with the in-process encoder (aurc_x86.h) and runs it in an
+ * executable buffer. A loop is the run of instruction words from its head
+ * (the target of a back edge) to the branch that jumps back, and compiled
+ * code is entered only at the head.
+ *
+ * Compiled code keeps no VM state of its own: it loads the task's registers
+ * on entry and stores them back on the way out, records the operands of each
+ * cmp for the interpreter, and returns the address the interpreter resumes
+ * at. A loop is
+ * compiled only when every instruction in it is one compiled code runs
+ * (arithmetic, cmp and branches, the stack, atomics on plain shared slots),
+ * so calls, returns, services, spawn/join and sharded counters keep a loop
+ * in the interpreter. Compiled code leaves the loop (a side exit) before a
+ * stack access outside the task's stack and before a division by zero or by
+ * -1, so the interpreter raises the fault or defines the overflow itself; at
+ * branches out of the loop; and when the slice budget runs out on a back
+ * edge. After any exit the task is exactly where the interpreter would have
+ * it.
+ *
+ * Only x86-64 hosts compile; elsewhere aurc_jit_compile_loop always fails
+ * and the VM stays in the interpreter.
+ */
+
+/* What compiled code sees of the task it runs for; the offsets are baked into the code. */
+typedef struct aurc_jit_frame {
+    uint64_t *regs;             /* r0-r7 and sp: loaded on entry, stored back at every exit */
+    int64_t compare_lhs;        /* operands of the last cmp: compare is the sign of lhs - rhs */
+    int64_t compare_rhs;
+    int64_t budget;             /* back edges left in the slice; the loop exits when it reaches 0 */
+    uint64_t stack_low;
+    uint64_t stack_bias;        /* host address of stack address 0: the task's stack minus stack_low */
+    uint8_t *arena;             /* for atomics on shared slots */
+} aurc_jit_frame;
+
+/* The code a loop comes from, and what decides which atomic slots are valid. */
+typedef struct aurc_jit_image {
+    const uint8_t *code;
+    uint32_t code_size;
+    uint32_t shared_low;
+    uint32_t image_size;
+} aurc_jit_image;
+
+typedef struct aurc_jit_loop aurc_jit_loop;
+
+/* 1 when this build can compile loops for the host it runs on. */
+int aurc_jit_supported(void);
+
+/*
+ * Compiles the loop from the word at address head to the back edge at
+ * address tail. Returns NULL when the host has no x86-64, when the loop holds
+ * an instruction compiled code does not run or when memory runs out; the
+ * caller then keeps interpreting.
+ */
+aurc_jit_loop *aurc_jit_compile_loop(const aurc_jit_image *image, uint32_t head, uint32_t tail);
+
+/* Runs loop from its head; returns the address to resume interpreting at. */
+uint32_t aurc_jit_run(const aurc_jit_loop *loop, aurc_jit_frame *frame);
+
+void aurc_jit_free(aurc_jit_loop *loop);
+
+#endif /* AURC_JIT_H */
@@ -0,0 +1,113 @@
+#ifndef AURC_LEXER_H
+#define AURC_LEXER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aurc_arena.h"
+#include "aurc_source.h"
+
+/*
+ * Token kinds follow pipeline/src/lexer.js. Math builtins (sqrt, pow, ...)
+ * are plain identifiers here; the parser recognises them at call sites.
+ * There are no negative-number tokens: `-1` is unary minus, which keeps
+ * `a-1` a subtraction.
+ */
+typedef enum aurc_token_kind {
+    AURC_TOK_EOF = 0,
+    AURC_TOK_IDENT,
+    AURC_TOK_INT,
+    AURC_TOK_FLOAT,
+    AURC_TOK_STRING,
+
+    /* keywords */
+    AURC_TOK_MODULE,
+    AURC_TOK_FN,
+    AURC_TOK_LET,
+    AURC_TOK_IF,
+    AURC_TOK_ELSE,
+    AURC_TOK_WHILE,
+    AURC_TOK_FOR,
+    AURC_TOK_IN,
+    AURC_TOK_BREAK,
+    AURC_TOK_CONTINUE,
+    AURC_TOK_STEP,
+    AURC_TOK_RETURN,
+    AURC_TOK_REQUEST,
+    AURC_TOK_SERVICE,
+    AURC_TOK_TRUE,
+    AURC_TOK_FALSE,
+    AURC_TOK_SHARED,
+    AURC_TOK_ATOMIC,
+    AURC_TOK_KW_INT,
+    AURC_TOK_KW_FLOAT,
+    AURC_TOK_KW_STRING,
+    AURC_TOK_KW_BOOL,
+    AURC_TOK_KW_THREAD,
+    AURC_TOK_SPAWN,
+    AURC_TOK_JOIN,
+    AURC_TOK_PRINT,
+    AURC_TOK_INPUT,
+    AURC_TOK_AS,
+
+    /* operators and punctuation */
+    AURC_TOK_PLUS,
+    AURC_TOK_MINUS,
+    AURC_TOK_STAR,
+    AURC_TOK_SLASH,
+    AURC_TOK_PERCENT,
+    AURC_TOK_ASSIGN,
+    AURC_TOK_EQ,
+    AURC_TOK_NE,
+    AURC_TOK_LT,
+    AURC_TOK_GT,
+    AURC_TOK_LE,
+    AURC_TOK_GE,
+    AURC_TOK_AND_AND,
+    AURC_TOK_OR_OR,
+    AURC_TOK_BANG,
+    AURC_TOK_AMP,
+    AURC_TOK_PIPE,
+    AURC_TOK_CARET,
+    AURC_TOK_TILDE,
+    AURC_TOK_SHL,
+    AURC_TOK_SHR,
+    AURC_TOK_LPAREN,
+    AURC_TOK_RPAREN,
+    AURC_TOK_LBRACE,
+    AURC_TOK_RBRACE,
+    AURC_TOK_LBRACKET,
+    AURC_TOK_RBRACKET,
+    AURC_TOK_COMMA,
+    AURC_TOK_COLON,
+    AURC_TOK_SEMICOLON,
+    AURC_TOK_ARROW,
+    AURC_TOK_DOTDOT,
+    AURC_TOK_DOT
+} aurc_token_kind;
+
+typedef struct aurc_token {
+    aurc_token_kind kind;
+    uint32_t line;
+    uint32_t column;
+    aurc_view text;              /* spelling in the source */
+    union {
+        int64_t int_value;       /* AURC_TOK_INT */
+        double float_value;      /* AURC_TOK_FLOAT */
+        aurc_view string_value;  /* AURC_TOK_STRING, escapes decoded; aliases the source when there are none */
+    } as;
+} aurc_token;
+
+typedef struct aurc_token_list {
+    aurc_token *items;           /* always terminated by an AURC_TOK_EOF token */
+    size_t count;
+    size_t cap;
+} aurc_token_list;
+
+/* Tokenises source in one pass; decoded strings are allocated from arena. Reports "path:line:col" errors. */
+int aurc_lex(const char *path, aurc_view source, aurc_arena *arena, aurc_token_list *out);
+void aurc_token_list_free(aurc_token_list *tokens);
+
+const char *aurc_token_kind_name(aurc_token_kind kind);
+
+#endif /* AURC_LEXER_H */
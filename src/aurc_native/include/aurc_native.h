@@ -13,9 +13,102 @@ struct aurc_buffer {
     size_t len;
 };
 
-int aurc_compile_file(const char *input_path, const char *output_path);
+/* Instruction set --emit-exe may assume. */
+typedef enum aurc_target_cpu {
+    AURC_CPU_X86_64 = 0,        /* baseline: SSE2 */
+    AURC_CPU_X86_64_V3          /* AVX2 and the rest of x86-64-v3 */
+} aurc_target_cpu;
+
+/* Operating system --emit-exe writes for: a PE32+ or a static ELF64 executable. */
+typedef enum aurc_target_os {
+    AURC_OS_WINDOWS = 0,        /* kernel32 imports */
+    AURC_OS_LINUX               /* no libc, raw syscalls */
+} aurc_target_os;
+
+#ifdef _WIN32
+#define AURC_OS_HOST AURC_OS_WINDOWS
+#else
+#define AURC_OS_HOST AURC_OS_LINUX
+#endif
+
+/* Phases of one compile, in pipeline order, as timed for --time-report and --stats-json. */
+typedef enum aurc_phase {
+    AURC_PHASE_READ = 0,        /* mapping the input file */
+    AURC_PHASE_CACHE,           /* --cache-dir: hashing, lookups, copies in and out */
+    AURC_PHASE_LEX,
+    AURC_PHASE_PARSE,
+    AURC_PHASE_LOWER,           /* syntax tree -> IR */
+    AURC_PHASE_OPTIMIZE,        /* aurc_ir_optimize and aurc_ir_shard_counters */
+    AURC_PHASE_MANIFEST,        /* codegen into the .aurs writer */
+    AURC_PHASE_IMAGE,           /* codegen into the image sink, plus writing it */
+    AURC_PHASE_EXE,             /* x86-64 codegen and the PE32+ or ELF64 writer */
+    AURC_PHASE_COUNT
+} aurc_phase;
+
+/*
+ * Where one compile spent its time and how much it produced. Times are
+ * nanoseconds of monotonic wall clock and of CPU time of the compiling
+ * thread; phases that did not run stay 0.
+ */
+typedef struct aurc_compile_stats {
+    uint64_t wall_ns[AURC_PHASE_COUNT];
+    uint64_t cpu_ns[AURC_PHASE_COUNT];
+    uint64_t source_bytes;
+    uint64_t lines;
+    uint64_t tokens;            /* not counting the end-of-file token */
+    uint64_t functions;
+    uint64_t ir_lowered;        /* IR instructions as lowered */
+    uint64_t ir_optimized;      /* ... and after the optimizer, equal to ir_lowered at -O0 */
+    uint64_t isa_words;         /* Minimal ISA words generated (the manifest and the image get the same) */
+    uint64_t x86_bytes;         /* machine code in the executable's .text */
+    uint64_t bytes_written;     /* all output files together */
+    uint64_t cache_hits;        /* 1 when the outputs came from --cache-dir without compiling */
+    uint64_t cache_stores;      /* outputs added to --cache-dir */
+} aurc_compile_stats;
+
+/*
+ * Outputs of one compile, any subset of which may be requested (NULL skips
+ * one), followed by the code generation switches.
+ */
+typedef struct aurc_compile_options {
+    const char *manifest_path;  /* `.aurs` text, mostly useful for debugging */
+    const char *binary_path;    /* Minimal ISA image, emitted without going through the manifest */
+    const char *exe_path;       /* native executable for target_os */
+    unsigned opt_level;         /* -O0: backends see the IR as lowered; -O1 (default): aurc_ir_optimize first; -O2: also vectorize --emit-exe reductions */
+    int shard_counters;         /* --shard-counters: add-only shared ints become per-worker sums */
+    aurc_target_cpu target_cpu; /* --target-cpu x86-64|x86-64-v3 */
+    aurc_target_os target_os;   /* --target-os windows|linux, AURC_OS_HOST by default */
+    int time_report;            /* --time-report: print per-phase times and counters as a diagnostic */
+    const char *stats_json_path; /* --stats-json <file>: write the same as JSON */
+    const char *cache_dir;      /* --cache-dir <dir>: reuse outputs of identical earlier compiles (aurc_cache.h) */
+} aurc_compile_options;
+
+int aurc_compile_file(const char *input_path, const aurc_compile_options *options);
+
+/*
+ * A compile session carries the arena and IR buffers from one compilation to
+ * the next, so batch and server modes stop paying for allocation warm-up on
+ * every input. Sessions are not thread-safe.
+ */
+typedef struct aurc_session aurc_session;
+
+aurc_session *aurc_session_create(void);
+void aurc_session_destroy(aurc_session *session);
+int aurc_session_compile(aurc_session *session, const char *input_path, const aurc_compile_options *options);
 int aurc_assemble_manifest(const char *manifest_path, const char *binary_path);
-int aurc_compile_to_exe(const char *input_path, const char *exe_path);
+
+typedef struct aurc_run_options {
+    unsigned workers;           /* -j: threads spawned tasks run on, 0 for one per processor */
+    int pair_profile;           /* --pair-profile: report the op pairs executed most, for VM_FUSED_PAIRS (vm.c) */
+    int no_jit;                 /* --no-jit: interpret hot loops too instead of compiling them (aurc_jit.h) */
+    const char *profile;        /* --profile prefix: write prefix.folded and prefix.json (aurc_profile.h), or NULL */
+} aurc_run_options;
+
+/*
+ * Executes an assembled .bin image in the Stage N1 VM; *exit_status receives
+ * the program's exit code.
+ */
+int aurc_run_image(const char *image_path, const aurc_run_options *options, int *exit_status);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,52 @@
+#ifndef AURC_POOL_H
+#define AURC_POOL_H
+
+#include <stddef.h>
+
+#include "aurc_thread.h"
+
+/*
+ * Size-class allocator for runtime objects that come and go while a program
+ * runs (bignum limb arrays, task stacks). Blocks are rounded up to a power of
+ * two, and a freed block waits on its class's free list for the next request
+ * of that class instead of going back to malloc.
+ *
+ * An aurc_pool is the depot several threads share under its lock; each
+ * thread goes through an aurc_pool_cache of its own, which keeps a few blocks
+ * per class without locking and trades them with the depot in batches, so a
+ * worker that frees what it allocated never touches the lock. A block may be
+ * given back through any thread's cache. Caches and the depot both keep only
+ * a bounded number of blocks per class and free the rest.
+ */
+
+#define AURC_POOL_CLASSES 48  /* class c holds blocks of 2^c bytes */
+
+typedef struct aurc_pool {
+    aurc_mutex lock;
+    void *free_list[AURC_POOL_CLASSES];  /* linked through their first bytes */
+    unsigned cached[AURC_POOL_CLASSES];
+} aurc_pool;
+
+typedef struct aurc_pool_cache {
+    aurc_pool *pool;
+    void *free_list[AURC_POOL_CLASSES];
+    unsigned cached[AURC_POOL_CLASSES];
+} aurc_pool_cache;
+
+int aurc_pool_init(aurc_pool *pool);
+/* Frees the depot's blocks; every cache in front of it must be flushed first. */
+void aurc_pool_free(aurc_pool *pool);
+
+void aurc_pool_cache_init(aurc_pool_cache *cache, aurc_pool *pool);
+/* Hands every block the cache holds back to its depot. */
+void aurc_pool_cache_flush(aurc_pool_cache *cache);
+
+/*
+ * A block of at least size bytes, aligned like malloc's; its class size lands
+ * in *cap when cap is not NULL. NULL when out of memory.
+ */
+void *aurc_pool_take(aurc_pool_cache *cache, size_t size, size_t *cap);
+/* size is the size the block was taken with (or its class size); NULL is ignored. */
+void aurc_pool_give(aurc_pool_cache *cache, void *block, size_t size);
+
+#endif /* AURC_POOL_H */
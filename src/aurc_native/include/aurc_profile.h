@@ -0,0 +1,121 @@
+#ifndef AURC_PROFILE_H
+#define AURC_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aurc_bytes.h"
+#include "aurc_thread.h"
+
+/*
+ * Execution profile of one VM run (`run --profile`). The VM fills it in from
+ * the instruction stream (vm.c): every executed instruction word is counted
+ * on the worker that ran it, each task keeps a shadow stack of the calls it
+ * is in, and a sampler thread ticks every AURC_PROFILE_INTERVAL_US; a worker
+ * that sees the tick move takes one sample of the task it is running at its
+ * next instruction, so samples land only where a worker is busy. Counters
+ * are per worker and only written by their worker; the stack table behind
+ * samples is shared under a lock, which a few thousand samples a second
+ * never contend.
+ *
+ * Names come from the image's symbol section (the manifest's labels): a
+ * sample's stack is the label its task started at, the label of each call
+ * target on its shadow stack and, innermost, the label the sampled
+ * instruction lies under when that is not the function itself. Images
+ * without symbols name addresses in hex.
+ *
+ * aurc_profile_write produces <prefix>.folded, one "frame;frame;... count"
+ * line per distinct stack as flamegraph.pl and speedscope read it, and
+ * <prefix>.json with executions per opcode and per label, samples per
+ * label, and per worker the instructions it ran, spawns, joins (and how many
+ * had to wait), atomic operations and how many of those found their shared
+ * line last touched by another worker, the cache-line hand-offs contended
+ * counters pay for.
+ */
+
+#define AURC_PROFILE_INTERVAL_US 500u
+
+typedef struct aurc_profile_symbol {
+    uint32_t address;
+    const char *name;           /* NUL-terminated, inside the image */
+} aurc_profile_symbol;
+
+typedef struct aurc_profile_frames {
+    uint32_t entry;             /* word the task started at */
+    uint32_t depth;
+    uint32_t cap;
+    uint32_t *calls;            /* call target words, outermost first */
+} aurc_profile_frames;
+
+typedef struct aurc_profile_worker {
+    uint64_t *counts;           /* executions per instruction word; NULL until the worker runs */
+    uint64_t *sampled;          /* samples per instruction word */
+    int64_t tick;               /* the sampler tick last sampled */
+    uint64_t samples;
+    uint64_t spawns;
+    uint64_t joins;
+    uint64_t joins_waited;      /* joins whose task had not finished yet */
+    uint64_t atomic_ops;
+    uint64_t atomic_transfers;  /* atomic ops on a line another worker touched last */
+    uint64_t sharded_ops;       /* adds to and loads of sharded counters */
+    aurc_bytes scratch;         /* the stack being sampled */
+} aurc_profile_worker;
+
+typedef struct aurc_profile_stack {
+    char *text;                 /* folded frames, NUL-terminated; NULL for an empty slot */
+    uint64_t hash;
+    uint64_t count;
+} aurc_profile_stack;
+
+typedef struct aurc_profile {
+    const uint8_t *code;
+    uint32_t words;             /* instruction words in the code */
+    aurc_profile_symbol *symbols; /* sorted by address */
+    size_t symbol_count;
+    unsigned worker_count;
+    aurc_profile_worker *workers;
+    uint32_t task_count;
+    aurc_profile_frames *tasks; /* shadow stack per task id */
+    int64_t *line_owner;        /* atomic, per shared line: 1 + the worker that touched it last, 0 for none */
+    uint32_t line_count;
+    int64_t tick;               /* atomic, advanced by the sampler */
+    int64_t done;               /* atomic, stops the sampler */
+    aurc_thread sampler;
+    int sampling;
+    aurc_mutex lock;            /* stacks */
+    aurc_profile_stack *stacks;
+    size_t stack_count;
+    size_t stack_cap;           /* a power of two */
+} aurc_profile;
+
+/*
+ * Sets up a profile of code (words instruction words) for up to workers
+ * workers and tasks tasks, with names from the raw symbol section (NULL for
+ * none). Returns NULL with a diagnostic when memory runs out.
+ */
+aurc_profile *aurc_profile_create(const uint8_t *code, uint32_t words, const uint8_t *symbols, uint32_t symbols_size,
+                                  unsigned workers, uint32_t tasks, uint32_t lines);
+void aurc_profile_destroy(aurc_profile *profile);
+
+/* Starts and stops the sampler thread around a run. */
+int aurc_profile_start(aurc_profile *profile);
+void aurc_profile_stop(aurc_profile *profile);
+
+/* The worker's counters, allocated on first use by that worker; NULL when memory runs out. */
+aurc_profile_worker *aurc_profile_worker_for(aurc_profile *profile, unsigned worker);
+
+/* Shadow stacks: a task starting at word entry, and the calls and returns it makes. */
+void aurc_profile_task_start(aurc_profile *profile, uint32_t task, uint32_t entry);
+void aurc_profile_call(aurc_profile *profile, uint32_t task, uint32_t target);
+void aurc_profile_return(aurc_profile *profile, uint32_t task);
+
+/* A timer sample of task at word on worker. */
+void aurc_profile_sample(aurc_profile *profile, aurc_profile_worker *worker, uint32_t task, uint32_t word);
+
+/* An atomic operation by worker on shared line. */
+void aurc_profile_atomic(aurc_profile *profile, aurc_profile_worker *worker, unsigned self, uint32_t line);
+
+/* Writes <prefix>.folded and <prefix>.json; image names the run in the JSON. */
+int aurc_profile_write(const aurc_profile *profile, const char *image, const char *prefix);
+
+#endif /* AURC_PROFILE_H */
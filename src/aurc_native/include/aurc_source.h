@@ -0,0 +1,53 @@
+#ifndef AURC_SOURCE_H
+#define AURC_SOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Non-owning slice of source text; not NUL-terminated. */
+typedef struct aurc_view {
+    const char *data;
+    size_t len;
+} aurc_view;
+
+#define AURC_VIEW_NPOS SIZE_MAX
+
+/*
+ * Read-only view of a whole input file. The file is memory-mapped (mmap or
+ * MapViewOfFile) and scanned in place; files that cannot be mapped, such as
+ * pipes, fall back to a single heap read.
+ */
+typedef struct aurc_source {
+    const char *path;
+    aurc_view text;
+    void *base;          /* mapping or heap block backing text */
+    size_t size;
+    int mapped;
+} aurc_source;
+
+int aurc_source_open(aurc_source *src, const char *path);
+void aurc_source_close(aurc_source *src);
+
+aurc_view aurc_view_of(const char *cstr);
+aurc_view aurc_view_trim(aurc_view view);
+aurc_view aurc_view_skip_space(aurc_view view);
+aurc_view aurc_view_drop(aurc_view view, size_t count);
+aurc_view aurc_view_take(aurc_view view, size_t count);
+int aurc_view_eq(aurc_view view, const char *literal);
+int aurc_view_equal(aurc_view a, aurc_view b);
+int aurc_view_starts_with(aurc_view view, const char *prefix);
+size_t aurc_view_find(aurc_view view, const char *needle);
+size_t aurc_view_find_char(aurc_view view, char c);
+size_t aurc_view_rfind_char(aurc_view view, char c);
+
+/* Splits the next line off *rest (without its "\n" or "\r\n"); returns 0 once rest is empty. */
+int aurc_view_next_line(aurc_view *rest, aurc_view *line);
+
+/* Parses a whole view as a decimal or 0x-prefixed integer; fails on any trailing text. */
+int aurc_view_parse_int(aurc_view view, long long *value);
+int aurc_view_parse_u64(aurc_view view, uint64_t *value);
+
+/* Copies view into dst as a C string; fails if it does not fit. */
+int aurc_view_copy(aurc_view view, char *dst, size_t cap);
+
+#endif /* AURC_SOURCE_H */
@@ -0,0 +1,31 @@
+#ifndef AURC_STATS_H
+#define AURC_STATS_H
+
+#include <stdint.h>
+
+#include "aurc_native.h"
+
+/*
+ * Phase timing for aurc_compile_stats. A phase is measured between two clock
+ * samples: monotonic wall time (clock_gettime / QueryPerformanceCounter) and
+ * the calling thread's CPU time (CLOCK_THREAD_CPUTIME_ID / GetThreadTimes),
+ * so worker threads in compile-many each see their own compile.
+ */
+
+typedef struct aurc_clock_sample {
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+} aurc_clock_sample;
+
+void aurc_clock_sample_now(aurc_clock_sample *sample);
+/* Adds the time since start to phase and restarts start from now. */
+void aurc_stats_lap(aurc_compile_stats *stats, aurc_phase phase, aurc_clock_sample *start);
+
+const char *aurc_phase_name(aurc_phase phase);
+
+/* Prints the --time-report table for input through aurc_diag_printf. */
+void aurc_stats_report(const aurc_compile_stats *stats, const char *input);
+/* Writes stats as one JSON object to path; reports and returns 1 on I/O errors. */
+int aurc_stats_write_json(const aurc_compile_stats *stats, const char *input, const char *path);
+
+#endif /* AURC_STATS_H */
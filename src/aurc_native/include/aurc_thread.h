@@ -0,0 +1,101 @@
+#ifndef AURC_THREAD_H
+#define AURC_THREAD_H
+
+/*
+ * Minimal threading layer over Win32 threads and pthreads: enough for the
+ * batch compile pool and the VM scheduler. Every call reports failure as a
+ * non-zero return.
+ */
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AURC_THREAD_LOCAL __declspec(thread)
+#else
+#define AURC_THREAD_LOCAL _Thread_local
+#endif
+
+typedef int (*aurc_thread_fn)(void *arg);
+
+typedef struct aurc_thread {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    aurc_thread_fn fn;
+    void *arg;
+    int result;
+} aurc_thread;
+
+typedef struct aurc_mutex {
+#ifdef _WIN32
+    CRITICAL_SECTION cs;
+#else
+    pthread_mutex_t mutex;
+#endif
+} aurc_mutex;
+
+typedef struct aurc_cond {
+#ifdef _WIN32
+    CONDITION_VARIABLE cv;
+#else
+    pthread_cond_t cv;
+#endif
+} aurc_cond;
+
+/* thread must stay valid until aurc_thread_join returns. */
+int aurc_thread_start(aurc_thread *thread, aurc_thread_fn fn, void *arg);
+/* Waits for the thread; *result (optional) receives fn's return value. */
+int aurc_thread_join(aurc_thread *thread, int *result);
+
+int aurc_mutex_init(aurc_mutex *mutex);
+void aurc_mutex_destroy(aurc_mutex *mutex);
+void aurc_mutex_lock(aurc_mutex *mutex);
+void aurc_mutex_unlock(aurc_mutex *mutex);
+
+int aurc_cond_init(aurc_cond *cond);
+void aurc_cond_destroy(aurc_cond *cond);
+/* mutex must be held; it is released while waiting and re-acquired before returning. */
+void aurc_cond_wait(aurc_cond *cond, aurc_mutex *mutex);
+void aurc_cond_signal(aurc_cond *cond);
+void aurc_cond_broadcast(aurc_cond *cond);
+
+/* Sequentially consistent 64-bit atomics on naturally aligned words. */
+#if defined(_MSC_VER) && !defined(__clang__)
+static inline int64_t aurc_atomic_load64(volatile int64_t *p) {
+    return InterlockedCompareExchange64((volatile LONG64 *)p, 0, 0);
+}
+static inline void aurc_atomic_store64(volatile int64_t *p, int64_t value) {
+    InterlockedExchange64((volatile LONG64 *)p, value);
+}
+/* Returns the value before the addition. */
+static inline int64_t aurc_atomic_add64(volatile int64_t *p, int64_t value) {
+    return InterlockedExchangeAdd64((volatile LONG64 *)p, value);
+}
+#else
+static inline int64_t aurc_atomic_load64(volatile int64_t *p) {
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+static inline void aurc_atomic_store64(volatile int64_t *p, int64_t value) {
+    __atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+}
+/* Returns the value before the addition. */
+static inline int64_t aurc_atomic_add64(volatile int64_t *p, int64_t value) {
+    return __atomic_fetch_add(p, value, __ATOMIC_SEQ_CST);
+}
+#endif
+
+/* Number of online processors, at least 1. */
+unsigned aurc_cpu_count(void);
+
+/* Suspends the calling thread for at least us microseconds (milliseconds on Windows). */
+void aurc_sleep_us(unsigned us);
+
+#endif /* AURC_THREAD_H */
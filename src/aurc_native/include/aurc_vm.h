@@ -0,0 +1,140 @@
+#ifndef AURC_VM_H
+#define AURC_VM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aurc_isa.h"
+
+/*
+ * Stage N1 virtual machine for assembled Minimal ISA images.
+ *
+ * Images address a flat arena (specs/aurora_minimal_isa.md §2) of
+ * AURC_VM_ARENA_SIZE bytes, of which only the image and the stacks in use are
+ * backed by memory: the image from address 0 and each task's stack down from
+ * the top. A stack starts at AURC_VM_TASK_STACK bytes and doubles whenever an
+ * access lands below it, until it would reach the image, so deep recursion
+ * needs no bigger arena. A container image (aurc_image.h) is used in place:
+ * code and rodata are read straight from the loaded file at [0, rom_size),
+ * which the VM never writes, and only its shared section is copied into the
+ * arena. A bare image, as older assemblers wrote, is copied to address 0 of
+ * the arena as a whole. Either way the code is decoded once at load into the
+ * ops the interpreter dispatches (vm.c). sp is register 8, so frames are set
+ * up with plain `sub sp, sp, #n` and addressed with load_stack / store_stack.
+ * Label operands (sentinel 0xFE) carry the absolute arena address of their
+ * target in imm32, as written by the manifest assembler.
+ *
+ * `spawn` starts a task: a register file and pc of its own, with r1-r7 copied
+ * from the spawner so arguments travel as they do for `call`; `join` leaves
+ * the task's return value (its r0 at the final ret) in r0. Every task has a
+ * private stack seen at the same addresses, ending at the arena top; only the
+ * image and its shared slots are common to every task. Stacks and bignum
+ * limbs come from the VM's size-class pool (aurc_pool.h), through a cache per
+ * worker. Tasks run on a fixed pool of worker threads (one per processor, the
+ * calling thread included) started at the first spawn; see vm.c for the
+ * scheduler. The arena is cache-line aligned on the host, so each shared slot
+ * (ISA_SHARED_STRIDE bytes, aligned in the image) sits on a host cache line
+ * of its own.
+ *
+ * The bignum service (ISA_SERVICE_BIGNUM) keeps its numbers in a table
+ * outside the arena that lives for one run; programs hold them by handle, an
+ * int that is 0 for no number. Numbers are immutable once made, so tasks may
+ * share handles freely.
+ *
+ * Print services (write to stdout, print_int, bignum print) append to a
+ * buffer of the task's own, which goes out when it fills, when the program
+ * asks (ISA_SERVICE_FLUSH), and before the task spawns, joins, reads input,
+ * writes to stderr, faults or finishes. One task's output therefore keeps its
+ * order and lands in one piece between those points, and what a task printed
+ * before a spawn or join comes out before anything the other side prints
+ * after it. At the end of a run main's buffer is written first, then those of
+ * tasks the stop cut short, in spawn order.
+ */
+
+#define AURC_VM_ARENA_SIZE 0x1000000u
+#define AURC_VM_TASK_STACK 0x4000u
+#define AURC_VM_MAIN_TASK 0u
+
+typedef enum aurc_vm_task_state {
+    AURC_VM_TASK_RUNNABLE = 0,
+    AURC_VM_TASK_BLOCKED,          /* parked in join until its target finishes */
+    AURC_VM_TASK_DONE
+} aurc_vm_task_state;
+
+typedef struct aurc_vm_task {
+    uint64_t regs[ISA_REGISTER_COUNT + 1];  /* r0-r7, then sp */
+    uint32_t pc;
+    int compare;          /* sign of (lhs - rhs) from the last cmp */
+    aurc_vm_task_state state;
+    uint8_t *stack;       /* backs [stack_low, AURC_VM_ARENA_SIZE) */
+    uint32_t stack_low;
+    uint32_t waiters;     /* first task joined on this one, AURC_VM_NO_TASK if none */
+    uint32_t next_waiter;
+    uint8_t *out;         /* stdout bytes collected by print services, NULL until the first */
+    uint32_t out_len;
+} aurc_vm_task;
+
+#define AURC_VM_NO_TASK UINT32_MAX
+
+typedef struct aurc_vm_sched aurc_vm_sched;
+typedef struct aurc_vm_bignums aurc_vm_bignums;
+typedef struct aurc_vm_op aurc_vm_op;
+typedef struct aurc_vm_jit aurc_vm_jit;
+typedef struct aurc_profile aurc_profile;
+typedef struct aurc_vm_heap aurc_vm_heap;
+
+typedef struct aurc_vm {
+    uint32_t image_size;  /* arena bytes the image occupies; stacks start above */
+    const uint8_t *rom;   /* addresses [0, rom_size): the mapped file, or the arena for bare images */
+    uint32_t rom_size;
+    uint32_t code_size;   /* pc stays below this */
+    uint32_t shared_low;  /* atomics address [shared_low, image_size) */
+    const uint8_t *symbols; /* a container's raw symbol section, NULL when it has none */
+    uint32_t symbols_size;
+    aurc_vm_op *ops;      /* the code decoded at load, one op per word, then an end marker */
+    uint32_t op_count;
+    uint64_t *pair_counts; /* set before aurc_vm_run to count executed op pairs per worker (vm.c) */
+    aurc_vm_jit *jit;     /* set before aurc_vm_run to compile hot loops (vm.c) */
+    aurc_profile *profile; /* set before aurc_vm_run to profile it (aurc_profile.h) */
+    int64_t stopped;      /* atomic: set once by halt, exit, a fault or the main task's last ret */
+    int exit_status;
+    int faulted;
+    unsigned worker_limit; /* 0: one worker per processor */
+    aurc_vm_task main;
+    aurc_vm_sched *sched; /* NULL until the first spawn */
+    aurc_vm_bignums *bignums; /* bignum service table, for the length of aurc_vm_run */
+    aurc_vm_heap *heap;   /* stacks and bignum limbs, from load to unload */
+    uint8_t *arena;       /* backs [0, image_size), cache-line aligned */
+    void *arena_block;
+} aurc_vm;
+
+/*
+ * Loads a container or bare image into a zeroed or unloaded vm and decodes
+ * its code; a container's code stays in image, which must outlive the run.
+ * path only names the image in diagnostics.
+ */
+int aurc_vm_load(aurc_vm *vm, const uint8_t *image, size_t size, const char *path);
+/* Runs until the program stops; returns 1 if any task faulted. */
+int aurc_vm_run(aurc_vm *vm);
+/*
+ * Makes aurc_vm_run count, per pair of ops that follow each other in the
+ * code, how often the second ran right after the first (`run
+ * --pair-profile`). Superinstructions and the JIT are off while counting.
+ */
+int aurc_vm_profile_pairs(aurc_vm *vm);
+/*
+ * Makes aurc_vm_run record an execution profile in vm->profile (`run
+ * --profile`); superinstructions and the JIT are off meanwhile.
+ */
+int aurc_vm_profile(aurc_vm *vm);
+/*
+ * Makes aurc_vm_run compile loops that keep jumping back to the same head
+ * to x86-64 (aurc_jit.h). Does nothing on hosts the JIT cannot target.
+ */
+int aurc_vm_enable_jit(aurc_vm *vm);
+/* Prints the most frequent pairs counted by a profiled run to stderr. */
+void aurc_vm_report_pairs(const aurc_vm *vm, unsigned top);
+/* Frees what aurc_vm_load and the profiling and JIT set-up calls allocated. */
+void aurc_vm_unload(aurc_vm *vm);
+
+#endif /* AURC_VM_H */
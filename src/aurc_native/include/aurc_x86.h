@@ -0,0 +1,208 @@
+#ifndef AURC_X86_H
+#define AURC_X86_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aurc_bytes.h"
+
+/*
+ * In-process x86-64 encoder. Code and data are accumulated in separate
+ * buffers; references across sections (RIP-relative data loads, import slot
+ * calls) are recorded as fixups and patched by the container writer once the
+ * section addresses are known (see aurc_x86_link).
+ */
+
+typedef enum x86_reg {
+    X86_RAX = 0,
+    X86_RCX = 1,
+    X86_RDX = 2,
+    X86_RBX = 3,
+    X86_RSP = 4,
+    X86_RBP = 5,
+    X86_RSI = 6,
+    X86_RDI = 7,
+    X86_R8 = 8,
+    X86_R9 = 9,
+    X86_R10 = 10,
+    X86_R11 = 11,
+    X86_R12 = 12,
+    X86_R13 = 13,
+    X86_R14 = 14,
+    X86_R15 = 15
+} x86_reg;
+
+/* Low nibble of the Jcc opcode (0x0F 0x80+cc). */
+typedef enum x86_cond {
+    X86_CC_B = 0x2,      /* unsigned below */
+    X86_CC_AE = 0x3,
+    X86_CC_E = 0x4,
+    X86_CC_NE = 0x5,
+    X86_CC_BE = 0x6,
+    X86_CC_A = 0x7,      /* unsigned above */
+    X86_CC_S = 0x8,
+    X86_CC_NS = 0x9,
+    X86_CC_L = 0xC,
+    X86_CC_GE = 0xD,
+    X86_CC_LE = 0xE,
+    X86_CC_G = 0xF
+} x86_cond;
+
+/* ModR/M /digit of the 0x81/0x83 group and the matching reg-reg opcode. */
+typedef enum x86_alu_op {
+    X86_ALU_ADD = 0,
+    X86_ALU_OR = 1,
+    X86_ALU_AND = 4,
+    X86_ALU_SUB = 5,
+    X86_ALU_XOR = 6,
+    X86_ALU_CMP = 7
+} x86_alu_op;
+
+/* ModR/M /digit of the 0xF7 group (one-operand arithmetic on r64). */
+typedef enum x86_unary_op {
+    X86_UNARY_NOT = 2,
+    X86_UNARY_NEG = 3,
+    X86_UNARY_DIV = 6,   /* unsigned rdx:rax / r64 */
+    X86_UNARY_IDIV = 7   /* signed rdx:rax / r64 */
+} x86_unary_op;
+
+/* ModR/M /digit of the 0xD3 / 0xC1 groups (shift r64 by cl or by an immediate). */
+typedef enum x86_shift_op {
+    X86_SHIFT_SHL = 4,
+    X86_SHIFT_SHR = 5,
+    X86_SHIFT_SAR = 7
+} x86_shift_op;
+
+/*
+ * Packed integer instructions on xmm/ymm registers 0-15 take an encoding
+ * mode: legacy SSE2 forms are two-operand (dst must be lhs) and 128 bits
+ * wide; VEX forms are three-operand, 128 bits (AVX) or 256 bits (AVX2).
+ */
+typedef enum x86_vec_mode {
+    X86_VEC_SSE = 0,
+    X86_VEC_VEX128,
+    X86_VEC_VEX256
+} x86_vec_mode;
+
+/* Opcode byte after 66 0F. */
+typedef enum x86_vec_op {
+    X86_VEC_PUNPCKLQDQ = 0x6C,
+    X86_VEC_PCMPEQD = 0x76,
+    X86_VEC_PADDQ = 0xD4,
+    X86_VEC_PAND = 0xDB,
+    X86_VEC_PMULUDQ = 0xF4,   /* low 32 bits of each 64-bit lane, full 64-bit product */
+    X86_VEC_POR = 0xEB,
+    X86_VEC_PXOR = 0xEF,
+    X86_VEC_PSUBQ = 0xFB
+} x86_vec_op;
+
+/* ModR/M /digit of the 66 0F 73 group (64-bit lane shifts by an immediate). */
+typedef enum x86_vec_shift {
+    X86_VEC_PSRLQ = 2,
+    X86_VEC_PSLLQ = 6
+} x86_vec_shift;
+
+/* kernel32.dll imports available to PE64 images. */
+typedef enum aurc_import {
+    AURC_IMPORT_EXIT_PROCESS = 0,
+    AURC_IMPORT_GET_STD_HANDLE,
+    AURC_IMPORT_WRITE_FILE,
+    AURC_IMPORT_COUNT
+} aurc_import;
+
+typedef enum x86_fixup_kind {
+    X86_FIXUP_LABEL,   /* rel32 to a code label */
+    X86_FIXUP_DATA,    /* rel32 (RIP-relative) to a data-section offset */
+    X86_FIXUP_IMPORT   /* rel32 (RIP-relative) to an import address slot */
+} x86_fixup_kind;
+
+typedef struct x86_fixup {
+    size_t offset;       /* position of the rel32 field in code */
+    uint32_t target;     /* label id, data offset or aurc_import */
+    uint8_t trailing;    /* instruction bytes following the rel32 field */
+    x86_fixup_kind kind;
+} x86_fixup;
+
+#define X86_LABEL_UNBOUND SIZE_MAX
+
+typedef struct aurc_x86_asm {
+    aurc_bytes code;
+    aurc_bytes data;
+    size_t *labels;
+    size_t label_count;
+    size_t label_cap;
+    x86_fixup *fixups;
+    size_t fixup_count;
+    size_t fixup_cap;
+    int failed;          /* sticky: set when any emission ran out of memory */
+} aurc_x86_asm;
+
+void aurc_x86_init(aurc_x86_asm *as);
+void aurc_x86_free(aurc_x86_asm *as);
+
+uint32_t x86_new_label(aurc_x86_asm *as);
+void x86_bind_label(aurc_x86_asm *as, uint32_t label);
+uint32_t x86_add_data(aurc_x86_asm *as, const void *bytes, size_t len);
+
+void x86_mov_reg_imm(aurc_x86_asm *as, x86_reg dst, int64_t value);
+void x86_mov_reg_reg(aurc_x86_asm *as, x86_reg dst, x86_reg src);
+void x86_alu_reg_reg(aurc_x86_asm *as, x86_alu_op op, x86_reg dst, x86_reg src);
+void x86_alu_reg_imm(aurc_x86_asm *as, x86_alu_op op, x86_reg dst, int32_t imm);
+void x86_imul_reg_reg(aurc_x86_asm *as, x86_reg dst, x86_reg src);
+void x86_test_reg_reg(aurc_x86_asm *as, x86_reg lhs, x86_reg rhs);
+void x86_unary(aurc_x86_asm *as, x86_unary_op op, x86_reg reg);
+void x86_shift_cl(aurc_x86_asm *as, x86_shift_op op, x86_reg reg);
+void x86_shift_imm(aurc_x86_asm *as, x86_shift_op op, x86_reg reg, uint8_t count);
+void x86_cqo(aurc_x86_asm *as);
+/* setcc on the low byte of reg; the upper bits are left untouched. */
+void x86_setcc(aurc_x86_asm *as, x86_cond cond, x86_reg reg);
+void x86_push(aurc_x86_asm *as, x86_reg reg);
+void x86_pop(aurc_x86_asm *as, x86_reg reg);
+/* 64-bit loads and stores at [base + disp]. */
+void x86_mov_reg_mem(aurc_x86_asm *as, x86_reg dst, x86_reg base, int32_t disp);
+void x86_mov_mem_reg(aurc_x86_asm *as, x86_reg base, int32_t disp, x86_reg src);
+void x86_mov_mem_imm(aurc_x86_asm *as, x86_reg base, int32_t disp, int32_t imm);
+void x86_mov_mem8_reg(aurc_x86_asm *as, x86_reg base, int32_t disp, x86_reg src);
+void x86_mov_mem8_imm(aurc_x86_asm *as, x86_reg base, int32_t disp, uint8_t imm);
+void x86_lock_add_mem_reg(aurc_x86_asm *as, x86_reg base, int32_t disp, x86_reg src);
+void x86_xchg_mem_reg(aurc_x86_asm *as, x86_reg base, int32_t disp, x86_reg reg);
+void x86_lea_mem(aurc_x86_asm *as, x86_reg dst, x86_reg base, int32_t disp);
+void x86_lea_data(aurc_x86_asm *as, x86_reg dst, uint32_t data_offset);
+void x86_lea_rsp(aurc_x86_asm *as, x86_reg dst, int8_t disp);
+void x86_mov_rsp_imm(aurc_x86_asm *as, int8_t disp, int32_t imm);
+void x86_jmp(aurc_x86_asm *as, uint32_t label);
+void x86_jcc(aurc_x86_asm *as, x86_cond cond, uint32_t label);
+void x86_call(aurc_x86_asm *as, uint32_t label);
+void x86_call_import(aurc_x86_asm *as, aurc_import import);
+void x86_ret(aurc_x86_asm *as);
+/* Linux x86-64: number in rax, arguments in rdi, rsi, rdx; clobbers rcx and r11. */
+void x86_syscall(aurc_x86_asm *as);
+
+void x86_vec_alu(aurc_x86_asm *as, x86_vec_mode mode, x86_vec_op op, unsigned dst, unsigned lhs, unsigned rhs);
+void x86_vec_shift_imm(aurc_x86_asm *as, x86_vec_mode mode, x86_vec_shift op, unsigned dst, unsigned src, uint8_t count);
+void x86_vec_mov(aurc_x86_asm *as, x86_vec_mode mode, unsigned dst, unsigned src);
+/* Unaligned load of a whole vector from [base + disp]. */
+void x86_vec_load(aurc_x86_asm *as, x86_vec_mode mode, unsigned dst, x86_reg base, int32_t disp);
+/* pshufd: 32-bit lanes of src picked by the four 2-bit fields of order. */
+void x86_vec_shuffle32(aurc_x86_asm *as, x86_vec_mode mode, unsigned dst, unsigned src, uint8_t order);
+/* movq between a general register and lane 0 (the other lanes become zero); mode is SSE or VEX128. */
+void x86_vec_from_reg(aurc_x86_asm *as, x86_vec_mode mode, unsigned dst, x86_reg src);
+void x86_vec_to_reg(aurc_x86_asm *as, x86_vec_mode mode, x86_reg dst, unsigned src);
+/* AVX2 only: vpbroadcastq ymm, xmm and vextracti128 xmm, ymm, 1. */
+void x86_vec_broadcast(aurc_x86_asm *as, unsigned dst, unsigned src);
+void x86_vec_extract_high(aurc_x86_asm *as, unsigned dst, unsigned src);
+void x86_vzeroupper(aurc_x86_asm *as);
+
+/*
+ * Patches every fixup. code_base/data_base are the load addresses (or RVAs)
+ * of the two sections and import_slots[i] the address of import i's slot,
+ * all relative to the same origin. Fails on unbound labels.
+ */
+int aurc_x86_link(aurc_x86_asm *as, uint64_t code_base, uint64_t data_base, const uint64_t *import_slots);
+
+/* Writes a console PE32+ image (kernel32 imports) for the assembled program; *size (if non-NULL) gets the file size. */
+int aurc_write_pe64(aurc_x86_asm *as, const char *path, size_t *size);
+/* Writes a static Linux ELF64 executable (no imports, no interpreter) for the assembled program, marked executable. */
+int aurc_write_elf64(aurc_x86_asm *as, const char *path, size_t *size);
+
+#endif /* AURC_X86_H */
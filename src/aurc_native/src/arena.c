@@ -0,0 +1,137 @@
+#include "aurc_arena.h"
+#include "aurc_diag.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_CHUNK (64u * 1024u)
+#define ARENA_ALIGN alignof(max_align_t)
+
+struct aurc_arena_chunk {
+    aurc_arena_chunk *next;
+    size_t used;
+    size_t cap;
+    alignas(max_align_t) unsigned char data[];
+};
+
+void aurc_arena_init(aurc_arena *arena) {
+    arena->head = NULL;
+    arena->spare = NULL;
+    arena->chunk_size = ARENA_DEFAULT_CHUNK;
+    arena->allocated = 0;
+}
+
+static void free_chunks(aurc_arena_chunk *chunk) {
+    while (chunk) {
+        aurc_arena_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+void aurc_arena_free(aurc_arena *arena) {
+    free_chunks(arena->head);
+    free_chunks(arena->spare);
+    aurc_arena_init(arena);
+}
+
+void aurc_arena_reset(aurc_arena *arena) {
+    aurc_arena_chunk *chunk = arena->head;
+    while (chunk) {
+        aurc_arena_chunk *next = chunk->next;
+        if (chunk->cap == arena->chunk_size) {
+            chunk->used = 0;
+            chunk->next = arena->spare;
+            arena->spare = chunk;
+        } else {
+            free(chunk);
+        }
+        chunk = next;
+    }
+    arena->head = NULL;
+    arena->allocated = 0;
+}
+
+static aurc_arena_chunk *new_chunk(size_t cap) {
+    if (cap > SIZE_MAX - sizeof(aurc_arena_chunk)) {
+        return NULL;
+    }
+    aurc_arena_chunk *chunk = malloc(sizeof(aurc_arena_chunk) + cap);
+    if (!chunk) {
+        return NULL;
+    }
+    chunk->next = NULL;
+    chunk->used = 0;
+    chunk->cap = cap;
+    return chunk;
+}
+
+void *aurc_arena_alloc(aurc_arena *arena, size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    size_t rounded = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (rounded < size) {
+        aurc_diag_printf("aurc-native: arena allocation size overflow\n");
+        return NULL;
+    }
+
+    aurc_arena_chunk *chunk = arena->head;
+    if (!chunk || chunk->cap - chunk->used < rounded) {
+        if (rounded > arena->chunk_size / 4) {
+            /* oversized blocks get a private chunk behind the current one so its tail stays usable */
+            aurc_arena_chunk *big = new_chunk(rounded);
+            if (!big) {
+                aurc_diag_printf("aurc-native: out of memory allocating %zu arena bytes\n", size);
+                return NULL;
+            }
+            big->used = rounded;
+            if (chunk) {
+                big->next = chunk->next;
+                chunk->next = big;
+            } else {
+                arena->head = big;
+            }
+            arena->allocated += rounded;
+            return big->data;
+        }
+        if (arena->spare) {
+            chunk = arena->spare;
+            arena->spare = chunk->next;
+        } else {
+            chunk = new_chunk(arena->chunk_size);
+        }
+        if (!chunk) {
+            aurc_diag_printf("aurc-native: out of memory allocating %zu arena bytes\n", size);
+            return NULL;
+        }
+        chunk->next = arena->head;
+        arena->head = chunk;
+    }
+
+    void *ptr = chunk->data + chunk->used;
+    chunk->used += rounded;
+    arena->allocated += rounded;
+    return ptr;
+}
+
+void *aurc_arena_zalloc(aurc_arena *arena, size_t size) {
+    void *ptr = aurc_arena_alloc(arena, size);
+    if (ptr) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+char *aurc_arena_strndup(aurc_arena *arena, const char *data, size_t len) {
+    char *copy = aurc_arena_alloc(arena, len + 1);
+    if (copy) {
+        memcpy(copy, data, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
@@ -0,0 +1,823 @@
+#include "aurc_native.h"
+#include "aurc_bytes.h"
+#include "aurc_diag.h"
+#include "aurc_image.h"
+#include "aurc_isa.h"
+#include "aurc_source.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Single-pass manifest assembler. The manifest is mapped and scanned in place;
+ * directives are decoded straight into an in-memory image that is written
+ * with one bulk write at the end. Label references are recorded as fixups
+ * during the pass and back-patched once every label is known:
+ *
+ *   - Minimal ISA words carrying the 0xFE label sentinel take the target
+ *     named in their trailing comment (`; jmp loop`, `; mov r1, #addr(msg)`)
+ *     and receive its absolute address in imm32.
+ *   - `ref name` reserves an 8-byte little-endian absolute address.
+ *   - atomic_load/atomic_store/atomic_add words name a `shared` slot by id
+ *     and receive the slot's absolute address in imm32 once the slots are
+ *     laid out, one cache line each, after the image; words naming a
+ *     `sharded` slot also get ISA_ATOMIC_SHARDED in op2.
+ *
+ * Sentinels are only interpreted in Minimal ISA sections (`header minimal_isa`
+ * or manifests without any header, as produced by the pipeline); other
+ * sections such as the seed interpreter's raw x86 blobs are copied verbatim.
+ *
+ * A manifest that is Minimal ISA throughout is written as an aurc_image.h
+ * container: code runs to the end of the last instruction word, rodata from
+ * there to the shared slots, and every label and patched address goes into
+ * the symbol and relocation sections. Manifests with any other section are
+ * written as the bare bytes they describe.
+ */
+
+#define ASM_NAME_MAX 128
+
+typedef enum asm_fixup_kind {
+    ASM_FIXUP_IMM32,   /* big-endian imm32 of the ISA word at offset */
+    ASM_FIXUP_REF64,   /* little-endian 64-bit address at offset */
+    ASM_FIXUP_SHARED   /* big-endian imm32 of the atomic word at offset, slot `shared_id` */
+} asm_fixup_kind;
+
+typedef struct asm_symbol {
+    size_t name;          /* offset into the name pool, 0 = empty slot */
+    size_t name_len;
+    uint64_t hash;
+    uint32_t address;
+} asm_symbol;
+
+typedef struct asm_fixup {
+    size_t offset;
+    size_t name;
+    size_t name_len;
+    unsigned line;
+    asm_fixup_kind kind;
+    uint64_t shared_id;
+} asm_fixup;
+
+typedef struct asm_shared {
+    size_t name;
+    size_t name_len;
+    uint64_t id;
+    uint64_t init;
+    int sharded;
+} asm_shared;
+
+typedef struct assembler {
+    const char *path;
+    aurc_view rest;         /* unread manifest text */
+    unsigned line;
+    aurc_bytes image;
+    size_t pos;             /* write cursor; org may move it anywhere */
+    uint64_t origin;        /* base for `label name <word index>` */
+    int isa_section;
+    int foreign_section;    /* some `header` other than minimal_isa: write a bare image */
+    size_t code_end;        /* end of the last instruction word */
+    aurc_bytes names;       /* NUL-terminated label names; offset 0 is reserved */
+    asm_symbol *symbols;    /* open-addressed, power-of-two capacity */
+    size_t symbol_count;
+    size_t symbol_cap;
+    asm_fixup *fixups;
+    size_t fixup_count;
+    size_t fixup_cap;
+    asm_shared *shared;
+    size_t shared_count;
+    size_t shared_cap;
+    size_t shared_base;     /* address of shared slot 0 after layout_shared */
+} assembler;
+
+static int asm_error(const assembler *as, const char *message) {
+    aurc_diag_printf("aurc-native: %s:%u: %s\n", as->path, as->line, message);
+    return 1;
+}
+
+static int is_name_char(int c) {
+    return isalnum(c) || c == '_' || c == '.' || c == '$';
+}
+
+static int at_line_end(aurc_view args) {
+    args = aurc_view_skip_space(args);
+    return args.len == 0 || args.data[0] == ';' || args.data[0] == '#';
+}
+
+/* Splits the leading identifier off *args. */
+static aurc_view take_name(aurc_view *args) {
+    aurc_view view = aurc_view_skip_space(*args);
+    size_t len = 0;
+    while (len < view.len && is_name_char((unsigned char)view.data[len])) {
+        ++len;
+    }
+    *args = aurc_view_drop(view, len);
+    return aurc_view_take(view, len);
+}
+
+/* Splits the next whitespace-delimited token (stopping at a comment) off *args. */
+static aurc_view take_token(aurc_view *args) {
+    aurc_view view = aurc_view_skip_space(*args);
+    size_t len = 0;
+    while (len < view.len && !isspace((unsigned char)view.data[len]) && view.data[len] != ';' && view.data[len] != '#') {
+        ++len;
+    }
+    *args = aurc_view_drop(view, len);
+    return aurc_view_take(view, len);
+}
+
+static uint64_t hash_name(aurc_view name) {
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < name.len; ++i) {
+        hash ^= (unsigned char)name.data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static int intern_name(assembler *as, aurc_view name, size_t *offset) {
+    if (name.len == 0 || name.len >= ASM_NAME_MAX) {
+        return asm_error(as, "label name is empty or too long");
+    }
+    if (as->names.len == 0 && aurc_bytes_append_u8(&as->names, 0) != 0) {
+        return 1;
+    }
+    *offset = as->names.len;
+    if (aurc_bytes_append(&as->names, name.data, name.len) != 0 || aurc_bytes_append_u8(&as->names, 0) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+static const char *name_at(const assembler *as, size_t offset) {
+    return (const char *)as->names.data + offset;
+}
+
+static asm_symbol *find_slot(asm_symbol *symbols, size_t cap, const aurc_bytes *names, aurc_view name, uint64_t hash) {
+    size_t mask = cap - 1;
+    for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+        asm_symbol *slot = &symbols[i];
+        if (slot->name == 0) {
+            return slot;
+        }
+        if (slot->hash == hash && slot->name_len == name.len && memcmp(names->data + slot->name, name.data, name.len) == 0) {
+            return slot;
+        }
+    }
+}
+
+static int grow_symbols(assembler *as) {
+    size_t cap = as->symbol_cap ? as->symbol_cap * 2 : 64;
+    asm_symbol *symbols = calloc(cap, sizeof *symbols);
+    if (!symbols) {
+        aurc_diag_printf("aurc-native: out of memory growing label table\n");
+        return 1;
+    }
+    for (size_t i = 0; i < as->symbol_cap; ++i) {
+        const asm_symbol *old = &as->symbols[i];
+        if (old->name != 0) {
+            aurc_view name = {name_at(as, old->name), old->name_len};
+            *find_slot(symbols, cap, &as->names, name, old->hash) = *old;
+        }
+    }
+    free(as->symbols);
+    as->symbols = symbols;
+    as->symbol_cap = cap;
+    return 0;
+}
+
+static const asm_symbol *lookup_symbol(const assembler *as, aurc_view name) {
+    if (as->symbol_cap == 0) {
+        return NULL;
+    }
+    const asm_symbol *slot = find_slot(as->symbols, as->symbol_cap, &as->names, name, hash_name(name));
+    return slot->name != 0 ? slot : NULL;
+}
+
+static int define_label(assembler *as, aurc_view name, uint64_t address) {
+    if (address > UINT32_MAX) {
+        return asm_error(as, "label address exceeds 32-bit range");
+    }
+    if ((as->symbol_count + 1) * 2 > as->symbol_cap && grow_symbols(as) != 0) {
+        return 1;
+    }
+    uint64_t hash = hash_name(name);
+    asm_symbol *slot = find_slot(as->symbols, as->symbol_cap, &as->names, name, hash);
+    if (slot->name != 0) {
+        aurc_diag_printf("aurc-native: %s:%u: duplicate label '%.*s'\n", as->path, as->line, (int)name.len, name.data);
+        return 1;
+    }
+    if (intern_name(as, name, &slot->name) != 0) {
+        return 1;
+    }
+    slot->name_len = name.len;
+    slot->hash = hash;
+    slot->address = (uint32_t)address;
+    as->symbol_count++;
+    return 0;
+}
+
+static asm_fixup *new_fixup(assembler *as, asm_fixup_kind kind, size_t offset) {
+    if (as->fixup_count == as->fixup_cap) {
+        size_t cap = as->fixup_cap ? as->fixup_cap * 2 : 64;
+        asm_fixup *fixups = realloc(as->fixups, cap * sizeof *fixups);
+        if (!fixups) {
+            aurc_diag_printf("aurc-native: out of memory growing fixup list\n");
+            return NULL;
+        }
+        as->fixups = fixups;
+        as->fixup_cap = cap;
+    }
+    asm_fixup *fixup = &as->fixups[as->fixup_count];
+    memset(fixup, 0, sizeof *fixup);
+    fixup->offset = offset;
+    fixup->line = as->line;
+    fixup->kind = kind;
+    return fixup;
+}
+
+static int add_fixup(assembler *as, asm_fixup_kind kind, size_t offset, aurc_view name) {
+    asm_fixup *fixup = new_fixup(as, kind, offset);
+    if (!fixup || intern_name(as, name, &fixup->name) != 0) {
+        return 1;
+    }
+    fixup->name_len = name.len;
+    as->fixup_count++;
+    return 0;
+}
+
+static int add_shared_fixup(assembler *as, size_t offset, uint64_t id) {
+    asm_fixup *fixup = new_fixup(as, ASM_FIXUP_SHARED, offset);
+    if (!fixup) {
+        return 1;
+    }
+    fixup->shared_id = id;
+    as->fixup_count++;
+    return 0;
+}
+
+static int extend_image(assembler *as, size_t end) {
+    if (end > as->image.len && aurc_bytes_append_zeros(&as->image, end - as->image.len) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+/* Returns a pointer to len writable bytes at the cursor, zero-extending the image as needed. */
+static uint8_t *claim(assembler *as, size_t len) {
+    size_t end = as->pos + len;
+    if (end < as->pos) {
+        asm_error(as, "image size overflow");
+        return NULL;
+    }
+    if (extend_image(as, end) != 0) {
+        return NULL;
+    }
+    uint8_t *dst = as->image.data + as->pos;
+    as->pos = end;
+    return dst;
+}
+
+static int hex_value(int c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return 10 + (c - 'a');
+    }
+    if (c >= 'A' && c <= 'F') {
+        return 10 + (c - 'A');
+    }
+    return -1;
+}
+
+/*
+ * Extracts the jump/label target from an instruction comment: `#addr(name)`,
+ * `@name`, or otherwise the last operand (`cjmp eq, exit`, `jmp loop`).
+ */
+static aurc_view comment_target(aurc_view comment) {
+    size_t end = aurc_view_find_char(comment, ';');
+    if (end != AURC_VIEW_NPOS) {
+        comment = aurc_view_take(comment, end);
+    }
+
+    size_t at = aurc_view_find(comment, "#addr(");
+    if (at != AURC_VIEW_NPOS) {
+        aurc_view rest = aurc_view_drop(comment, at + 6);
+        return take_name(&rest);
+    }
+    at = aurc_view_find_char(comment, '@');
+    if (at != AURC_VIEW_NPOS) {
+        aurc_view rest = aurc_view_drop(comment, at + 1);
+        return take_name(&rest);
+    }
+
+    aurc_view operand;
+    size_t comma = aurc_view_rfind_char(comment, ',');
+    if (comma != AURC_VIEW_NPOS) {
+        operand = aurc_view_drop(comment, comma + 1);
+    } else {
+        /* single-operand form: skip the mnemonic */
+        operand = comment;
+        take_token(&operand);
+    }
+    return take_name(&operand);
+}
+
+static int emit_hex_bytes(assembler *as, aurc_view args) {
+    aurc_view hex = take_token(&args);
+    if (!aurc_view_starts_with(hex, "0x") && !aurc_view_starts_with(hex, "0X")) {
+        return asm_error(as, "bytes directive missing 0x literal");
+    }
+    hex = aurc_view_drop(hex, 2);
+
+    size_t digits = 0;
+    for (size_t i = 0; i < hex.len; ++i) {
+        if (hex.data[i] == '_') {
+            continue;
+        }
+        if (hex_value((unsigned char)hex.data[i]) < 0) {
+            aurc_diag_printf("aurc-native: %s:%u: invalid hex digit '%c' in bytes directive\n", as->path, as->line, hex.data[i]);
+            return 1;
+        }
+        digits++;
+    }
+    if (digits == 0) {
+        return asm_error(as, "bytes directive did not contain any data");
+    }
+    if (digits & 1) {
+        return asm_error(as, "odd number of hex digits in bytes directive");
+    }
+
+    size_t start = as->pos;
+    uint8_t *dst = claim(as, digits / 2);
+    if (!dst) {
+        return 1;
+    }
+    int high = -1;
+    for (size_t i = 0; i < hex.len; ++i) {
+        if (hex.data[i] == '_') {
+            continue;
+        }
+        int v = hex_value((unsigned char)hex.data[i]);
+        if (high < 0) {
+            high = v;
+        } else {
+            *dst++ = (uint8_t)((high << 4) | v);
+            high = -1;
+        }
+    }
+
+    if (!as->isa_section || digits / 2 != ISA_WORD_SIZE) {
+        return 0;
+    }
+    if (as->pos > as->code_end) {
+        as->code_end = as->pos;
+    }
+    const uint8_t *word = as->image.data + start;
+    if (isa_is_atomic(word[0])) {
+        return add_shared_fixup(as, start, isa_atomic_slot(word[0], word[1], word[2]));
+    }
+    if (word[1] != ISA_OPERAND_LABEL && word[2] != ISA_OPERAND_LABEL && word[3] != ISA_OPERAND_LABEL) {
+        return 0;
+    }
+    aurc_view target = {NULL, 0};
+    size_t semi = aurc_view_find_char(args, ';');
+    if (semi != AURC_VIEW_NPOS) {
+        target = comment_target(aurc_view_drop(args, semi + 1));
+    }
+    if (target.len == 0) {
+        return asm_error(as, "label operand without a target name in its comment");
+    }
+    return add_fixup(as, ASM_FIXUP_IMM32, start, target);
+}
+
+static int emit_byte(assembler *as, uint8_t value) {
+    uint8_t *dst = claim(as, 1);
+    if (!dst) {
+        return 1;
+    }
+    *dst = value;
+    return 0;
+}
+
+/* Decodes a quoted literal; string literals may span lines and keep the newlines. */
+static int emit_quoted(assembler *as, aurc_view args, int multiline, int terminate) {
+    size_t open = aurc_view_find_char(args, '"');
+    if (open == AURC_VIEW_NPOS) {
+        return asm_error(as, "literal missing opening quote");
+    }
+    aurc_view p = aurc_view_drop(args, open + 1);
+    for (;;) {
+        while (p.len > 0 && p.data[0] != '"') {
+            uint8_t ch = (uint8_t)p.data[0];
+            if (ch == '\\') {
+                if (p.len < 2) {
+                    return asm_error(as, "incomplete escape sequence in literal");
+                }
+                p = aurc_view_drop(p, 1);
+                switch (p.data[0]) {
+                    case '\\': ch = '\\'; break;
+                    case '"': ch = '"'; break;
+                    case 'n': ch = '\n'; break;
+                    case 'r': ch = '\r'; break;
+                    case 't': ch = '\t'; break;
+                    case '0': ch = '\0'; break;
+                    default:
+                        aurc_diag_printf("aurc-native: %s:%u: unsupported escape sequence \\%c\n", as->path, as->line, p.data[0]);
+                        return 1;
+                }
+            }
+            if (emit_byte(as, ch) != 0) {
+                return 1;
+            }
+            p = aurc_view_drop(p, 1);
+        }
+        if (p.len > 0) {
+            break;
+        }
+        if (!multiline || !aurc_view_next_line(&as->rest, &p)) {
+            return asm_error(as, "literal missing closing quote");
+        }
+        as->line++;
+        if (emit_byte(as, '\n') != 0) {
+            return 1;
+        }
+    }
+    if (!at_line_end(aurc_view_drop(p, 1))) {
+        return asm_error(as, "unexpected text after literal");
+    }
+    return terminate ? emit_byte(as, 0) : 0;
+}
+
+static int parse_single_number(assembler *as, aurc_view args, const char *directive, uint64_t *value) {
+    aurc_view token = take_token(&args);
+    if (aurc_view_parse_u64(token, value) != 0 || !at_line_end(args)) {
+        aurc_diag_printf("aurc-native: %s:%u: %s directive has invalid value\n", as->path, as->line, directive);
+        return 1;
+    }
+    return 0;
+}
+
+static int emit_sized(assembler *as, aurc_view args, const char *directive, size_t size) {
+    uint64_t value;
+    if (parse_single_number(as, args, directive, &value) != 0) {
+        return 1;
+    }
+    if (size < 8 && value >> (size * 8) != 0) {
+        aurc_diag_printf("aurc-native: %s:%u: %s value 0x%llX does not fit\n", as->path, as->line, directive, (unsigned long long)value);
+        return 1;
+    }
+    uint8_t *dst = claim(as, size);
+    if (!dst) {
+        return 1;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        dst[i] = (uint8_t)(value >> (8 * i));
+    }
+    return 0;
+}
+
+static int handle_label(assembler *as, aurc_view args) {
+    aurc_view name = take_name(&args);
+    if (name.len == 0) {
+        return asm_error(as, "label directive missing name");
+    }
+    uint64_t address = as->pos;
+    if (!at_line_end(args)) {
+        /* pipeline form: `label name <instruction word index>` */
+        uint64_t index;
+        aurc_view token = take_token(&args);
+        if (aurc_view_parse_u64(token, &index) != 0 || !at_line_end(args)) {
+            return asm_error(as, "label directive has invalid word index");
+        }
+        address = as->origin + index * ISA_WORD_SIZE;
+    }
+    return define_label(as, name, address);
+}
+
+static int handle_ref(assembler *as, aurc_view args) {
+    aurc_view name = take_name(&args);
+    if (name.len == 0 || !at_line_end(args)) {
+        return asm_error(as, "ref directive expects a label name");
+    }
+    size_t offset = as->pos;
+    if (!claim(as, 8)) {
+        return 1;
+    }
+    return add_fixup(as, ASM_FIXUP_REF64, offset, name);
+}
+
+/* `shared <id> <name> <init> [sharded]`: slots are laid out after the image once the pass is done. */
+static int handle_shared(assembler *as, aurc_view args) {
+    asm_shared slot;
+    if (aurc_view_parse_u64(take_token(&args), &slot.id) != 0) {
+        return asm_error(as, "shared directive has invalid id");
+    }
+    aurc_view name = take_name(&args);
+    if (name.len == 0) {
+        return asm_error(as, "shared directive missing name");
+    }
+    long long init;
+    if (aurc_view_parse_int(take_token(&args), &init) != 0) {
+        return asm_error(as, "shared directive has invalid initial value");
+    }
+    slot.init = (uint64_t)init;
+    slot.sharded = 0;
+    if (!at_line_end(args)) {
+        if (!aurc_view_eq(take_token(&args), "sharded") || !at_line_end(args)) {
+            return asm_error(as, "shared directive has trailing text");
+        }
+        slot.sharded = 1;
+    }
+    for (size_t i = 0; i < as->shared_count; ++i) {
+        if (as->shared[i].id == slot.id) {
+            return asm_error(as, "duplicate shared id");
+        }
+    }
+    if (as->shared_count == as->shared_cap) {
+        size_t cap = as->shared_cap ? as->shared_cap * 2 : 8;
+        asm_shared *shared = realloc(as->shared, cap * sizeof *shared);
+        if (!shared) {
+            aurc_diag_printf("aurc-native: out of memory growing shared table\n");
+            return 1;
+        }
+        as->shared = shared;
+        as->shared_cap = cap;
+    }
+    if (intern_name(as, name, &slot.name) != 0) {
+        return 1;
+    }
+    slot.name_len = name.len;
+    as->shared[as->shared_count++] = slot;
+    return 0;
+}
+
+static int layout_shared(assembler *as) {
+    if (as->shared_count == 0) {
+        return 0;
+    }
+    /* one line-aligned slot per id, appended after everything else */
+    as->pos = (as->image.len + ISA_SHARED_STRIDE - 1) & ~(size_t)(ISA_SHARED_STRIDE - 1);
+    uint64_t slots = 0;
+    for (size_t i = 0; i < as->shared_count; ++i) {
+        if (as->shared[i].id >= slots) {
+            slots = as->shared[i].id + 1;
+        }
+    }
+    if (slots > 0x10000) {
+        return asm_error(as, "shared id out of range");
+    }
+    size_t base = as->pos;
+    as->shared_base = base;
+    uint8_t *dst = claim(as, (size_t)slots * ISA_SHARED_STRIDE);
+    if (!dst) {
+        return 1;
+    }
+    for (size_t i = 0; i < as->shared_count; ++i) {
+        const asm_shared *slot = &as->shared[i];
+        for (int b = 0; b < 8; ++b) {
+            dst[slot->id * ISA_SHARED_STRIDE + (uint64_t)b] = (uint8_t)(slot->init >> (8 * b));
+        }
+        aurc_view name = {name_at(as, slot->name), slot->name_len};
+        if (define_label(as, name, base + slot->id * ISA_SHARED_STRIDE) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int resolve_shared(const assembler *as, const asm_fixup *fixup) {
+    for (size_t i = 0; i < as->shared_count; ++i) {
+        if (as->shared[i].id == fixup->shared_id) {
+            /* layout_shared already rejected slot labels beyond 32 bits */
+            uint64_t address = as->shared_base + fixup->shared_id * ISA_SHARED_STRIDE;
+            uint8_t *dst = as->image.data + fixup->offset;
+            if (as->shared[i].sharded) {
+                if (dst[0] == ISA_OPCODE_ATOMIC_STORE) {
+                    aurc_diag_printf("aurc-native: %s:%u: atomic_store to sharded shared slot %llu\n", as->path,
+                                     fixup->line, (unsigned long long)fixup->shared_id);
+                    return 1;
+                }
+                dst[3] |= ISA_ATOMIC_SHARDED;
+            }
+            for (int b = 0; b < 4; ++b) {
+                dst[4 + b] = (uint8_t)(address >> (8 * (3 - b)));
+            }
+            return 0;
+        }
+    }
+    aurc_diag_printf("aurc-native: %s:%u: atomic access to undeclared shared slot %llu\n", as->path, fixup->line,
+                     (unsigned long long)fixup->shared_id);
+    return 1;
+}
+
+static int resolve_fixups(assembler *as) {
+    int rc = 0;
+    for (size_t i = 0; i < as->fixup_count; ++i) {
+        const asm_fixup *fixup = &as->fixups[i];
+        if (fixup->kind == ASM_FIXUP_SHARED) {
+            if (resolve_shared(as, fixup) != 0) {
+                rc = 1;
+            }
+            continue;
+        }
+        aurc_view name = {name_at(as, fixup->name), fixup->name_len};
+        const asm_symbol *symbol = lookup_symbol(as, name);
+        if (!symbol && fixup->kind == ASM_FIXUP_IMM32) {
+            /* pipeline spawn comments name the function, its label carries the fn_ prefix */
+            char prefixed[ASM_NAME_MAX + 3];
+            int len = snprintf(prefixed, sizeof prefixed, "fn_%s", name.data);
+            aurc_view alias = {prefixed, (size_t)len};
+            symbol = lookup_symbol(as, alias);
+        }
+        if (!symbol) {
+            aurc_diag_printf("aurc-native: %s:%u: undefined label '%s'\n", as->path, fixup->line, name.data);
+            rc = 1;
+            continue;
+        }
+        uint8_t *dst = as->image.data + fixup->offset;
+        if (fixup->kind == ASM_FIXUP_IMM32) {
+            for (int b = 0; b < 4; ++b) {
+                dst[4 + b] = (uint8_t)(symbol->address >> (8 * (3 - b)));
+            }
+        } else {
+            for (int b = 0; b < 8; ++b) {
+                dst[b] = (uint8_t)((uint64_t)symbol->address >> (8 * b));
+            }
+        }
+    }
+    return rc;
+}
+
+static int assemble_line(assembler *as, aurc_view line) {
+    aurc_view args = aurc_view_skip_space(line);
+    if (at_line_end(args)) {
+        return 0;
+    }
+    aurc_view directive = take_token(&args);
+#define IS(word) aurc_view_eq(directive, word)
+
+    if (IS("bytes")) {
+        return emit_hex_bytes(as, args);
+    }
+    if (IS("label")) {
+        return handle_label(as, args);
+    }
+    if (IS("u8")) {
+        return emit_sized(as, args, "u8", 1);
+    }
+    if (IS("u16")) {
+        return emit_sized(as, args, "u16", 2);
+    }
+    if (IS("u32")) {
+        return emit_sized(as, args, "u32", 4);
+    }
+    if (IS("u64")) {
+        return emit_sized(as, args, "u64", 8);
+    }
+    if (IS("ref")) {
+        return handle_ref(as, args);
+    }
+    if (IS("ascii")) {
+        return emit_quoted(as, args, 0, 0);
+    }
+    if (IS("string")) {
+        return emit_quoted(as, args, 1, 1);
+    }
+    if (IS("pad")) {
+        uint64_t count;
+        if (parse_single_number(as, args, "pad", &count) != 0) {
+            return 1;
+        }
+        if (count == 0) {
+            return 0;
+        }
+        uint8_t *dst = claim(as, (size_t)count);
+        if (!dst) {
+            return 1;
+        }
+        memset(dst, 0, (size_t)count);
+        return 0;
+    }
+    if (IS("org")) {
+        uint64_t offset;
+        if (parse_single_number(as, args, "org", &offset) != 0) {
+            return 1;
+        }
+        as->pos = (size_t)offset;
+        as->origin = offset;
+        return extend_image(as, as->pos);
+    }
+    if (IS("halt")) {
+        uint8_t *dst = claim(as, ISA_WORD_SIZE);
+        if (!dst) {
+            return 1;
+        }
+        memset(dst, 0, ISA_WORD_SIZE);
+        dst[0] = ISA_OPCODE_HALT;
+        if (as->pos > as->code_end) {
+            as->code_end = as->pos;
+        }
+        return 0;
+    }
+    if (IS("header")) {
+        as->isa_section = aurc_view_eq(take_name(&args), "minimal_isa");
+        as->foreign_section |= !as->isa_section;
+        return 0;
+    }
+    if (IS("shared")) {
+        return handle_shared(as, args);
+    }
+    if (IS("stack_size")) {
+        /* consumed by the runtime, nothing to place in the image */
+        return 0;
+    }
+#undef IS
+
+    aurc_diag_printf("aurc-native: %s:%u: unknown directive '%.*s'\n", as->path, as->line, (int)directive.len, directive.data);
+    return 1;
+}
+
+/* Symbols and relocations for the container, then the container itself. */
+static int write_container(assembler *as, size_t data_end, const char *binary_path) {
+    aurc_image_symbol *symbols = calloc(as->symbol_count ? as->symbol_count : 1, sizeof *symbols);
+    aurc_image_reloc *relocs = calloc(as->fixup_count ? as->fixup_count : 1, sizeof *relocs);
+    aurc_bytes out;
+    aurc_bytes_init(&out);
+    int rc = 1;
+    if (symbols && relocs) {
+        size_t count = 0;
+        for (size_t i = 0; i < as->symbol_cap; ++i) {
+            const asm_symbol *symbol = &as->symbols[i];
+            if (symbol->name != 0) {
+                symbols[count++] = (aurc_image_symbol){name_at(as, symbol->name), symbol->name_len, symbol->address};
+            }
+        }
+        for (size_t i = 0; i < as->fixup_count; ++i) {
+            relocs[i].offset = (uint32_t)as->fixups[i].offset;
+            relocs[i].kind = as->fixups[i].kind == ASM_FIXUP_REF64 ? AURC_RELOC_ABS64 : AURC_RELOC_IMM32;
+        }
+        size_t code_size = as->code_end < data_end ? as->code_end : data_end;
+        size_t shared_size = as->shared_count ? as->image.len - as->shared_base : 0;
+        aurc_image_layout layout = {as->image.data, as->image.len, code_size, data_end,
+                                    as->shared_count ? as->shared_base : as->image.len, shared_size,
+                                    symbols, count, relocs, as->fixup_count};
+        rc = aurc_image_encode(&layout, &out);
+    } else {
+        aurc_diag_printf("aurc-native: out of memory collecting image symbols\n");
+    }
+    if (rc == 0) {
+        rc = aurc_bytes_write_file(&out, binary_path);
+    }
+    aurc_bytes_free(&out);
+    free(symbols);
+    free(relocs);
+    return rc;
+}
+
+int aurc_assemble_manifest(const char *manifest_path, const char *binary_path) {
+    aurc_source source;
+    if (aurc_source_open(&source, manifest_path) != 0) {
+        return 1;
+    }
+
+    assembler as;
+    memset(&as, 0, sizeof as);
+    as.path = manifest_path;
+    as.rest = source.text;
+    as.isa_section = 1;
+    aurc_bytes_init(&as.image);
+    aurc_bytes_init(&as.names);
+    /* manifests are mostly hex text: half the input size is a good first estimate */
+    int rc = aurc_bytes_reserve(&as.image, source.text.len / 2 + 64);
+
+    aurc_view line;
+    while (rc == 0 && aurc_view_next_line(&as.rest, &line)) {
+        as.line++;
+        rc = assemble_line(&as, line);
+    }
+    aurc_source_close(&source);
+
+    size_t data_end = as.image.len;
+    if (rc == 0) {
+        rc = layout_shared(&as);
+    }
+    if (rc == 0) {
+        rc = resolve_fixups(&as);
+    }
+    if (rc == 0 && as.foreign_section) {
+        rc = aurc_bytes_write_file(&as.image, binary_path);
+    } else if (rc == 0) {
+        rc = write_container(&as, data_end, binary_path);
+    }
+
+    aurc_bytes_free(&as.image);
+    aurc_bytes_free(&as.names);
+    free(as.symbols);
+    free(as.fixups);
+    free(as.shared);
+    return rc;
+}
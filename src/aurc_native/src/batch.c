@@ -0,0 +1,668 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "aurc_batch.h"
+#include "aurc_diag.h"
+#include "aurc_source.h"
+#include "aurc_thread.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#define SERVE_MAX_ARGS 16
+
+/* -O0, -O1 or -O2; returns the level or -1 for any other argument */
+static int opt_level_flag(const char *arg) {
+    if (arg[0] == '-' && arg[1] == 'O' && arg[2] >= '0' && arg[2] <= '2' && arg[3] == '\0') {
+        return arg[2] - '0';
+    }
+    return -1;
+}
+
+static int parse_target_cpu(const char *name, aurc_target_cpu *cpu) {
+    if (!name) {
+        aurc_diag_printf("Missing argument for --target-cpu\n");
+        return 1;
+    }
+    if (strcmp(name, "x86-64") == 0) {
+        *cpu = AURC_CPU_X86_64;
+    } else if (strcmp(name, "x86-64-v3") == 0) {
+        *cpu = AURC_CPU_X86_64_V3;
+    } else {
+        aurc_diag_printf("--target-cpu expects x86-64 or x86-64-v3, got '%s'\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+static int parse_target_os(const char *name, aurc_target_os *os) {
+    if (!name) {
+        aurc_diag_printf("Missing argument for --target-os\n");
+        return 1;
+    }
+    if (strcmp(name, "windows") == 0) {
+        *os = AURC_OS_WINDOWS;
+    } else if (strcmp(name, "linux") == 0) {
+        *os = AURC_OS_LINUX;
+    } else {
+        aurc_diag_printf("--target-os expects windows or linux, got '%s'\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+int aurc_parse_compile_options(int argc, char **argv, aurc_compile_options *options) {
+    memset(options, 0, sizeof *options);
+    options->opt_level = 1;
+    options->target_os = AURC_OS_HOST;
+    for (int i = 0; i < argc; ++i) {
+        const char **slot = NULL;
+        if (strcmp(argv[i], "--shard-counters") == 0) {
+            options->shard_counters = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--time-report") == 0) {
+            options->time_report = 1;
+            continue;
+        }
+        if (opt_level_flag(argv[i]) >= 0) {
+            options->opt_level = (unsigned)opt_level_flag(argv[i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--target-cpu") == 0) {
+            if (parse_target_cpu(i + 1 < argc ? argv[++i] : NULL, &options->target_cpu) != 0) {
+                return 1;
+            }
+            continue;
+        }
+        if (strcmp(argv[i], "--target-os") == 0) {
+            if (parse_target_os(i + 1 < argc ? argv[++i] : NULL, &options->target_os) != 0) {
+                return 1;
+            }
+            continue;
+        }
+        if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
+            slot = &options->manifest_path;
+        } else if (strcmp(argv[i], "--emit-bin") == 0) {
+            slot = &options->binary_path;
+        } else if (strcmp(argv[i], "--emit-exe") == 0) {
+            slot = &options->exe_path;
+        } else if (strcmp(argv[i], "--stats-json") == 0) {
+            slot = &options->stats_json_path;
+        } else if (strcmp(argv[i], "--cache-dir") == 0) {
+            slot = &options->cache_dir;
+        } else {
+            aurc_diag_printf("Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+        if (i + 1 >= argc) {
+            aurc_diag_printf("Missing argument for %s\n", argv[i]);
+            return 1;
+        }
+        *slot = argv[++i];
+    }
+    if (!options->manifest_path && !options->binary_path && !options->exe_path) {
+        aurc_diag_printf("Nothing to emit: pass -o, --emit-bin and/or --emit-exe.\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* ---- input lists -------------------------------------------------------- */
+
+typedef struct path_list {
+    char **items;
+    size_t count;
+    size_t cap;
+} path_list;
+
+static int path_list_add(path_list *list, const char *data, size_t len) {
+    if (list->count == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 32;
+        char **items = realloc(list->items, cap * sizeof *items);
+        if (!items) {
+            aurc_diag_printf("aurc-native: out of memory listing inputs\n");
+            return 1;
+        }
+        list->items = items;
+        list->cap = cap;
+    }
+    char *copy = malloc(len + 1);
+    if (!copy) {
+        aurc_diag_printf("aurc-native: out of memory listing inputs\n");
+        return 1;
+    }
+    memcpy(copy, data, len);
+    copy[len] = '\0';
+    list->items[list->count++] = copy;
+    return 0;
+}
+
+static void path_list_free(path_list *list) {
+    for (size_t i = 0; i < list->count; ++i) {
+        free(list->items[i]);
+    }
+    free(list->items);
+    memset(list, 0, sizeof *list);
+}
+
+static int compare_paths(const void *lhs, const void *rhs) {
+    return strcmp(*(char *const *)lhs, *(char *const *)rhs);
+}
+
+static int has_aur_extension(const char *name) {
+    size_t len = strlen(name);
+    return len > 4 && strcmp(name + len - 4, ".aur") == 0;
+}
+
+static int join_and_add(path_list *list, const char *dir, const char *name) {
+    size_t dir_len = strlen(dir);
+    size_t name_len = strlen(name);
+    char *joined = malloc(dir_len + 1 + name_len + 1);
+    if (!joined) {
+        aurc_diag_printf("aurc-native: out of memory listing inputs\n");
+        return 1;
+    }
+    memcpy(joined, dir, dir_len);
+    joined[dir_len] = '/';
+    memcpy(joined + dir_len + 1, name, name_len + 1);
+    int rc = path_list_add(list, joined, dir_len + 1 + name_len);
+    free(joined);
+    return rc;
+}
+
+#ifdef _WIN32
+
+static int is_directory(const char *path) {
+    DWORD attributes = GetFileAttributesA(path);
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+static int make_directory(const char *dir) {
+    if (!CreateDirectoryA(dir, NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+        aurc_diag_printf("aurc-native: cannot create directory %s (error %lu)\n", dir, (unsigned long)GetLastError());
+        return 1;
+    }
+    return 0;
+}
+
+static int list_directory(const char *dir, path_list *list) {
+    char pattern[MAX_PATH];
+    if (snprintf(pattern, sizeof pattern, "%s\\*.aur", dir) >= (int)sizeof pattern) {
+        aurc_diag_printf("aurc-native: path too long: %s\n", dir);
+        return 1;
+    }
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA(pattern, &entry);
+    if (find == INVALID_HANDLE_VALUE) {
+        return GetLastError() == ERROR_FILE_NOT_FOUND ? 0 : 1;
+    }
+    int rc = 0;
+    do {
+        if (!(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && has_aur_extension(entry.cFileName)) {
+            rc = join_and_add(list, dir, entry.cFileName);
+        }
+    } while (rc == 0 && FindNextFileA(find, &entry));
+    FindClose(find);
+    return rc;
+}
+
+#else
+
+static int is_directory(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static int make_directory(const char *dir) {
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+        aurc_diag_printf("aurc-native: cannot create directory %s: %s\n", dir, strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+static int list_directory(const char *dir, path_list *list) {
+    DIR *handle = opendir(dir);
+    if (!handle) {
+        aurc_diag_printf("aurc-native: cannot open directory %s: %s\n", dir, strerror(errno));
+        return 1;
+    }
+    int rc = 0;
+    struct dirent *entry;
+    while (rc == 0 && (entry = readdir(handle)) != NULL) {
+        if (entry->d_name[0] != '.' && has_aur_extension(entry->d_name)) {
+            rc = join_and_add(list, dir, entry->d_name);
+        }
+    }
+    closedir(handle);
+    return rc;
+}
+
+#endif
+
+/* Creates dir and any missing parents, as mkdir -p does. */
+static int make_directories(const char *dir) {
+    size_t len = strlen(dir);
+    char *prefix = malloc(len + 1);
+    if (!prefix) {
+        aurc_diag_printf("aurc-native: out of memory creating %s\n", dir);
+        return 1;
+    }
+    memcpy(prefix, dir, len + 1);
+    int rc = 0;
+    for (size_t i = 1; rc == 0 && i <= len; ++i) {
+        if (i < len && dir[i] != '/' && dir[i] != '\\') {
+            continue;
+        }
+        prefix[i] = '\0';
+        /* a drive letter and the root exist already */
+        if (dir[i - 1] != ':' && dir[i - 1] != '/' && dir[i - 1] != '\\' && !is_directory(prefix)) {
+            rc = make_directory(prefix);
+        }
+        prefix[i] = dir[i];
+    }
+    free(prefix);
+    if (rc == 0 && !is_directory(dir)) {
+        aurc_diag_printf("aurc-native: output directory %s is not a directory\n", dir);
+        rc = 1;
+    }
+    return rc;
+}
+
+/* One path per line; blank lines and `#` comments are skipped. */
+static int read_list_file(const char *path, path_list *list) {
+    aurc_source src;
+    if (aurc_source_open(&src, path) != 0) {
+        return 1;
+    }
+    int rc = 0;
+    aurc_view rest = src.text;
+    aurc_view line;
+    while (rc == 0 && aurc_view_next_line(&rest, &line)) {
+        size_t hash = aurc_view_find_char(line, '#');
+        if (hash != AURC_VIEW_NPOS) {
+            line = aurc_view_take(line, hash);
+        }
+        line = aurc_view_trim(line);
+        if (line.len > 0) {
+            rc = path_list_add(list, line.data, line.len);
+        }
+    }
+    aurc_source_close(&src);
+    return rc;
+}
+
+/* ---- compile-many ------------------------------------------------------- */
+
+typedef struct batch_options {
+    const char *out_dir;     /* NULL: next to each input */
+    int emit_aurs;
+    int emit_bin;
+    int emit_exe;
+    unsigned opt_level;
+    int shard_counters;
+    aurc_target_cpu target_cpu;
+    aurc_target_os target_os;
+    unsigned jobs;           /* worker threads, 0 = one per processor */
+    int time_report;
+    const char *cache_dir;   /* shared by every worker; entries are renamed into place */
+} batch_options;
+
+/* <out_dir or input dir>/<input stem><ext> */
+static char *output_path(const batch_options *options, const char *input, const char *ext) {
+    const char *base = input;
+    for (const char *p = input; *p; ++p) {
+        if (*p == '/' || *p == '\\') {
+            base = p + 1;
+        }
+    }
+    size_t stem_len = strlen(base);
+    const char *dot = strrchr(base, '.');
+    if (dot && dot != base) {
+        stem_len = (size_t)(dot - base);
+    }
+    const char *dir = options->out_dir ? options->out_dir : input;
+    size_t dir_len = options->out_dir ? strlen(dir) : (size_t)(base - input);
+    int needs_sep = options->out_dir && dir_len > 0 && dir[dir_len - 1] != '/' && dir[dir_len - 1] != '\\';
+
+    size_t len = dir_len + (size_t)needs_sep + stem_len + strlen(ext);
+    char *path = malloc(len + 1);
+    if (!path) {
+        aurc_diag_printf("aurc-native: out of memory naming outputs\n");
+        return NULL;
+    }
+    memcpy(path, dir, dir_len);
+    if (needs_sep) {
+        path[dir_len] = '/';
+    }
+    memcpy(path + dir_len + needs_sep, base, stem_len);
+    strcpy(path + dir_len + needs_sep + stem_len, ext);
+    return path;
+}
+
+static int compile_one(aurc_session *session, const batch_options *options, const char *input) {
+    char *aurs = options->emit_aurs ? output_path(options, input, ".aurs") : NULL;
+    char *bin = options->emit_bin ? output_path(options, input, ".bin") : NULL;
+    /* Linux executables go without an extension, as the linker would name them */
+    char *exe = options->emit_exe ? output_path(options, input, options->target_os == AURC_OS_WINDOWS ? ".exe" : "") : NULL;
+    int rc = 1;
+    if ((!options->emit_aurs || aurs) && (!options->emit_bin || bin) && (!options->emit_exe || exe)) {
+        aurc_compile_options compile = {aurs, bin, exe, options->opt_level, options->shard_counters, options->target_cpu,
+                                        options->target_os, options->time_report, NULL, options->cache_dir};
+        rc = aurc_session_compile(session, input, &compile);
+    }
+    free(aurs);
+    free(bin);
+    free(exe);
+    return rc;
+}
+
+/* ---- worker pool ---------------------------------------------------------
+ *
+ * Every worker owns a deque holding a contiguous share of the job indices. It
+ * pops from the bottom of its own deque and, once that runs dry, steals from
+ * the top of the others', so a worker stuck on one large input does not hold
+ * up the rest of its share. Jobs are all known up front, which makes each
+ * deque a [top, bottom) window into one shared index array; a mutex per deque
+ * is plenty when one job is a whole compilation.
+ *
+ * Each worker compiles with its own aurc_session and captures every job's
+ * diagnostics, which the caller prints in input order afterwards.
+ */
+
+typedef struct batch_job {
+    const char *input;
+    aurc_bytes diagnostics;
+    int rc;
+} batch_job;
+
+typedef struct job_deque {
+    aurc_mutex lock;
+    size_t top;
+    size_t bottom;
+} job_deque;
+
+typedef struct batch_pool {
+    const batch_options *options;
+    batch_job *jobs;
+    job_deque *deques;
+    unsigned worker_count;
+} batch_pool;
+
+typedef struct batch_worker {
+    batch_pool *pool;
+    unsigned index;
+    aurc_thread thread;
+} batch_worker;
+
+static int take_job(batch_pool *pool, unsigned self, size_t *job) {
+    job_deque *own = &pool->deques[self];
+    aurc_mutex_lock(&own->lock);
+    int found = own->top < own->bottom;
+    if (found) {
+        *job = --own->bottom;
+    }
+    aurc_mutex_unlock(&own->lock);
+
+    for (unsigned k = 1; !found && k < pool->worker_count; ++k) {
+        job_deque *victim = &pool->deques[(self + k) % pool->worker_count];
+        aurc_mutex_lock(&victim->lock);
+        found = victim->top < victim->bottom;
+        if (found) {
+            *job = victim->top++;
+        }
+        aurc_mutex_unlock(&victim->lock);
+    }
+    return found;
+}
+
+static int worker_main(void *arg) {
+    batch_worker *worker = arg;
+    batch_pool *pool = worker->pool;
+    aurc_session *session = aurc_session_create();
+    size_t index;
+    while (take_job(pool, worker->index, &index)) {
+        batch_job *job = &pool->jobs[index];
+        aurc_diag_capture(&job->diagnostics);
+        job->rc = session ? compile_one(session, pool->options, job->input) : 1;
+        aurc_diag_capture(NULL);
+    }
+    aurc_session_destroy(session);
+    return 0;
+}
+
+/* Compiles every job; worker 0 runs on the calling thread. */
+static int run_pool(batch_pool *pool, size_t job_count) {
+    unsigned workers = pool->worker_count;
+    batch_worker *threads = calloc(workers, sizeof *threads);
+    pool->deques = calloc(workers, sizeof *pool->deques);
+    if (!threads || !pool->deques) {
+        aurc_diag_printf("aurc-native: out of memory starting compile workers\n");
+        free(threads);
+        free(pool->deques);
+        return 1;
+    }
+    for (unsigned w = 0; w < workers; ++w) {
+        aurc_mutex_init(&pool->deques[w].lock);
+        pool->deques[w].top = job_count * w / workers;
+        pool->deques[w].bottom = job_count * (w + 1) / workers;
+        threads[w].pool = pool;
+        threads[w].index = w;
+    }
+
+    unsigned started = 1;
+    while (started < workers && aurc_thread_start(&threads[started].thread, worker_main, &threads[started]) == 0) {
+        ++started;
+    }
+    /* workers that failed to start leave their share to be stolen */
+    worker_main(&threads[0]);
+    for (unsigned w = 1; w < started; ++w) {
+        aurc_thread_join(&threads[w].thread, NULL);
+    }
+
+    for (unsigned w = 0; w < workers; ++w) {
+        aurc_mutex_destroy(&pool->deques[w].lock);
+    }
+    free(pool->deques);
+    free(threads);
+    return 0;
+}
+
+int aurc_compile_many(const char *list_or_dir, int argc, char **argv) {
+    batch_options options = {NULL, 0, 0, 0, 1, 0, AURC_CPU_X86_64, AURC_OS_HOST, 0, 0, NULL};
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--out-dir") == 0) {
+            if (i + 1 >= argc) {
+                aurc_diag_printf("Missing argument for %s\n", argv[i]);
+                return 1;
+            }
+            options.out_dir = argv[++i];
+        } else if (strcmp(argv[i], "--cache-dir") == 0) {
+            if (i + 1 >= argc) {
+                aurc_diag_printf("Missing argument for %s\n", argv[i]);
+                return 1;
+            }
+            options.cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            long long jobs = 0;
+            if (i + 1 >= argc || aurc_view_parse_int(aurc_view_of(argv[i + 1]), &jobs) != 0 || jobs < 1 ||
+                jobs > 1024) {
+                aurc_diag_printf("%s expects a worker count between 1 and 1024\n", argv[i]);
+                return 1;
+            }
+            options.jobs = (unsigned)jobs;
+            ++i;
+        } else if (strcmp(argv[i], "--aurs") == 0) {
+            options.emit_aurs = 1;
+        } else if (strcmp(argv[i], "--bin") == 0) {
+            options.emit_bin = 1;
+        } else if (strcmp(argv[i], "--exe") == 0) {
+            options.emit_exe = 1;
+        } else if (strcmp(argv[i], "--shard-counters") == 0) {
+            options.shard_counters = 1;
+        } else if (strcmp(argv[i], "--time-report") == 0) {
+            options.time_report = 1;
+        } else if (opt_level_flag(argv[i]) >= 0) {
+            options.opt_level = (unsigned)opt_level_flag(argv[i]);
+        } else if (strcmp(argv[i], "--target-cpu") == 0) {
+            if (parse_target_cpu(i + 1 < argc ? argv[++i] : NULL, &options.target_cpu) != 0) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--target-os") == 0) {
+            if (parse_target_os(i + 1 < argc ? argv[++i] : NULL, &options.target_os) != 0) {
+                return 1;
+            }
+        } else {
+            aurc_diag_printf("Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!options.emit_aurs && !options.emit_exe) {
+        options.emit_bin = 1;
+    }
+    if (options.out_dir && make_directories(options.out_dir) != 0) {
+        return 1;
+    }
+
+    path_list inputs = {NULL, 0, 0};
+    int rc;
+    if (is_directory(list_or_dir)) {
+        rc = list_directory(list_or_dir, &inputs);
+        if (rc == 0) {
+            qsort(inputs.items, inputs.count, sizeof *inputs.items, compare_paths);
+        }
+    } else {
+        rc = read_list_file(list_or_dir, &inputs);
+    }
+    if (rc != 0) {
+        path_list_free(&inputs);
+        return 1;
+    }
+
+    batch_pool pool;
+    memset(&pool, 0, sizeof pool);
+    pool.options = &options;
+    pool.jobs = calloc(inputs.count ? inputs.count : 1, sizeof *pool.jobs);
+    if (!pool.jobs) {
+        aurc_diag_printf("aurc-native: out of memory queueing inputs\n");
+        path_list_free(&inputs);
+        return 1;
+    }
+    for (size_t i = 0; i < inputs.count; ++i) {
+        pool.jobs[i].input = inputs.items[i];
+        aurc_bytes_init(&pool.jobs[i].diagnostics);
+    }
+    unsigned workers = options.jobs ? options.jobs : aurc_cpu_count();
+    pool.worker_count = inputs.count < workers ? (inputs.count ? (unsigned)inputs.count : 1u) : workers;
+    rc = run_pool(&pool, inputs.count);
+
+    size_t failures = 0;
+    for (size_t i = 0; i < inputs.count; ++i) {
+        batch_job *job = &pool.jobs[i];
+        if (job->diagnostics.len != 0) {
+            fwrite(job->diagnostics.data, 1, job->diagnostics.len, stderr);
+        }
+        if (rc != 0 || job->rc != 0) {
+            aurc_diag_printf("aurc-native: %s: compilation failed\n", job->input);
+            failures++;
+        }
+        aurc_bytes_free(&job->diagnostics);
+    }
+    free(pool.jobs);
+
+    printf("[aurc-native] compiled %zu of %zu inputs\n", inputs.count - failures, inputs.count);
+    path_list_free(&inputs);
+    return failures != 0;
+}
+
+/* ---- server ------------------------------------------------------------- */
+
+/* Splits line in place on blanks; returns the number of words or -1 when there are too many. */
+static int split_words(char *line, char **words, int max_words) {
+    int count = 0;
+    char *p = line;
+    for (;;) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+            ++p;
+        }
+        if (*p == '\0') {
+            return count;
+        }
+        if (count == max_words) {
+            return -1;
+        }
+        words[count++] = p;
+        while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+            ++p;
+        }
+        if (*p) {
+            *p++ = '\0';
+        }
+    }
+}
+
+/* Reads one whole line of any length into *buf; returns 0 at end of input. */
+static int read_line(FILE *in, char **buf, size_t *cap) {
+    size_t len = 0;
+    for (;;) {
+        if (len + 2 > *cap) {
+            size_t grown_cap = *cap ? *cap * 2 : 1024;
+            char *grown = realloc(*buf, grown_cap);
+            if (!grown) {
+                aurc_diag_printf("aurc-native: out of memory reading job\n");
+                return 0;
+            }
+            *buf = grown;
+            *cap = grown_cap;
+        }
+        if (!fgets(*buf + len, (int)(*cap - len), in)) {
+            return len > 0;
+        }
+        len += strlen(*buf + len);
+        if (len > 0 && (*buf)[len - 1] == '\n') {
+            return 1;
+        }
+    }
+}
+
+int aurc_serve(FILE *in, FILE *out) {
+    aurc_session *session = aurc_session_create();
+    if (!session) {
+        return 1;
+    }
+    char *line = NULL;
+    size_t cap = 0;
+    while (read_line(in, &line, &cap)) {
+        char *words[SERVE_MAX_ARGS];
+        int count = split_words(line, words, SERVE_MAX_ARGS);
+        if (count == 0) {
+            continue;
+        }
+        if (count == 1 && strcmp(words[0], "quit") == 0) {
+            break;
+        }
+        int rc = 1;
+        aurc_compile_options options;
+        if (count < 0) {
+            aurc_diag_printf("aurc-native: too many arguments in job\n");
+        } else if (aurc_parse_compile_options(count - 1, words + 1, &options) == 0) {
+            rc = aurc_session_compile(session, words[0], &options);
+        }
+        fprintf(out, "%s %s\n", rc == 0 ? "ok" : "error", count > 0 ? words[0] : "-");
+        fflush(out);
+    }
+    free(line);
+    aurc_session_destroy(session);
+    return 0;
+}
@@ -0,0 +1,1133 @@
+#include "aurc_bignum.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Kernels (mag_*) work on bare limb arrays; the aurc_bn layer on top handles
+ * signs, aliasing and the pool. Every result is built in a fresh array and
+ * swapped in at the end, so operands may alias it and a failed allocation
+ * leaves it untouched.
+ *
+ * Multiplication by size of the shorter operand: schoolbook below
+ * KARATSUBA_THRESHOLD limbs, Karatsuba below TOOM3_THRESHOLD, Toom-3 (with
+ * Bodrato's interpolation sequence) below NTT_THRESHOLD, and above that a
+ * number-theoretic transform modulo three 30-bit primes whose product bounds
+ * every convolution coefficient for transforms up to NTT_MAX_LENGTH points.
+ * Operands much longer than the other are cut into pieces of the shorter
+ * one's size first.
+ *
+ * Division, square root and decimal output reduce to multiplication once
+ * operands are long: division multiplies by a Newton reciprocal, the square
+ * root recurses on the top half of the bits and finishes with a couple of
+ * Newton steps, and decimal output splits the number by 10^(9 2^k) into
+ * halves written independently.
+ */
+
+#define KARATSUBA_THRESHOLD 32
+#define TOOM3_THRESHOLD 150
+#define NTT_THRESHOLD 16000
+#define NTT_MAX_LENGTH ((size_t)1 << 22)
+#define LIMB_BITS 32
+#define NEWTON_DIV_THRESHOLD 200    /* quotient and divisor limbs from which division goes through a reciprocal */
+#define NEWTON_BASE_BITS 2048       /* reciprocals this precise come from long division */
+#define NEWTON_GUARD_BITS 32
+#define NEWTON_MAX_FIXUPS 16
+#define RADIX_SPLIT_LIMBS 64        /* numbers this short go to decimal by repeated division */
+#define DECIMAL_CHUNK 1000000000u   /* 10^9, nine digits per division */
+#define DECIMAL_MAX_LEVELS 40       /* powers 10^(9 2^k) aurc_bn_to_decimal may square up to */
+
+static const char *const OP_NAMES[AURC_BN_OP_COUNT] = {
+    [AURC_BN_FROM_INT] = "bignum",     [AURC_BN_ADD] = "bignum_add",     [AURC_BN_SUB] = "bignum_sub",
+    [AURC_BN_MUL] = "bignum_mul",      [AURC_BN_DIV] = "bignum_div",     [AURC_BN_MOD] = "bignum_mod",
+    [AURC_BN_POW] = "bignum_pow",      [AURC_BN_SHL] = "bignum_shl",     [AURC_BN_SHR] = "bignum_shr",
+    [AURC_BN_SQRT] = "bignum_sqrt",    [AURC_BN_CMP] = "bignum_cmp",     [AURC_BN_TO_INT] = "bignum_to_int",
+    [AURC_BN_PRINT] = "bignum_print",  [AURC_BN_FREE] = "bignum_free",
+};
+
+const char *aurc_bn_op_name(aurc_bn_op op) {
+    return op < AURC_BN_OP_COUNT ? OP_NAMES[op] : "?";
+}
+
+unsigned aurc_bn_op_arity(aurc_bn_op op) {
+    switch (op) {
+        case AURC_BN_FROM_INT:
+        case AURC_BN_SQRT:
+        case AURC_BN_TO_INT:
+        case AURC_BN_PRINT:
+        case AURC_BN_FREE:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+/* ---- pool --------------------------------------------------------------- */
+
+/* An array of at least limbs limbs (its class size lands in *cap), or NULL. */
+static uint32_t *pool_take(aurc_bn_pool *pool, size_t limbs, size_t *cap) {
+    size_t bytes;
+    if (limbs > SIZE_MAX / sizeof(uint32_t)) {
+        return NULL;
+    }
+    uint32_t *array = aurc_pool_take(pool, limbs * sizeof(uint32_t), &bytes);
+    if (array && cap) {
+        *cap = bytes / sizeof(uint32_t);
+    }
+    return array;
+}
+
+/* limbs is the size the array was taken with (or its class size). */
+static void pool_give(aurc_bn_pool *pool, uint32_t *array, size_t limbs) {
+    aurc_pool_give(pool, array, limbs * sizeof(uint32_t));
+}
+
+/* ---- magnitude kernels ---------------------------------------------------- */
+
+static size_t mag_normalize(const uint32_t *a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) {
+        --n;
+    }
+    return n;
+}
+
+static int mag_cmp(const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+    if (an != bn) {
+        return an < bn ? -1 : 1;
+    }
+    while (an-- > 0) {
+        if (a[an] != b[an]) {
+            return a[an] < b[an] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/* r = a + b for an >= bn; returns the carry out of limb an - 1. r may alias a or b. */
+static uint32_t mag_add(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < bn; ++i) {
+        carry += (uint64_t)a[i] + b[i];
+        r[i] = (uint32_t)carry;
+        carry >>= LIMB_BITS;
+    }
+    for (; i < an; ++i) {
+        carry += a[i];
+        r[i] = (uint32_t)carry;
+        carry >>= LIMB_BITS;
+    }
+    return (uint32_t)carry;
+}
+
+/* r = a - b for a >= b (an >= bn); returns the borrow, 0 when the precondition holds. */
+static uint32_t mag_sub(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+    uint64_t borrow = 0;
+    size_t i = 0;
+    for (; i < bn; ++i) {
+        uint64_t d = (uint64_t)a[i] - b[i] - borrow;
+        r[i] = (uint32_t)d;
+        borrow = d >> 63;
+    }
+    for (; i < an; ++i) {
+        uint64_t d = (uint64_t)a[i] - borrow;
+        r[i] = (uint32_t)d;
+        borrow = d >> 63;
+    }
+    return (uint32_t)borrow;
+}
+
+/* r[offset .. rn) += a[0 .. an); the sum must fit in rn limbs. */
+static void mag_add_at(uint32_t *r, size_t rn, const uint32_t *a, size_t an, size_t offset) {
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < an; ++i) {
+        carry += (uint64_t)r[offset + i] + a[i];
+        r[offset + i] = (uint32_t)carry;
+        carry >>= LIMB_BITS;
+    }
+    for (size_t k = offset + i; carry && k < rn; ++k) {
+        carry += r[k];
+        r[k] = (uint32_t)carry;
+        carry >>= LIMB_BITS;
+    }
+}
+
+/* r[0 .. n) += a[0 .. n) * m; returns the carry limb. */
+static uint32_t mag_addmul_1(uint32_t *r, const uint32_t *a, size_t n, uint32_t m) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        carry += (uint64_t)a[i] * m + r[i];
+        r[i] = (uint32_t)carry;
+        carry >>= LIMB_BITS;
+    }
+    return (uint32_t)carry;
+}
+
+/* q = a / d, returning a % d; q may alias a. */
+static uint32_t mag_div_1(uint32_t *q, const uint32_t *a, size_t n, uint32_t d) {
+    uint64_t rem = 0;
+    for (size_t i = n; i-- > 0;) {
+        uint64_t cur = (rem << LIMB_BITS) | a[i];
+        q[i] = (uint32_t)(cur / d);
+        rem = cur % d;
+    }
+    return (uint32_t)rem;
+}
+
+/* r[0 .. n) = a << s for 0 < s < 32; returns the bits shifted out of the top. r may alias a. */
+static uint32_t mag_shl_bits(uint32_t *r, const uint32_t *a, size_t n, unsigned s) {
+    uint32_t out = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t limb = a[i];
+        r[i] = (limb << s) | out;
+        out = limb >> (LIMB_BITS - s);
+    }
+    return out;
+}
+
+/* r[0 .. n) = a >> s for 0 < s < 32; returns whether any one bits fell off. r may alias a. */
+static int mag_shr_bits(uint32_t *r, const uint32_t *a, size_t n, unsigned s) {
+    int lost = n > 0 && (a[0] & ((1u << s) - 1)) != 0;
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = (a[i] >> s) | (i + 1 < n ? a[i + 1] << (LIMB_BITS - s) : 0);
+    }
+    return lost;
+}
+
+static unsigned leading_zeros(uint32_t x) {
+    unsigned n = 0;
+    while (!(x & 0x80000000u)) {
+        x <<= 1;
+        ++n;
+    }
+    return n;
+}
+
+static size_t mag_bits(const uint32_t *a, size_t n) {
+    return n == 0 ? 0 : n * LIMB_BITS - leading_zeros(a[n - 1]);
+}
+
+/* ---- multiplication ------------------------------------------------------ */
+
+static int mul_any(aurc_bn_pool *pool, uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn);
+
+static void mul_basecase(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+    memset(r, 0, (an + bn) * sizeof *r);
+    for (size_t j = 0; j < bn; ++j) {
+        r[an + j] = mag_addmul_1(r + j, a, an, b[j]);
+    }
+}
+
+/* an >= bn > (an + 1) / 2: a = a1 B^h + a0, b = b1 B^h + b0, three half-size products. */
+static int mul_karatsuba(aurc_bn_pool *pool, uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+    size_t h = (an + 1) / 2;
+    size_t scratch = 4 * (h + 1);
+    uint32_t *sa = pool_take(pool, scratch, NULL);
+    if (!sa) {
+        return 1;
+    }
+    uint32_t *sb = sa + h + 1;
+    uint32_t *mid = sb + h + 1;
+    sa[h] = mag_add(sa, a, h, a + h, an - h);
+    sb[h] = mag_add(sb, b, h, b + h, bn - h);
+    if (mul_any(pool, r, a, h, b, h) != 0 || mul_any(pool, r + 2 * h, a + h, an - h, b + h, bn - h) != 0 ||
+        mul_any(pool, mid, sa, h + 1, sb, h + 1) != 0) {
+        pool_give(pool, sa, scratch);
+        return 1;
+    }
+    mag_sub(mid, mid, 2 * h + 2, r, 2 * h);
+    mag_sub(mid, mid, 2 * h + 2, r + 2 * h, an + bn - 2 * h);
+    mag_add_at(r, an + bn, mid, mag_normalize(mid, 2 * h + 2), h);
+    pool_give(pool, sa, scratch);
+    return 0;
+}
+
+/* A read-only aurc_bn over limbs (cap 0, so clearing it never returns them to the pool). */
+static aurc_bn bn_view(const uint32_t *limbs, size_t len) {
+    aurc_bn view = {(uint32_t *)limbs, mag_normalize(limbs, len), 0, 0};
+    return view;
+}
+
+/* x /= d for a d that divides x exactly; x owns its limbs. */
+static void bn_divexact_1(aurc_bn *x, uint32_t d) {
+    mag_div_1(x->limb, x->limb, x->len, d);
+    x->len = mag_normalize(x->limb, x->len);
+    x->neg = x->len ? x->neg : 0;
+}
+
+static void bn_half_exact(aurc_bn *x) {
+    mag_shr_bits(x->limb, x->limb, x->len, 1);
+    x->len = mag_normalize(x->limb, x->len);
+    x->neg = x->len ? x->neg : 0;
+}
+
+/*
+ * an >= bn > 2k with k = ceil(an / 3): both split in three k-limb parts,
+ * evaluated at 0, 1, -1, -2 and infinity, five products, Bodrato's
+ * interpolation. The signed intermediates go through the aurc_bn layer.
+ */
+static int mul_toom3(aurc_bn_pool *pool, uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+    size_t k = (an + 2) / 3;
+    aurc_bn a0 = bn_view(a, k), a1 = bn_view(a + k, k), a2 = bn_view(a + 2 * k, an - 2 * k);
+    aurc_bn b0 = bn_view(b, k), b1 = bn_view(b + k, k), b2 = bn_view(b + 2 * k, bn - 2 * k);
+    aurc_bn t[10];
+    for (int i = 0; i < 10; ++i) {
+        aurc_bn_init(&t[i]);
+    }
+    aurc_bn *p1 = &t[0], *pm1 = &t[1], *pm2 = &t[2], *q1 = &t[3], *qm1 = &t[4], *qm2 = &t[5];
+    aurc_bn *r0 = &t[6], *r1 = &t[7], *rm1 = &t[8], *rinf = &t[9];
+    int failed =
+        aurc_bn_add(pool, p1, &a0, &a2) || aurc_bn_sub(pool, pm1, p1, &a1) || aurc_bn_add(pool, p1, p1, &a1) ||
+        aurc_bn_add(pool, pm2, pm1, &a2) || aurc_bn_shl(pool, pm2, pm2, 1) || aurc_bn_sub(pool, pm2, pm2, &a0) ||
+        aurc_bn_add(pool, q1, &b0, &b2) || aurc_bn_sub(pool, qm1, q1, &b1) || aurc_bn_add(pool, q1, q1, &b1) ||
+        aurc_bn_add(pool, qm2, qm1, &b2) || aurc_bn_shl(pool, qm2, qm2, 1) || aurc_bn_sub(pool, qm2, qm2, &b0) ||
+        aurc_bn_mul(pool, r0, &a0, &b0) || aurc_bn_mul(pool, r1, p1, q1) || aurc_bn_mul(pool, rm1, pm1, qm1) ||
+        aurc_bn_mul(pool, pm2, pm2, qm2) || aurc_bn_mul(pool, rinf, &a2, &b2);
+    /* pm2 now holds r(-2); reuse the evaluation slots for the interpolation */
+    aurc_bn *rm2 = pm2, *c1 = q1, *c2 = qm1, *c3 = qm2;
+    if (!failed) {
+        failed = aurc_bn_sub(pool, c3, rm2, r1);
+    }
+    if (!failed) {
+        bn_divexact_1(c3, 3);
+        failed = aurc_bn_sub(pool, c1, r1, rm1);
+    }
+    if (!failed) {
+        bn_half_exact(c1);
+        failed = aurc_bn_sub(pool, c2, rm1, r0) || aurc_bn_sub(pool, c3, c2, c3);
+    }
+    if (!failed) {
+        bn_half_exact(c3);
+        failed = aurc_bn_add(pool, c3, c3, rinf) || aurc_bn_add(pool, c3, c3, rinf) ||
+                 aurc_bn_add(pool, c2, c2, c1) || aurc_bn_sub(pool, c2, c2, rinf) || aurc_bn_sub(pool, c1, c1, c3);
+    }
+    if (!failed) {
+        const aurc_bn *coef[5] = {r0, c1, c2, c3, rinf};
+        memset(r, 0, (an + bn) * sizeof *r);
+        for (int i = 0; i < 5; ++i) {
+            mag_add_at(r, an + bn, coef[i]->limb, coef[i]->len, (size_t)i * k);
+        }
+    }
+    for (int i = 0; i < 10; ++i) {
+        aurc_bn_clear(pool, &t[i]);
+    }
+    return failed;
+}
+
+/* ---- number-theoretic transform ------------------------------------------ */
+
+typedef struct ntt_prime {
+    uint32_t p;
+    uint32_t neg_inv;   /* -p^-1 mod 2^32, for Montgomery reduction */
+    uint32_t r2;        /* 2^64 mod p: multiplying by it enters Montgomery form */
+} ntt_prime;
+
+/* p - 1 = c 2^k with k >= 23 for each, and 3 generates the multiplicative group. */
+static const uint32_t NTT_PRIMES[3] = {998244353u, 167772161u, 469762049u};
+
+static uint32_t mont_mul(uint32_t a, uint32_t b, const ntt_prime *m) {
+    uint64_t t = (uint64_t)a * b;
+    uint32_t q = (uint32_t)t * m->neg_inv;
+    uint32_t u = (uint32_t)((t + (uint64_t)q * m->p) >> LIMB_BITS);
+    return u - (m->p & (0u - (uint32_t)(u >= m->p)));
+}
+
+static ntt_prime ntt_setup(uint32_t p) {
+    ntt_prime m;
+    uint32_t inv = p;
+    for (int i = 0; i < 5; ++i) {
+        inv *= 2u - p * inv;
+    }
+    m.p = p;
+    m.neg_inv = (uint32_t)0 - inv;
+    m.r2 = (uint32_t)(((uint64_t)0 - p) % p);  /* 2^64 - p is 2^64 mod p */
+    return m;
+}
+
+/* x^e mod p with x and the result in Montgomery form; one is 2^32 mod p in that form. */
+static uint32_t mont_pow(uint32_t x, uint64_t e, const ntt_prime *m) {
+    uint32_t result = (uint32_t)((((uint64_t)1) << LIMB_BITS) % m->p);
+    while (e) {
+        if (e & 1) {
+            result = mont_mul(result, x, m);
+        }
+        x = mont_mul(x, x, m);
+        e >>= 1;
+    }
+    return result;
+}
+
+static uint32_t mod_add(uint32_t a, uint32_t b, uint32_t p) {
+    /* masks rather than branches: the comparisons are data-dependent coin flips */
+    uint32_t sum = a + b;
+    return sum - (p & (0u - (uint32_t)(sum >= p)));
+}
+
+static uint32_t mod_sub(uint32_t a, uint32_t b, uint32_t p) {
+    return a - b + (p & (0u - (uint32_t)(a < b)));
+}
+
+/* twiddle[0 .. half) = successive powers of the root of unity of order 2 half (its inverse if asked). */
+static void ntt_twiddles(uint32_t *twiddle, size_t half, const ntt_prime *m, int inverse) {
+    uint32_t g = mont_mul(3, m->r2, m);
+    uint64_t e = (m->p - 1) / (2 * half);
+    uint32_t w = mont_pow(g, inverse ? (m->p - 1) - e : e, m);
+    twiddle[0] = mont_pow(g, 0, m);
+    for (size_t j = 1; j < half; ++j) {
+        twiddle[j] = mont_mul(twiddle[j - 1], w, m);
+    }
+}
+
+/*
+ * In-place transform of n (a power of two) Montgomery-form residues. The
+ * forward pass is decimation in frequency, leaving its output in bit-reversed
+ * order, and the inverse decimation in time, which takes that order back to
+ * natural; pointwise products do not care, so no bit-reversal pass is needed.
+ * The inverse also scales by 1/n.
+ */
+static void ntt(uint32_t *a, size_t n, const ntt_prime *prime, int inverse, uint32_t *twiddle) {
+    const ntt_prime local = *prime, *m = &local;  /* a local copy the stores into a cannot alias */
+    const uint32_t p = m->p;
+    for (size_t step = 1; step < n; step <<= 1) {
+        size_t half = inverse ? step : n / (2 * step);
+        ntt_twiddles(twiddle, half, m, inverse);
+        for (size_t i = 0; i < n; i += 2 * half) {
+            uint32_t *lo = a + i, *hi = a + i + half;
+            if (inverse) {
+                for (size_t j = 0; j < half; ++j) {
+                    uint32_t u = lo[j], v = mont_mul(hi[j], twiddle[j], m);
+                    lo[j] = mod_add(u, v, p);
+                    hi[j] = mod_sub(u, v, p);
+                }
+            } else {
+                for (size_t j = 0; j < half; ++j) {
+                    uint32_t u = lo[j], v = hi[j];
+                    lo[j] = mod_add(u, v, p);
+                    hi[j] = mont_mul(mod_sub(u, v, p), twiddle[j], m);
+                }
+            }
+        }
+    }
+    if (inverse) {
+        uint32_t n_mont = mont_mul((uint32_t)(n % p), m->r2, m);
+        uint32_t scale = mont_pow(n_mont, p - 2, m);
+        for (size_t i = 0; i < n; ++i) {
+            a[i] = mont_mul(a[i], scale, m);
+        }
+    }
+}
+
+static uint64_t pow_mod(uint64_t x, uint64_t e, uint64_t p) {
+    uint64_t result = 1;
+    x %= p;
+    while (e) {
+        if (e & 1) {
+            result = result * x % p;
+        }
+        x = x * x % p;
+        e >>= 1;
+    }
+    return result;
+}
+
+/* Convolution modulo each prime, then the coefficients rebuilt by Garner's CRT and carried into r. */
+static int mul_ntt(aurc_bn_pool *pool, uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+    size_t n = 1;
+    while (n < an + bn) {
+        n <<= 1;
+    }
+    int square = a == b && an == bn;
+    size_t scratch = 5 * n;
+    uint32_t *res = pool_take(pool, scratch, NULL);
+    if (!res) {
+        return 1;
+    }
+    uint32_t *fb = res + 3 * n;
+    uint32_t *twiddle = res + 4 * n;
+    for (int k = 0; k < 3; ++k) {
+        ntt_prime m = ntt_setup(NTT_PRIMES[k]);
+        uint32_t *fa = res + (size_t)k * n;
+        for (size_t i = 0; i < n; ++i) {
+            fa[i] = i < an ? mont_mul(a[i] % m.p, m.r2, &m) : 0;
+        }
+        ntt(fa, n, &m, 0, twiddle);
+        if (!square) {
+            for (size_t i = 0; i < n; ++i) {
+                fb[i] = i < bn ? mont_mul(b[i] % m.p, m.r2, &m) : 0;
+            }
+            ntt(fb, n, &m, 0, twiddle);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            fa[i] = mont_mul(fa[i], square ? fa[i] : fb[i], &m);
+        }
+        ntt(fa, n, &m, 1, twiddle);
+        for (size_t i = 0; i < n; ++i) {
+            fa[i] = mont_mul(fa[i], 1, &m);
+        }
+    }
+
+    const uint64_t p1 = NTT_PRIMES[0], p2 = NTT_PRIMES[1], p3 = NTT_PRIMES[2];
+    const uint64_t inv_p1 = pow_mod(p1, p2 - 2, p2);
+    const uint64_t p12 = p1 * p2;
+    const uint64_t inv_p12 = pow_mod(p12 % p3, p3 - 2, p3);
+    const uint64_t p12_lo = p12 & 0xFFFFFFFFu, p12_hi = p12 >> LIMB_BITS;
+    uint64_t acc0 = 0, acc1 = 0, acc2 = 0;  /* running carry, 32 bits per word */
+    for (size_t i = 0; i < an + bn; ++i) {
+        uint64_t r1 = res[i], r2 = res[n + i], r3 = res[2 * n + i];
+        uint64_t t2 = (r2 + p2 - r1 % p2) % p2 * inv_p1 % p2;
+        uint64_t x12 = r1 + p1 * t2;
+        uint64_t t3 = (r3 + p3 - x12 % p3) % p3 * inv_p12 % p3;
+        /* coefficient = x12 + p12 * t3, as three 32-bit words */
+        uint64_t lo = p12_lo * t3, hi = p12_hi * t3;
+        uint64_t s0 = (lo & 0xFFFFFFFFu) + (x12 & 0xFFFFFFFFu);
+        uint64_t s1 = (lo >> LIMB_BITS) + (hi & 0xFFFFFFFFu) + (x12 >> LIMB_BITS) + (s0 >> LIMB_BITS);
+        uint64_t s2 = (hi >> LIMB_BITS) + (s1 >> LIMB_BITS);
+        uint64_t sum = acc0 + (s0 & 0xFFFFFFFFu);
+        r[i] = (uint32_t)sum;
+        sum = (sum >> LIMB_BITS) + acc1 + (s1 & 0xFFFFFFFFu);
+        acc0 = sum & 0xFFFFFFFFu;
+        sum = (sum >> LIMB_BITS) + acc2 + s2;
+        acc1 = sum & 0xFFFFFFFFu;
+        acc2 = sum >> LIMB_BITS;
+    }
+    pool_give(pool, res, scratch);
+    return 0;
+}
+
+/* an >= bn >= 1; r holds an + bn limbs and overlaps neither operand. */
+static int mul_mag(aurc_bn_pool *pool, uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+    if (bn < KARATSUBA_THRESHOLD) {
+        mul_basecase(r, a, an, b, bn);
+        return 0;
+    }
+    if (bn >= NTT_THRESHOLD && an + bn <= NTT_MAX_LENGTH) {
+        return mul_ntt(pool, r, a, an, b, bn);
+    }
+    if (an >= 2 * bn) {
+        /* a in bn-limb pieces, each product added in at its offset */
+        size_t piece_cap = 2 * bn;
+        uint32_t *piece = pool_take(pool, piece_cap, NULL);
+        if (!piece) {
+            return 1;
+        }
+        memset(r, 0, (an + bn) * sizeof *r);
+        for (size_t at = 0; at < an; at += bn) {
+            size_t len = an - at < bn ? an - at : bn;
+            if (mul_any(pool, piece, a + at, len, b, bn) != 0) {
+                pool_give(pool, piece, piece_cap);
+                return 1;
+            }
+            mag_add_at(r, an + bn, piece, mag_normalize(piece, len + bn), at);
+        }
+        pool_give(pool, piece, piece_cap);
+        return 0;
+    }
+    if (bn >= TOOM3_THRESHOLD && bn > 2 * ((an + 2) / 3)) {
+        return mul_toom3(pool, r, a, an, b, bn);
+    }
+    if (bn > (an + 1) / 2) {
+        return mul_karatsuba(pool, r, a, an, b, bn);
+    }
+    mul_basecase(r, a, an, b, bn);
+    return 0;
+}
+
+/* r[0 .. an + bn) = a * b for any lengths, leading zero limbs included. */
+static int mul_any(aurc_bn_pool *pool, uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+    size_t full = an + bn;
+    an = mag_normalize(a, an);
+    bn = mag_normalize(b, bn);
+    if (an < bn) {
+        const uint32_t *t = a;
+        a = b;
+        b = t;
+        size_t tn = an;
+        an = bn;
+        bn = tn;
+    }
+    if (bn == 0) {
+        memset(r, 0, full * sizeof *r);
+        return 0;
+    }
+    if (mul_mag(pool, r, a, an, b, bn) != 0) {
+        return 1;
+    }
+    memset(r + an + bn, 0, (full - an - bn) * sizeof *r);
+    return 0;
+}
+
+/* ---- division ------------------------------------------------------------ */
+
+/*
+ * Knuth's algorithm D: q[0 .. un - vn] = u / v, rem[0 .. vn) = u % v for
+ * un >= vn >= 2 and v normalised to no leading zero limb. u is copied, so
+ * q and rem may be NULL and the arrays need not be distinct from u.
+ */
+static int divmod_mag(aurc_bn_pool *pool, uint32_t *q, uint32_t *rem, const uint32_t *u, size_t un, const uint32_t *v,
+                      size_t vn) {
+    size_t scratch = un + 1 + vn;
+    uint32_t *nu = pool_take(pool, scratch, NULL);
+    if (!nu) {
+        return 1;
+    }
+    uint32_t *nv = nu + un + 1;
+    unsigned s = leading_zeros(v[vn - 1]);
+    if (s) {
+        mag_shl_bits(nv, v, vn, s);
+        nu[un] = mag_shl_bits(nu, u, un, s);
+    } else {
+        memcpy(nv, v, vn * sizeof *nv);
+        memcpy(nu, u, un * sizeof *nu);
+        nu[un] = 0;
+    }
+    uint64_t top = nv[vn - 1], next = nv[vn - 2];
+    for (size_t j = un - vn + 1; j-- > 0;) {
+        uint64_t num = ((uint64_t)nu[j + vn] << LIMB_BITS) | nu[j + vn - 1];
+        uint64_t qhat = num / top;
+        uint64_t rhat = num % top;
+        while (qhat > 0xFFFFFFFFu || qhat * next > ((rhat << LIMB_BITS) | nu[j + vn - 2])) {
+            --qhat;
+            rhat += top;
+            if (rhat > 0xFFFFFFFFu) {
+                break;
+            }
+        }
+        uint64_t carry = 0, borrow = 0;
+        for (size_t i = 0; i < vn; ++i) {
+            uint64_t p = qhat * nv[i] + carry;
+            carry = p >> LIMB_BITS;
+            uint64_t d = (uint64_t)nu[i + j] - (uint32_t)p - borrow;
+            nu[i + j] = (uint32_t)d;
+            borrow = d >> 63;
+        }
+        uint64_t d = (uint64_t)nu[j + vn] - carry - borrow;
+        nu[j + vn] = (uint32_t)d;
+        if (d >> 63) {
+            /* qhat was one too large: add v back */
+            --qhat;
+            uint64_t c = 0;
+            for (size_t i = 0; i < vn; ++i) {
+                c += (uint64_t)nu[i + j] + nv[i];
+                nu[i + j] = (uint32_t)c;
+                c >>= LIMB_BITS;
+            }
+            nu[j + vn] += (uint32_t)c;
+        }
+        if (q) {
+            q[j] = (uint32_t)qhat;
+        }
+    }
+    if (rem) {
+        if (s) {
+            mag_shr_bits(rem, nu, vn, s);
+            rem[vn - 1] |= nu[vn] << (LIMB_BITS - s);
+        } else {
+            memcpy(rem, nu, vn * sizeof *rem);
+        }
+    }
+    pool_give(pool, nu, scratch);
+    return 0;
+}
+
+/* ---- signed numbers ------------------------------------------------------ */
+
+void aurc_bn_init(aurc_bn *x) {
+    x->limb = NULL;
+    x->len = 0;
+    x->cap = 0;
+    x->neg = 0;
+}
+
+void aurc_bn_clear(aurc_bn_pool *pool, aurc_bn *x) {
+    if (x->cap) {
+        pool_give(pool, x->limb, x->cap);
+    }
+    aurc_bn_init(x);
+}
+
+/* Replaces x by the number in limbs (a pool array of class size cap), normalising it. */
+static void bn_assign(aurc_bn_pool *pool, aurc_bn *x, uint32_t *limbs, size_t cap, size_t len, int neg) {
+    aurc_bn_clear(pool, x);
+    x->limb = limbs;
+    x->cap = cap;
+    x->len = mag_normalize(limbs, len);
+    x->neg = x->len ? neg : 0;
+}
+
+/* A fresh array for a result of up to limbs limbs; at least one so results are never NULL-backed. */
+static uint32_t *bn_take(aurc_bn_pool *pool, size_t limbs, size_t *cap) {
+    return pool_take(pool, limbs ? limbs : 1, cap);
+}
+
+int aurc_bn_set_i64(aurc_bn_pool *pool, aurc_bn *x, int64_t value) {
+    size_t cap;
+    uint32_t *limbs = bn_take(pool, 2, &cap);
+    if (!limbs) {
+        return 1;
+    }
+    uint64_t mag = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    limbs[0] = (uint32_t)mag;
+    limbs[1] = (uint32_t)(mag >> LIMB_BITS);
+    bn_assign(pool, x, limbs, cap, 2, value < 0);
+    return 0;
+}
+
+int aurc_bn_copy(aurc_bn_pool *pool, aurc_bn *dst, const aurc_bn *src) {
+    if (dst == src) {
+        return 0;
+    }
+    size_t cap;
+    uint32_t *limbs = bn_take(pool, src->len, &cap);
+    if (!limbs) {
+        return 1;
+    }
+    if (src->len) {
+        memcpy(limbs, src->limb, src->len * sizeof *limbs);
+    }
+    bn_assign(pool, dst, limbs, cap, src->len, src->neg);
+    return 0;
+}
+
+int64_t aurc_bn_to_i64(const aurc_bn *x) {
+    uint64_t mag = (x->len > 0 ? x->limb[0] : 0) | (uint64_t)(x->len > 1 ? x->limb[1] : 0) << LIMB_BITS;
+    return (int64_t)(x->neg ? (uint64_t)0 - mag : mag);
+}
+
+int aurc_bn_cmp(const aurc_bn *a, const aurc_bn *b) {
+    if (a->neg != b->neg) {
+        return a->neg ? -1 : 1;
+    }
+    int mag = mag_cmp(a->limb, a->len, b->limb, b->len);
+    return a->neg ? -mag : mag;
+}
+
+/* r = a + (-1)^b_neg |b|, the shared body of add and sub. */
+static int add_signed(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, const aurc_bn *b, int b_neg) {
+    const aurc_bn *big = a, *small = b;
+    int big_neg = a->neg, small_neg = b_neg;
+    if (mag_cmp(a->limb, a->len, b->limb, b->len) < 0) {
+        big = b;
+        small = a;
+        big_neg = b_neg;
+        small_neg = a->neg;
+    }
+    size_t cap;
+    uint32_t *limbs = bn_take(pool, big->len + 1, &cap);
+    if (!limbs) {
+        return 1;
+    }
+    if (big_neg == small_neg) {
+        limbs[big->len] = mag_add(limbs, big->limb, big->len, small->limb, small->len);
+    } else {
+        mag_sub(limbs, big->limb, big->len, small->limb, small->len);
+        limbs[big->len] = 0;
+    }
+    bn_assign(pool, r, limbs, cap, big->len + 1, big_neg);
+    return 0;
+}
+
+int aurc_bn_add(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, const aurc_bn *b) {
+    return add_signed(pool, r, a, b, b->neg);
+}
+
+int aurc_bn_sub(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, const aurc_bn *b) {
+    return add_signed(pool, r, a, b, !b->neg && b->len);
+}
+
+int aurc_bn_mul(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, const aurc_bn *b) {
+    size_t n = a->len + b->len;
+    size_t cap;
+    uint32_t *limbs = bn_take(pool, n, &cap);
+    if (!limbs) {
+        return 1;
+    }
+    if (mul_any(pool, limbs, a->limb, a->len, b->limb, b->len) != 0) {
+        pool_give(pool, limbs, cap);
+        return 1;
+    }
+    bn_assign(pool, r, limbs, cap, n, a->neg != b->neg);
+    return 0;
+}
+
+/* aurc_bn_divmod by long division: one limb at a time, O(quotient limbs x divisor limbs). */
+static int divmod_basecase(aurc_bn_pool *pool, aurc_bn *q, aurc_bn *rem, const aurc_bn *a, const aurc_bn *b) {
+    size_t qn = a->len >= b->len ? a->len - b->len + 1 : 0;
+    size_t qcap = 0, rcap = 0;
+    uint32_t *qs = q ? bn_take(pool, qn, &qcap) : NULL;
+    uint32_t *rs = rem ? bn_take(pool, b->len, &rcap) : NULL;
+    if ((q && !qs) || (rem && !rs)) {
+        pool_give(pool, qs, qcap);
+        pool_give(pool, rs, rcap);
+        return 1;
+    }
+    size_t rn = b->len;
+    if (qn == 0) {
+        /* |a| < |b| */
+        if (rs) {
+            memcpy(rs, a->limb, a->len * sizeof *rs);
+            rn = a->len;
+        }
+    } else if (b->len == 1) {
+        uint32_t r0;
+        if (qs) {
+            r0 = mag_div_1(qs, a->limb, a->len, b->limb[0]);
+        } else {
+            /* remainder only: fold the limbs without storing a quotient */
+            uint64_t acc = 0;
+            for (size_t i = a->len; i-- > 0;) {
+                acc = ((acc << LIMB_BITS) | a->limb[i]) % b->limb[0];
+            }
+            r0 = (uint32_t)acc;
+        }
+        if (rs) {
+            rs[0] = r0;
+        }
+    } else if (divmod_mag(pool, qs, rs, a->limb, a->len, b->limb, b->len) != 0) {
+        pool_give(pool, qs, qcap);
+        pool_give(pool, rs, rcap);
+        return 1;
+    }
+    int a_neg = a->neg, b_neg = b->neg;
+    if (q) {
+        bn_assign(pool, q, qs, qcap, qn, a_neg != b_neg);
+    }
+    if (rem) {
+        bn_assign(pool, rem, rs, rcap, rn, a_neg);
+    }
+    return 0;
+}
+
+/* Moves src into dst with sign neg (ignored for zero), leaving src zero. */
+static void bn_move(aurc_bn_pool *pool, aurc_bn *dst, aurc_bn *src, int neg) {
+    aurc_bn_clear(pool, dst);
+    *dst = *src;
+    dst->neg = dst->len ? neg : 0;
+    aurc_bn_init(src);
+}
+
+/*
+ * About floor(2^(bits(b) + j) / b) for b > 0, by Newton's iteration
+ * x' = x (2 - b x) on a reciprocal of a little over half the precision, with
+ * b cut to the bits the step can use, so the whole costs a few products of
+ * j-bit numbers. The iteration approaches from below and the truncations
+ * lose a little more, so the result may be a few units short; callers step
+ * their quotient onto the exact one against the remainder.
+ */
+static int reciprocal(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *b, uint64_t j) {
+    uint64_t pb = mag_bits(b->limb, b->len);
+    aurc_bn cut, x, e;
+    aurc_bn_init(&cut);
+    aurc_bn_init(&x);
+    aurc_bn_init(&e);
+    const aurc_bn *d = b;
+    int failed = 0;
+    if (pb > j + 2 * NEWTON_GUARD_BITS) {
+        failed = aurc_bn_shr(pool, &cut, b, pb - j - NEWTON_GUARD_BITS);
+        d = &cut;
+        pb = j + NEWTON_GUARD_BITS;
+    }
+    if (!failed && j <= NEWTON_BASE_BITS) {
+        failed = aurc_bn_set_i64(pool, &e, 1) || aurc_bn_shl(pool, &e, &e, pb + j) ||
+                 divmod_basecase(pool, &x, NULL, &e, d);
+    } else if (!failed) {
+        /* x ~ 2^(pb + h) / d, then x 2^(j - h + 1) - d x^2 / 2^(pb + 2h - j) ~ 2^(pb + j) / d */
+        uint64_t h = j / 2 + NEWTON_GUARD_BITS;
+        failed = reciprocal(pool, &x, d, h) || aurc_bn_mul(pool, &e, &x, &x) || aurc_bn_mul(pool, &e, &e, d) ||
+                 aurc_bn_shr(pool, &e, &e, pb + 2 * h - j) || aurc_bn_shl(pool, &x, &x, j - h + 1) ||
+                 aurc_bn_sub(pool, &x, &x, &e);
+    }
+    if (!failed) {
+        bn_move(pool, r, &x, 0);
+    }
+    aurc_bn_clear(pool, &cut);
+    aurc_bn_clear(pool, &x);
+    aurc_bn_clear(pool, &e);
+    return failed;
+}
+
+/* Division of magnitudes a >= b > 0 as a times b's reciprocal, corrected against the remainder. */
+static int divmod_newton(aurc_bn_pool *pool, aurc_bn *q, aurc_bn *rem, const aurc_bn *a, const aurc_bn *b) {
+    uint64_t pa = mag_bits(a->limb, a->len), pb = mag_bits(b->limb, b->len);
+    uint64_t j = pa - pb + NEWTON_GUARD_BITS;
+    /* bits of a below the quotient's precision cannot change the estimate */
+    uint64_t s = pa > j + NEWTON_GUARD_BITS ? pa - j - NEWTON_GUARD_BITS : 0;
+    aurc_bn x, qe, r, one;
+    aurc_bn_init(&x);
+    aurc_bn_init(&qe);
+    aurc_bn_init(&r);
+    aurc_bn_init(&one);
+    int failed = reciprocal(pool, &x, b, j) || aurc_bn_shr(pool, &qe, a, s) || aurc_bn_mul(pool, &qe, &qe, &x) ||
+                 aurc_bn_shr(pool, &qe, &qe, pb + j - s) || aurc_bn_mul(pool, &r, &qe, b) ||
+                 aurc_bn_sub(pool, &r, a, &r) || aurc_bn_set_i64(pool, &one, 1);
+    for (int fix = 0; !failed && fix < NEWTON_MAX_FIXUPS && (r.neg || aurc_bn_cmp(&r, b) >= 0); ++fix) {
+        if (r.neg) {
+            failed = aurc_bn_add(pool, &r, &r, b) || aurc_bn_sub(pool, &qe, &qe, &one);
+        } else {
+            failed = aurc_bn_sub(pool, &r, &r, b) || aurc_bn_add(pool, &qe, &qe, &one);
+        }
+    }
+    if (!failed && (r.neg || aurc_bn_cmp(&r, b) >= 0)) {
+        /* the estimate is never this far off; long division settles it regardless */
+        failed = divmod_basecase(pool, &qe, &r, a, b);
+    }
+    if (!failed) {
+        if (q) {
+            bn_move(pool, q, &qe, 0);
+        }
+        if (rem) {
+            bn_move(pool, rem, &r, 0);
+        }
+    }
+    aurc_bn_clear(pool, &x);
+    aurc_bn_clear(pool, &qe);
+    aurc_bn_clear(pool, &r);
+    aurc_bn_clear(pool, &one);
+    return failed;
+}
+
+int aurc_bn_divmod(aurc_bn_pool *pool, aurc_bn *q, aurc_bn *rem, const aurc_bn *a, const aurc_bn *b) {
+    size_t qn = a->len >= b->len ? a->len - b->len + 1 : 0;
+    if (qn < NEWTON_DIV_THRESHOLD || b->len < NEWTON_DIV_THRESHOLD) {
+        return divmod_basecase(pool, q, rem, a, b);
+    }
+    /* truncating division of the magnitudes, then the signs: q by both, rem by a's */
+    aurc_bn ma = *a, mb = *b;
+    ma.neg = 0;
+    mb.neg = 0;
+    int q_neg = a->neg != b->neg, rem_neg = a->neg;
+    aurc_bn qt, rt;
+    aurc_bn_init(&qt);
+    aurc_bn_init(&rt);
+    if (divmod_newton(pool, q ? &qt : NULL, rem ? &rt : NULL, &ma, &mb) != 0) {
+        return 1;
+    }
+    if (q) {
+        bn_move(pool, q, &qt, q_neg);
+    }
+    if (rem) {
+        bn_move(pool, rem, &rt, rem_neg);
+    }
+    return 0;
+}
+
+int aurc_bn_shl(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, uint64_t bits) {
+    if (a->len == 0) {
+        return aurc_bn_copy(pool, r, a);
+    }
+    size_t limbs_shift = (size_t)(bits / LIMB_BITS);
+    unsigned s = (unsigned)(bits % LIMB_BITS);
+    size_t n = a->len + limbs_shift + 1;
+    size_t cap;
+    uint32_t *limbs = bn_take(pool, n, &cap);
+    if (!limbs) {
+        return 1;
+    }
+    memset(limbs, 0, limbs_shift * sizeof *limbs);
+    if (s) {
+        limbs[n - 1] = mag_shl_bits(limbs + limbs_shift, a->limb, a->len, s);
+    } else {
+        memcpy(limbs + limbs_shift, a->limb, a->len * sizeof *limbs);
+        limbs[n - 1] = 0;
+    }
+    bn_assign(pool, r, limbs, cap, n, a->neg);
+    return 0;
+}
+
+int aurc_bn_shr(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, uint64_t bits) {
+    size_t limbs_shift = (size_t)(bits / LIMB_BITS);
+    unsigned s = (unsigned)(bits % LIMB_BITS);
+    size_t n = a->len > limbs_shift ? a->len - limbs_shift : 0;
+    size_t cap;
+    uint32_t *limbs = bn_take(pool, n + 1, &cap);
+    if (!limbs) {
+        return 1;
+    }
+    int lost = 0;
+    for (size_t i = 0; i < limbs_shift && i < a->len; ++i) {
+        lost |= a->limb[i] != 0;
+    }
+    if (s) {
+        lost |= mag_shr_bits(limbs, a->limb + limbs_shift, n, s);
+    } else if (n) {
+        memcpy(limbs, a->limb + limbs_shift, n * sizeof *limbs);
+    }
+    limbs[n] = 0;
+    if (a->neg && lost) {
+        /* rounding toward minus infinity: one more in magnitude */
+        uint32_t one = 1;
+        limbs[n] = mag_add(limbs, limbs, n, &one, n ? 1 : 0);
+        if (n == 0) {
+            limbs[0] = 1;
+        }
+    }
+    bn_assign(pool, r, limbs, cap, n + 1, a->neg);
+    return 0;
+}
+
+int aurc_bn_pow(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a, uint64_t exponent) {
+    aurc_bn result, base;
+    aurc_bn_init(&result);
+    aurc_bn_init(&base);
+    int failed = aurc_bn_set_i64(pool, &result, 1) || aurc_bn_copy(pool, &base, a);
+    while (!failed && exponent) {
+        if (exponent & 1) {
+            failed = aurc_bn_mul(pool, &result, &result, &base);
+        }
+        exponent >>= 1;
+        if (!failed && exponent) {
+            failed = aurc_bn_mul(pool, &base, &base, &base);
+        }
+    }
+    if (!failed) {
+        aurc_bn_clear(pool, r);
+        *r = result;
+        aurc_bn_init(&result);
+    }
+    aurc_bn_clear(pool, &result);
+    aurc_bn_clear(pool, &base);
+    return failed;
+}
+
+/*
+ * Newton's iteration x' = (x + a / x) / 2 never lands below floor(sqrt(a))
+ * and falls monotonically from above onto it. Long operands start from the
+ * root of their top half (scaled back), good to half the bits, so a couple
+ * of steps finish the job.
+ */
+int aurc_bn_sqrt(aurc_bn_pool *pool, aurc_bn *r, const aurc_bn *a) {
+    if (a->len == 0) {
+        return aurc_bn_copy(pool, r, a);
+    }
+    uint64_t bits = mag_bits(a->limb, a->len);
+    aurc_bn x, y;
+    aurc_bn_init(&x);
+    aurc_bn_init(&y);
+    int failed;
+    if (bits <= NEWTON_BASE_BITS) {
+        failed = aurc_bn_set_i64(pool, &x, 1) || aurc_bn_shl(pool, &x, &x, (bits + 1) / 2);
+    } else {
+        uint64_t k = bits / 4;
+        failed = aurc_bn_shr(pool, &y, a, 2 * k) || aurc_bn_sqrt(pool, &x, &y) || aurc_bn_shl(pool, &x, &x, k);
+    }
+    int first = 1;
+    while (!failed) {
+        failed = aurc_bn_divmod(pool, &y, NULL, a, &x) || aurc_bn_add(pool, &y, &y, &x) ||
+                 aurc_bn_shr(pool, &y, &y, 1);
+        /* the first step only lifts a start from below onto the falling side */
+        if (failed || (!first && aurc_bn_cmp(&y, &x) >= 0)) {
+            break;
+        }
+        first = 0;
+        aurc_bn t = x;
+        x = y;
+        y = t;
+    }
+    if (!failed) {
+        bn_move(pool, r, &x, 0);
+    }
+    aurc_bn_clear(pool, &x);
+    aurc_bn_clear(pool, &y);
+    return failed;
+}
+
+/* ---- decimal output ------------------------------------------------------ */
+
+/* Writes n limbs as exactly width digits, zero-padded on the left; the number must fit. */
+static int decimal_basecase(aurc_bn_pool *pool, char *out, size_t width, const uint32_t *limbs, size_t n) {
+    size_t work_cap;
+    uint32_t *work = bn_take(pool, n, &work_cap);
+    if (!work) {
+        return 1;
+    }
+    if (n) {
+        memcpy(work, limbs, n * sizeof *work);
+    }
+    char *at = out + width;
+    while (n > 0) {
+        uint32_t chunk = mag_div_1(work, work, n, DECIMAL_CHUNK);
+        n = mag_normalize(work, n);
+        for (int d = 0; d < 9 && at > out; ++d) {
+            *--at = (char)('0' + chunk % 10);
+            chunk /= 10;
+        }
+    }
+    memset(out, '0', (size_t)(at - out));
+    pool_give(pool, work, work_cap);
+    return 0;
+}
+
+/*
+ * Writes x < powers[level]^2 as exactly 9 2^(level + 1) digits: x is split
+ * by powers[level] = 10^(9 2^level) into halves written side by side.
+ */
+static int decimal_split(aurc_bn_pool *pool, char *out, const aurc_bn *x, const aurc_bn *powers, unsigned level) {
+    size_t width = (size_t)9 << (level + 1);
+    if (level == 0 || x->len <= RADIX_SPLIT_LIMBS) {
+        return decimal_basecase(pool, out, width, x->limb, x->len);
+    }
+    aurc_bn hi, lo;
+    aurc_bn_init(&hi);
+    aurc_bn_init(&lo);
+    int failed = aurc_bn_divmod(pool, &hi, &lo, x, &powers[level]) ||
+                 decimal_split(pool, out, &hi, powers, level - 1) ||
+                 decimal_split(pool, out + width / 2, &lo, powers, level - 1);
+    aurc_bn_clear(pool, &hi);
+    aurc_bn_clear(pool, &lo);
+    return failed;
+}
+
+char *aurc_bn_to_decimal(aurc_bn_pool *pool, const aurc_bn *x, size_t *len) {
+    /* powers[k] = 10^(9 2^k), up to the first whose square exceeds |x| */
+    aurc_bn powers[DECIMAL_MAX_LEVELS];
+    unsigned levels = 1;
+    aurc_bn mag = *x;
+    mag.neg = 0;
+    aurc_bn_init(&powers[0]);
+    int failed = aurc_bn_set_i64(pool, &powers[0], DECIMAL_CHUNK);
+    while (!failed) {
+        const aurc_bn *top = &powers[levels - 1];
+        if (mag.len + 2 <= 2 * top->len) {
+            break;  /* top^2 >= 2^(32 (2 top->len - 2)) > |x| */
+        }
+        if (levels == DECIMAL_MAX_LEVELS) {
+            failed = 1;
+            break;
+        }
+        aurc_bn_init(&powers[levels]);
+        failed = aurc_bn_mul(pool, &powers[levels], top, top);
+        ++levels;
+        if (!failed && aurc_bn_cmp(&mag, &powers[levels - 1]) < 0) {
+            --levels;
+            aurc_bn_clear(pool, &powers[levels]);
+            break;
+        }
+    }
+    size_t width = (size_t)9 << levels;
+    char *text = failed ? NULL : malloc(width + 2);
+    if (text && decimal_split(pool, text + 1, &mag, powers, levels - 1) != 0) {
+        free(text);
+        text = NULL;
+    }
+    for (unsigned k = 0; k < levels; ++k) {
+        aurc_bn_clear(pool, &powers[k]);
+    }
+    if (!text) {
+        return NULL;
+    }
+    size_t skip = 0;
+    while (skip + 1 < width && text[1 + skip] == '0') {
+        ++skip;
+    }
+    size_t n = 0;
+    if (x->neg) {
+        text[n++] = '-';
+    }
+    memmove(text + n, text + 1 + skip, width - skip);
+    n += width - skip;
+    text[n] = '\0';
+    if (len) {
+        *len = n;
+    }
+    return text;
+}
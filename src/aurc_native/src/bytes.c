@@ -0,0 +1,135 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "aurc_bytes.h"
+#include "aurc_diag.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+void aurc_bytes_init(aurc_bytes *buf) {
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+}
+
+void aurc_bytes_free(aurc_bytes *buf) {
+    free(buf->data);
+    aurc_bytes_init(buf);
+}
+
+int aurc_bytes_reserve(aurc_bytes *buf, size_t extra) {
+    if (extra <= buf->cap - buf->len) {
+        return 0;
+    }
+    size_t needed = buf->len + extra;
+    if (needed < buf->len) {
+        aurc_diag_printf("aurc-native: byte buffer size overflow\n");
+        return 1;
+    }
+    size_t cap = buf->cap ? buf->cap : 256;
+    while (cap < needed) {
+        cap *= 2;
+    }
+    uint8_t *data = realloc(buf->data, cap);
+    if (!data) {
+        aurc_diag_printf("aurc-native: out of memory growing byte buffer to %zu bytes\n", cap);
+        return 1;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return 0;
+}
+
+int aurc_bytes_append(aurc_bytes *buf, const void *data, size_t len) {
+    if (len == 0) {
+        return 0;
+    }
+    if (aurc_bytes_reserve(buf, len) != 0) {
+        return 1;
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return 0;
+}
+
+int aurc_bytes_append_u8(aurc_bytes *buf, uint8_t value) {
+    return aurc_bytes_append(buf, &value, 1);
+}
+
+int aurc_bytes_append_le16(aurc_bytes *buf, uint16_t value) {
+    uint8_t bytes[2] = {(uint8_t)value, (uint8_t)(value >> 8)};
+    return aurc_bytes_append(buf, bytes, sizeof bytes);
+}
+
+int aurc_bytes_append_le32(aurc_bytes *buf, uint32_t value) {
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+    return aurc_bytes_append(buf, bytes, sizeof bytes);
+}
+
+int aurc_bytes_append_le64(aurc_bytes *buf, uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+    return aurc_bytes_append(buf, bytes, sizeof bytes);
+}
+
+int aurc_bytes_append_zeros(aurc_bytes *buf, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    if (aurc_bytes_reserve(buf, count) != 0) {
+        return 1;
+    }
+    memset(buf->data + buf->len, 0, count);
+    buf->len += count;
+    return 0;
+}
+
+void aurc_bytes_patch_le32(aurc_bytes *buf, size_t offset, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        buf->data[offset + (size_t)i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+int aurc_bytes_write_file(const aurc_bytes *buf, const char *path) {
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        aurc_diag_printf("aurc-native: cannot open %s for writing: %s\n", path, strerror(errno));
+        return 1;
+    }
+    if (buf->len > 0 && fwrite(buf->data, 1, buf->len, out) != buf->len) {
+        aurc_diag_printf("aurc-native: cannot write %s: %s\n", path, strerror(errno));
+        fclose(out);
+        return 1;
+    }
+    if (fclose(out) != 0) {
+        aurc_diag_printf("aurc-native: cannot write %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+int aurc_make_executable(const char *path) {
+#ifdef _WIN32
+    (void)path;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0 || chmod(path, (st.st_mode & 07777) | (st.st_mode & 0444) >> 2) != 0) {
+        aurc_diag_printf("aurc-native: cannot make %s executable: %s\n", path, strerror(errno));
+        return 1;
+    }
+#endif
+    return 0;
+}
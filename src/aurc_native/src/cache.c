@@ -0,0 +1,416 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "aurc_cache.h"
+#include "aurc_bytes.h"
+#include "aurc_diag.h"
+#include "aurc_thread.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define CACHE_FORMAT "aurc-cache 2"
+#define COPY_CHUNK (1u << 16)
+/* every entry starts with the magic, the content length (u64 LE) and the content's SHA-256 */
+#define ENTRY_MAGIC "AURCENT1"
+#define ENTRY_HEADER (8 + 8 + 32)
+
+/* ---- SHA-256 ------------------------------------------------------------ */
+
+typedef struct sha256 {
+    uint32_t state[8];
+    uint64_t length;        /* bytes hashed so far */
+    uint8_t block[64];
+    size_t used;
+} sha256;
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static uint32_t rotr(uint32_t x, unsigned n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static void sha256_block(sha256 *h, const uint8_t *p) {
+    uint32_t w[64];
+    for (unsigned i = 0; i < 16; ++i) {
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    }
+    for (unsigned i = 16; i < 64; ++i) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = h->state[0], b = h->state[1], c = h->state[2], d = h->state[3];
+    uint32_t e = h->state[4], f = h->state[5], g = h->state[6], k = h->state[7];
+    for (unsigned i = 0; i < 64; ++i) {
+        uint32_t t1 = k + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h->state[0] += a;
+    h->state[1] += b;
+    h->state[2] += c;
+    h->state[3] += d;
+    h->state[4] += e;
+    h->state[5] += f;
+    h->state[6] += g;
+    h->state[7] += k;
+}
+
+static void sha256_init(sha256 *h) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(h->state, initial, sizeof initial);
+    h->length = 0;
+    h->used = 0;
+}
+
+static void sha256_update(sha256 *h, const void *data, size_t len) {
+    const uint8_t *p = data;
+    h->length += len;
+    if (h->used) {
+        size_t take = 64 - h->used < len ? 64 - h->used : len;
+        memcpy(h->block + h->used, p, take);
+        h->used += take;
+        p += take;
+        len -= take;
+        if (h->used < 64) {
+            return;
+        }
+        sha256_block(h, h->block);
+        h->used = 0;
+    }
+    for (; len >= 64; p += 64, len -= 64) {
+        sha256_block(h, p);
+    }
+    memcpy(h->block, p, len);
+    h->used = len;
+}
+
+static void sha256_final(sha256 *h, uint8_t digest[32]) {
+    uint64_t bits = h->length * 8;
+    static const uint8_t pad[64] = {0x80};
+    size_t fill = h->used < 56 ? 56 - h->used : 120 - h->used;
+    sha256_update(h, pad, fill);
+    uint8_t length[8];
+    for (int i = 0; i < 8; ++i) {
+        length[i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    sha256_update(h, length, sizeof length);
+    for (int i = 0; i < 8; ++i) {
+        for (int b = 0; b < 4; ++b) {
+            digest[4 * i + b] = (uint8_t)(h->state[i] >> (24 - 8 * b));
+        }
+    }
+}
+
+/* ---- keys --------------------------------------------------------------- */
+
+/* Path of the running executable in buf; 1 when the platform offers no way to find it. */
+static int self_path(char *buf, size_t cap) {
+#ifdef _WIN32
+    DWORD len = GetModuleFileNameA(NULL, buf, (DWORD)cap);
+    return len == 0 || len >= cap;
+#elif defined(__linux__)
+    ssize_t len = readlink("/proc/self/exe", buf, cap - 1);
+    if (len <= 0) {
+        return 1;
+    }
+    buf[len] = '\0';
+    return 0;
+#else
+    (void)buf;
+    (void)cap;
+    return 1;
+#endif
+}
+
+void aurc_cache_compiler_id(uint8_t id[AURC_CACHE_COMPILER_ID]) {
+    sha256 h;
+    sha256_init(&h);
+    static const char build[] = "aurc-native built " __DATE__ " " __TIME__;
+    sha256_update(&h, build, sizeof build);
+    /* size and modification time of the executable, as cheap to check as ccache's default */
+    uint64_t stamp[2] = {0, 0};
+    char path[4096];
+    if (self_path(path, sizeof path) == 0) {
+#ifdef _WIN32
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (GetFileAttributesExA(path, GetFileExInfoStandard, &data)) {
+            stamp[0] = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+            stamp[1] = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+        }
+#else
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            stamp[0] = (uint64_t)st.st_size;
+            stamp[1] = (uint64_t)st.st_mtim.tv_sec * 1000000000u + (uint64_t)st.st_mtim.tv_nsec;
+        }
+#endif
+    }
+    uint8_t bytes[16];
+    for (int i = 0; i < 16; ++i) {
+        bytes[i] = (uint8_t)(stamp[i / 8] >> (8 * (i % 8)));
+    }
+    sha256_update(&h, bytes, sizeof bytes);
+    sha256_final(&h, id);
+}
+
+void aurc_cache_key_for(const uint8_t compiler_id[AURC_CACHE_COMPILER_ID], const aurc_compile_options *options,
+                        aurc_view source, aurc_cache_key *key) {
+    sha256 h;
+    sha256_init(&h);
+    sha256_update(&h, CACHE_FORMAT, sizeof CACHE_FORMAT);
+    sha256_update(&h, compiler_id, AURC_CACHE_COMPILER_ID);
+    /* every switch that changes generated code; output paths and reporting flags do not */
+    uint8_t switches[4] = {(uint8_t)options->opt_level, (uint8_t)(options->shard_counters != 0),
+                           (uint8_t)options->target_cpu, (uint8_t)options->target_os};
+    sha256_update(&h, switches, sizeof switches);
+    uint8_t length[8];
+    for (int i = 0; i < 8; ++i) {
+        length[i] = (uint8_t)((uint64_t)source.len >> (8 * i));
+    }
+    sha256_update(&h, length, sizeof length);
+    sha256_update(&h, source.data, source.len);
+
+    uint8_t digest[32];
+    sha256_final(&h, digest);
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < 32; ++i) {
+        key->hex[2 * i] = digits[digest[i] >> 4];
+        key->hex[2 * i + 1] = digits[digest[i] & 15];
+    }
+    key->hex[64] = '\0';
+}
+
+/* ---- entries ------------------------------------------------------------ */
+
+typedef struct cache_output {
+    const char *path;       /* where the compile writes it, NULL when not requested */
+    const char *ext;
+    int executable;         /* copies out of the cache need the execute bit back */
+} cache_output;
+
+static void requested_outputs(const aurc_compile_options *options, cache_output out[3]) {
+    out[0] = (cache_output){options->manifest_path, ".aurs", 0};
+    out[1] = (cache_output){options->binary_path, ".bin", 0};
+    out[2] = (cache_output){options->exe_path, ".exe", options->target_os == AURC_OS_LINUX};
+}
+
+/* <dir>/<key><ext><suffix> in a malloc'd string */
+static char *entry_path(const char *dir, const aurc_cache_key *key, const char *ext, const char *suffix) {
+    size_t dir_len = strlen(dir);
+    int needs_sep = dir_len > 0 && dir[dir_len - 1] != '/' && dir[dir_len - 1] != '\\';
+    size_t len = dir_len + (size_t)needs_sep + 64 + strlen(ext) + strlen(suffix) + 1;
+    char *path = malloc(len);
+    if (!path) {
+        aurc_diag_printf("aurc-native: out of memory naming cache entries\n");
+        return NULL;
+    }
+    snprintf(path, len, "%s%s%s%s%s", dir, needs_sep ? "/" : "", key->hex, ext, suffix);
+    return path;
+}
+
+/* Copies in to out, hashing what passes through; returns the bytes copied, or -1 when a file fails (errno set). */
+static long long copy_stream(FILE *in, FILE *out, sha256 *h) {
+    uint8_t *chunk = malloc(COPY_CHUNK);
+    if (!chunk) {
+        errno = ENOMEM;
+        return -1;
+    }
+    long long total = 0;
+    size_t got;
+    while ((got = fread(chunk, 1, COPY_CHUNK, in)) > 0) {
+        if (fwrite(chunk, 1, got, out) != got) {
+            break;
+        }
+        sha256_update(h, chunk, got);
+        total += (long long)got;
+    }
+    int failed = ferror(in) || ferror(out);
+    free(chunk);
+    return failed ? -1 : total;
+}
+
+static void entry_header(uint8_t header[ENTRY_HEADER], uint64_t length, const uint8_t digest[32]) {
+    memcpy(header, ENTRY_MAGIC, 8);
+    for (int i = 0; i < 8; ++i) {
+        header[8 + i] = (uint8_t)(length >> (8 * i));
+    }
+    memcpy(header + 16, digest, 32);
+}
+
+/* Writes the file at from as the entry to, header first; 0 on success, otherwise -1 with errno set. */
+static int write_entry(const char *from, const char *to) {
+    FILE *in = fopen(from, "rb");
+    if (!in) {
+        return -1;
+    }
+    FILE *out = fopen(to, "wb");
+    if (!out) {
+        fclose(in);
+        return -1;
+    }
+    /* the header is only known once the contents went through, so it is written last */
+    uint8_t header[ENTRY_HEADER];
+    memset(header, 0, sizeof header);
+    sha256 h;
+    sha256_init(&h);
+    long long total = fwrite(header, 1, sizeof header, out) == sizeof header ? copy_stream(in, out, &h) : -1;
+    if (total >= 0) {
+        uint8_t digest[32];
+        sha256_final(&h, digest);
+        entry_header(header, (uint64_t)total, digest);
+        if (fseek(out, 0, SEEK_SET) != 0 || fwrite(header, 1, sizeof header, out) != sizeof header) {
+            total = -1;
+        }
+    }
+    fclose(in);
+    if (fclose(out) != 0) {
+        total = -1;
+    }
+    return total < 0 ? -1 : 0;
+}
+
+typedef enum entry_status {
+    ENTRY_COPIED,
+    ENTRY_MISSING,          /* or unreadable, or the output failed */
+    ENTRY_DAMAGED           /* the length or hash in its header does not match what follows */
+} entry_status;
+
+/* Copies the entry at from to to, checking it against its header; the bytes copied go to *copied. */
+static entry_status read_entry(const char *from, const char *to, uint64_t *copied) {
+    FILE *in = fopen(from, "rb");
+    if (!in) {
+        return ENTRY_MISSING;
+    }
+    uint8_t header[ENTRY_HEADER];
+    if (fread(header, 1, sizeof header, in) != sizeof header || memcmp(header, ENTRY_MAGIC, 8) != 0) {
+        int damaged = !ferror(in);
+        fclose(in);
+        return damaged ? ENTRY_DAMAGED : ENTRY_MISSING;
+    }
+    FILE *out = fopen(to, "wb");
+    if (!out) {
+        fclose(in);
+        return ENTRY_MISSING;
+    }
+    sha256 h;
+    sha256_init(&h);
+    long long total = copy_stream(in, out, &h);
+    fclose(in);
+    if (fclose(out) != 0 || total < 0) {
+        return ENTRY_MISSING;
+    }
+    uint8_t digest[32];
+    uint8_t expected[ENTRY_HEADER];
+    sha256_final(&h, digest);
+    entry_header(expected, (uint64_t)total, digest);
+    *copied = (uint64_t)total;
+    return memcmp(header, expected, sizeof expected) == 0 ? ENTRY_COPIED : ENTRY_DAMAGED;
+}
+
+/* rename() that replaces an existing target on every platform */
+static int replace_file(const char *from, const char *to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) ? 0 : 1;
+#else
+    return rename(from, to) != 0;
+#endif
+}
+
+static void make_directory(const char *dir) {
+#ifdef _WIN32
+    CreateDirectoryA(dir, NULL);
+#else
+    mkdir(dir, 0777);
+#endif
+}
+
+int aurc_cache_fetch(const aurc_compile_options *options, const aurc_cache_key *key, aurc_compile_stats *stats) {
+    cache_output outputs[3];
+    requested_outputs(options, outputs);
+    uint64_t written = 0;
+    int hit = 1;
+    for (int i = 0; i < 3 && hit; ++i) {
+        if (!outputs[i].path) {
+            continue;
+        }
+        char *entry = entry_path(options->cache_dir, key, outputs[i].ext, "");
+        uint64_t copied = 0;
+        entry_status status = entry ? read_entry(entry, outputs[i].path, &copied) : ENTRY_MISSING;
+        if (status == ENTRY_DAMAGED) {
+            /* a bad entry in a shared directory would be handed out again and again; the compile stores a good one */
+            aurc_diag_printf("aurc-native: discarding damaged cache entry %s\n", entry);
+            remove(entry);
+        }
+        hit = status == ENTRY_COPIED && (!outputs[i].executable || aurc_make_executable(outputs[i].path) == 0);
+        written += copied;
+        free(entry);
+    }
+    if (hit) {
+        stats->cache_hits = 1;
+        stats->bytes_written = written;
+    }
+    return hit;
+}
+
+void aurc_cache_store(const aurc_compile_options *options, const aurc_cache_key *key, aurc_compile_stats *stats) {
+    static volatile int64_t sequence;
+    cache_output outputs[3];
+    requested_outputs(options, outputs);
+    make_directory(options->cache_dir);
+#ifdef _WIN32
+    unsigned long pid = (unsigned long)GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    for (int i = 0; i < 3; ++i) {
+        if (!outputs[i].path) {
+            continue;
+        }
+        /* unique per process and per store, so concurrent writers of one entry never share a temporary */
+        char suffix[64];
+        snprintf(suffix, sizeof suffix, ".%lu.%lld.tmp", pid, (long long)aurc_atomic_add64(&sequence, 1));
+        char *temporary = entry_path(options->cache_dir, key, outputs[i].ext, suffix);
+        char *entry = entry_path(options->cache_dir, key, outputs[i].ext, "");
+        if (temporary && entry) {
+            if (write_entry(outputs[i].path, temporary) != 0 || replace_file(temporary, entry) != 0) {
+                aurc_diag_printf("aurc-native: cannot store %s in cache %s: %s\n", outputs[i].path, options->cache_dir,
+                                 strerror(errno));
+                remove(temporary);
+            } else {
+                ++stats->cache_stores;
+            }
+        }
+        free(temporary);
+        free(entry);
+    }
+}
@@ -0,0 +1,1196 @@
+#include "aurc_codegen.h"
+#include "aurc_bignum.h"
+#include "aurc_diag.h"
+#include "aurc_emit.h"
+#include "aurc_isa.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * IR -> Minimal ISA, written to an aurc_isa_sink. Label operands carry the
+ * 0xFE sentinel and name their target both to the sink and, for manifests,
+ * in the trailing comment (`; jmp main.L3`, `; cjmp lt, main.L3`,
+ * `; call fn_add`, `; mov r1, #addr(str_0)`) the assembler reads back.
+ * Atomic words name their shared slot by id, which the assembler resolves on
+ * its own; the image sink gets the slot's `shared.<name>` label instead.
+ */
+
+#define FIRST_TEMP ISA_REG_R2
+#define TEMP_COUNT 6
+#define TEMP_MASK ((1u << TEMP_COUNT) - 1)
+#define REG_SPILLED 0xFF
+#define REG_IMMEDIATE 0xFE      /* constant only read as the rhs of ALU ops, compares and branches */
+#define MAX_CALL_ARGS 7
+#define MAX_SHARED 256          /* the slot id travels in one operand byte */
+#define LABEL_MAX 160
+#define LOCAL_LABEL_MAX (LABEL_MAX + sizeof ".L4294967295")    /* the function's label, then .L<label> */
+
+typedef struct isa_gen {
+    aurc_isa_sink *sink;
+    const aurc_ir_program *ir;
+    const aurc_ir_function *fn;
+    char fn_label[LABEL_MAX];
+    uint8_t *reg;           /* register per value, REG_SPILLED when it lives in a frame slot */
+    uint32_t *slot;         /* frame slot of a spilled value */
+    int32_t *imm;           /* value of a REG_IMMEDIATE constant */
+    uint32_t *last_use;     /* last instruction reading each value */
+    uint8_t *call_saves;    /* temps live across each CALL/SPAWN (bit i = r2 + i), in program order */
+    uint8_t *local_reg;     /* register per local, REG_SPILLED when it stays in its frame slot */
+    uint32_t *local_slot;   /* frame slot of a spilled local */
+    uint32_t *owner;        /* local whose register a value shares, AURC_IR_NONE for the rest */
+    uint8_t *local_mask;    /* temps held by locals between instruction i and i + 1 */
+    size_t next_call;
+    uint32_t frame_locals;
+    uint32_t frame_slots;
+    uint32_t push_depth;    /* words pushed on top of the frame */
+    uint32_t next_label;    /* backend-local labels continue after the IR's own */
+} isa_gen;
+
+static const char *reg_name(uint8_t reg) {
+    static const char *const names[] = {"r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "sp"};
+    return reg <= ISA_REG_SP ? names[reg] : "r?";
+}
+
+/* target names the label a 0xFE operand refers to; the comment is only formatted for manifests. */
+static void emit_word(isa_gen *g, const char *target, uint64_t word, const char *fmt, ...) {
+    char comment[2 * LABEL_MAX];
+    comment[0] = '\0';
+    if (g->sink->wants_comments) {
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(comment, sizeof comment, fmt, args);
+        va_end(args);
+    }
+    g->sink->word(g->sink, word, target, comment);
+}
+
+/* Nonzero when the function's name does not fit in cap. */
+static int function_label(const aurc_ir_program *ir, uint32_t index, char *dst, size_t cap) {
+    if (index == ir->entry) {
+        snprintf(dst, cap, "main");
+        return 0;
+    }
+    int len = snprintf(dst, cap, "fn_%s", aurc_interner_cstr(&ir->symbols, ir->functions[index].name));
+    return len < 0 || (size_t)len >= cap;
+}
+
+static void local_label(const isa_gen *g, uint32_t label, char *dst, size_t cap) {
+    snprintf(dst, cap, "%s.L%u", g->fn_label, label);
+}
+
+static int32_t slot_offset(const isa_gen *g, uint32_t slot) {
+    return (int32_t)(ISA_WORD_SIZE * (slot + g->push_depth));
+}
+
+static void mov_imm(isa_gen *g, uint8_t dst, int32_t value) {
+    emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_MOV, dst, ISA_OPERAND_IMMEDIATE, ISA_OPERAND_UNUSED, (uint32_t)value),
+              "mov %s, #%d", reg_name(dst), (int)value);
+}
+
+static void mov_reg(isa_gen *g, uint8_t dst, uint8_t src) {
+    if (dst != src) {
+        emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_MOV, dst, src, ISA_OPERAND_UNUSED, 0), "mov %s, %s",
+                  reg_name(dst), reg_name(src));
+    }
+}
+
+static void alu(isa_gen *g, isa_opcode opcode, uint8_t dst, uint8_t lhs, uint8_t rhs) {
+    emit_word(g, NULL, pack_instruction_word((uint8_t)opcode, dst, lhs, rhs, 0), "%s %s, %s, %s", isa_mnemonic(opcode),
+              reg_name(dst), reg_name(lhs), reg_name(rhs));
+}
+
+static void alu_imm(isa_gen *g, isa_opcode opcode, uint8_t dst, uint8_t lhs, int32_t imm) {
+    emit_word(g, NULL, pack_instruction_word((uint8_t)opcode, dst, lhs, ISA_OPERAND_IMMEDIATE, (uint32_t)imm),
+              "%s %s, %s, #%d", isa_mnemonic(opcode), reg_name(dst), reg_name(lhs), (int)imm);
+}
+
+static void not_reg(isa_gen *g, uint8_t dst, uint8_t src) {
+    emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_NOT, dst, src, ISA_OPERAND_UNUSED, 0), "not %s, %s", reg_name(dst),
+              reg_name(src));
+}
+
+static void cmp_reg(isa_gen *g, uint8_t lhs, uint8_t rhs) {
+    emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_CMP, lhs, rhs, ISA_OPERAND_UNUSED, 0), "cmp %s, %s", reg_name(lhs),
+              reg_name(rhs));
+}
+
+static void cmp_imm(isa_gen *g, uint8_t lhs, int32_t imm) {
+    emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_CMP, lhs, ISA_OPERAND_IMMEDIATE, ISA_OPERAND_UNUSED, (uint32_t)imm),
+              "cmp %s, #%d", reg_name(lhs), (int)imm);
+}
+
+static const char *condition_name(isa_condition cond) {
+    switch (cond) {
+        case ISA_COND_EQ: return "eq";
+        case ISA_COND_NE: return "ne";
+        case ISA_COND_LT: return "lt";
+        case ISA_COND_LE: return "le";
+        case ISA_COND_GT: return "gt";
+        case ISA_COND_GE: return "ge";
+    }
+    return "?";
+}
+
+static void cjmp(isa_gen *g, isa_condition cond, const char *label) {
+    emit_word(g, label, pack_instruction_word(ISA_OPCODE_CJMP, (uint8_t)cond, ISA_OPERAND_LABEL, ISA_OPERAND_UNUSED, 0),
+              "cjmp %s, %s", condition_name(cond), label);
+}
+
+static void jmp(isa_gen *g, const char *label) {
+    emit_word(g, label, pack_instruction_word(ISA_OPCODE_JMP, ISA_OPERAND_LABEL, ISA_OPERAND_UNUSED, ISA_OPERAND_UNUSED, 0),
+              "jmp %s", label);
+}
+
+static void push_reg(isa_gen *g, uint8_t reg) {
+    emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_PUSH, reg, ISA_OPERAND_UNUSED, ISA_OPERAND_UNUSED, 0), "push %s",
+              reg_name(reg));
+    g->push_depth++;
+}
+
+static void pop_reg(isa_gen *g, uint8_t reg) {
+    emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_POP, reg, ISA_OPERAND_UNUSED, ISA_OPERAND_UNUSED, 0), "pop %s",
+              reg_name(reg));
+    g->push_depth--;
+}
+
+static void store_stack(isa_gen *g, uint8_t src, int32_t offset) {
+    emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_STORE_STACK, src, ISA_OPERAND_IMMEDIATE, ISA_OPERAND_UNUSED, (uint32_t)offset),
+              "store_stack %s, [sp+%d]", reg_name(src), (int)offset);
+}
+
+static void load_stack(isa_gen *g, uint8_t dst, int32_t offset) {
+    emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_LOAD_STACK, dst, ISA_OPERAND_IMMEDIATE, ISA_OPERAND_UNUSED, (uint32_t)offset),
+              "load_stack %s, [sp+%d]", reg_name(dst), (int)offset);
+}
+
+static void emit_label(isa_gen *g, const char *label) {
+    g->sink->label(g->sink, label);
+}
+
+/* Returns the register holding value, reloading a spilled one (or materialising an immediate) into scratch. */
+static uint8_t use(isa_gen *g, uint32_t value, uint8_t scratch) {
+    if (g->reg[value] == REG_IMMEDIATE) {
+        mov_imm(g, scratch, g->imm[value]);
+        return scratch;
+    }
+    if (g->reg[value] != REG_SPILLED) {
+        return g->reg[value];
+    }
+    load_stack(g, scratch, slot_offset(g, g->slot[value]));
+    return scratch;
+}
+
+/* Register to compute value into; spilled values go through r0 and are written back by commit(). */
+static uint8_t def(const isa_gen *g, uint32_t value) {
+    return g->reg[value] != REG_SPILLED ? g->reg[value] : ISA_REG_R0;
+}
+
+static void commit(isa_gen *g, uint32_t value) {
+    if (g->reg[value] == REG_SPILLED) {
+        store_stack(g, ISA_REG_R0, slot_offset(g, g->slot[value]));
+    }
+}
+
+static void load_constant(isa_gen *g, uint8_t dst, int64_t value) {
+    if (value >= INT32_MIN && value <= INT32_MAX) {
+        mov_imm(g, dst, (int32_t)value);
+        return;
+    }
+    /* signed high half, then the low half in two zero-extended 16-bit pieces */
+    uint64_t bits = (uint64_t)value;
+    mov_imm(g, dst, (int32_t)(value >> 32));
+    alu_imm(g, ISA_OPCODE_SHL, dst, dst, 16);
+    alu_imm(g, ISA_OPCODE_OR, dst, dst, (int32_t)((bits >> 16) & 0xFFFF));
+    alu_imm(g, ISA_OPCODE_SHL, dst, dst, 16);
+    alu_imm(g, ISA_OPCODE_OR, dst, dst, (int32_t)(bits & 0xFFFF));
+}
+
+static isa_condition condition_for(aurc_ir_op op) {
+    switch (op) {
+        case AURC_IR_EQ: case AURC_IR_BR_EQ: return ISA_COND_EQ;
+        case AURC_IR_NE: case AURC_IR_BR_NE: return ISA_COND_NE;
+        case AURC_IR_LT: case AURC_IR_BR_LT: return ISA_COND_LT;
+        case AURC_IR_LE: case AURC_IR_BR_LE: return ISA_COND_LE;
+        case AURC_IR_GT: case AURC_IR_BR_GT: return ISA_COND_GT;
+        default: return ISA_COND_GE;
+    }
+}
+
+/* Whether operand b of op may be encoded as an immediate (op2 / cmp op1 = 0xFF). */
+static int takes_immediate_rhs(aurc_ir_op op) {
+    return (op >= AURC_IR_ADD && op <= AURC_IR_GE) || aurc_ir_op_is_branch(op);
+}
+
+/*
+ * Locals in registers. Unlike values, locals live across labels, so each gets
+ * a live interval over the whole function: from its first access to its
+ * last, widened until it covers every loop (a branch back to an earlier
+ * label) it overlaps. That over-approximates liveness but never misses it.
+ * Intervals are scanned by start point; one takes a temp when that keeps
+ * every instruction it spans within TEMP_COUNT registers counting the values
+ * live there, otherwise the active interval with the lowest spill weight
+ * there gives its register up when that weight is below the newcomer's. The
+ * weight counts the loads and stores a register saves, 8x per loop level,
+ * less the push and pop every call inside the interval costs: the ISA
+ * convention has no callee-saved registers, so a register kept across a call
+ * is always paid for by the caller.
+ *
+ * Moves are coalesced: a value loaded from a register local reads the
+ * local's register while no store to the local intervenes, and a value
+ * computed only to be stored to one is computed straight into it, so the
+ * load_local / store_local pair around `i = i + 1` disappears.
+ */
+#define LOOP_WEIGHT_SHIFT 3
+#define LOOP_WEIGHT_DEPTH 6     /* deeper nests weigh as much as this one */
+
+typedef struct local_interval {
+    uint32_t local;
+    uint32_t start;
+    uint32_t end;
+    int64_t weight;
+} local_interval;
+
+/* Last gap (gap i sits between instructions i and i + 1) an interval covers; it always covers start. */
+static uint32_t last_gap(uint32_t start, uint32_t end) {
+    return end > start ? end - 1 : start;
+}
+
+static int64_t loop_weight(const uint8_t *depth, size_t at) {
+    return (int64_t)1 << (LOOP_WEIGHT_SHIFT * (depth[at] < LOOP_WEIGHT_DEPTH ? depth[at] : LOOP_WEIGHT_DEPTH));
+}
+
+static int ends_block(aurc_ir_op op) {
+    return op == AURC_IR_LABEL || op == AURC_IR_JUMP || aurc_ir_op_is_branch(op) || op == AURC_IR_RET ||
+           op == AURC_IR_EXIT;
+}
+
+/* Whether a store to local in (from, to] other than one of value could change the register under it. */
+static int local_stored_between(const aurc_ir_code *code, uint32_t local, uint32_t value, size_t from, size_t to) {
+    for (size_t i = from + 1; i <= to; ++i) {
+        if (code->op[i] == AURC_IR_STORE_LOCAL && code->a[i] == local && code->b[i] != value) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Whether the register of local can take value at its definition def, ahead of the store at store. */
+static int can_compute_into(const aurc_ir_code *code, uint32_t local, size_t def, size_t store) {
+    for (size_t i = def + 1; i < store; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (ends_block(op) || ((op == AURC_IR_LOAD_LOCAL || op == AURC_IR_STORE_LOCAL) && code->a[i] == local)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Picks the values that would share a local's register (owner[]) in one
+ * forward sweep; busy[] holds the last instruction reading each local's
+ * register through such a value, which a later value computed into the
+ * register may not precede.
+ */
+static void find_owners(isa_gen *g, uint32_t *store_at, uint32_t *busy) {
+    const aurc_ir_code *code = &g->fn->code;
+    for (uint32_t v = 0; v < g->fn->value_count; ++v) {
+        g->owner[v] = AURC_IR_NONE;
+        store_at[v] = AURC_IR_NONE;
+    }
+    for (uint32_t local = 0; local < g->fn->local_count; ++local) {
+        busy[local] = 0;
+    }
+    for (size_t i = code->count; i > 0; --i) {
+        if (code->op[i - 1] == AURC_IR_STORE_LOCAL) {
+            store_at[code->b[i - 1]] = (uint32_t)(i - 1);
+        }
+    }
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (!aurc_ir_op_has_dst(op)) {
+            continue;
+        }
+        uint32_t v = code->dst[i];
+        uint32_t last = g->last_use[v];
+        if (g->reg[v] == REG_IMMEDIATE) {
+            continue;
+        }
+        if (op == AURC_IR_LOAD_LOCAL && !local_stored_between(code, code->a[i], v, i, last)) {
+            g->owner[v] = code->a[i];
+        } else if (store_at[v] != AURC_IR_NONE) {
+            uint32_t store = store_at[v];
+            uint32_t local = code->a[store];
+            if (busy[local] <= i && can_compute_into(code, local, i, store) &&
+                !local_stored_between(code, local, v, store, last)) {
+                g->owner[v] = local;
+            }
+        }
+        if (g->owner[v] != AURC_IR_NONE && busy[g->owner[v]] < last) {
+            busy[g->owner[v]] = last;
+        }
+    }
+}
+
+static int compare_intervals(const void *lhs, const void *rhs) {
+    const local_interval *a = lhs;
+    const local_interval *b = rhs;
+    if (a->start != b->start) {
+        return a->start < b->start ? -1 : 1;
+    }
+    return a->local < b->local ? -1 : a->local > b->local;
+}
+
+/* Widens every interval over the loops it overlaps until none changes. */
+static void cover_loops(const aurc_ir_code *code, const uint32_t *label_at, local_interval *iv, uint32_t count) {
+    for (int changed = 1; changed;) {
+        changed = 0;
+        for (size_t j = 0; j < code->count; ++j) {
+            aurc_ir_op op = (aurc_ir_op)code->op[j];
+            if (op != AURC_IR_JUMP && !aurc_ir_op_is_branch(op)) {
+                continue;
+            }
+            uint32_t head = label_at[code->imm[j]];
+            if (head > j) {
+                continue;
+            }
+            for (uint32_t k = 0; k < count; ++k) {
+                if (iv[k].start <= j && iv[k].end >= head && (iv[k].start > head || iv[k].end < j)) {
+                    iv[k].start = iv[k].start < head ? iv[k].start : head;
+                    iv[k].end = iv[k].end > j ? iv[k].end : (uint32_t)j;
+                    changed = 1;
+                }
+            }
+        }
+    }
+}
+
+/* Loop nesting depth of every instruction, from the branches back to earlier labels. */
+static void loop_depths(const aurc_ir_code *code, const uint32_t *label_at, uint8_t *depth) {
+    int32_t level = 0;
+    int32_t *delta = calloc(code->count + 1, sizeof *delta);
+    if (!delta) {
+        memset(depth, 0, code->count);  /* weights only steer the choice; flat ones are still correct */
+        return;
+    }
+    for (size_t j = 0; j < code->count; ++j) {
+        aurc_ir_op op = (aurc_ir_op)code->op[j];
+        if ((op == AURC_IR_JUMP || aurc_ir_op_is_branch(op)) && label_at[code->imm[j]] <= j) {
+            delta[label_at[code->imm[j]]]++;
+            delta[j + 1]--;
+        }
+    }
+    for (size_t i = 0; i < code->count; ++i) {
+        level += delta[i];
+        depth[i] = (uint8_t)(level < UINT8_MAX ? level : UINT8_MAX);
+    }
+    free(delta);
+}
+
+/* Values (not sharing a local's register) live in each gap, which locals must leave registers for. */
+static void value_pressure(const isa_gen *g, uint32_t *pressure) {
+    const aurc_ir_code *code = &g->fn->code;
+    memset(pressure, 0, (code->count + 1) * sizeof *pressure);
+    for (size_t i = 0; i < code->count; ++i) {
+        uint32_t v = code->dst[i];
+        if (aurc_ir_op_has_dst((aurc_ir_op)code->op[i]) && g->reg[v] != REG_IMMEDIATE && g->owner[v] == AURC_IR_NONE) {
+            pressure[i]++;
+            pressure[last_gap((uint32_t)i, g->last_use[v]) + 1]--;
+        }
+    }
+    for (size_t i = 1; i <= code->count; ++i) {
+        pressure[i] += pressure[i - 1];
+    }
+}
+
+static void occupy(uint8_t *occupied, const local_interval *iv, int delta) {
+    for (uint32_t gap = iv->start; gap <= last_gap(iv->start, iv->end); ++gap) {
+        occupied[gap] = (uint8_t)(occupied[gap] + delta);
+    }
+}
+
+static void scan_intervals(isa_gen *g, local_interval *iv, uint32_t count, const uint32_t *pressure, uint8_t *occupied) {
+    local_interval *active[TEMP_COUNT];
+    unsigned active_count = 0;
+    for (uint32_t k = 0; k < count; ++k) {
+        local_interval *cur = &iv[k];
+        uint32_t cur_last = last_gap(cur->start, cur->end);
+        for (unsigned a = 0; a < active_count;) {
+            if (last_gap(active[a]->start, active[a]->end) < cur->start) {
+                active[a] = active[--active_count];
+            } else {
+                ++a;
+            }
+        }
+        int placed = 1;
+        for (;;) {
+            uint32_t full = UINT32_MAX;
+            for (uint32_t gap = cur->start; gap <= cur_last; ++gap) {
+                if (occupied[gap] + pressure[gap] + 1 > TEMP_COUNT) {
+                    full = gap;
+                    break;
+                }
+            }
+            if (full == UINT32_MAX) {
+                break;
+            }
+            unsigned victim = active_count;
+            for (unsigned a = 0; a < active_count; ++a) {
+                if (last_gap(active[a]->start, active[a]->end) >= full && active[a]->weight < cur->weight &&
+                    (victim == active_count || active[a]->weight < active[victim]->weight)) {
+                    victim = a;
+                }
+            }
+            if (victim == active_count) {
+                placed = 0;
+                break;
+            }
+            g->local_reg[active[victim]->local] = REG_SPILLED;
+            occupy(occupied, active[victim], -1);
+            active[victim] = active[--active_count];
+        }
+        if (!placed) {
+            continue;
+        }
+
+        unsigned taken = 0;
+        for (unsigned a = 0; a < active_count; ++a) {
+            taken |= 1u << (g->local_reg[active[a]->local] - FIRST_TEMP);
+        }
+        /* a parameter that arrives in a temp stays there */
+        unsigned bit = 0;
+        if (cur->local < g->fn->param_count && ISA_REG_R1 + cur->local >= FIRST_TEMP &&
+            !(taken & (1u << (ISA_REG_R1 + cur->local - FIRST_TEMP)))) {
+            bit = ISA_REG_R1 + cur->local - FIRST_TEMP;
+        } else {
+            while (taken & (1u << bit)) {
+                ++bit;
+            }
+        }
+        g->local_reg[cur->local] = (uint8_t)(FIRST_TEMP + bit);
+        occupy(occupied, cur, 1);
+        active[active_count++] = cur;
+    }
+}
+
+static void touch(local_interval *iv, uint32_t at) {
+    iv->start = at < iv->start ? at : iv->start;
+    iv->end = at > iv->end ? at : iv->end;
+}
+
+static int allocate_locals(isa_gen *g) {
+    const aurc_ir_code *code = &g->fn->code;
+    uint32_t locals = g->fn->local_count;
+    uint32_t values = g->fn->value_count;
+    size_t n = code->count;
+    g->local_reg = malloc(locals ? locals : 1);
+    g->local_slot = malloc((locals ? locals : 1) * sizeof *g->local_slot);
+    g->owner = malloc((values ? values : 1) * sizeof *g->owner);
+    g->local_mask = calloc(n ? n : 1, 1);
+    local_interval *iv = malloc((locals ? locals : 1) * sizeof *iv);
+    uint32_t *store_at = malloc((values ? values : 1) * sizeof *store_at);
+    uint32_t *busy = malloc((locals ? locals : 1) * sizeof *busy);
+    uint32_t *label_at = malloc((g->fn->label_count ? g->fn->label_count : 1) * sizeof *label_at);
+    uint32_t *pressure = malloc((n + 1) * sizeof *pressure);
+    uint8_t *depth = malloc(n ? n : 1);
+    uint8_t *occupied = calloc(n ? n : 1, 1);
+    int status = 0;
+    if (!g->local_reg || !g->local_slot || !g->owner || !g->local_mask || !iv || !store_at || !busy || !label_at ||
+        !pressure || !depth || !occupied) {
+        aurc_diag_printf("aurc-native: out of memory allocating registers\n");
+        status = 1;
+        goto done;
+    }
+
+    find_owners(g, store_at, busy);
+    for (size_t i = 0; i < n; ++i) {
+        if (code->op[i] == AURC_IR_LABEL) {
+            label_at[code->imm[i]] = (uint32_t)i;
+        }
+    }
+    loop_depths(code, label_at, depth);
+    for (uint32_t local = 0; local < locals; ++local) {
+        g->local_reg[local] = REG_SPILLED;
+        iv[local].local = local;
+        iv[local].start = UINT32_MAX;
+        iv[local].end = 0;
+        iv[local].weight = 0;
+        if (local < g->fn->param_count) {
+            touch(&iv[local], 0);
+            iv[local].weight = 1;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (op == AURC_IR_LOAD_LOCAL || op == AURC_IR_STORE_LOCAL) {
+            touch(&iv[code->a[i]], (uint32_t)i);
+            iv[code->a[i]].weight += loop_weight(depth, i);
+        }
+        if (aurc_ir_op_has_dst(op) && g->owner[code->dst[i]] != AURC_IR_NONE) {
+            local_interval *shared = &iv[g->owner[code->dst[i]]];
+            touch(shared, (uint32_t)i);
+            touch(shared, g->last_use[code->dst[i]]);
+        }
+    }
+    uint32_t count = 0;
+    for (uint32_t local = 0; local < locals; ++local) {
+        if (iv[local].start != UINT32_MAX) {
+            iv[count++] = iv[local];
+        }
+    }
+    cover_loops(code, label_at, iv, count);
+    for (uint32_t k = 0; k < count; ++k) {
+        for (uint32_t i = iv[k].start + 1; i < iv[k].end; ++i) {
+            if (aurc_ir_op_takes_args((aurc_ir_op)code->op[i])) {
+                iv[k].weight -= 2 * loop_weight(depth, i);
+            }
+        }
+    }
+    uint32_t kept = 0;
+    for (uint32_t k = 0; k < count; ++k) {
+        if (iv[k].weight > 0) {
+            iv[kept++] = iv[k];
+        }
+    }
+    qsort(iv, kept, sizeof *iv, compare_intervals);
+    value_pressure(g, pressure);
+    scan_intervals(g, iv, kept, pressure, occupied);
+
+    for (uint32_t k = 0; k < kept; ++k) {
+        uint8_t reg = g->local_reg[iv[k].local];
+        if (reg != REG_SPILLED) {
+            for (uint32_t gap = iv[k].start; gap <= last_gap(iv[k].start, iv[k].end) && gap < n; ++gap) {
+                g->local_mask[gap] |= (uint8_t)(1u << (reg - FIRST_TEMP));
+            }
+        }
+    }
+    g->frame_locals = 0;
+    for (uint32_t local = 0; local < locals; ++local) {
+        g->local_slot[local] = g->local_reg[local] == REG_SPILLED ? g->frame_locals++ : 0;
+    }
+    for (uint32_t v = 0; v < values; ++v) {
+        if (g->owner[v] != AURC_IR_NONE && g->local_reg[g->owner[v]] == REG_SPILLED) {
+            g->owner[v] = AURC_IR_NONE;
+        } else if (g->owner[v] != AURC_IR_NONE) {
+            g->reg[v] = g->local_reg[g->owner[v]];
+        }
+    }
+
+done:
+    free(iv);
+    free(store_at);
+    free(busy);
+    free(label_at);
+    free(pressure);
+    free(depth);
+    free(occupied);
+    return status;
+}
+
+/* Temps held by register locals anywhere in [def, last], the gaps a value defined at def and read until last spans. */
+static unsigned local_conflicts(const isa_gen *g, uint32_t def, uint32_t last) {
+    unsigned mask = 0;
+    for (uint32_t gap = def; gap <= last_gap(def, last) && gap < g->fn->code.count; ++gap) {
+        mask |= g->local_mask[gap];
+    }
+    return mask;
+}
+
+/*
+ * Linear allocation: after the locals have theirs (above), a register is
+ * taken at a value's definition and handed back after its last use. Since no
+ * value lives across a label (see aurc_ir.h) program order is enough; a
+ * register counts as taken while a local's interval holds it. With every temp
+ * taken the value gets a frame slot of its own. A 32-bit constant that is only ever the rhs of ALU
+ * ops, compares and branches, or is read just once, gets no register at all:
+ * its users encode it, or use() moves it straight into their scratch register.
+ */
+static int allocate(isa_gen *g) {
+    const aurc_ir_code *code = &g->fn->code;
+    uint32_t values = g->fn->value_count;
+    size_t calls = 0;
+    for (size_t i = 0; i < code->count; ++i) {
+        calls += aurc_ir_op_takes_args((aurc_ir_op)code->op[i]);
+    }
+    g->reg = calloc(values ? values : 1, 1);
+    g->slot = malloc((values ? values : 1) * sizeof *g->slot);
+    g->imm = malloc((values ? values : 1) * sizeof *g->imm);
+    g->last_use = malloc((values ? values : 1) * sizeof *g->last_use);
+    g->call_saves = malloc(calls ? calls : 1);
+    if (!g->reg || !g->slot || !g->imm || !g->last_use || !g->call_saves) {
+        aurc_diag_printf("aurc-native: out of memory allocating registers\n");
+        return 1;
+    }
+
+    /* slot counts each constant's register operand reads until allocation takes it over */
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        unsigned uses = aurc_ir_op_uses(op);
+        if (op == AURC_IR_CONST && code->imm[i] >= INT32_MIN && code->imm[i] <= INT32_MAX) {
+            g->reg[code->dst[i]] = REG_IMMEDIATE;
+            g->imm[code->dst[i]] = (int32_t)code->imm[i];
+            g->slot[code->dst[i]] = 0;
+        }
+        if ((uses & AURC_IR_USES_A) && code->a[i] != AURC_IR_NONE && g->reg[code->a[i]] == REG_IMMEDIATE) {
+            g->slot[code->a[i]]++;
+        }
+        if ((uses & AURC_IR_USES_B) && !takes_immediate_rhs(op) && g->reg[code->b[i]] == REG_IMMEDIATE) {
+            g->slot[code->b[i]]++;
+        }
+    }
+    for (uint32_t v = 0; v < values; ++v) {
+        if (g->reg[v] == REG_IMMEDIATE && g->slot[v] > 1) {
+            g->reg[v] = 0;
+        }
+    }
+
+    /* definitions precede uses, so one forward sweep leaves each value's last use */
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        unsigned uses = aurc_ir_op_uses(op);
+        if ((uses & AURC_IR_USES_A) && code->a[i] != AURC_IR_NONE) {
+            g->last_use[code->a[i]] = (uint32_t)i;
+        }
+        if (uses & AURC_IR_USES_B) {
+            g->last_use[code->b[i]] = (uint32_t)i;
+        }
+        if (aurc_ir_op_has_dst(op)) {
+            g->last_use[code->dst[i]] = (uint32_t)i;
+        }
+    }
+    if (allocate_locals(g) != 0) {
+        return 1;
+    }
+
+    unsigned free_mask = TEMP_MASK;
+    uint32_t spills = 0;
+    size_t call = 0;
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        unsigned uses = aurc_ir_op_uses(op);
+        uint32_t operands[2] = {(uses & AURC_IR_USES_A) ? code->a[i] : AURC_IR_NONE,
+                                (uses & AURC_IR_USES_B) ? code->b[i] : AURC_IR_NONE};
+        for (int k = 0; k < 2; ++k) {
+            uint32_t v = operands[k];
+            if (v != AURC_IR_NONE && g->last_use[v] == i && g->reg[v] < REG_IMMEDIATE && g->owner[v] == AURC_IR_NONE) {
+                free_mask |= 1u << (g->reg[v] - FIRST_TEMP);
+            }
+        }
+        if (aurc_ir_op_takes_args(op)) {
+            unsigned locals_across = i > 0 ? g->local_mask[i - 1] & g->local_mask[i] : 0;
+            g->call_saves[call++] = (uint8_t)((~free_mask & TEMP_MASK) | locals_across);
+        }
+        if (!aurc_ir_op_has_dst(op)) {
+            continue;
+        }
+        uint32_t dst = code->dst[i];
+        if (g->reg[dst] == REG_IMMEDIATE || g->owner[dst] != AURC_IR_NONE) {
+            continue;
+        }
+        unsigned usable = free_mask & ~local_conflicts(g, (uint32_t)i, g->last_use[dst]);
+        if (usable == 0) {
+            g->reg[dst] = REG_SPILLED;
+            g->slot[dst] = g->frame_locals + spills++;
+            continue;
+        }
+        unsigned bit = 0;
+        while (!(usable & (1u << bit))) {
+            ++bit;
+        }
+        g->reg[dst] = (uint8_t)(FIRST_TEMP + bit);
+        if (g->last_use[dst] != i) {
+            free_mask &= ~(1u << bit);
+        }
+    }
+    g->frame_slots = g->frame_locals + spills;
+    return 0;
+}
+
+static void release(isa_gen *g) {
+    free(g->reg);
+    free(g->slot);
+    free(g->imm);
+    free(g->last_use);
+    free(g->call_saves);
+    free(g->local_reg);
+    free(g->local_slot);
+    free(g->owner);
+    free(g->local_mask);
+    g->reg = NULL;
+    g->slot = NULL;
+    g->imm = NULL;
+    g->last_use = NULL;
+    g->call_saves = NULL;
+    g->local_reg = NULL;
+    g->local_slot = NULL;
+    g->owner = NULL;
+    g->local_mask = NULL;
+}
+
+/*
+ * Emits the ARG run [first, call) and the CALL or SPAWN at index call. A
+ * spawned task starts with the spawner's r1-r7, so spawn passes arguments
+ * exactly like call and leaves the handle in r0 instead of a result.
+ */
+static void gen_call(isa_gen *g, size_t first, size_t call) {
+    const aurc_ir_code *code = &g->fn->code;
+    unsigned saves = g->call_saves[g->next_call++];
+    uint32_t argc = (uint32_t)code->imm[call];
+
+    for (unsigned bit = 0; bit < TEMP_COUNT; ++bit) {
+        if (saves & (1u << bit)) {
+            push_reg(g, (uint8_t)(FIRST_TEMP + bit));
+        }
+    }
+    /* push every argument first: popping straight into r1..rN could clobber one not yet moved */
+    for (size_t i = first; i < call; ++i) {
+        push_reg(g, use(g, code->a[i], ISA_REG_R0));
+    }
+    for (uint32_t k = argc; k > 0; --k) {
+        pop_reg(g, (uint8_t)k);
+    }
+
+    char target[LABEL_MAX];
+    function_label(g->ir, code->a[call], target, sizeof target);   /* too long a name fails the callee's gen_function */
+    if (code->op[call] == AURC_IR_SPAWN) {
+        emit_word(g, target, pack_instruction_word(ISA_OPCODE_SPAWN, ISA_REG_R0, ISA_OPERAND_LABEL, ISA_OPERAND_UNUSED, 0),
+                  "spawn r0, %s", target);
+    } else {
+        emit_word(g, target, pack_instruction_word(ISA_OPCODE_CALL, ISA_OPERAND_LABEL, ISA_OPERAND_UNUSED, ISA_OPERAND_UNUSED, 0),
+                  "call %s", target);
+    }
+
+    for (unsigned bit = TEMP_COUNT; bit > 0; --bit) {
+        if (saves & (1u << (bit - 1))) {
+            pop_reg(g, (uint8_t)(FIRST_TEMP + bit - 1));
+        }
+    }
+    uint32_t dst = code->dst[call];
+    mov_reg(g, def(g, dst), ISA_REG_R0);
+    commit(g, dst);
+}
+
+static void gen_return(isa_gen *g, uint32_t value) {
+    if (value != AURC_IR_NONE) {
+        mov_reg(g, ISA_REG_R0, use(g, value, ISA_REG_R0));
+    } else {
+        mov_imm(g, ISA_REG_R0, 0);
+    }
+    if (g->frame_slots > 0) {
+        alu_imm(g, ISA_OPCODE_ADD, ISA_REG_SP, ISA_REG_SP, (int32_t)(g->frame_slots * ISA_WORD_SIZE));
+    }
+    emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_RET, 0, 0, 0, 0), "ret");
+}
+
+/* rhs is ISA_OPERAND_IMMEDIATE when value b is encoded in the cmp itself. */
+static void gen_compare(isa_gen *g, uint8_t lhs, uint8_t rhs, uint32_t b) {
+    if (rhs == ISA_OPERAND_IMMEDIATE) {
+        cmp_imm(g, lhs, g->imm[b]);
+    } else {
+        cmp_reg(g, lhs, rhs);
+    }
+}
+
+static void gen_binary(isa_gen *g, aurc_ir_op op, uint32_t dst, uint32_t a, uint32_t b) {
+    static const isa_opcode OPCODE[] = {
+        [AURC_IR_ADD] = ISA_OPCODE_ADD, [AURC_IR_SUB] = ISA_OPCODE_SUB, [AURC_IR_MUL] = ISA_OPCODE_MUL,
+        [AURC_IR_DIV] = ISA_OPCODE_DIV, [AURC_IR_MOD] = ISA_OPCODE_REM, [AURC_IR_AND] = ISA_OPCODE_AND,
+        [AURC_IR_OR] = ISA_OPCODE_OR,   [AURC_IR_XOR] = ISA_OPCODE_XOR, [AURC_IR_SHL] = ISA_OPCODE_SHL,
+        [AURC_IR_SHR] = ISA_OPCODE_SHR,
+    };
+    uint8_t lhs = use(g, a, ISA_REG_R0);
+    int immediate = g->reg[b] == REG_IMMEDIATE;
+    uint8_t rhs = immediate ? ISA_OPERAND_IMMEDIATE : use(g, b, ISA_REG_R1);
+    uint8_t rd = def(g, dst);
+    if (op >= AURC_IR_EQ && op <= AURC_IR_GE) {
+        /* materialise the flag: cmp; d = 1; skip when the condition holds; d = 0 */
+        char skip[LOCAL_LABEL_MAX];
+        local_label(g, g->next_label++, skip, sizeof skip);
+        gen_compare(g, lhs, rhs, b);
+        mov_imm(g, rd, 1);
+        cjmp(g, condition_for(op), skip);
+        mov_imm(g, rd, 0);
+        emit_label(g, skip);
+    } else if (immediate) {
+        alu_imm(g, OPCODE[op], rd, lhs, g->imm[b]);
+    } else {
+        alu(g, OPCODE[op], rd, lhs, rhs);
+    }
+    commit(g, dst);
+}
+
+static void shared_label(const isa_gen *g, uint32_t id, char *dst, size_t cap) {
+    snprintf(dst, cap, "shared.%s", aurc_interner_cstr(&g->ir->symbols, g->ir->shared[id].name));
+}
+
+/* atomic_load names the slot in op1, atomic_store / atomic_add in op0 (pipeline/src/codegen.js). */
+static void gen_atomic(isa_gen *g, isa_opcode opcode, uint32_t id, uint8_t reg) {
+    char label[LABEL_MAX];
+    shared_label(g, id, label, sizeof label);
+    uint8_t flags = g->ir->shared[id].sharded ? ISA_ATOMIC_SHARDED : ISA_OPERAND_UNUSED;
+    if (opcode == ISA_OPCODE_ATOMIC_LOAD) {
+        emit_word(g, label, pack_instruction_word((uint8_t)opcode, reg, (uint8_t)id, flags, 0),
+                  "atomic_load %s, shared[%u] ; %s", reg_name(reg), (unsigned)id, label);
+    } else {
+        emit_word(g, label, pack_instruction_word((uint8_t)opcode, (uint8_t)id, reg, flags, 0),
+                  "%s shared[%u], %s ; %s", opcode == ISA_OPCODE_ATOMIC_ADD ? "atomic_add" : "atomic_store",
+                  (unsigned)id, reg_name(reg), label);
+    }
+}
+
+static void gen_instruction(isa_gen *g, size_t *index) {
+    const aurc_ir_code *code = &g->fn->code;
+    size_t i = *index;
+    aurc_ir_op op = (aurc_ir_op)code->op[i];
+    uint32_t dst = code->dst[i];
+    uint32_t a = code->a[i];
+    uint32_t b = code->b[i];
+    char label[LOCAL_LABEL_MAX];
+
+    switch (op) {
+        case AURC_IR_CONST:
+            if (g->reg[dst] != REG_IMMEDIATE) {
+                load_constant(g, def(g, dst), code->imm[i]);
+                commit(g, dst);
+            }
+            break;
+        case AURC_IR_STRING:
+            snprintf(label, sizeof label, "str_%u", a);
+            emit_word(g, label, pack_instruction_word(ISA_OPCODE_MOV, def(g, dst), ISA_OPERAND_LABEL, ISA_OPERAND_UNUSED, 0),
+                      "mov %s, #addr(%s)", reg_name(def(g, dst)), label);
+            commit(g, dst);
+            break;
+        case AURC_IR_LOAD_LOCAL:
+            if (g->local_reg[a] != REG_SPILLED) {
+                mov_reg(g, def(g, dst), g->local_reg[a]);
+            } else {
+                load_stack(g, def(g, dst), slot_offset(g, g->local_slot[a]));
+            }
+            commit(g, dst);
+            break;
+        case AURC_IR_STORE_LOCAL:
+            if (g->local_reg[a] != REG_SPILLED && g->reg[b] == REG_IMMEDIATE) {
+                mov_imm(g, g->local_reg[a], g->imm[b]);
+            } else if (g->local_reg[a] != REG_SPILLED) {
+                mov_reg(g, g->local_reg[a], use(g, b, ISA_REG_R0));
+            } else {
+                store_stack(g, use(g, b, ISA_REG_R0), slot_offset(g, g->local_slot[a]));
+            }
+            break;
+        case AURC_IR_NEG: {
+            uint8_t src = use(g, a, ISA_REG_R0);
+            uint8_t rd = def(g, dst);
+            not_reg(g, rd, src);
+            alu_imm(g, ISA_OPCODE_ADD, rd, rd, 1);
+            commit(g, dst);
+            break;
+        }
+        case AURC_IR_BITNOT:
+            not_reg(g, def(g, dst), use(g, a, ISA_REG_R0));
+            commit(g, dst);
+            break;
+        case AURC_IR_NOT: {
+            uint8_t src = use(g, a, ISA_REG_R0);
+            uint8_t rd = def(g, dst);
+            local_label(g, g->next_label++, label, sizeof label);
+            cmp_imm(g, src, 0);
+            mov_imm(g, rd, 1);
+            cjmp(g, ISA_COND_EQ, label);
+            mov_imm(g, rd, 0);
+            emit_label(g, label);
+            commit(g, dst);
+            break;
+        }
+        case AURC_IR_LABEL:
+            local_label(g, (uint32_t)code->imm[i], label, sizeof label);
+            emit_label(g, label);
+            break;
+        case AURC_IR_JUMP:
+            local_label(g, (uint32_t)code->imm[i], label, sizeof label);
+            jmp(g, label);
+            break;
+        case AURC_IR_BR_EQ:
+        case AURC_IR_BR_NE:
+        case AURC_IR_BR_LT:
+        case AURC_IR_BR_LE:
+        case AURC_IR_BR_GT:
+        case AURC_IR_BR_GE: {
+            uint8_t lhs = use(g, a, ISA_REG_R0);
+            uint8_t rhs = g->reg[b] == REG_IMMEDIATE ? ISA_OPERAND_IMMEDIATE : use(g, b, ISA_REG_R1);
+            local_label(g, (uint32_t)code->imm[i], label, sizeof label);
+            gen_compare(g, lhs, rhs, b);
+            cjmp(g, condition_for(op), label);
+            break;
+        }
+        case AURC_IR_ARG: {
+            size_t call = i;
+            while (!aurc_ir_op_takes_args((aurc_ir_op)code->op[call])) {
+                ++call;
+            }
+            gen_call(g, i, call);
+            *index = call;
+            break;
+        }
+        case AURC_IR_CALL:
+        case AURC_IR_SPAWN:
+            gen_call(g, i, i);
+            break;
+        case AURC_IR_JOIN: {
+            uint8_t handle = use(g, a, ISA_REG_R0);
+            emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_JOIN, handle, ISA_OPERAND_UNUSED, ISA_OPERAND_UNUSED, 0),
+                      "join %s", reg_name(handle));
+            mov_reg(g, def(g, dst), ISA_REG_R0);
+            commit(g, dst);
+            break;
+        }
+        case AURC_IR_ATOMIC_LOAD:
+            gen_atomic(g, ISA_OPCODE_ATOMIC_LOAD, a, def(g, dst));
+            commit(g, dst);
+            break;
+        case AURC_IR_ATOMIC_STORE:
+            gen_atomic(g, ISA_OPCODE_ATOMIC_STORE, a, use(g, b, ISA_REG_R0));
+            break;
+        case AURC_IR_ATOMIC_ADD:
+            gen_atomic(g, ISA_OPCODE_ATOMIC_ADD, a, use(g, b, ISA_REG_R0));
+            break;
+        case AURC_IR_RET:
+            gen_return(g, a);
+            break;
+        case AURC_IR_PRINT_INT:
+            mov_reg(g, ISA_REG_R0, use(g, a, ISA_REG_R0));
+            emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_SVC, ISA_SERVICE_PRINT_INT, 0, 0, 0), "svc 0x05 print_int(r0)");
+            break;
+        case AURC_IR_PRINT_STR:
+            mov_reg(g, ISA_REG_R1, use(g, a, ISA_REG_R1));
+            emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_SVC, ISA_SERVICE_WRITE, 1, 0, 0), "svc 0x01 write(stdout)");
+            break;
+        case AURC_IR_FLUSH:
+            emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_SVC, ISA_SERVICE_FLUSH, 0, 0, 0), "svc 0x08 flush");
+            break;
+        case AURC_IR_INPUT_INT:
+            emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_SVC, ISA_SERVICE_INPUT_INT, 0, 0, 0), "svc 0x06 input_int -> r0");
+            mov_reg(g, def(g, dst), ISA_REG_R0);
+            commit(g, dst);
+            break;
+        case AURC_IR_EXIT:
+            mov_reg(g, ISA_REG_R0, use(g, a, ISA_REG_R0));
+            emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_SVC, ISA_SERVICE_EXIT, 0, 0, 0), "svc 0x02 exit(r0)");
+            break;
+        case AURC_IR_BIGNUM_UNARY:
+        case AURC_IR_BIGNUM_BINARY: {
+            aurc_bn_op service_op = (aurc_bn_op)code->imm[i];
+            mov_reg(g, ISA_REG_R0, use(g, a, ISA_REG_R0));
+            if (op == AURC_IR_BIGNUM_BINARY) {
+                mov_reg(g, ISA_REG_R1, use(g, b, ISA_REG_R1));
+            }
+            emit_word(g, NULL, pack_instruction_word(ISA_OPCODE_SVC, ISA_SERVICE_BIGNUM, (uint8_t)service_op, 0, 0),
+                      "svc 0x10 %s", aurc_bn_op_name(service_op));
+            mov_reg(g, def(g, dst), ISA_REG_R0);
+            commit(g, dst);
+            break;
+        }
+        default:
+            gen_binary(g, op, dst, a, b);
+            break;
+    }
+}
+
+/*
+ * Moves the arguments from r1..rN to their locals: frame slots first, then
+ * the registers as one parallel move, breaking cycles through r0.
+ */
+static void gen_parameters(isa_gen *g) {
+    uint8_t from[MAX_CALL_ARGS];
+    uint8_t to[MAX_CALL_ARGS];
+    unsigned pending = 0;
+    for (uint32_t p = 0; p < g->fn->param_count; ++p) {
+        uint8_t reg = g->local_reg[p];
+        if (reg == REG_SPILLED) {
+            store_stack(g, (uint8_t)(ISA_REG_R1 + p), slot_offset(g, g->local_slot[p]));
+        } else if (reg != ISA_REG_R1 + p) {
+            from[pending] = (uint8_t)(ISA_REG_R1 + p);
+            to[pending++] = reg;
+        }
+    }
+    while (pending > 0) {
+        unsigned ready = pending;
+        for (unsigned m = 0; m < pending && ready == pending; ++m) {
+            ready = m;
+            for (unsigned k = 0; k < pending; ++k) {
+                if (from[k] == to[m]) {
+                    ready = pending;
+                    break;
+                }
+            }
+        }
+        if (ready == pending) {
+            /* every target is still to be read: park the first one in r0 */
+            mov_reg(g, ISA_REG_R0, to[0]);
+            for (unsigned k = 0; k < pending; ++k) {
+                from[k] = from[k] == to[0] ? ISA_REG_R0 : from[k];
+            }
+            ready = 0;
+        }
+        mov_reg(g, to[ready], from[ready]);
+        from[ready] = from[pending - 1];
+        to[ready] = to[--pending];
+    }
+}
+
+/* ---- strings ------------------------------------------------------------ */
+
+typedef struct string_entry {
+    aurc_view text;
+    uint32_t id;
+} string_entry;
+
+/* Orders strings by their bytes read backwards, so a string comes right before the ones it ends. */
+static int compare_reversed(const void *a, const void *b) {
+    const string_entry *x = a;
+    const string_entry *y = b;
+    for (size_t i = 1; i <= x->text.len && i <= y->text.len; ++i) {
+        unsigned char cx = (unsigned char)x->text.data[x->text.len - i];
+        unsigned char cy = (unsigned char)y->text.data[y->text.len - i];
+        if (cx != cy) {
+            return cx < cy ? -1 : 1;
+        }
+    }
+    return (x->text.len > y->text.len) - (x->text.len < y->text.len);
+}
+
+static int ends_with(aurc_view text, aurc_view tail) {
+    return tail.len <= text.len && memcmp(text.data + text.len - tail.len, tail.data, tail.len) == 0;
+}
+
+/*
+ * Lays the interned strings out after the code, NUL-terminated. A string the
+ * next one in reversed order ends with has no bytes of its own: its label
+ * lands inside the longest string of that run (`"lo\n"` inside
+ * `"hello\n"`), so each distinct tail is stored once. Strings that own
+ * their bytes go out in id order.
+ */
+static int emit_strings(isa_gen *g) {
+    const aurc_interner *strings = &g->ir->strings;
+    uint32_t count = strings->count;
+    if (count == 0) {
+        return 0;
+    }
+    string_entry *sorted = malloc(count * sizeof *sorted);
+    uint32_t *position = malloc(count * sizeof *position);
+    if (!sorted || !position) {
+        free(sorted);
+        free(position);
+        aurc_diag_printf("aurc-native: out of memory laying out strings\n");
+        return 1;
+    }
+    for (uint32_t id = 0; id < count; ++id) {
+        sorted[id] = (string_entry){aurc_interner_get(strings, id), id};
+    }
+    qsort(sorted, count, sizeof *sorted, compare_reversed);
+    for (uint32_t i = 0; i < count; ++i) {
+        position[sorted[i].id] = i;
+    }
+    for (uint32_t id = 0; id < count; ++id) {
+        uint32_t last = position[id];
+        if (last + 1 < count && ends_with(sorted[last + 1].text, sorted[last].text)) {
+            continue;  /* stored inside a longer string */
+        }
+        uint32_t first = last;
+        while (first > 0 && ends_with(sorted[first].text, sorted[first - 1].text)) {
+            --first;
+        }
+        /* the run's strings, longest first, start further and further into the host */
+        aurc_view host = sorted[last].text;
+        size_t done = 0;
+        for (uint32_t i = last + 1; i-- > first;) {
+            size_t start = host.len - sorted[i].text.len;
+            char label[LABEL_MAX];
+            if (start > done) {
+                g->sink->bytes(g->sink, (aurc_view){host.data + done, start - done});
+                done = start;
+            }
+            snprintf(label, sizeof label, "str_%u", sorted[i].id);
+            emit_label(g, label);
+        }
+        g->sink->string(g->sink, (aurc_view){host.data + done, host.len - done});
+    }
+    free(sorted);
+    free(position);
+    return 0;
+}
+
+static int gen_function(isa_gen *g, uint32_t index) {
+    const aurc_ir_function *fn = &g->ir->functions[index];
+    g->fn = fn;
+    g->next_call = 0;
+    g->push_depth = 0;
+    g->next_label = fn->label_count;
+    if (function_label(g->ir, index, g->fn_label, sizeof g->fn_label) != 0) {
+        aurc_diag_printf("aurc-native: function name '%s' is longer than a manifest label allows\n",
+                aurc_interner_cstr(&g->ir->symbols, fn->name));
+        return 1;
+    }
+    if (fn->param_count > MAX_CALL_ARGS) {
+        aurc_diag_printf("aurc-native: function '%s' takes more than %d parameters\n",
+                aurc_interner_cstr(&g->ir->symbols, fn->name), MAX_CALL_ARGS);
+        return 1;
+    }
+    if (allocate(g) != 0) {
+        release(g);
+        return 1;
+    }
+
+    g->sink->directive(g->sink, "");
+    emit_label(g, g->fn_label);
+    if (g->frame_slots > 0) {
+        alu_imm(g, ISA_OPCODE_SUB, ISA_REG_SP, ISA_REG_SP, (int32_t)(g->frame_slots * ISA_WORD_SIZE));
+    }
+    gen_parameters(g);
+    for (size_t i = 0; i < fn->code.count; ++i) {
+        gen_instruction(g, &i);
+    }
+    release(g);
+    return 0;
+}
+
+int aurc_codegen_isa(const aurc_ir_program *ir, aurc_isa_sink *sink) {
+    isa_gen g;
+    memset(&g, 0, sizeof g);
+    g.sink = sink;
+    g.ir = ir;
+
+    sink->directive(sink, "# Aurora Minimal ISA manifest generated by aurc-native");
+    sink->directive(sink, "header minimal_isa");
+    sink->directive(sink, "org 0x0000");
+    if (ir->shared_count > MAX_SHARED) {
+        aurc_diag_printf("aurc-native: more than %d shared variables\n", MAX_SHARED);
+        return 1;
+    }
+    for (uint32_t id = 0; id < ir->shared_count; ++id) {
+        char label[LABEL_MAX];
+        shared_label(&g, id, label, sizeof label);
+        sink->shared(sink, id, label, ir->shared[id].init, ir->shared[id].sharded);
+    }
+    emit_label(&g, "__aur_start");
+    emit_word(&g, "main", pack_instruction_word(ISA_OPCODE_CALL, ISA_OPERAND_LABEL, ISA_OPERAND_UNUSED, ISA_OPERAND_UNUSED, 0),
+              "call main");
+    emit_word(&g, NULL, pack_instruction_word(ISA_OPCODE_SVC, ISA_SERVICE_EXIT, 0, 0, 0), "svc 0x02 exit(r0)");
+    emit_word(&g, NULL, pack_instruction_word(ISA_OPCODE_HALT, 0, 0, 0, 0), "halt");
+
+    for (uint32_t i = 0; i < ir->function_count; ++i) {
+        if (gen_function(&g, i) != 0) {
+            return 1;
+        }
+    }
+
+    if (ir->strings.count > 0) {
+        sink->directive(sink, "");
+    }
+    if (emit_strings(&g) != 0) {
+        return 1;
+    }
+    return sink->failed;
+}
@@ -0,0 +1,1157 @@
+#include "aurc_codegen.h"
+#include "aurc_diag.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * IR -> Win64 x86-64. Every local and every IR value gets its own 8-byte slot
+ * below rbp; instructions go through rax/rcx/rdx. Internal calls pass
+ * arguments in the outgoing area at [rsp + 8*i], which the callee reads as
+ * [rbp + 16 + 8*i], and return in rax. The print services are small runtime
+ * routines appended after the program code; only they and exit differ
+ * between Windows (kernel32 imports) and Linux (raw syscalls, no libc).
+ *
+ * With target->vectorize (-O2), counted loops that fold a lane-wise
+ * expression of the induction variable into accumulators get a packed
+ * preheader in front of their scalar code; see "reduction loops" below.
+ */
+
+#define STD_OUTPUT_HANDLE (-11)
+#define LINUX_SYS_WRITE 1
+#define LINUX_SYS_EXIT_GROUP 231
+#define LINUX_STDOUT 1
+
+typedef enum runtime_routine {
+    RUNTIME_WRITE = 0,       /* rcx = bytes, rdx = length */
+    RUNTIME_PRINT_STR,       /* rcx = string in the data section (length in the preceding 8 bytes) */
+    RUNTIME_PRINT_INT,       /* rcx = value, printed in decimal with a newline */
+    RUNTIME_COUNT
+} runtime_routine;
+
+typedef struct x86_gen {
+    const aurc_ir_program *ir;
+    const aurc_x86_target *target;
+    const aurc_ir_function *fn;
+    aurc_x86_asm *as;
+    uint32_t *function_labels;
+    uint32_t *labels;           /* x86 label per IR label of the current function */
+    uint32_t *string_offsets;   /* data offset of each string's bytes */
+    uint32_t runtime[RUNTIME_COUNT];
+    unsigned runtime_used;
+    /* reduction loop scratch for the current function, only with target->vectorize */
+    uint32_t *label_refs;
+    uint8_t *lane;              /* per value: lane_class */
+    uint8_t *vreg;              /* per value: vector register while it is live */
+    uint32_t *def_at;           /* per value: defining instruction */
+    uint32_t *last_use;
+    uint32_t *local_stores;     /* per local: stores in the loop body */
+    uint32_t *local_loads;
+} x86_gen;
+
+static int32_t local_disp(const x86_gen *g, uint32_t local) {
+    if (local < g->fn->param_count) {
+        return (int32_t)(16 + 8 * local);
+    }
+    return -(int32_t)(8 * (local - g->fn->param_count + 1));
+}
+
+static int32_t value_disp(const x86_gen *g, uint32_t value) {
+    return -(int32_t)(8 * (g->fn->local_count - g->fn->param_count + value + 1));
+}
+
+static void load(x86_gen *g, x86_reg reg, uint32_t value) {
+    x86_mov_reg_mem(g->as, reg, X86_RBP, value_disp(g, value));
+}
+
+static void store(x86_gen *g, uint32_t value, x86_reg reg) {
+    x86_mov_mem_reg(g->as, X86_RBP, value_disp(g, value), reg);
+}
+
+static void call_runtime(x86_gen *g, runtime_routine routine) {
+    g->runtime_used |= 1u << routine;
+    x86_call(g->as, g->runtime[routine]);
+}
+
+/* Where gen_exit takes the exit status: ExitProcess's first argument or exit_group's. */
+static x86_reg exit_status_reg(const x86_gen *g) {
+    return g->target->syscalls ? X86_RDI : X86_RCX;
+}
+
+static void gen_exit(x86_gen *g) {
+    if (g->target->syscalls) {
+        x86_mov_reg_imm(g->as, X86_RAX, LINUX_SYS_EXIT_GROUP);
+        x86_syscall(g->as);
+    } else {
+        x86_call_import(g->as, AURC_IMPORT_EXIT_PROCESS);
+    }
+}
+
+static x86_cond condition_for(aurc_ir_op op) {
+    switch (op) {
+        case AURC_IR_EQ: case AURC_IR_BR_EQ: return X86_CC_E;
+        case AURC_IR_NE: case AURC_IR_BR_NE: return X86_CC_NE;
+        case AURC_IR_LT: case AURC_IR_BR_LT: return X86_CC_L;
+        case AURC_IR_LE: case AURC_IR_BR_LE: return X86_CC_LE;
+        case AURC_IR_GT: case AURC_IR_BR_GT: return X86_CC_G;
+        default: return X86_CC_GE;
+    }
+}
+
+/* x86 idiv traps on INT64_MIN / -1, which the VM defines as INT64_MIN (remainder 0). */
+static void gen_divide(x86_gen *g, int remainder) {
+    aurc_x86_asm *as = g->as;
+    uint32_t divide = x86_new_label(as);
+    uint32_t done = x86_new_label(as);
+    x86_alu_reg_imm(as, X86_ALU_CMP, X86_RCX, -1);
+    x86_jcc(as, X86_CC_NE, divide);
+    if (remainder) {
+        x86_mov_reg_imm(as, X86_RAX, 0);
+    } else {
+        x86_unary(as, X86_UNARY_NEG, X86_RAX);
+    }
+    x86_jmp(as, done);
+    x86_bind_label(as, divide);
+    x86_cqo(as);
+    x86_unary(as, X86_UNARY_IDIV, X86_RCX);
+    if (remainder) {
+        x86_mov_reg_reg(as, X86_RAX, X86_RDX);
+    }
+    x86_bind_label(as, done);
+}
+
+static int gen_instruction(x86_gen *g, size_t i) {
+    aurc_x86_asm *as = g->as;
+    const aurc_ir_code *code = &g->fn->code;
+    aurc_ir_op op = (aurc_ir_op)code->op[i];
+    uint32_t dst = code->dst[i];
+    uint32_t a = code->a[i];
+    uint32_t b = code->b[i];
+
+    switch (op) {
+        case AURC_IR_CONST:
+            x86_mov_reg_imm(as, X86_RAX, code->imm[i]);
+            store(g, dst, X86_RAX);
+            break;
+        case AURC_IR_STRING:
+            x86_lea_data(as, X86_RAX, g->string_offsets[a]);
+            store(g, dst, X86_RAX);
+            break;
+        case AURC_IR_LOAD_LOCAL:
+            x86_mov_reg_mem(as, X86_RAX, X86_RBP, local_disp(g, a));
+            store(g, dst, X86_RAX);
+            break;
+        case AURC_IR_STORE_LOCAL:
+            load(g, X86_RAX, b);
+            x86_mov_mem_reg(as, X86_RBP, local_disp(g, a), X86_RAX);
+            break;
+        case AURC_IR_ADD:
+        case AURC_IR_SUB:
+        case AURC_IR_AND:
+        case AURC_IR_OR:
+        case AURC_IR_XOR: {
+            static const x86_alu_op alu[] = {
+                [AURC_IR_ADD] = X86_ALU_ADD, [AURC_IR_SUB] = X86_ALU_SUB, [AURC_IR_AND] = X86_ALU_AND,
+                [AURC_IR_OR] = X86_ALU_OR,   [AURC_IR_XOR] = X86_ALU_XOR,
+            };
+            load(g, X86_RAX, a);
+            load(g, X86_RCX, b);
+            x86_alu_reg_reg(as, alu[op], X86_RAX, X86_RCX);
+            store(g, dst, X86_RAX);
+            break;
+        }
+        case AURC_IR_MUL:
+            load(g, X86_RAX, a);
+            load(g, X86_RCX, b);
+            x86_imul_reg_reg(as, X86_RAX, X86_RCX);
+            store(g, dst, X86_RAX);
+            break;
+        case AURC_IR_DIV:
+        case AURC_IR_MOD:
+            load(g, X86_RAX, a);
+            load(g, X86_RCX, b);
+            gen_divide(g, op == AURC_IR_MOD);
+            store(g, dst, X86_RAX);
+            break;
+        case AURC_IR_SHL:
+        case AURC_IR_SHR:
+            load(g, X86_RAX, a);
+            load(g, X86_RCX, b);
+            x86_shift_cl(as, op == AURC_IR_SHL ? X86_SHIFT_SHL : X86_SHIFT_SAR, X86_RAX);
+            store(g, dst, X86_RAX);
+            break;
+        case AURC_IR_EQ:
+        case AURC_IR_NE:
+        case AURC_IR_LT:
+        case AURC_IR_LE:
+        case AURC_IR_GT:
+        case AURC_IR_GE:
+            load(g, X86_RAX, a);
+            load(g, X86_RCX, b);
+            x86_alu_reg_reg(as, X86_ALU_XOR, X86_RDX, X86_RDX);
+            x86_alu_reg_reg(as, X86_ALU_CMP, X86_RAX, X86_RCX);
+            x86_setcc(as, condition_for(op), X86_RDX);
+            store(g, dst, X86_RDX);
+            break;
+        case AURC_IR_NEG:
+        case AURC_IR_BITNOT:
+            load(g, X86_RAX, a);
+            x86_unary(as, op == AURC_IR_NEG ? X86_UNARY_NEG : X86_UNARY_NOT, X86_RAX);
+            store(g, dst, X86_RAX);
+            break;
+        case AURC_IR_NOT:
+            load(g, X86_RAX, a);
+            x86_alu_reg_reg(as, X86_ALU_XOR, X86_RDX, X86_RDX);
+            x86_test_reg_reg(as, X86_RAX, X86_RAX);
+            x86_setcc(as, X86_CC_E, X86_RDX);
+            store(g, dst, X86_RDX);
+            break;
+        case AURC_IR_LABEL:
+            x86_bind_label(as, g->labels[code->imm[i]]);
+            break;
+        case AURC_IR_JUMP:
+            x86_jmp(as, g->labels[code->imm[i]]);
+            break;
+        case AURC_IR_BR_EQ:
+        case AURC_IR_BR_NE:
+        case AURC_IR_BR_LT:
+        case AURC_IR_BR_LE:
+        case AURC_IR_BR_GT:
+        case AURC_IR_BR_GE:
+            load(g, X86_RAX, a);
+            load(g, X86_RCX, b);
+            x86_alu_reg_reg(as, X86_ALU_CMP, X86_RAX, X86_RCX);
+            x86_jcc(as, condition_for(op), g->labels[code->imm[i]]);
+            break;
+        case AURC_IR_ARG:
+            load(g, X86_RAX, a);
+            x86_mov_mem_reg(as, X86_RSP, (int32_t)(8 * code->imm[i]), X86_RAX);
+            break;
+        case AURC_IR_CALL:
+            x86_call(as, g->function_labels[a]);
+            store(g, dst, X86_RAX);
+            break;
+        case AURC_IR_RET:
+            if (a != AURC_IR_NONE) {
+                load(g, X86_RAX, a);
+            } else {
+                x86_mov_reg_imm(as, X86_RAX, 0);
+            }
+            x86_mov_reg_reg(as, X86_RSP, X86_RBP);
+            x86_pop(as, X86_RBP);
+            x86_ret(as);
+            break;
+        case AURC_IR_PRINT_INT:
+            load(g, X86_RCX, a);
+            call_runtime(g, RUNTIME_PRINT_INT);
+            break;
+        case AURC_IR_PRINT_STR:
+            load(g, X86_RCX, a);
+            call_runtime(g, RUNTIME_PRINT_STR);
+            break;
+        case AURC_IR_FLUSH:
+            break;  /* every print is already its own WriteFile or write */
+        case AURC_IR_EXIT:
+            load(g, exit_status_reg(g), a);
+            gen_exit(g);
+            break;
+        case AURC_IR_INPUT_INT:
+            aurc_diag_printf("aurc-native: input() is not supported by --emit-exe yet\n");
+            return 1;
+        case AURC_IR_SPAWN:
+        case AURC_IR_JOIN:
+        case AURC_IR_ATOMIC_LOAD:
+        case AURC_IR_ATOMIC_STORE:
+        case AURC_IR_ATOMIC_ADD:
+            aurc_diag_printf("aurc-native: threads and atomics are not supported by --emit-exe yet\n");
+            return 1;
+        case AURC_IR_BIGNUM_UNARY:
+        case AURC_IR_BIGNUM_BINARY:
+            aurc_diag_printf("aurc-native: bignums are not supported by --emit-exe yet\n");
+            return 1;
+        default:
+            aurc_diag_printf("aurc-native: x86 backend cannot lower '%s'\n", aurc_ir_op_name(op));
+            return 1;
+    }
+    return 0;
+}
+
+/* ---- reduction loops ---------------------------------------------------- */
+
+/*
+ * A loop `L: head; br c i, bound -> X; body; jump L` (nothing else jumping to
+ * L, head loads and constants only) is vectorized when its body steps the
+ * induction variable i by a constant and every other local it stores is a
+ * reduction `acc = acc op e` with op one of + - & | ^ and e built from i,
+ * constants and locals the loop leaves alone by + - * & | ^, negation,
+ * complement and shifts left by constants. Those operators act on each
+ * 64-bit lane exactly as on a scalar, and + & | ^ are associative and
+ * commutative modulo 2^64, so regrouping the iterations changes no result.
+ *
+ * The preheader computes the trip count n from the first test, then runs
+ * n / (lanes * unroll) blocks of lanes * unroll iterations with `unroll`
+ * independent accumulators per reduction: lane j of copy u carries iteration
+ * u * lanes + j of the block. The accumulators are folded into the locals,
+ * i is advanced past the blocks, and control falls into the untouched scalar
+ * loop, which runs the remaining iterations and the final test. SSE2 gives
+ * two lanes; AVX2 (--target-cpu x86-64-v3) gives four. Lane products are
+ * put together from 32x32-bit pmuludq halves, since neither has a packed
+ * 64-bit multiply. Vector registers are never live across a call.
+ */
+
+#define VEC_MAX_REDUCTIONS 4
+#define VEC_MAX_UNROLL 2
+#define VEC_REGISTERS 16
+#define VEC_SCRATCH 3               /* two product halves and the all-ones mask */
+
+enum {
+    LANE_NONE = 0,                  /* not part of any reduced expression */
+    LANE_IV,                        /* the induction variable: one lane register per copy */
+    LANE_UNIFORM,                   /* a constant or untouched local, broadcast once */
+    LANE_SHIFT_COUNT,               /* a constant only ever used as a shift count */
+    LANE_TEMP                       /* computed per copy into a pooled register */
+};
+
+typedef struct vec_plan {
+    size_t head;                    /* LABEL instruction */
+    size_t test;
+    size_t back;                    /* the jump back to head */
+    uint32_t iv;
+    int64_t step;
+    aurc_ir_op exit_op;             /* with the induction variable on the left */
+    uint32_t bound;
+    unsigned reductions;
+    uint32_t red_local[VEC_MAX_REDUCTIONS];
+    aurc_ir_op red_op[VEC_MAX_REDUCTIONS];
+    size_t red_at[VEC_MAX_REDUCTIONS];  /* the reduction instruction */
+    size_t red_store[VEC_MAX_REDUCTIONS];
+    uint32_t red_acc[VEC_MAX_REDUCTIONS];  /* its load of the accumulator */
+    uint32_t red_value[VEC_MAX_REDUCTIONS];
+    unsigned uniforms;
+    unsigned temps;                 /* most pooled registers one copy holds at once */
+    unsigned unroll;
+} vec_plan;
+
+typedef struct vec_regs {
+    x86_vec_mode mode;
+    unsigned lanes;
+    unsigned acc[VEC_MAX_REDUCTIONS][VEC_MAX_UNROLL];
+    unsigned iv[VEC_MAX_UNROLL];
+    unsigned step;
+    unsigned scratch;               /* first of VEC_SCRATCH */
+    unsigned free;                  /* bit mask of pooled registers */
+} vec_regs;
+
+static int is_reduction_op(aurc_ir_op op) {
+    return op == AURC_IR_ADD || op == AURC_IR_SUB || op == AURC_IR_AND || op == AURC_IR_OR || op == AURC_IR_XOR;
+}
+
+static int is_lane_op(aurc_ir_op op) {
+    return is_reduction_op(op) || op == AURC_IR_MUL || op == AURC_IR_SHL || op == AURC_IR_NEG || op == AURC_IR_BITNOT;
+}
+
+static x86_vec_op lane_op(aurc_ir_op op) {
+    switch (op) {
+        case AURC_IR_SUB: return X86_VEC_PSUBQ;
+        case AURC_IR_AND: return X86_VEC_PAND;
+        case AURC_IR_OR: return X86_VEC_POR;
+        case AURC_IR_XOR: return X86_VEC_PXOR;
+        default: return X86_VEC_PADDQ;
+    }
+}
+
+static int is_local_load(const aurc_ir_code *code, uint32_t def, uint32_t local) {
+    return def != AURC_IR_NONE && code->op[def] == AURC_IR_LOAD_LOCAL && code->a[def] == local;
+}
+
+/* The instruction defining v inside the planned loop, or AURC_IR_NONE for a value from before it (def_at keeps
+ * the entries of earlier loops in the function) */
+static uint32_t loop_def(const x86_gen *g, const vec_plan *plan, uint32_t v) {
+    uint32_t def = g->def_at[v];
+    return def != AURC_IR_NONE && def > plan->head && def < plan->back ? def : AURC_IR_NONE;
+}
+
+/* Marks value v and everything it is computed from as part of a reduced expression; 0 if some part is not lane-wise. */
+static int mark_lanes(x86_gen *g, const vec_plan *plan, uint32_t v) {
+    const aurc_ir_code *code = &g->fn->code;
+    if (g->lane[v] != LANE_NONE && g->lane[v] != LANE_SHIFT_COUNT) {
+        return 1;
+    }
+    uint32_t def = loop_def(g, plan, v);
+    if (def == AURC_IR_NONE) {
+        return 0;
+    }
+    aurc_ir_op op = (aurc_ir_op)code->op[def];
+    if (op == AURC_IR_CONST) {
+        g->lane[v] = LANE_UNIFORM;
+        return 1;
+    }
+    if (op == AURC_IR_LOAD_LOCAL) {
+        if (code->a[def] == plan->iv) {
+            g->lane[v] = LANE_IV;
+        } else if (g->local_stores[code->a[def]] == 0) {
+            g->lane[v] = LANE_UNIFORM;
+        } else {
+            return 0;
+        }
+        return 1;
+    }
+    if (!is_lane_op(op)) {
+        return 0;
+    }
+    g->lane[v] = LANE_TEMP;
+    if (op == AURC_IR_SHL) {
+        uint32_t count = loop_def(g, plan, code->b[def]);
+        if (count == AURC_IR_NONE || code->op[count] != AURC_IR_CONST) {
+            return 0;
+        }
+        if (g->lane[code->b[def]] == LANE_NONE) {
+            g->lane[code->b[def]] = LANE_SHIFT_COUNT;
+        }
+        return mark_lanes(g, plan, code->a[def]);
+    }
+    if (op == AURC_IR_NEG || op == AURC_IR_BITNOT) {
+        return mark_lanes(g, plan, code->a[def]);
+    }
+    return mark_lanes(g, plan, code->a[def]) && mark_lanes(g, plan, code->b[def]);
+}
+
+static void note_use(x86_gen *g, uint32_t v, size_t i) {
+    if (g->lane[v] == LANE_TEMP) {
+        g->last_use[v] = (uint32_t)i;
+    }
+}
+
+/* Pooled registers copy generation will hold at most at once, freeing operands only after the result is allocated. */
+static unsigned count_temps(x86_gen *g, const vec_plan *plan) {
+    const aurc_ir_code *code = &g->fn->code;
+    unsigned live = 0;
+    unsigned most = 0;
+    for (size_t i = plan->test + 1; i < plan->back; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        uint32_t operands[2] = {AURC_IR_NONE, AURC_IR_NONE};
+        if (aurc_ir_op_has_dst(op) && g->lane[code->dst[i]] == LANE_TEMP) {
+            if (++live > most) {
+                most = live;
+            }
+            operands[0] = code->a[i];
+            if (op != AURC_IR_SHL && op != AURC_IR_NEG && op != AURC_IR_BITNOT && code->b[i] != code->a[i]) {
+                operands[1] = code->b[i];
+            }
+        } else {
+            for (unsigned r = 0; r < plan->reductions; ++r) {
+                if (plan->red_at[r] == i) {
+                    operands[0] = plan->red_value[r];
+                }
+            }
+        }
+        for (int k = 0; k < 2; ++k) {
+            if (operands[k] != AURC_IR_NONE && g->lane[operands[k]] == LANE_TEMP && g->last_use[operands[k]] == i) {
+                --live;
+            }
+        }
+    }
+    return most;
+}
+
+/* Whether the loop starting at LABEL code[head] can take a packed preheader; fills plan when it can. */
+static int plan_reduction_loop(x86_gen *g, size_t head, vec_plan *plan) {
+    const aurc_ir_function *fn = g->fn;
+    const aurc_ir_code *code = &fn->code;
+    int64_t label = code->imm[head];
+    if (g->label_refs[label] != 1) {
+        return 0;
+    }
+    memset(plan, 0, sizeof *plan);
+    plan->head = head;
+    plan->test = SIZE_MAX;
+    size_t end = head + 1;
+    while (end < code->count && code->op[end] != AURC_IR_LABEL) {
+        ++end;
+    }
+    if (end == head + 1 || code->op[end - 1] != AURC_IR_JUMP || code->imm[end - 1] != label) {
+        return 0;
+    }
+    plan->back = end - 1;
+    memset(g->local_stores, 0, fn->local_count * sizeof *g->local_stores);
+    memset(g->local_loads, 0, fn->local_count * sizeof *g->local_loads);
+    for (size_t i = head + 1; i < plan->back; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (aurc_ir_op_has_dst(op)) {
+            g->def_at[code->dst[i]] = (uint32_t)i;
+            g->lane[code->dst[i]] = LANE_NONE;
+        }
+        if (aurc_ir_op_is_branch(op)) {
+            if (plan->test != SIZE_MAX) {
+                return 0;
+            }
+            plan->test = i;
+        } else if (plan->test == SIZE_MAX && op != AURC_IR_LOAD_LOCAL && op != AURC_IR_CONST) {
+            return 0;
+        } else if (op == AURC_IR_STORE_LOCAL) {
+            g->local_stores[code->a[i]]++;
+        } else if (op == AURC_IR_LOAD_LOCAL) {
+            g->local_loads[code->a[i]]++;
+        } else if (op != AURC_IR_CONST && !is_lane_op(op)) {
+            return 0;
+        }
+    }
+    if (plan->test == SIZE_MAX) {
+        return 0;
+    }
+
+    /* the induction variable is the stored local the exit test reads */
+    plan->exit_op = (aurc_ir_op)code->op[plan->test];
+    uint32_t iv_value = code->a[plan->test];
+    plan->bound = code->b[plan->test];
+    uint32_t iv_def = loop_def(g, plan, iv_value);
+    if (iv_def == AURC_IR_NONE || code->op[iv_def] != AURC_IR_LOAD_LOCAL || g->local_stores[code->a[iv_def]] == 0) {
+        uint32_t swap = iv_value;
+        iv_value = plan->bound;
+        plan->bound = swap;
+        switch (plan->exit_op) {
+            case AURC_IR_BR_LT: plan->exit_op = AURC_IR_BR_GT; break;
+            case AURC_IR_BR_LE: plan->exit_op = AURC_IR_BR_GE; break;
+            case AURC_IR_BR_GT: plan->exit_op = AURC_IR_BR_LT; break;
+            case AURC_IR_BR_GE: plan->exit_op = AURC_IR_BR_LE; break;
+            default: break;
+        }
+    }
+    /* a bound computed before the loop is invariant, and the preheader reads it from its slot */
+    iv_def = loop_def(g, plan, iv_value);
+    uint32_t bound_def = loop_def(g, plan, plan->bound);
+    if (iv_def == AURC_IR_NONE || code->op[iv_def] != AURC_IR_LOAD_LOCAL || g->local_stores[code->a[iv_def]] != 1 ||
+        (bound_def != AURC_IR_NONE && code->op[bound_def] == AURC_IR_LOAD_LOCAL &&
+         g->local_stores[code->a[bound_def]] != 0)) {
+        return 0;
+    }
+    plan->iv = code->a[iv_def];
+
+    for (size_t i = plan->test + 1; i < plan->back; ++i) {
+        if (code->op[i] != AURC_IR_STORE_LOCAL) {
+            continue;
+        }
+        uint32_t local = code->a[i];
+        uint32_t def = loop_def(g, plan, code->b[i]);
+        if (g->local_stores[local] != 1 || def == AURC_IR_NONE || def <= plan->test) {
+            return 0;
+        }
+        aurc_ir_op op = (aurc_ir_op)code->op[def];
+        unsigned uses = aurc_ir_op_uses(op);
+        uint32_t a = uses & AURC_IR_USES_A ? loop_def(g, plan, code->a[def]) : AURC_IR_NONE;
+        uint32_t b = uses & AURC_IR_USES_B ? loop_def(g, plan, code->b[def]) : AURC_IR_NONE;
+        if (local == plan->iv) {
+            /* i = i + c or i - c, where the i read precedes the store */
+            if ((op != AURC_IR_ADD && op != AURC_IR_SUB) || !is_local_load(code, a, plan->iv) || b == AURC_IR_NONE ||
+                code->op[b] != AURC_IR_CONST) {
+                return 0;
+            }
+            plan->step = op == AURC_IR_ADD ? code->imm[b] : (int64_t)(0 - (uint64_t)code->imm[b]);
+            continue;
+        }
+        if (!is_reduction_op(op) || plan->reductions == VEC_MAX_REDUCTIONS || g->local_loads[local] != 1) {
+            return 0;
+        }
+        unsigned r = plan->reductions++;
+        if (is_local_load(code, a, local)) {
+            plan->red_acc[r] = code->a[def];
+            plan->red_value[r] = code->b[def];
+        } else if (op != AURC_IR_SUB && is_local_load(code, b, local)) {
+            plan->red_acc[r] = code->b[def];
+            plan->red_value[r] = code->a[def];
+        } else {
+            return 0;
+        }
+        plan->red_local[r] = local;
+        plan->red_op[r] = op;
+        plan->red_at[r] = def;
+        plan->red_store[r] = i;
+    }
+    for (size_t i = plan->test + 1; i < plan->back; ++i) {
+        /* the loop may read i only before stepping it, and each accumulator only in its reduction */
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (op == AURC_IR_STORE_LOCAL && code->a[i] == plan->iv) {
+            for (size_t k = i + 1; k < plan->back; ++k) {
+                if (is_local_load(code, (uint32_t)k, plan->iv)) {
+                    return 0;
+                }
+            }
+        }
+    }
+    uint64_t magnitude = plan->step > 0 ? (uint64_t)plan->step : 0 - (uint64_t)plan->step;
+    int counted;
+    switch (plan->exit_op) {
+        case AURC_IR_BR_GE: case AURC_IR_BR_GT: counted = plan->step > 0; break;
+        case AURC_IR_BR_LE: case AURC_IR_BR_LT: counted = plan->step < 0; break;
+        case AURC_IR_BR_EQ: counted = magnitude == 1; break;
+        default: counted = 0; break;
+    }
+    if (!counted || plan->reductions == 0 || magnitude > (uint64_t)INT32_MAX) {
+        return 0;
+    }
+
+    for (unsigned r = 0; r < plan->reductions; ++r) {
+        if (!mark_lanes(g, plan, plan->red_value[r])) {
+            return 0;
+        }
+    }
+    /* an accumulator's load feeds only its reduction, whose result feeds only the store */
+    for (size_t i = head + 1; i < plan->back; ++i) {
+        unsigned uses = aurc_ir_op_uses((aurc_ir_op)code->op[i]);
+        for (unsigned r = 0; r < plan->reductions; ++r) {
+            uint32_t result = code->dst[plan->red_at[r]];
+            for (int k = 0; k < 2; ++k) {
+                uint32_t x = k == 0 ? code->a[i] : code->b[i];
+                if (!(uses & (k == 0 ? AURC_IR_USES_A : AURC_IR_USES_B))) {
+                    continue;
+                }
+                if ((x == plan->red_acc[r] && i != plan->red_at[r]) || (x == result && i != plan->red_store[r])) {
+                    return 0;
+                }
+            }
+        }
+    }
+
+    for (size_t i = head + 1; i < plan->back; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (aurc_ir_op_has_dst(op) && g->lane[code->dst[i]] == LANE_TEMP) {
+            note_use(g, code->a[i], i);
+            if (op != AURC_IR_SHL && op != AURC_IR_NEG && op != AURC_IR_BITNOT) {
+                note_use(g, code->b[i], i);
+            }
+        }
+        for (unsigned r = 0; r < plan->reductions; ++r) {
+            if (plan->red_at[r] == i) {
+                note_use(g, plan->red_value[r], i);
+            }
+        }
+        if (aurc_ir_op_has_dst(op) && g->lane[code->dst[i]] == LANE_UNIFORM) {
+            plan->uniforms++;
+        }
+    }
+    plan->temps = count_temps(g, plan);
+    for (plan->unroll = VEC_MAX_UNROLL; plan->unroll > 0; --plan->unroll) {
+        unsigned need = plan->reductions * plan->unroll + plan->unroll + 1 + plan->uniforms + VEC_SCRATCH + plan->temps;
+        if (need <= VEC_REGISTERS) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static unsigned lane_reg(const x86_gen *g, const vec_regs *regs, uint32_t v, unsigned copy) {
+    return g->lane[v] == LANE_IV ? regs->iv[copy] : g->vreg[v];
+}
+
+static void vec_broadcast_rax(x86_gen *g, const vec_regs *regs, unsigned dst) {
+    x86_vec_from_reg(g->as, regs->mode, dst, X86_RAX);
+    if (regs->mode == X86_VEC_SSE) {
+        x86_vec_alu(g->as, X86_VEC_SSE, X86_VEC_PUNPCKLQDQ, dst, dst, dst);
+    } else {
+        x86_vec_broadcast(g->as, dst, dst);
+    }
+}
+
+/* dst = lhs op rhs, whatever the encoding's operand rules */
+static void vec_binary(x86_gen *g, const vec_regs *regs, x86_vec_op op, unsigned dst, unsigned lhs, unsigned rhs) {
+    aurc_x86_asm *as = g->as;
+    if (regs->mode != X86_VEC_SSE || dst == lhs) {
+        x86_vec_alu(as, regs->mode, op, dst, lhs, rhs);
+    } else if (dst == rhs && op != X86_VEC_PSUBQ) {
+        x86_vec_alu(as, regs->mode, op, dst, dst, lhs);
+    } else if (dst == rhs) {
+        unsigned t = regs->scratch + 2;
+        x86_vec_mov(as, regs->mode, t, lhs);
+        x86_vec_alu(as, regs->mode, op, t, t, rhs);
+        x86_vec_mov(as, regs->mode, dst, t);
+    } else {
+        x86_vec_mov(as, regs->mode, dst, lhs);
+        x86_vec_alu(as, regs->mode, op, dst, dst, rhs);
+    }
+}
+
+static void vec_shift(x86_gen *g, const vec_regs *regs, x86_vec_shift op, unsigned dst, unsigned src, uint8_t count) {
+    if (regs->mode == X86_VEC_SSE && dst != src) {
+        x86_vec_mov(g->as, regs->mode, dst, src);
+    }
+    x86_vec_shift_imm(g->as, regs->mode, op, dst, src, count);
+}
+
+/* 64-bit lane product: lo(a) * lo(b) + ((hi(a) * lo(b) + lo(a) * hi(b)) << 32) */
+static void vec_multiply(x86_gen *g, const vec_regs *regs, unsigned dst, unsigned a, unsigned b) {
+    unsigned t0 = regs->scratch;
+    unsigned t1 = regs->scratch + 1;
+    vec_shift(g, regs, X86_VEC_PSRLQ, t0, a, 32);
+    vec_binary(g, regs, X86_VEC_PMULUDQ, t0, t0, b);
+    vec_shift(g, regs, X86_VEC_PSRLQ, t1, b, 32);
+    vec_binary(g, regs, X86_VEC_PMULUDQ, t1, t1, a);
+    vec_binary(g, regs, X86_VEC_PADDQ, t0, t0, t1);
+    vec_shift(g, regs, X86_VEC_PSLLQ, t0, t0, 32);
+    vec_binary(g, regs, X86_VEC_PMULUDQ, dst, a, b);
+    vec_binary(g, regs, X86_VEC_PADDQ, dst, dst, t0);
+}
+
+static unsigned take_reg(vec_regs *regs) {
+    unsigned reg = 0;
+    while (!(regs->free & (1u << reg))) {
+        ++reg;
+    }
+    regs->free &= ~(1u << reg);
+    return reg;
+}
+
+static void release(const x86_gen *g, vec_regs *regs, uint32_t v, size_t i) {
+    if (g->lane[v] == LANE_TEMP && g->last_use[v] == i) {
+        regs->free |= 1u << g->vreg[v];
+    }
+}
+
+/* One copy of the body on the lanes of copy, folding into that copy's accumulators. */
+static void gen_lane_copy(x86_gen *g, const vec_plan *plan, vec_regs *regs, unsigned copy) {
+    const aurc_ir_code *code = &g->fn->code;
+    for (size_t i = plan->test + 1; i < plan->back; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        for (unsigned r = 0; r < plan->reductions; ++r) {
+            if (plan->red_at[r] == i) {
+                uint32_t e = plan->red_value[r];
+                unsigned acc = regs->acc[r][copy];
+                vec_binary(g, regs, plan->red_op[r] == AURC_IR_SUB ? X86_VEC_PADDQ : lane_op(plan->red_op[r]), acc, acc,
+                           lane_reg(g, regs, e, copy));
+                release(g, regs, e, i);
+            }
+        }
+        if (!aurc_ir_op_has_dst(op) || g->lane[code->dst[i]] != LANE_TEMP) {
+            continue;
+        }
+        uint32_t dst_value = code->dst[i];
+        unsigned lhs = lane_reg(g, regs, code->a[i], copy);
+        unsigned dst = take_reg(regs);
+        g->vreg[dst_value] = (uint8_t)dst;
+        switch (op) {
+            case AURC_IR_MUL:
+                vec_multiply(g, regs, dst, lhs, lane_reg(g, regs, code->b[i], copy));
+                break;
+            case AURC_IR_SHL:
+                vec_shift(g, regs, X86_VEC_PSLLQ, dst, lhs, (uint8_t)(code->imm[loop_def(g, plan, code->b[i])] & 63));
+                break;
+            case AURC_IR_NEG:
+                x86_vec_alu(g->as, regs->mode, X86_VEC_PXOR, dst, dst, dst);
+                x86_vec_alu(g->as, regs->mode, X86_VEC_PSUBQ, dst, dst, lhs);
+                break;
+            case AURC_IR_BITNOT:
+                x86_vec_alu(g->as, regs->mode, X86_VEC_PCMPEQD, regs->scratch + 2, regs->scratch + 2, regs->scratch + 2);
+                vec_binary(g, regs, X86_VEC_PXOR, dst, lhs, regs->scratch + 2);
+                break;
+            default:
+                vec_binary(g, regs, lane_op(op), dst, lhs, lane_reg(g, regs, code->b[i], copy));
+                break;
+        }
+        release(g, regs, code->a[i], i);
+        if (op != AURC_IR_SHL && op != AURC_IR_NEG && op != AURC_IR_BITNOT && code->b[i] != code->a[i]) {
+            release(g, regs, code->b[i], i);
+        }
+    }
+}
+
+/* rax = iterations of the loop, given that its first test has already failed (i in r9, bound in rcx) */
+static void gen_trip_count(x86_gen *g, const vec_plan *plan) {
+    aurc_x86_asm *as = g->as;
+    uint64_t magnitude = plan->step > 0 ? (uint64_t)plan->step : 0 - (uint64_t)plan->step;
+    int towards_bound_up = plan->exit_op == AURC_IR_BR_GE || plan->exit_op == AURC_IR_BR_GT ||
+                           (plan->exit_op == AURC_IR_BR_EQ && plan->step > 0);
+    x86_mov_reg_reg(as, X86_RAX, towards_bound_up ? X86_RCX : X86_R9);
+    x86_alu_reg_reg(as, X86_ALU_SUB, X86_RAX, towards_bound_up ? X86_R9 : X86_RCX);
+    if (plan->exit_op == AURC_IR_BR_EQ) {
+        return;
+    }
+    /* i < bound and i > bound round the distance up; the inclusive tests count the last iteration on top */
+    int inclusive = plan->exit_op == AURC_IR_BR_GT || plan->exit_op == AURC_IR_BR_LT;
+    if (magnitude > 1) {
+        if (!inclusive) {
+            x86_alu_reg_imm(as, X86_ALU_ADD, X86_RAX, (int32_t)(magnitude - 1));
+        }
+        if ((magnitude & (magnitude - 1)) == 0) {
+            uint8_t shift = 0;
+            while (((uint64_t)1 << shift) != magnitude) {
+                ++shift;
+            }
+            x86_shift_imm(as, X86_SHIFT_SHR, X86_RAX, shift);
+        } else {
+            x86_alu_reg_reg(as, X86_ALU_XOR, X86_RDX, X86_RDX);
+            x86_mov_reg_imm(as, X86_R11, (int64_t)magnitude);
+            x86_unary(as, X86_UNARY_DIV, X86_R11);
+        }
+    }
+    if (inclusive) {
+        x86_alu_reg_imm(as, X86_ALU_ADD, X86_RAX, 1);
+    }
+}
+
+static void gen_vector_preheader(x86_gen *g, const vec_plan *plan) {
+    aurc_x86_asm *as = g->as;
+    const aurc_ir_code *code = &g->fn->code;
+    uint32_t scalar = g->labels[code->imm[plan->head]];
+    vec_regs regs;
+    memset(&regs, 0, sizeof regs);
+    regs.mode = g->target->avx2 ? X86_VEC_VEX256 : X86_VEC_SSE;
+    regs.lanes = g->target->avx2 ? 4 : 2;
+    x86_vec_mode narrow = g->target->avx2 ? X86_VEC_VEX128 : X86_VEC_SSE;
+    unsigned next = 0;
+    for (unsigned r = 0; r < plan->reductions; ++r) {
+        for (unsigned u = 0; u < plan->unroll; ++u) {
+            regs.acc[r][u] = next++;
+        }
+    }
+    for (unsigned u = 0; u < plan->unroll; ++u) {
+        regs.iv[u] = next++;
+    }
+    regs.step = next++;
+    regs.scratch = next;
+    next += VEC_SCRATCH;
+    for (size_t i = plan->head + 1; i < plan->back; ++i) {
+        if (aurc_ir_op_has_dst((aurc_ir_op)code->op[i]) && g->lane[code->dst[i]] == LANE_UNIFORM) {
+            g->vreg[code->dst[i]] = (uint8_t)next++;
+        }
+    }
+    regs.free = ((1u << VEC_REGISTERS) - 1) & ~((1u << next) - 1);
+    unsigned block = regs.lanes * plan->unroll;
+    uint8_t block_shift = block == 2 ? 1 : block == 4 ? 2 : 3;
+    uint64_t block_step = (uint64_t)plan->step * block;
+
+    /* enter the lanes only for at least one whole block */
+    x86_mov_reg_mem(as, X86_R9, X86_RBP, local_disp(g, plan->iv));
+    uint32_t bound_def = loop_def(g, plan, plan->bound);
+    if (bound_def == AURC_IR_NONE) {
+        load(g, X86_RCX, plan->bound);
+    } else if (code->op[bound_def] == AURC_IR_CONST) {
+        x86_mov_reg_imm(as, X86_RCX, code->imm[bound_def]);
+    } else {
+        x86_mov_reg_mem(as, X86_RCX, X86_RBP, local_disp(g, code->a[bound_def]));
+    }
+    x86_alu_reg_reg(as, X86_ALU_CMP, X86_R9, X86_RCX);
+    x86_jcc(as, condition_for(plan->exit_op), scalar);
+    gen_trip_count(g, plan);
+    x86_shift_imm(as, X86_SHIFT_SHR, X86_RAX, block_shift);
+    x86_jcc(as, X86_CC_E, scalar);
+    x86_mov_reg_reg(as, X86_R8, X86_RAX);
+    x86_mov_reg_reg(as, X86_R10, X86_RAX);
+
+    x86_mov_reg_reg(as, X86_RAX, X86_R9);
+    vec_broadcast_rax(g, &regs, regs.scratch);
+    for (unsigned u = 0; u < plan->unroll; ++u) {
+        int64_t offsets[4];
+        for (unsigned j = 0; j < regs.lanes; ++j) {
+            offsets[j] = (int64_t)((uint64_t)plan->step * (u * regs.lanes + j));
+        }
+        x86_lea_data(as, X86_RAX, x86_add_data(as, offsets, regs.lanes * sizeof offsets[0]));
+        x86_vec_load(as, regs.mode, regs.iv[u], X86_RAX, 0);
+        vec_binary(g, &regs, X86_VEC_PADDQ, regs.iv[u], regs.iv[u], regs.scratch);
+    }
+    x86_mov_reg_imm(as, X86_RAX, (int64_t)block_step);
+    vec_broadcast_rax(g, &regs, regs.step);
+    for (size_t i = plan->head + 1; i < plan->back; ++i) {
+        if (!aurc_ir_op_has_dst((aurc_ir_op)code->op[i]) || g->lane[code->dst[i]] != LANE_UNIFORM) {
+            continue;
+        }
+        if (code->op[i] == AURC_IR_CONST) {
+            x86_mov_reg_imm(as, X86_RAX, code->imm[i]);
+        } else {
+            x86_mov_reg_mem(as, X86_RAX, X86_RBP, local_disp(g, code->a[i]));
+        }
+        vec_broadcast_rax(g, &regs, g->vreg[code->dst[i]]);
+    }
+    for (unsigned r = 0; r < plan->reductions; ++r) {
+        x86_vec_op identity = plan->red_op[r] == AURC_IR_AND ? X86_VEC_PCMPEQD : X86_VEC_PXOR;
+        for (unsigned u = 0; u < plan->unroll; ++u) {
+            x86_vec_alu(as, regs.mode, identity, regs.acc[r][u], regs.acc[r][u], regs.acc[r][u]);
+        }
+    }
+
+    uint32_t top = x86_new_label(as);
+    x86_bind_label(as, top);
+    for (unsigned u = 0; u < plan->unroll; ++u) {
+        gen_lane_copy(g, plan, &regs, u);
+    }
+    for (unsigned u = 0; u < plan->unroll; ++u) {
+        vec_binary(g, &regs, X86_VEC_PADDQ, regs.iv[u], regs.iv[u], regs.step);
+    }
+    x86_alu_reg_imm(as, X86_ALU_SUB, X86_R8, 1);
+    x86_jcc(as, X86_CC_NE, top);
+
+    for (unsigned r = 0; r < plan->reductions; ++r) {
+        aurc_ir_op op = plan->red_op[r];
+        x86_vec_op fold = op == AURC_IR_SUB ? X86_VEC_PADDQ : lane_op(op);
+        unsigned acc = regs.acc[r][0];
+        for (unsigned u = 1; u < plan->unroll; ++u) {
+            vec_binary(g, &regs, fold, acc, acc, regs.acc[r][u]);
+        }
+        if (regs.mode == X86_VEC_VEX256) {
+            x86_vec_extract_high(as, regs.scratch, acc);
+            x86_vec_alu(as, narrow, fold, acc, acc, regs.scratch);
+        }
+        x86_vec_shuffle32(as, narrow, regs.scratch, acc, 0x4E);
+        x86_vec_alu(as, narrow, fold, acc, acc, regs.scratch);
+        x86_vec_to_reg(as, narrow, X86_RAX, acc);
+        static const x86_alu_op scalar_op[] = {
+            [AURC_IR_ADD] = X86_ALU_ADD, [AURC_IR_SUB] = X86_ALU_SUB, [AURC_IR_AND] = X86_ALU_AND,
+            [AURC_IR_OR] = X86_ALU_OR,   [AURC_IR_XOR] = X86_ALU_XOR,
+        };
+        x86_mov_reg_mem(as, X86_RCX, X86_RBP, local_disp(g, plan->red_local[r]));
+        x86_alu_reg_reg(as, scalar_op[op], X86_RCX, X86_RAX);
+        x86_mov_mem_reg(as, X86_RBP, local_disp(g, plan->red_local[r]), X86_RCX);
+    }
+    if (regs.mode == X86_VEC_VEX256) {
+        x86_vzeroupper(as);
+    }
+    x86_mov_reg_imm(as, X86_RAX, (int64_t)block_step);
+    x86_imul_reg_reg(as, X86_RAX, X86_R10);
+    x86_alu_reg_reg(as, X86_ALU_ADD, X86_RAX, X86_R9);
+    x86_mov_mem_reg(as, X86_RBP, local_disp(g, plan->iv), X86_RAX);
+}
+
+static void free_loop_scratch(x86_gen *g) {
+    free(g->label_refs);
+    free(g->lane);
+    free(g->vreg);
+    free(g->def_at);
+    free(g->last_use);
+    free(g->local_stores);
+    free(g->local_loads);
+    g->label_refs = NULL;
+    g->lane = NULL;
+    g->vreg = NULL;
+    g->def_at = NULL;
+    g->last_use = NULL;
+    g->local_stores = NULL;
+    g->local_loads = NULL;
+}
+
+static int alloc_loop_scratch(x86_gen *g) {
+    const aurc_ir_function *fn = g->fn;
+    size_t values = fn->value_count ? fn->value_count : 1;
+    size_t locals = fn->local_count ? fn->local_count : 1;
+    free_loop_scratch(g);
+    g->label_refs = calloc(fn->label_count ? fn->label_count : 1, sizeof *g->label_refs);
+    g->lane = calloc(values, 1);
+    g->vreg = malloc(values);
+    g->def_at = malloc(values * sizeof *g->def_at);
+    g->last_use = malloc(values * sizeof *g->last_use);
+    g->local_stores = malloc(locals * sizeof *g->local_stores);
+    g->local_loads = malloc(locals * sizeof *g->local_loads);
+    if (!g->label_refs || !g->lane || !g->vreg || !g->def_at || !g->last_use || !g->local_stores || !g->local_loads) {
+        aurc_diag_printf("aurc-native: out of memory lowering to x86-64\n");
+        return 1;
+    }
+    for (size_t v = 0; v < values; ++v) {
+        g->def_at[v] = AURC_IR_NONE;
+    }
+    for (size_t i = 0; i < fn->code.count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)fn->code.op[i];
+        if (op == AURC_IR_JUMP || aurc_ir_op_is_branch(op)) {
+            g->label_refs[fn->code.imm[i]]++;
+        }
+    }
+    return 0;
+}
+
+static int gen_function(x86_gen *g, uint32_t index) {
+    aurc_x86_asm *as = g->as;
+    const aurc_ir_function *fn = &g->ir->functions[index];
+    g->fn = fn;
+
+    uint32_t max_args = 4; /* the outgoing area doubles as Win64 shadow space for EXIT */
+    for (size_t i = 0; i < fn->code.count; ++i) {
+        if (fn->code.op[i] == AURC_IR_CALL && (uint32_t)fn->code.imm[i] > max_args) {
+            max_args = (uint32_t)fn->code.imm[i];
+        }
+    }
+    uint64_t frame = 8ull * (fn->local_count - fn->param_count + fn->value_count + max_args);
+    frame = (frame + 15) & ~15ull;
+    if (frame > INT32_MAX) {
+        aurc_diag_printf("aurc-native: stack frame of '%s' is too large\n", aurc_interner_cstr(&g->ir->symbols, fn->name));
+        return 1;
+    }
+
+    free(g->labels);
+    g->labels = malloc((fn->label_count ? fn->label_count : 1) * sizeof *g->labels);
+    if (!g->labels) {
+        aurc_diag_printf("aurc-native: out of memory lowering to x86-64\n");
+        return 1;
+    }
+    for (uint32_t l = 0; l < fn->label_count; ++l) {
+        g->labels[l] = x86_new_label(as);
+    }
+    if (g->target->vectorize && alloc_loop_scratch(g) != 0) {
+        return 1;
+    }
+
+    x86_bind_label(as, g->function_labels[index]);
+    x86_push(as, X86_RBP);
+    x86_mov_reg_reg(as, X86_RBP, X86_RSP);
+    if (frame > 0) {
+        x86_alu_reg_imm(as, X86_ALU_SUB, X86_RSP, (int32_t)frame);
+    }
+    for (size_t i = 0; i < fn->code.count; ++i) {
+        vec_plan plan;
+        if (g->target->vectorize && fn->code.op[i] == AURC_IR_LABEL && plan_reduction_loop(g, i, &plan)) {
+            gen_vector_preheader(g, &plan);
+        }
+        if (gen_instruction(g, i) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void gen_runtime(x86_gen *g) {
+    aurc_x86_asm *as = g->as;
+
+    if (g->runtime_used & (1u << RUNTIME_PRINT_STR)) {
+        x86_bind_label(as, g->runtime[RUNTIME_PRINT_STR]);
+        x86_mov_reg_mem(as, X86_RDX, X86_RCX, -8);
+        x86_jmp(as, g->runtime[RUNTIME_WRITE]);
+        g->runtime_used |= 1u << RUNTIME_WRITE;
+    }
+
+    if (g->runtime_used & (1u << RUNTIME_PRINT_INT)) {
+        uint32_t digits = x86_new_label(as);
+        uint32_t next = x86_new_label(as);
+        uint32_t out = x86_new_label(as);
+        /* digits are written backwards from the newline at [rsp + 0x37] */
+        x86_bind_label(as, g->runtime[RUNTIME_PRINT_INT]);
+        x86_alu_reg_imm(as, X86_ALU_SUB, X86_RSP, 0x38);
+        x86_mov_reg_reg(as, X86_RAX, X86_RCX);
+        x86_mov_reg_reg(as, X86_R9, X86_RCX);
+        x86_lea_mem(as, X86_R8, X86_RSP, 0x37);
+        x86_mov_mem8_imm(as, X86_R8, 0, '\n');
+        x86_test_reg_reg(as, X86_RAX, X86_RAX);
+        x86_jcc(as, X86_CC_NS, digits);
+        x86_unary(as, X86_UNARY_NEG, X86_RAX); /* INT64_MIN stays put and divides correctly unsigned */
+        x86_bind_label(as, digits);
+        x86_mov_reg_imm(as, X86_R10, 10);
+        x86_bind_label(as, next);
+        x86_alu_reg_reg(as, X86_ALU_XOR, X86_RDX, X86_RDX);
+        x86_unary(as, X86_UNARY_DIV, X86_R10);
+        x86_alu_reg_imm(as, X86_ALU_ADD, X86_RDX, '0');
+        x86_alu_reg_imm(as, X86_ALU_SUB, X86_R8, 1);
+        x86_mov_mem8_reg(as, X86_R8, 0, X86_RDX);
+        x86_test_reg_reg(as, X86_RAX, X86_RAX);
+        x86_jcc(as, X86_CC_NE, next);
+        x86_test_reg_reg(as, X86_R9, X86_R9);
+        x86_jcc(as, X86_CC_NS, out);
+        x86_alu_reg_imm(as, X86_ALU_SUB, X86_R8, 1);
+        x86_mov_mem8_imm(as, X86_R8, 0, '-');
+        x86_bind_label(as, out);
+        x86_lea_mem(as, X86_RDX, X86_RSP, 0x38);
+        x86_alu_reg_reg(as, X86_ALU_SUB, X86_RDX, X86_R8);
+        x86_mov_reg_reg(as, X86_RCX, X86_R8);
+        x86_call(as, g->runtime[RUNTIME_WRITE]);
+        x86_alu_reg_imm(as, X86_ALU_ADD, X86_RSP, 0x38);
+        x86_ret(as);
+        g->runtime_used |= 1u << RUNTIME_WRITE;
+    }
+
+    if ((g->runtime_used & (1u << RUNTIME_WRITE)) && g->target->syscalls) {
+        /* write(1, rcx, rdx) until everything is out; a failed or empty write gives up */
+        uint32_t again = x86_new_label(as);
+        uint32_t done = x86_new_label(as);
+        x86_bind_label(as, g->runtime[RUNTIME_WRITE]);
+        x86_mov_reg_reg(as, X86_RSI, X86_RCX);
+        x86_bind_label(as, again);
+        x86_mov_reg_imm(as, X86_RAX, LINUX_SYS_WRITE);
+        x86_mov_reg_imm(as, X86_RDI, LINUX_STDOUT);
+        x86_syscall(as);
+        x86_test_reg_reg(as, X86_RAX, X86_RAX);
+        x86_jcc(as, X86_CC_LE, done);
+        x86_alu_reg_reg(as, X86_ALU_ADD, X86_RSI, X86_RAX);
+        x86_alu_reg_reg(as, X86_ALU_SUB, X86_RDX, X86_RAX);
+        x86_jcc(as, X86_CC_NE, again);
+        x86_bind_label(as, done);
+        x86_ret(as);
+    } else if (g->runtime_used & (1u << RUNTIME_WRITE)) {
+        /* Win64: shadow space (0x20) + WriteFile's 5th argument (0x20) + bytes-written slot (0x28) */
+        x86_bind_label(as, g->runtime[RUNTIME_WRITE]);
+        x86_push(as, X86_RBX);
+        x86_push(as, X86_RSI);
+        x86_alu_reg_imm(as, X86_ALU_SUB, X86_RSP, 0x38);
+        x86_mov_reg_reg(as, X86_RSI, X86_RCX);
+        x86_mov_reg_reg(as, X86_RBX, X86_RDX);
+        x86_mov_reg_imm(as, X86_RCX, STD_OUTPUT_HANDLE);
+        x86_call_import(as, AURC_IMPORT_GET_STD_HANDLE);
+        x86_mov_reg_reg(as, X86_RCX, X86_RAX);
+        x86_mov_reg_reg(as, X86_RDX, X86_RSI);
+        x86_mov_reg_reg(as, X86_R8, X86_RBX);
+        x86_lea_rsp(as, X86_R9, 0x28);
+        x86_mov_rsp_imm(as, 0x20, 0);
+        x86_call_import(as, AURC_IMPORT_WRITE_FILE);
+        x86_alu_reg_imm(as, X86_ALU_ADD, X86_RSP, 0x38);
+        x86_pop(as, X86_RSI);
+        x86_pop(as, X86_RBX);
+        x86_ret(as);
+    }
+}
+
+static int add_strings(x86_gen *g) {
+    const aurc_interner *strings = &g->ir->strings;
+    for (uint32_t id = 0; id < strings->count; ++id) {
+        aurc_view text = aurc_interner_get(strings, id);
+        /* 8-byte length header, the bytes, then a NUL for good measure */
+        uint8_t *item = malloc(8 + text.len + 1);
+        if (!item) {
+            aurc_diag_printf("aurc-native: out of memory lowering to x86-64\n");
+            return 1;
+        }
+        for (int byte = 0; byte < 8; ++byte) {
+            item[byte] = (uint8_t)((uint64_t)text.len >> (8 * byte));
+        }
+        memcpy(item + 8, text.data, text.len);
+        item[8 + text.len] = 0;
+        g->string_offsets[id] = x86_add_data(g->as, item, 8 + text.len + 1) + 8;
+        free(item);
+    }
+    return 0;
+}
+
+int aurc_codegen_x86(const aurc_ir_program *ir, const aurc_x86_target *target, aurc_x86_asm *as) {
+    x86_gen g;
+    memset(&g, 0, sizeof g);
+    g.ir = ir;
+    g.target = target;
+    g.as = as;
+    g.function_labels = malloc((ir->function_count ? ir->function_count : 1) * sizeof *g.function_labels);
+    g.string_offsets = malloc((ir->strings.count ? ir->strings.count : 1) * sizeof *g.string_offsets);
+    if (!g.function_labels || !g.string_offsets) {
+        aurc_diag_printf("aurc-native: out of memory lowering to x86-64\n");
+        free(g.function_labels);
+        free(g.string_offsets);
+        return 1;
+    }
+    for (uint32_t i = 0; i < ir->function_count; ++i) {
+        g.function_labels[i] = x86_new_label(as);
+    }
+    for (int r = 0; r < RUNTIME_COUNT; ++r) {
+        g.runtime[r] = x86_new_label(as);
+    }
+
+    int rc = add_strings(&g);
+    if (rc == 0) {
+        /* entry point: Windows enters 8 off 16-byte alignment, Linux aligned, with argc at [rsp] */
+        x86_alu_reg_imm(as, X86_ALU_SUB, X86_RSP, target->syscalls ? 0x20 : 0x28);
+        x86_call(as, g.function_labels[ir->entry]);
+        x86_mov_reg_reg(as, exit_status_reg(&g), X86_RAX);
+        gen_exit(&g);
+    }
+    for (uint32_t i = 0; rc == 0 && i < ir->function_count; ++i) {
+        rc = gen_function(&g, i);
+    }
+    if (rc == 0) {
+        gen_runtime(&g);
+    }
+
+    free(g.function_labels);
+    free(g.labels);
+    free(g.string_offsets);
+    free_loop_scratch(&g);
+    return rc;
+}
@@ -0,0 +1,46 @@
+#include "aurc_diag.h"
+#include "aurc_thread.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+static AURC_THREAD_LOCAL aurc_bytes *capture;
+
+void aurc_diag_capture(aurc_bytes *buf) {
+    capture = buf;
+}
+
+void aurc_diag_vprintf(const char *fmt, va_list args) {
+    if (!capture) {
+        vfprintf(stderr, fmt, args);
+        return;
+    }
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(NULL, 0, fmt, copy);
+    va_end(copy);
+    /* a message that cannot be buffered still reaches the user, just out of order */
+    aurc_bytes *buf = capture;
+    capture = NULL; /* the reserve failure message must not come back here */
+    int full = len < 0 || aurc_bytes_reserve(buf, (size_t)len + 1) != 0;
+    capture = buf;
+    if (full) {
+        vfprintf(stderr, fmt, args);
+        return;
+    }
+    vsnprintf((char *)capture->data + capture->len, (size_t)len + 1, fmt, args);
+    capture->len += (size_t)len;
+}
+
+void aurc_diag_printf(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    aurc_diag_vprintf(fmt, args);
+    va_end(args);
+}
+
+void aurc_diag_perror(const char *prefix) {
+    int err = errno;
+    aurc_diag_printf("%s: %s\n", prefix, strerror(err));
+}
@@ -0,0 +1,108 @@
+#include "aurc_x86.h"
+#include "aurc_diag.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Minimal static ELF64 executable for Linux x86-64, mapped at 0x400000 like
+ * pipeline/src/backend/elf64_generator.js: the headers and code share one
+ * read/execute segment, the data section follows in a read-only one, and a
+ * PT_GNU_STACK entry keeps the stack non-executable. There is no
+ * interpreter, dynamic section or section table; the generated runtime talks
+ * to the kernel with raw syscalls, so code referring to an import fails to
+ * link.
+ */
+
+#define ELF_IMAGE_BASE 0x400000ull
+#define ELF_PAGE 0x1000u
+#define ELF_HEADER_SIZE 64u
+#define ELF_PHDR_SIZE 56u
+#define ELF_PHDR_COUNT 3u
+#define ELF_CODE_ALIGNMENT 16u
+
+#define ELF_PT_LOAD 1u
+#define ELF_PT_GNU_STACK 0x6474E551u
+#define ELF_PF_X 1u
+#define ELF_PF_W 2u
+#define ELF_PF_R 4u
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static int write_phdr(aurc_bytes *out, uint32_t type, uint32_t flags, uint64_t offset, uint64_t vaddr, uint64_t size,
+                      uint64_t alignment) {
+    int rc = aurc_bytes_append_le32(out, type);
+    rc |= aurc_bytes_append_le32(out, flags);
+    rc |= aurc_bytes_append_le64(out, offset);
+    rc |= aurc_bytes_append_le64(out, vaddr);
+    rc |= aurc_bytes_append_le64(out, vaddr);   /* p_paddr */
+    rc |= aurc_bytes_append_le64(out, size);    /* p_filesz */
+    rc |= aurc_bytes_append_le64(out, size);    /* p_memsz */
+    rc |= aurc_bytes_append_le64(out, alignment);
+    return rc;
+}
+
+int aurc_write_elf64(aurc_x86_asm *as, const char *path, size_t *size) {
+    if (as->data.len == 0) {
+        x86_add_data(as, "\0\0\0\0\0\0\0\0", 8);
+    }
+
+    const uint64_t text_offset = align_up(ELF_HEADER_SIZE + ELF_PHDR_COUNT * ELF_PHDR_SIZE, ELF_CODE_ALIGNMENT);
+    const uint64_t text_size = as->code.len;
+    const uint64_t text_end = text_offset + text_size;
+    /* the data segment starts on a page of its own, at the same offset within the page as in the file */
+    const uint64_t data_offset = align_up(text_end, ELF_CODE_ALIGNMENT);
+    const uint64_t data_size = as->data.len;
+    const uint64_t data_vaddr = ELF_IMAGE_BASE + align_up(text_end, ELF_PAGE) + data_offset % ELF_PAGE;
+    const uint64_t entry = ELF_IMAGE_BASE + text_offset;
+
+    if (aurc_x86_link(as, entry, data_vaddr, NULL) != 0) {
+        return 1;
+    }
+
+    aurc_bytes out;
+    aurc_bytes_init(&out);
+    int rc = 0;
+
+    /* e_ident: 64-bit, little-endian, version 1, System V ABI */
+    rc |= aurc_bytes_append(&out, "\x7F" "ELF\x02\x01\x01", 7);
+    rc |= aurc_bytes_append_zeros(&out, 9);
+    rc |= aurc_bytes_append_le16(&out, 2);                /* ET_EXEC */
+    rc |= aurc_bytes_append_le16(&out, 0x3E);             /* EM_X86_64 */
+    rc |= aurc_bytes_append_le32(&out, 1);                /* e_version */
+    rc |= aurc_bytes_append_le64(&out, entry);
+    rc |= aurc_bytes_append_le64(&out, ELF_HEADER_SIZE);  /* e_phoff */
+    rc |= aurc_bytes_append_le64(&out, 0);                /* e_shoff: no section table */
+    rc |= aurc_bytes_append_le32(&out, 0);                /* e_flags */
+    rc |= aurc_bytes_append_le16(&out, ELF_HEADER_SIZE);
+    rc |= aurc_bytes_append_le16(&out, ELF_PHDR_SIZE);
+    rc |= aurc_bytes_append_le16(&out, ELF_PHDR_COUNT);
+    rc |= aurc_bytes_append_le16(&out, 0);                /* e_shentsize */
+    rc |= aurc_bytes_append_le16(&out, 0);                /* e_shnum */
+    rc |= aurc_bytes_append_le16(&out, 0);                /* e_shstrndx */
+
+    rc |= write_phdr(&out, ELF_PT_LOAD, ELF_PF_R | ELF_PF_X, 0, ELF_IMAGE_BASE, text_end, ELF_PAGE);
+    rc |= write_phdr(&out, ELF_PT_LOAD, ELF_PF_R, data_offset, data_vaddr, data_size, ELF_PAGE);
+    rc |= write_phdr(&out, ELF_PT_GNU_STACK, ELF_PF_R | ELF_PF_W, 0, 0, 0, ELF_CODE_ALIGNMENT);
+
+    if (rc == 0) {
+        rc |= aurc_bytes_append_zeros(&out, text_offset - out.len);
+        rc |= aurc_bytes_append(&out, as->code.data, text_size);
+        rc |= aurc_bytes_append_zeros(&out, data_offset - text_end);
+        rc |= aurc_bytes_append(&out, as->data.data, data_size);
+    }
+    if (rc == 0) {
+        rc = aurc_bytes_write_file(&out, path);
+    }
+    if (rc == 0) {
+        rc = aurc_make_executable(path);
+    }
+    if (rc == 0 && size) {
+        *size = out.len;
+    }
+
+    aurc_bytes_free(&out);
+    return rc != 0 ? 1 : 0;
+}
@@ -0,0 +1,263 @@
+#include "aurc_image.h"
+#include "aurc_diag.h"
+#include "aurc_isa.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* ---- encoding ----------------------------------------------------------- */
+
+typedef struct image_section {
+    uint32_t kind;
+    uint32_t address;
+    uint32_t size;
+    uint32_t offset;
+    const uint8_t *data;    /* NULL: payload built separately */
+} image_section;
+
+static int compare_symbols(const void *a, const void *b) {
+    const aurc_image_symbol *x = a;
+    const aurc_image_symbol *y = b;
+    if (x->address != y->address) {
+        return x->address < y->address ? -1 : 1;
+    }
+    size_t common = x->name_len < y->name_len ? x->name_len : y->name_len;
+    int order = memcmp(x->name, y->name, common);
+    if (order != 0) {
+        return order;
+    }
+    return x->name_len < y->name_len ? -1 : x->name_len > y->name_len;
+}
+
+static int compare_relocs(const void *a, const void *b) {
+    const aurc_image_reloc *x = a;
+    const aurc_image_reloc *y = b;
+    return x->offset < y->offset ? -1 : x->offset > y->offset;
+}
+
+static size_t align_up(size_t value) {
+    return (value + AURC_IMAGE_ALIGN - 1) & ~(size_t)(AURC_IMAGE_ALIGN - 1);
+}
+
+static int append_symbols(const aurc_image_layout *layout, aurc_bytes *out) {
+    int rc = aurc_bytes_append_le32(out, (uint32_t)layout->symbol_count);
+    uint32_t name_offset = 0;
+    for (size_t i = 0; i < layout->symbol_count; ++i) {
+        rc |= aurc_bytes_append_le32(out, layout->symbols[i].address);
+        rc |= aurc_bytes_append_le32(out, name_offset);
+        name_offset += (uint32_t)layout->symbols[i].name_len + 1;
+    }
+    for (size_t i = 0; i < layout->symbol_count; ++i) {
+        rc |= aurc_bytes_append(out, layout->symbols[i].name, layout->symbols[i].name_len);
+        rc |= aurc_bytes_append_u8(out, 0);
+    }
+    return rc;
+}
+
+static int append_relocs(const aurc_image_layout *layout, aurc_bytes *out) {
+    int rc = aurc_bytes_append_le32(out, (uint32_t)layout->reloc_count);
+    for (size_t i = 0; i < layout->reloc_count; ++i) {
+        rc |= aurc_bytes_append_le32(out, layout->relocs[i].offset);
+        rc |= aurc_bytes_append_le32(out, layout->relocs[i].kind);
+    }
+    return rc;
+}
+
+int aurc_image_encode(aurc_image_layout *layout, aurc_bytes *out) {
+    if (layout->size > UINT32_MAX || layout->code_size > layout->data_end || layout->data_end > layout->size ||
+        (layout->shared_size && (layout->shared_base < layout->data_end ||
+                                 layout->shared_base + layout->shared_size != layout->size))) {
+        aurc_diag_printf("aurc-native: image layout does not fit the image format\n");
+        return 1;
+    }
+    size_t names = 0;
+    for (size_t i = 0; i < layout->symbol_count; ++i) {
+        names += layout->symbols[i].name_len + 1;
+    }
+    qsort(layout->symbols, layout->symbol_count, sizeof *layout->symbols, compare_symbols);
+    qsort(layout->relocs, layout->reloc_count, sizeof *layout->relocs, compare_relocs);
+
+    image_section sections[5];
+    unsigned count = 0;
+    sections[count++] = (image_section){AURC_SECTION_CODE, 0, (uint32_t)layout->code_size, 0, layout->bytes};
+    if (layout->data_end > layout->code_size) {
+        sections[count++] = (image_section){AURC_SECTION_RODATA, (uint32_t)layout->code_size,
+                                            (uint32_t)(layout->data_end - layout->code_size), 0,
+                                            layout->bytes + layout->code_size};
+    }
+    if (layout->shared_size) {
+        sections[count++] = (image_section){AURC_SECTION_SHARED, (uint32_t)layout->shared_base,
+                                            (uint32_t)layout->shared_size, 0, layout->bytes + layout->shared_base};
+    }
+    if (layout->symbol_count) {
+        sections[count++] =
+            (image_section){AURC_SECTION_SYMBOLS, 0, (uint32_t)(4 + 8 * layout->symbol_count + names), 0, NULL};
+    }
+    if (layout->reloc_count) {
+        sections[count++] = (image_section){AURC_SECTION_RELOCS, 0, (uint32_t)(4 + 8 * layout->reloc_count), 0, NULL};
+    }
+
+    /* code on a boundary, rodata glued to it, everything else on a boundary again */
+    size_t offset = align_up(AURC_IMAGE_HEADER_SIZE + count * AURC_IMAGE_SECTION_ENTRY_SIZE);
+    for (unsigned i = 0; i < count; ++i) {
+        if (sections[i].kind != AURC_SECTION_RODATA) {
+            offset = align_up(offset);
+        }
+        if (offset + sections[i].size > UINT32_MAX) {
+            aurc_diag_printf("aurc-native: image exceeds the 4 GiB image format limit\n");
+            return 1;
+        }
+        sections[i].offset = (uint32_t)offset;
+        offset += sections[i].size;
+    }
+
+    size_t start = out->len;
+    int rc = 0;
+    rc |= aurc_bytes_append(out, AURC_IMAGE_MAGIC, sizeof AURC_IMAGE_MAGIC);
+    rc |= aurc_bytes_append_le16(out, AURC_IMAGE_VERSION);
+    rc |= aurc_bytes_append_le16(out, AURC_IMAGE_HEADER_SIZE);
+    rc |= aurc_bytes_append_le16(out, (uint16_t)count);
+    rc |= aurc_bytes_append_le16(out, AURC_IMAGE_SECTION_ENTRY_SIZE);
+    rc |= aurc_bytes_append_le32(out, 0);                   /* flags */
+    rc |= aurc_bytes_append_le32(out, 0);                   /* execution starts at address 0 */
+    rc |= aurc_bytes_append_le32(out, (uint32_t)layout->size);
+    rc |= aurc_bytes_append_le32(out, AURC_IMAGE_HEADER_SIZE);
+    rc |= aurc_bytes_append_zeros(out, AURC_IMAGE_HEADER_SIZE - (out->len - start));
+    for (unsigned i = 0; i < count; ++i) {
+        const image_section *s = &sections[i];
+        rc |= aurc_bytes_append_le32(out, s->kind);
+        rc |= aurc_bytes_append_le32(out, 0);
+        rc |= aurc_bytes_append_le32(out, s->address);
+        rc |= aurc_bytes_append_le32(out, s->size);
+        rc |= aurc_bytes_append_le32(out, s->offset);
+        rc |= aurc_bytes_append_le32(out, s->kind == AURC_SECTION_RODATA ? 1u : AURC_IMAGE_ALIGN);
+    }
+    for (unsigned i = 0; rc == 0 && i < count; ++i) {
+        const image_section *s = &sections[i];
+        rc |= aurc_bytes_append_zeros(out, s->offset - (out->len - start));
+        if (s->data) {
+            rc |= aurc_bytes_append(out, s->data, s->size);
+        } else if (s->kind == AURC_SECTION_SYMBOLS) {
+            rc |= append_symbols(layout, out);
+        } else {
+            rc |= append_relocs(layout, out);
+        }
+    }
+    if (rc != 0) {
+        aurc_diag_printf("aurc-native: out of memory encoding image\n");
+    }
+    return rc;
+}
+
+/* ---- parsing ------------------------------------------------------------ */
+
+static uint32_t read_le16(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8;
+}
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+int aurc_image_is_container(const uint8_t *data, size_t size) {
+    return size >= sizeof AURC_IMAGE_MAGIC && memcmp(data, AURC_IMAGE_MAGIC, sizeof AURC_IMAGE_MAGIC) == 0;
+}
+
+static int bad_image(const char *path, const char *message) {
+    aurc_diag_printf("aurc-native: %s: %s\n", path, message);
+    return 1;
+}
+
+int aurc_image_parse(const uint8_t *data, size_t size, const char *path, aurc_image_view *view) {
+    memset(view, 0, sizeof *view);
+    if (!aurc_image_is_container(data, size) || size < AURC_IMAGE_HEADER_SIZE) {
+        return bad_image(path, "not an aurc image");
+    }
+    view->version = read_le16(data + 8);
+    if (view->version != AURC_IMAGE_VERSION) {
+        aurc_diag_printf("aurc-native: %s: image format version %u is not supported (expected %u)\n", path,
+                         (unsigned)view->version, AURC_IMAGE_VERSION);
+        return 1;
+    }
+    uint32_t header_size = read_le16(data + 10);
+    uint32_t count = read_le16(data + 12);
+    uint32_t entry_size = read_le16(data + 14);
+    view->entry = read_le32(data + 20);
+    view->address_space = read_le32(data + 24);
+    uint32_t table = read_le32(data + 28);
+    if (header_size < AURC_IMAGE_HEADER_SIZE || entry_size < AURC_IMAGE_SECTION_ENTRY_SIZE || table < header_size ||
+        (uint64_t)table + (uint64_t)count * entry_size > size) {
+        return bad_image(path, "truncated image header");
+    }
+
+    int seen_code = 0;
+    uint32_t code_offset = 0;
+    uint32_t rodata_address = 0;
+    uint32_t rodata_offset = 0;
+    uint32_t rodata_size = 0;
+    int seen_rodata = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t *entry = data + table + (size_t)i * entry_size;
+        uint32_t kind = read_le32(entry);
+        uint32_t address = read_le32(entry + 8);
+        uint32_t length = read_le32(entry + 12);
+        uint32_t offset = read_le32(entry + 16);
+        if ((uint64_t)offset + length > size) {
+            return bad_image(path, "section extends past the end of the image");
+        }
+        switch (kind) {
+            case AURC_SECTION_CODE:
+                if (seen_code || address != 0) {
+                    return bad_image(path, "misplaced code section");
+                }
+                seen_code = 1;
+                code_offset = offset;
+                view->code_size = length;
+                break;
+            case AURC_SECTION_RODATA:
+                if (seen_rodata) {
+                    return bad_image(path, "duplicate rodata section");
+                }
+                seen_rodata = 1;
+                rodata_address = address;
+                rodata_offset = offset;
+                rodata_size = length;
+                break;
+            case AURC_SECTION_SHARED:
+                if (view->shared || length == 0 || address % ISA_SHARED_STRIDE != 0) {
+                    return bad_image(path, "misplaced shared section");
+                }
+                view->shared = data + offset;
+                view->shared_base = address;
+                view->shared_size = length;
+                break;
+            case AURC_SECTION_SYMBOLS:
+                view->symbols = data + offset;
+                view->symbols_size = length;
+                break;
+            case AURC_SECTION_RELOCS:
+                view->relocs = data + offset;
+                view->relocs_size = length;
+                break;
+            default:
+                break;      /* sections a later revision of this version may add */
+        }
+    }
+    if (!seen_code) {
+        return bad_image(path, "image has no code section");
+    }
+    if (seen_rodata && (rodata_address != view->code_size || rodata_offset != code_offset + view->code_size)) {
+        return bad_image(path, "rodata section does not follow the code section");
+    }
+    view->rom = data + code_offset;
+    view->rom_size = view->code_size + rodata_size;
+    if (view->rom_size > view->address_space ||
+        (view->shared && (view->shared_base < view->rom_size ||
+                          (uint64_t)view->shared_base + view->shared_size > view->address_space))) {
+        return bad_image(path, "sections overlap or exceed the image's address space");
+    }
+    if (view->code_size && (uint64_t)view->entry + ISA_WORD_SIZE > view->code_size) {
+        return bad_image(path, "entry point outside the code section");
+    }
+    return 0;
+}
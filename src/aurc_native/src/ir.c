@@ -0,0 +1,283 @@
+#include "aurc_ir.h"
+#include "aurc_diag.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void aurc_interner_init(aurc_interner *in) {
+    memset(in, 0, sizeof *in);
+}
+
+void aurc_interner_free(aurc_interner *in) {
+    free(in->chars);
+    free(in->offsets);
+    free(in->lengths);
+    free(in->slots);
+    memset(in, 0, sizeof *in);
+}
+
+void aurc_interner_reset(aurc_interner *in) {
+    in->chars_len = 0;
+    in->count = 0;
+    if (in->slots) {
+        memset(in->slots, 0, in->slot_cap * sizeof *in->slots);
+    }
+}
+
+static uint32_t hash_view(aurc_view text) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < text.len; ++i) {
+        hash ^= (unsigned char)text.data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t probe(const aurc_interner *in, aurc_view text, uint32_t hash) {
+    uint32_t mask = in->slot_cap - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        uint32_t slot = in->slots[i];
+        if (slot == 0 || aurc_view_equal(aurc_interner_get(in, slot - 1), text)) {
+            return i;
+        }
+    }
+}
+
+static int rehash(aurc_interner *in, uint32_t slot_cap) {
+    uint32_t *slots = calloc(slot_cap, sizeof *slots);
+    if (!slots) {
+        return 1;
+    }
+    free(in->slots);
+    in->slots = slots;
+    in->slot_cap = slot_cap;
+    for (uint32_t id = 0; id < in->count; ++id) {
+        aurc_view text = aurc_interner_get(in, id);
+        in->slots[probe(in, text, hash_view(text))] = id + 1;
+    }
+    return 0;
+}
+
+uint32_t aurc_interner_find(const aurc_interner *in, aurc_view text) {
+    if (in->slot_cap == 0) {
+        return AURC_IR_NONE;
+    }
+    uint32_t slot = in->slots[probe(in, text, hash_view(text))];
+    return slot ? slot - 1 : AURC_IR_NONE;
+}
+
+uint32_t aurc_intern(aurc_interner *in, aurc_view text) {
+    uint32_t found = aurc_interner_find(in, text);
+    if (found != AURC_IR_NONE) {
+        return found;
+    }
+    /* keep the table at most half full */
+    if ((in->count + 1) * 2 > in->slot_cap && rehash(in, in->slot_cap ? in->slot_cap * 2 : 64) != 0) {
+        goto oom;
+    }
+    if (in->count == in->cap) {
+        uint32_t cap = in->cap ? in->cap * 2 : 32;
+        uint32_t *offsets = realloc(in->offsets, cap * sizeof *offsets);
+        if (!offsets) {
+            goto oom;
+        }
+        in->offsets = offsets;
+        uint32_t *lengths = realloc(in->lengths, cap * sizeof *lengths);
+        if (!lengths) {
+            goto oom;
+        }
+        in->lengths = lengths;
+        in->cap = cap;
+    }
+    if (in->chars_len + text.len + 1 > in->chars_cap) {
+        size_t cap = in->chars_cap ? in->chars_cap : 1024;
+        while (cap < in->chars_len + text.len + 1) {
+            cap *= 2;
+        }
+        char *chars = realloc(in->chars, cap);
+        if (!chars) {
+            goto oom;
+        }
+        in->chars = chars;
+        in->chars_cap = cap;
+    }
+    if (in->chars_len > UINT32_MAX - text.len - 1) {
+        goto oom;
+    }
+
+    uint32_t id = in->count++;
+    in->offsets[id] = (uint32_t)in->chars_len;
+    in->lengths[id] = (uint32_t)text.len;
+    if (text.len > 0) {
+        memcpy(in->chars + in->chars_len, text.data, text.len);
+    }
+    in->chars[in->chars_len + text.len] = '\0';
+    in->chars_len += text.len + 1;
+    in->slots[probe(in, text, hash_view(text))] = id + 1;
+    return id;
+
+oom:
+    aurc_diag_printf("aurc-native: out of memory interning '%.*s'\n", (int)text.len, text.data);
+    return AURC_IR_NONE;
+}
+
+void aurc_ir_init(aurc_ir_program *ir) {
+    memset(ir, 0, sizeof *ir);
+    aurc_interner_init(&ir->symbols);
+    aurc_interner_init(&ir->strings);
+    ir->entry = AURC_IR_NONE;
+}
+
+static void free_code(aurc_ir_code *code) {
+    free(code->op);
+    free(code->dst);
+    free(code->a);
+    free(code->b);
+    free(code->imm);
+    memset(code, 0, sizeof *code);
+}
+
+void aurc_ir_free(aurc_ir_program *ir) {
+    /* entries past function_count may still hold buffers kept by aurc_ir_reset */
+    for (uint32_t i = 0; i < ir->function_cap; ++i) {
+        free_code(&ir->functions[i].code);
+        free(ir->functions[i].local_names);
+    }
+    free(ir->functions);
+    free(ir->shared);
+    aurc_interner_free(&ir->symbols);
+    aurc_interner_free(&ir->strings);
+    aurc_ir_init(ir);
+}
+
+void aurc_ir_reset(aurc_ir_program *ir) {
+    for (uint32_t i = 0; i < ir->function_count; ++i) {
+        ir->functions[i].code.count = 0;
+    }
+    ir->function_count = 0;
+    ir->shared_count = 0;
+    aurc_interner_reset(&ir->symbols);
+    aurc_interner_reset(&ir->strings);
+    ir->entry = AURC_IR_NONE;
+}
+
+void aurc_ir_shard_counters(aurc_ir_program *ir) {
+    for (uint32_t i = 0; i < ir->shared_count; ++i) {
+        ir->shared[i].sharded = 1;
+    }
+    for (uint32_t f = 0; f < ir->function_count; ++f) {
+        const aurc_ir_code *code = &ir->functions[f].code;
+        for (size_t i = 0; i < code->count; ++i) {
+            if (code->op[i] == AURC_IR_ATOMIC_STORE) {
+                ir->shared[code->a[i]].sharded = 0;
+            }
+        }
+    }
+}
+
+static const char *const OP_NAMES[AURC_IR_OP_COUNT] = {
+    [AURC_IR_CONST] = "const",
+    [AURC_IR_STRING] = "string",
+    [AURC_IR_LOAD_LOCAL] = "load_local",
+    [AURC_IR_STORE_LOCAL] = "store_local",
+    [AURC_IR_ADD] = "add",
+    [AURC_IR_SUB] = "sub",
+    [AURC_IR_MUL] = "mul",
+    [AURC_IR_DIV] = "div",
+    [AURC_IR_MOD] = "mod",
+    [AURC_IR_AND] = "and",
+    [AURC_IR_OR] = "or",
+    [AURC_IR_XOR] = "xor",
+    [AURC_IR_SHL] = "shl",
+    [AURC_IR_SHR] = "shr",
+    [AURC_IR_EQ] = "eq",
+    [AURC_IR_NE] = "ne",
+    [AURC_IR_LT] = "lt",
+    [AURC_IR_LE] = "le",
+    [AURC_IR_GT] = "gt",
+    [AURC_IR_GE] = "ge",
+    [AURC_IR_NEG] = "neg",
+    [AURC_IR_NOT] = "not",
+    [AURC_IR_BITNOT] = "bitnot",
+    [AURC_IR_LABEL] = "label",
+    [AURC_IR_JUMP] = "jump",
+    [AURC_IR_BR_EQ] = "br_eq",
+    [AURC_IR_BR_NE] = "br_ne",
+    [AURC_IR_BR_LT] = "br_lt",
+    [AURC_IR_BR_LE] = "br_le",
+    [AURC_IR_BR_GT] = "br_gt",
+    [AURC_IR_BR_GE] = "br_ge",
+    [AURC_IR_ARG] = "arg",
+    [AURC_IR_CALL] = "call",
+    [AURC_IR_RET] = "ret",
+    [AURC_IR_PRINT_INT] = "print_int",
+    [AURC_IR_PRINT_STR] = "print_str",
+    [AURC_IR_FLUSH] = "flush",
+    [AURC_IR_INPUT_INT] = "input_int",
+    [AURC_IR_EXIT] = "exit",
+    [AURC_IR_SPAWN] = "spawn",
+    [AURC_IR_JOIN] = "join",
+    [AURC_IR_ATOMIC_LOAD] = "atomic_load",
+    [AURC_IR_ATOMIC_STORE] = "atomic_store",
+    [AURC_IR_ATOMIC_ADD] = "atomic_add",
+    [AURC_IR_BIGNUM_UNARY] = "bignum_unary",
+    [AURC_IR_BIGNUM_BINARY] = "bignum_binary",
+};
+
+const char *aurc_ir_op_name(aurc_ir_op op) {
+    return op < AURC_IR_OP_COUNT && OP_NAMES[op] ? OP_NAMES[op] : "?";
+}
+
+int aurc_ir_op_has_dst(aurc_ir_op op) {
+    switch (op) {
+        case AURC_IR_STORE_LOCAL:
+        case AURC_IR_LABEL:
+        case AURC_IR_JUMP:
+        case AURC_IR_BR_EQ:
+        case AURC_IR_BR_NE:
+        case AURC_IR_BR_LT:
+        case AURC_IR_BR_LE:
+        case AURC_IR_BR_GT:
+        case AURC_IR_BR_GE:
+        case AURC_IR_ARG:
+        case AURC_IR_RET:
+        case AURC_IR_PRINT_INT:
+        case AURC_IR_PRINT_STR:
+        case AURC_IR_FLUSH:
+        case AURC_IR_EXIT:
+        case AURC_IR_ATOMIC_STORE:
+        case AURC_IR_ATOMIC_ADD:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+unsigned aurc_ir_op_uses(aurc_ir_op op) {
+    switch (op) {
+        case AURC_IR_STORE_LOCAL:
+        case AURC_IR_ATOMIC_STORE:
+        case AURC_IR_ATOMIC_ADD:
+            return AURC_IR_USES_B;
+        case AURC_IR_NEG:
+        case AURC_IR_NOT:
+        case AURC_IR_BITNOT:
+        case AURC_IR_ARG:
+        case AURC_IR_PRINT_INT:
+        case AURC_IR_PRINT_STR:
+        case AURC_IR_EXIT:
+        case AURC_IR_JOIN:
+        case AURC_IR_BIGNUM_UNARY:
+            return AURC_IR_USES_A;
+        case AURC_IR_BIGNUM_BINARY:
+            return AURC_IR_USES_A | AURC_IR_USES_B;
+        case AURC_IR_RET:
+            return AURC_IR_USES_A; /* unless a is AURC_IR_NONE */
+        default:
+            if ((op >= AURC_IR_ADD && op <= AURC_IR_GE) || aurc_ir_op_is_branch(op)) {
+                return AURC_IR_USES_A | AURC_IR_USES_B;
+            }
+            return 0;
+    }
+}
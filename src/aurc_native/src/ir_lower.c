@@ -0,0 +1,1024 @@
+#include "aurc_ir.h"
+#include "aurc_bignum.h"
+#include "aurc_diag.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * AST -> IR lowering. Integers, booleans, string literals, thread handles
+ * and integer shared variables are handled; floats, arrays, atomic.fadd and
+ * atomic.cas are rejected with a diagnostic until the backend grows support
+ * for them.
+ */
+
+typedef enum value_type {
+    VT_VOID = 0,
+    VT_INT,
+    VT_BOOL,
+    VT_STRING,
+    VT_THREAD
+} value_type;
+
+typedef struct typed_value {
+    uint32_t id;
+    value_type type;
+} typed_value;
+
+typedef struct scope_entry {
+    uint32_t symbol;
+    uint32_t local;
+    value_type type;
+} scope_entry;
+
+typedef struct loop_labels {
+    uint32_t break_label;
+    uint32_t continue_label;
+} loop_labels;
+
+typedef struct lowerer {
+    const char *path;
+    const aurc_program *program;
+    aurc_ir_program *ir;
+    aurc_ir_function *fn;
+    const aurc_function *ast_fn;
+    scope_entry *scope;
+    size_t scope_count;
+    size_t scope_cap;
+    const loop_labels *loop;
+    /* built once the functions are declared, so calls resolve in constant time */
+    uint32_t *function_of;      /* per symbol id below function_symbols: function index, or AURC_IR_NONE */
+    uint32_t function_symbols;
+    const aurc_function **ast_functions;    /* per function index */
+    int failed;
+} lowerer;
+
+static const typed_value NO_VALUE = {AURC_IR_NONE, VT_VOID};
+
+static void lower_error(lowerer *lw, uint32_t line, uint32_t column, const char *fmt, ...) {
+    if (lw->failed) {
+        return;
+    }
+    lw->failed = 1;
+    aurc_diag_printf("aurc-native: %s:%u:%u: ", lw->path, line, column);
+    va_list args;
+    va_start(args, fmt);
+    aurc_diag_vprintf(fmt, args);
+    va_end(args);
+    aurc_diag_printf("\n");
+}
+
+static void out_of_memory(lowerer *lw) {
+    if (!lw->failed) {
+        aurc_diag_printf("aurc-native: out of memory lowering %s\n", lw->path);
+        lw->failed = 1;
+    }
+}
+
+static const char *type_name(value_type type) {
+    switch (type) {
+        case VT_INT: return "int";
+        case VT_BOOL: return "bool";
+        case VT_STRING: return "string";
+        case VT_THREAD: return "thread";
+        default: return "void";
+    }
+}
+
+static int grow_code(aurc_ir_code *code) {
+    size_t cap = code->cap ? code->cap * 2 : 64;
+    uint8_t *op = realloc(code->op, cap * sizeof *op);
+    if (!op) {
+        return 1;
+    }
+    code->op = op;
+    uint32_t *dst = realloc(code->dst, cap * sizeof *dst);
+    if (!dst) {
+        return 1;
+    }
+    code->dst = dst;
+    uint32_t *a = realloc(code->a, cap * sizeof *a);
+    if (!a) {
+        return 1;
+    }
+    code->a = a;
+    uint32_t *b = realloc(code->b, cap * sizeof *b);
+    if (!b) {
+        return 1;
+    }
+    code->b = b;
+    int64_t *imm = realloc(code->imm, cap * sizeof *imm);
+    if (!imm) {
+        return 1;
+    }
+    code->imm = imm;
+    code->cap = cap;
+    return 0;
+}
+
+static void emit(lowerer *lw, aurc_ir_op op, uint32_t dst, uint32_t a, uint32_t b, int64_t imm) {
+    aurc_ir_code *code = &lw->fn->code;
+    if (lw->failed) {
+        return;
+    }
+    if (code->count == code->cap && grow_code(code) != 0) {
+        out_of_memory(lw);
+        return;
+    }
+    size_t i = code->count++;
+    code->op[i] = (uint8_t)op;
+    code->dst[i] = dst;
+    code->a[i] = a;
+    code->b[i] = b;
+    code->imm[i] = imm;
+}
+
+/* Emits an instruction that defines a fresh value and returns it. */
+static uint32_t emit_value(lowerer *lw, aurc_ir_op op, uint32_t a, uint32_t b, int64_t imm) {
+    uint32_t dst = lw->fn->value_count++;
+    emit(lw, op, dst, a, b, imm);
+    return dst;
+}
+
+static uint32_t new_label(lowerer *lw) {
+    return lw->fn->label_count++;
+}
+
+static void emit_label(lowerer *lw, uint32_t label) {
+    emit(lw, AURC_IR_LABEL, AURC_IR_NONE, AURC_IR_NONE, AURC_IR_NONE, label);
+}
+
+static void emit_jump(lowerer *lw, uint32_t label) {
+    emit(lw, AURC_IR_JUMP, AURC_IR_NONE, AURC_IR_NONE, AURC_IR_NONE, label);
+}
+
+static uint32_t intern_symbol(lowerer *lw, aurc_view name) {
+    uint32_t id = aurc_intern(&lw->ir->symbols, name);
+    if (id == AURC_IR_NONE) {
+        lw->failed = 1;
+    }
+    return id;
+}
+
+static uint32_t new_local(lowerer *lw, uint32_t symbol) {
+    aurc_ir_function *fn = lw->fn;
+    if (fn->local_count == fn->local_cap) {
+        uint32_t cap = fn->local_cap ? fn->local_cap * 2 : 16;
+        uint32_t *names = realloc(fn->local_names, cap * sizeof *names);
+        if (!names) {
+            out_of_memory(lw);
+            return AURC_IR_NONE;
+        }
+        fn->local_names = names;
+        fn->local_cap = cap;
+    }
+    fn->local_names[fn->local_count] = symbol;
+    return fn->local_count++;
+}
+
+/* Declares name in the innermost scope; later declarations shadow earlier ones. */
+static uint32_t declare(lowerer *lw, aurc_view name, value_type type) {
+    uint32_t symbol = intern_symbol(lw, name);
+    if (symbol == AURC_IR_NONE) {
+        return AURC_IR_NONE;
+    }
+    uint32_t local = new_local(lw, symbol);
+    if (local == AURC_IR_NONE) {
+        return AURC_IR_NONE;
+    }
+    if (lw->scope_count == lw->scope_cap) {
+        size_t cap = lw->scope_cap ? lw->scope_cap * 2 : 32;
+        scope_entry *grown = realloc(lw->scope, cap * sizeof *grown);
+        if (!grown) {
+            out_of_memory(lw);
+            return AURC_IR_NONE;
+        }
+        lw->scope = grown;
+        lw->scope_cap = cap;
+    }
+    lw->scope[lw->scope_count].symbol = symbol;
+    lw->scope[lw->scope_count].local = local;
+    lw->scope[lw->scope_count].type = type;
+    lw->scope_count++;
+    return local;
+}
+
+static const scope_entry *lookup(const lowerer *lw, aurc_view name) {
+    uint32_t symbol = aurc_interner_find(&lw->ir->symbols, name);
+    if (symbol == AURC_IR_NONE) {
+        return NULL;
+    }
+    for (size_t i = lw->scope_count; i > 0; --i) {
+        if (lw->scope[i - 1].symbol == symbol) {
+            return &lw->scope[i - 1];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t find_function(const lowerer *lw, aurc_view name) {
+    uint32_t symbol = aurc_interner_find(&lw->ir->symbols, name);
+    if (symbol == AURC_IR_NONE || symbol >= lw->function_symbols) {
+        return AURC_IR_NONE;
+    }
+    return lw->function_of[symbol];
+}
+
+static int convert_type(lowerer *lw, aurc_type type, uint32_t line, uint32_t column, value_type *out) {
+    switch (type.kind) {
+        case AURC_TYPE_VOID: *out = VT_VOID; return 0;
+        case AURC_TYPE_INT: *out = VT_INT; return 0;
+        case AURC_TYPE_BOOL: *out = VT_BOOL; return 0;
+        case AURC_TYPE_STRING: *out = VT_STRING; return 0;
+        case AURC_TYPE_FLOAT:
+            lower_error(lw, line, column, "float values are not supported by the native backend yet");
+            return 1;
+        case AURC_TYPE_THREAD: *out = VT_THREAD; return 0;
+        case AURC_TYPE_ARRAY:
+            lower_error(lw, line, column, "arrays are not supported by the native backend yet");
+            return 1;
+    }
+    return 1;
+}
+
+/* int and bool share a representation; strings and threads only match themselves. */
+static int compatible(value_type want, value_type have) {
+    if (want == have) {
+        return 1;
+    }
+    return (want == VT_INT || want == VT_BOOL) && (have == VT_INT || have == VT_BOOL);
+}
+
+static typed_value lower_expr(lowerer *lw, const aurc_expr *expr);
+static typed_value lower_join(lowerer *lw, aurc_view name, uint32_t line, uint32_t column);
+static void lower_branch(lowerer *lw, const aurc_expr *expr, int when, uint32_t label);
+
+static typed_value lower_integer(lowerer *lw, const aurc_expr *expr, const char *what) {
+    typed_value v = lower_expr(lw, expr);
+    if (!lw->failed && v.type != VT_INT && v.type != VT_BOOL) {
+        lower_error(lw, expr->line, expr->column, "%s must be an int, not %s", what, type_name(v.type));
+    }
+    return v;
+}
+
+static typed_value make(uint32_t id, value_type type) {
+    typed_value v = {id, type};
+    return v;
+}
+
+static aurc_ir_op binary_ir_op(aurc_binary_op op) {
+    switch (op) {
+        case AURC_BIN_ADD: return AURC_IR_ADD;
+        case AURC_BIN_SUB: return AURC_IR_SUB;
+        case AURC_BIN_MUL: return AURC_IR_MUL;
+        case AURC_BIN_DIV: return AURC_IR_DIV;
+        case AURC_BIN_MOD: return AURC_IR_MOD;
+        case AURC_BIN_AND: return AURC_IR_AND;
+        case AURC_BIN_OR: return AURC_IR_OR;
+        case AURC_BIN_XOR: return AURC_IR_XOR;
+        case AURC_BIN_SHL: return AURC_IR_SHL;
+        case AURC_BIN_SHR: return AURC_IR_SHR;
+        case AURC_BIN_EQ: return AURC_IR_EQ;
+        case AURC_BIN_NE: return AURC_IR_NE;
+        case AURC_BIN_LT: return AURC_IR_LT;
+        case AURC_BIN_LE: return AURC_IR_LE;
+        case AURC_BIN_GT: return AURC_IR_GT;
+        case AURC_BIN_GE: return AURC_IR_GE;
+        default: return AURC_IR_OP_COUNT;
+    }
+}
+
+static int is_comparison(aurc_binary_op op) {
+    return op >= AURC_BIN_EQ && op <= AURC_BIN_GE;
+}
+
+/* Branch opcode taken when `lhs op rhs` is (when=1) true or (when=0) false. */
+static aurc_ir_op branch_op(aurc_binary_op op, int when) {
+    static const aurc_ir_op taken_true[] = {AURC_IR_BR_EQ, AURC_IR_BR_NE, AURC_IR_BR_LT,
+                                            AURC_IR_BR_LE, AURC_IR_BR_GT, AURC_IR_BR_GE};
+    static const aurc_ir_op taken_false[] = {AURC_IR_BR_NE, AURC_IR_BR_EQ, AURC_IR_BR_GE,
+                                             AURC_IR_BR_GT, AURC_IR_BR_LE, AURC_IR_BR_LT};
+    return (when ? taken_true : taken_false)[op - AURC_BIN_EQ];
+}
+
+/* && and || produce 0/1 through a hidden local written on each path: there are no phis to merge them. */
+static typed_value lower_logical(lowerer *lw, const aurc_expr *expr) {
+    uint32_t symbol = intern_symbol(lw, aurc_view_of(expr->as.binary.op == AURC_BIN_LOGICAL_AND ? "&&" : "||"));
+    uint32_t local = symbol == AURC_IR_NONE ? AURC_IR_NONE : new_local(lw, symbol);
+    if (local == AURC_IR_NONE) {
+        return NO_VALUE;
+    }
+    uint32_t done = new_label(lw);
+    uint32_t zero = emit_value(lw, AURC_IR_CONST, AURC_IR_NONE, AURC_IR_NONE, 0);
+    uint32_t one = emit_value(lw, AURC_IR_CONST, AURC_IR_NONE, AURC_IR_NONE, 1);
+    emit(lw, AURC_IR_STORE_LOCAL, AURC_IR_NONE, local, zero, 0);
+    lower_branch(lw, expr, 0, done);
+    emit(lw, AURC_IR_STORE_LOCAL, AURC_IR_NONE, local, one, 0);
+    emit_label(lw, done);
+    return make(emit_value(lw, AURC_IR_LOAD_LOCAL, local, AURC_IR_NONE, 0), VT_BOOL);
+}
+
+static typed_value lower_binary(lowerer *lw, const aurc_expr *expr) {
+    aurc_binary_op op = expr->as.binary.op;
+    if (op == AURC_BIN_LOGICAL_AND || op == AURC_BIN_LOGICAL_OR) {
+        return lower_logical(lw, expr);
+    }
+    typed_value lhs = lower_integer(lw, expr->as.binary.lhs, "operand");
+    typed_value rhs = lower_integer(lw, expr->as.binary.rhs, "operand");
+    if (lw->failed) {
+        return NO_VALUE;
+    }
+    uint32_t id = emit_value(lw, binary_ir_op(op), lhs.id, rhs.id, 0);
+    return make(id, is_comparison(op) ? VT_BOOL : VT_INT);
+}
+
+static aurc_bn_op find_bignum_builtin(aurc_view name) {
+    for (unsigned op = 0; op < AURC_BN_OP_COUNT; ++op) {
+        const char *builtin = aurc_bn_op_name((aurc_bn_op)op);
+        if (strlen(builtin) == name.len && memcmp(builtin, name.data, name.len) == 0) {
+            return (aurc_bn_op)op;
+        }
+    }
+    return AURC_BN_OP_COUNT;
+}
+
+/*
+ * The bignum builtins take and return ints: handles into the VM's table of
+ * numbers, or plain ints for the values, exponents and shift counts.
+ */
+static typed_value lower_bignum_builtin(lowerer *lw, const aurc_expr *expr, aurc_bn_op op) {
+    unsigned arity = aurc_bn_op_arity(op);
+    if (expr->as.call.arg_count != arity) {
+        lower_error(lw, expr->line, expr->column, "'%s' takes %u argument(s), %zu given", aurc_bn_op_name(op), arity,
+                    expr->as.call.arg_count);
+        return NO_VALUE;
+    }
+    const aurc_expr *first = expr->as.call.args;
+    typed_value a = lower_integer(lw, first, "bignum operand");
+    typed_value b = arity == 2 ? lower_integer(lw, first->next, "bignum operand") : NO_VALUE;
+    if (lw->failed) {
+        return NO_VALUE;
+    }
+    uint32_t id = emit_value(lw, arity == 2 ? AURC_IR_BIGNUM_BINARY : AURC_IR_BIGNUM_UNARY, a.id, b.id, (int64_t)op);
+    return make(id, VT_INT);
+}
+
+/*
+ * Lowers a call, or with op AURC_IR_SPAWN a spawn, which passes arguments the
+ * same way. A call to no function of the program may name a bignum builtin.
+ */
+static typed_value lower_call(lowerer *lw, const aurc_expr *expr, aurc_ir_op op) {
+    uint32_t index = find_function(lw, expr->as.call.callee);
+    aurc_bn_op builtin = find_bignum_builtin(expr->as.call.callee);
+    if (index == AURC_IR_NONE && op == AURC_IR_CALL && builtin != AURC_BN_OP_COUNT) {
+        return lower_bignum_builtin(lw, expr, builtin);
+    }
+    if (index == AURC_IR_NONE) {
+        lower_error(lw, expr->line, expr->column, "%s unknown function '%.*s'", op == AURC_IR_SPAWN ? "spawn of" : "call to",
+                    (int)expr->as.call.callee.len, expr->as.call.callee.data);
+        return NO_VALUE;
+    }
+    const aurc_function *callee = lw->ast_functions[index];
+    if (expr->as.call.arg_count != callee->param_count) {
+        lower_error(lw, expr->line, expr->column, "'%.*s' takes %zu argument(s), %zu given", (int)callee->name.len,
+                    callee->name.data, callee->param_count, expr->as.call.arg_count);
+        return NO_VALUE;
+    }
+
+    /* evaluate every argument before the ARG run so the backend sees ARG..ARG CALL/SPAWN back to back */
+    uint32_t inline_args[8];
+    uint32_t *args = inline_args;
+    if (expr->as.call.arg_count > sizeof inline_args / sizeof inline_args[0]) {
+        args = malloc(expr->as.call.arg_count * sizeof *args);
+        if (!args) {
+            out_of_memory(lw);
+            return NO_VALUE;
+        }
+    }
+    const aurc_param *param = callee->params;
+    size_t i = 0;
+    for (const aurc_expr *arg = expr->as.call.args; arg && !lw->failed; arg = arg->next, param = param->next, ++i) {
+        value_type want;
+        typed_value v = lower_expr(lw, arg);
+        if (lw->failed || convert_type(lw, param->type, arg->line, arg->column, &want) != 0) {
+            break;
+        }
+        if (!compatible(want, v.type)) {
+            lower_error(lw, arg->line, arg->column, "argument %zu of '%.*s' expects %s, got %s", i + 1,
+                        (int)callee->name.len, callee->name.data, type_name(want), type_name(v.type));
+            break;
+        }
+        args[i] = v.id;
+    }
+    for (size_t j = 0; j < i && !lw->failed; ++j) {
+        emit(lw, AURC_IR_ARG, AURC_IR_NONE, args[j], AURC_IR_NONE, (int64_t)j);
+    }
+    if (args != inline_args) {
+        free(args);
+    }
+    if (lw->failed) {
+        return NO_VALUE;
+    }
+
+    value_type ret;
+    if (convert_type(lw, callee->return_type, callee->line, callee->column, &ret) != 0) {
+        return NO_VALUE;
+    }
+    uint32_t id = emit_value(lw, op, index, AURC_IR_NONE, (int64_t)expr->as.call.arg_count);
+    /* a spawn yields the task's handle; its return value comes back from `join` */
+    return make(id, op == AURC_IR_SPAWN ? VT_THREAD : ret);
+}
+
+static uint32_t find_shared(lowerer *lw, aurc_view name, uint32_t line, uint32_t column) {
+    uint32_t symbol = aurc_interner_find(&lw->ir->symbols, name);
+    for (uint32_t i = 0; symbol != AURC_IR_NONE && i < lw->ir->shared_count; ++i) {
+        if (lw->ir->shared[i].name == symbol) {
+            return i;
+        }
+    }
+    lower_error(lw, line, column, "'%.*s' is not a shared variable", (int)name.len, name.data);
+    return AURC_IR_NONE;
+}
+
+static typed_value unsupported(lowerer *lw, const aurc_expr *expr, const char *what) {
+    lower_error(lw, expr->line, expr->column, "%s not supported by the native backend yet", what);
+    return NO_VALUE;
+}
+
+static typed_value lower_expr(lowerer *lw, const aurc_expr *expr) {
+    if (lw->failed) {
+        return NO_VALUE;
+    }
+    switch (expr->kind) {
+        case AURC_EXPR_INT:
+            return make(emit_value(lw, AURC_IR_CONST, AURC_IR_NONE, AURC_IR_NONE, expr->as.int_value), VT_INT);
+        case AURC_EXPR_BOOL:
+            return make(emit_value(lw, AURC_IR_CONST, AURC_IR_NONE, AURC_IR_NONE, expr->as.bool_value), VT_BOOL);
+        case AURC_EXPR_STRING: {
+            uint32_t id = aurc_intern(&lw->ir->strings, expr->as.string_value);
+            if (id == AURC_IR_NONE) {
+                lw->failed = 1;
+                return NO_VALUE;
+            }
+            return make(emit_value(lw, AURC_IR_STRING, id, AURC_IR_NONE, 0), VT_STRING);
+        }
+        case AURC_EXPR_VAR: {
+            const scope_entry *var = lookup(lw, expr->as.name);
+            if (!var) {
+                lower_error(lw, expr->line, expr->column, "undefined variable '%.*s'", (int)expr->as.name.len,
+                            expr->as.name.data);
+                return NO_VALUE;
+            }
+            return make(emit_value(lw, AURC_IR_LOAD_LOCAL, var->local, AURC_IR_NONE, 0), var->type);
+        }
+        case AURC_EXPR_UNARY: {
+            typed_value v = lower_integer(lw, expr->as.unary.operand, "operand");
+            if (lw->failed) {
+                return NO_VALUE;
+            }
+            switch (expr->as.unary.op) {
+                case AURC_UN_NEG: return make(emit_value(lw, AURC_IR_NEG, v.id, AURC_IR_NONE, 0), VT_INT);
+                case AURC_UN_NOT: return make(emit_value(lw, AURC_IR_NOT, v.id, AURC_IR_NONE, 0), VT_BOOL);
+                case AURC_UN_BITNOT: return make(emit_value(lw, AURC_IR_BITNOT, v.id, AURC_IR_NONE, 0), VT_INT);
+            }
+            return NO_VALUE;
+        }
+        case AURC_EXPR_BINARY:
+            return lower_binary(lw, expr);
+        case AURC_EXPR_CALL:
+            return lower_call(lw, expr, AURC_IR_CALL);
+        case AURC_EXPR_CAST:
+            if (expr->as.cast.target.kind == AURC_TYPE_INT) {
+                typed_value v = lower_integer(lw, expr->as.cast.operand, "cast operand");
+                return lw->failed ? NO_VALUE : make(v.id, VT_INT);
+            }
+            return unsupported(lw, expr, "casts to float are");
+        case AURC_EXPR_INPUT:
+            return make(emit_value(lw, AURC_IR_INPUT_INT, AURC_IR_NONE, AURC_IR_NONE, 0), VT_INT);
+        case AURC_EXPR_FLOAT:
+            return unsupported(lw, expr, "float literals are");
+        case AURC_EXPR_SPAWN:
+            return lower_call(lw, expr, AURC_IR_SPAWN);
+        case AURC_EXPR_JOIN:
+            return lower_join(lw, expr->as.name, expr->line, expr->column);
+        case AURC_EXPR_ATOMIC_LOAD: {
+            uint32_t shared = find_shared(lw, expr->as.name, expr->line, expr->column);
+            if (shared == AURC_IR_NONE) {
+                return NO_VALUE;
+            }
+            return make(emit_value(lw, AURC_IR_ATOMIC_LOAD, shared, AURC_IR_NONE, 0), VT_INT);
+        }
+        case AURC_EXPR_ARRAY:
+        case AURC_EXPR_INDEX:
+            return unsupported(lw, expr, "arrays are");
+    }
+    return NO_VALUE;
+}
+
+/* Jumps to label when expr evaluates to `when` (1 = true, 0 = false); falls through otherwise. */
+static void lower_branch(lowerer *lw, const aurc_expr *expr, int when, uint32_t label) {
+    if (lw->failed) {
+        return;
+    }
+    if (expr->kind == AURC_EXPR_BOOL) {
+        if (!!expr->as.bool_value == when) {
+            emit_jump(lw, label);
+        }
+        return;
+    }
+    if (expr->kind == AURC_EXPR_UNARY && expr->as.unary.op == AURC_UN_NOT) {
+        lower_branch(lw, expr->as.unary.operand, !when, label);
+        return;
+    }
+    if (expr->kind == AURC_EXPR_BINARY) {
+        aurc_binary_op op = expr->as.binary.op;
+        if (op == AURC_BIN_LOGICAL_AND || op == AURC_BIN_LOGICAL_OR) {
+            /* jumping on the operator's short-circuit value can exit after the lhs */
+            int short_value = op == AURC_BIN_LOGICAL_OR;
+            if (when == short_value) {
+                lower_branch(lw, expr->as.binary.lhs, when, label);
+                lower_branch(lw, expr->as.binary.rhs, when, label);
+            } else {
+                uint32_t skip = new_label(lw);
+                lower_branch(lw, expr->as.binary.lhs, short_value, skip);
+                lower_branch(lw, expr->as.binary.rhs, when, label);
+                emit_label(lw, skip);
+            }
+            return;
+        }
+        if (is_comparison(op)) {
+            typed_value lhs = lower_integer(lw, expr->as.binary.lhs, "comparison operand");
+            typed_value rhs = lower_integer(lw, expr->as.binary.rhs, "comparison operand");
+            emit(lw, branch_op(op, when), AURC_IR_NONE, lhs.id, rhs.id, label);
+            return;
+        }
+    }
+    typed_value v = lower_integer(lw, expr, "condition");
+    if (lw->failed) {
+        return;
+    }
+    uint32_t zero = emit_value(lw, AURC_IR_CONST, AURC_IR_NONE, AURC_IR_NONE, 0);
+    emit(lw, when ? AURC_IR_BR_NE : AURC_IR_BR_EQ, AURC_IR_NONE, v.id, zero, label);
+}
+
+static void lower_block(lowerer *lw, const aurc_block *block);
+
+static void lower_scoped_block(lowerer *lw, const aurc_block *block) {
+    size_t mark = lw->scope_count;
+    lower_block(lw, block);
+    lw->scope_count = mark;
+}
+
+static void lower_for(lowerer *lw, const aurc_stmt *stmt) {
+    int64_t step = 1;
+    const aurc_expr *step_expr = stmt->as.for_stmt.step;
+    if (step_expr) {
+        if (step_expr->kind != AURC_EXPR_INT || step_expr->as.int_value == 0) {
+            lower_error(lw, step_expr->line, step_expr->column, "for-loop step must be a non-zero integer literal");
+            return;
+        }
+        step = step_expr->as.int_value;
+    }
+
+    size_t mark = lw->scope_count;
+    typed_value start = lower_integer(lw, stmt->as.for_stmt.start, "range start");
+    typed_value end = lower_integer(lw, stmt->as.for_stmt.end, "range end");
+    uint32_t end_local = new_local(lw, intern_symbol(lw, aurc_view_of("..")));
+    uint32_t var = declare(lw, stmt->as.for_stmt.var, VT_INT);
+    if (lw->failed) {
+        return;
+    }
+    emit(lw, AURC_IR_STORE_LOCAL, AURC_IR_NONE, end_local, end.id, 0);
+    emit(lw, AURC_IR_STORE_LOCAL, AURC_IR_NONE, var, start.id, 0);
+
+    loop_labels labels = {new_label(lw), new_label(lw)};
+    uint32_t top = new_label(lw);
+    emit_label(lw, top);
+    uint32_t i = emit_value(lw, AURC_IR_LOAD_LOCAL, var, AURC_IR_NONE, 0);
+    uint32_t limit = emit_value(lw, AURC_IR_LOAD_LOCAL, end_local, AURC_IR_NONE, 0);
+    emit(lw, step > 0 ? AURC_IR_BR_GE : AURC_IR_BR_LE, AURC_IR_NONE, i, limit, labels.break_label);
+
+    const loop_labels *outer = lw->loop;
+    lw->loop = &labels;
+    lower_scoped_block(lw, &stmt->as.for_stmt.body);
+    lw->loop = outer;
+
+    emit_label(lw, labels.continue_label);
+    uint32_t current = emit_value(lw, AURC_IR_LOAD_LOCAL, var, AURC_IR_NONE, 0);
+    uint32_t delta = emit_value(lw, AURC_IR_CONST, AURC_IR_NONE, AURC_IR_NONE, step);
+    uint32_t next = emit_value(lw, AURC_IR_ADD, current, delta, 0);
+    emit(lw, AURC_IR_STORE_LOCAL, AURC_IR_NONE, var, next, 0);
+    emit_jump(lw, top);
+    emit_label(lw, labels.break_label);
+    lw->scope_count = mark;
+}
+
+static void lower_request(lowerer *lw, const aurc_stmt *stmt) {
+    aurc_view service = stmt->as.request.service;
+    if (aurc_view_eq(service, "print") || aurc_view_eq(service, "print_int")) {
+        int ints_only = aurc_view_eq(service, "print_int");
+        for (const aurc_expr *arg = stmt->as.request.args; arg && !lw->failed; arg = arg->next) {
+            typed_value v = lower_expr(lw, arg);
+            if (lw->failed) {
+                return;
+            }
+            if (v.type == VT_STRING && !ints_only) {
+                emit(lw, AURC_IR_PRINT_STR, AURC_IR_NONE, v.id, AURC_IR_NONE, 0);
+            } else if (v.type == VT_INT || v.type == VT_BOOL) {
+                emit(lw, AURC_IR_PRINT_INT, AURC_IR_NONE, v.id, AURC_IR_NONE, 0);
+            } else {
+                lower_error(lw, arg->line, arg->column, "cannot print a %s value", type_name(v.type));
+            }
+        }
+        return;
+    }
+    if (aurc_view_eq(service, "flush")) {
+        if (stmt->as.request.arg_count != 0) {
+            lower_error(lw, stmt->line, stmt->column, "flush takes no arguments");
+            return;
+        }
+        emit(lw, AURC_IR_FLUSH, AURC_IR_NONE, AURC_IR_NONE, AURC_IR_NONE, 0);
+        return;
+    }
+    if (aurc_view_eq(service, "exit")) {
+        if (stmt->as.request.arg_count != 1) {
+            lower_error(lw, stmt->line, stmt->column, "exit takes exactly one argument");
+            return;
+        }
+        typed_value v = lower_integer(lw, stmt->as.request.args, "exit status");
+        emit(lw, AURC_IR_EXIT, AURC_IR_NONE, v.id, AURC_IR_NONE, 0);
+        return;
+    }
+    lower_error(lw, stmt->line, stmt->column, "unknown service '%.*s'", (int)service.len, service.data);
+}
+
+/* `join name` as a statement or, yielding the task's return value, an expression. */
+static typed_value lower_join(lowerer *lw, aurc_view name, uint32_t line, uint32_t column) {
+    const scope_entry *var = lookup(lw, name);
+    if (!var) {
+        lower_error(lw, line, column, "join on undefined variable '%.*s'", (int)name.len, name.data);
+        return NO_VALUE;
+    }
+    if (var->type != VT_THREAD) {
+        lower_error(lw, line, column, "join needs a thread, '%.*s' is %s", (int)name.len, name.data,
+                    type_name(var->type));
+        return NO_VALUE;
+    }
+    uint32_t handle = emit_value(lw, AURC_IR_LOAD_LOCAL, var->local, AURC_IR_NONE, 0);
+    return make(emit_value(lw, AURC_IR_JOIN, handle, AURC_IR_NONE, 0), VT_INT);
+}
+
+static void lower_atomic(lowerer *lw, const aurc_stmt *stmt) {
+    aurc_atomic_op op = stmt->as.atomic.op;
+    if (op == AURC_ATOMIC_FADD || op == AURC_ATOMIC_CAS) {
+        lower_error(lw, stmt->line, stmt->column, "atomic.%s is not supported by the native backend yet",
+                    op == AURC_ATOMIC_FADD ? "fadd" : "cas");
+        return;
+    }
+    uint32_t shared = find_shared(lw, stmt->as.atomic.target, stmt->line, stmt->column);
+    if (shared == AURC_IR_NONE) {
+        return;
+    }
+    if (op == AURC_ATOMIC_LOAD) {
+        emit_value(lw, AURC_IR_ATOMIC_LOAD, shared, AURC_IR_NONE, 0);
+        return;
+    }
+    typed_value v = lower_integer(lw, stmt->as.atomic.value, "atomic operand");
+    if (lw->failed) {
+        return;
+    }
+    uint32_t operand = v.id;
+    if (op == AURC_ATOMIC_SUB) {
+        operand = emit_value(lw, AURC_IR_NEG, v.id, AURC_IR_NONE, 0);
+    }
+    emit(lw, op == AURC_ATOMIC_STORE ? AURC_IR_ATOMIC_STORE : AURC_IR_ATOMIC_ADD, AURC_IR_NONE, shared, operand, 0);
+}
+
+static void lower_stmt(lowerer *lw, const aurc_stmt *stmt) {
+    switch (stmt->kind) {
+        case AURC_STMT_LET: {
+            value_type declared;
+            if (convert_type(lw, stmt->as.let.type, stmt->line, stmt->column, &declared) != 0) {
+                return;
+            }
+            typed_value v = lower_expr(lw, stmt->as.let.value);
+            if (lw->failed) {
+                return;
+            }
+            if (!compatible(declared, v.type)) {
+                lower_error(lw, stmt->line, stmt->column, "cannot initialise %s '%.*s' with a %s value", type_name(declared),
+                            (int)stmt->as.let.name.len, stmt->as.let.name.data, type_name(v.type));
+                return;
+            }
+            /* declared after the initialiser so `let x = x + 1` reads the outer x */
+            uint32_t local = declare(lw, stmt->as.let.name, declared);
+            emit(lw, AURC_IR_STORE_LOCAL, AURC_IR_NONE, local, v.id, 0);
+            return;
+        }
+        case AURC_STMT_ASSIGN: {
+            if (stmt->as.assign.index) {
+                lower_error(lw, stmt->line, stmt->column, "arrays are not supported by the native backend yet");
+                return;
+            }
+            const scope_entry *var = lookup(lw, stmt->as.assign.name);
+            if (!var) {
+                lower_error(lw, stmt->line, stmt->column, "assignment to undefined variable '%.*s'",
+                            (int)stmt->as.assign.name.len, stmt->as.assign.name.data);
+                return;
+            }
+            uint32_t local = var->local;
+            value_type type = var->type;
+            typed_value v = lower_expr(lw, stmt->as.assign.value);
+            if (lw->failed) {
+                return;
+            }
+            if (!compatible(type, v.type)) {
+                lower_error(lw, stmt->line, stmt->column, "cannot assign a %s value to %s '%.*s'", type_name(v.type),
+                            type_name(type), (int)stmt->as.assign.name.len, stmt->as.assign.name.data);
+                return;
+            }
+            emit(lw, AURC_IR_STORE_LOCAL, AURC_IR_NONE, local, v.id, 0);
+            return;
+        }
+        case AURC_STMT_IF: {
+            uint32_t otherwise = new_label(lw);
+            lower_branch(lw, stmt->as.if_stmt.cond, 0, otherwise);
+            lower_scoped_block(lw, &stmt->as.if_stmt.then_block);
+            if (stmt->as.if_stmt.has_else) {
+                uint32_t done = new_label(lw);
+                emit_jump(lw, done);
+                emit_label(lw, otherwise);
+                lower_scoped_block(lw, &stmt->as.if_stmt.else_block);
+                emit_label(lw, done);
+            } else {
+                emit_label(lw, otherwise);
+            }
+            return;
+        }
+        case AURC_STMT_WHILE: {
+            loop_labels labels = {new_label(lw), new_label(lw)};
+            emit_label(lw, labels.continue_label);
+            lower_branch(lw, stmt->as.while_stmt.cond, 0, labels.break_label);
+            const loop_labels *outer = lw->loop;
+            lw->loop = &labels;
+            lower_scoped_block(lw, &stmt->as.while_stmt.body);
+            lw->loop = outer;
+            emit_jump(lw, labels.continue_label);
+            emit_label(lw, labels.break_label);
+            return;
+        }
+        case AURC_STMT_FOR:
+            lower_for(lw, stmt);
+            return;
+        case AURC_STMT_BREAK:
+        case AURC_STMT_CONTINUE:
+            if (!lw->loop) {
+                lower_error(lw, stmt->line, stmt->column, "%s outside of a loop",
+                            stmt->kind == AURC_STMT_BREAK ? "break" : "continue");
+                return;
+            }
+            emit_jump(lw, stmt->kind == AURC_STMT_BREAK ? lw->loop->break_label : lw->loop->continue_label);
+            return;
+        case AURC_STMT_REQUEST:
+            lower_request(lw, stmt);
+            return;
+        case AURC_STMT_RETURN: {
+            if (!stmt->as.ret_value) {
+                if (lw->fn->returns_value) {
+                    lower_error(lw, stmt->line, stmt->column, "missing return value");
+                    return;
+                }
+                emit(lw, AURC_IR_RET, AURC_IR_NONE, AURC_IR_NONE, AURC_IR_NONE, 0);
+                return;
+            }
+            if (!lw->fn->returns_value) {
+                lower_error(lw, stmt->line, stmt->column, "void function returns a value");
+                return;
+            }
+            typed_value v = lower_integer(lw, stmt->as.ret_value, "return value");
+            emit(lw, AURC_IR_RET, AURC_IR_NONE, v.id, AURC_IR_NONE, 0);
+            return;
+        }
+        case AURC_STMT_CALL:
+            lower_call(lw, stmt->as.call, AURC_IR_CALL);
+            return;
+        case AURC_STMT_JOIN:
+            lower_join(lw, stmt->as.join_handle, stmt->line, stmt->column);
+            return;
+        case AURC_STMT_ATOMIC:
+            lower_atomic(lw, stmt);
+            return;
+    }
+}
+
+static void lower_block(lowerer *lw, const aurc_block *block) {
+    for (const aurc_stmt *stmt = block->first; stmt && !lw->failed; stmt = stmt->next) {
+        lower_stmt(lw, stmt);
+    }
+}
+
+static aurc_ir_function *add_function(lowerer *lw, aurc_view name) {
+    aurc_ir_program *ir = lw->ir;
+    uint32_t symbol = intern_symbol(lw, name);
+    if (symbol == AURC_IR_NONE) {
+        return NULL;
+    }
+    if (ir->function_count == ir->function_cap) {
+        uint32_t cap = ir->function_cap ? ir->function_cap * 2 : 8;
+        aurc_ir_function *grown = realloc(ir->functions, cap * sizeof *grown);
+        if (!grown) {
+            out_of_memory(lw);
+            return NULL;
+        }
+        memset(grown + ir->function_cap, 0, (cap - ir->function_cap) * sizeof *grown);
+        ir->functions = grown;
+        ir->function_cap = cap;
+    }
+    /* a slot reused after aurc_ir_reset keeps its code and local-name buffers */
+    aurc_ir_function *fn = &ir->functions[ir->function_count++];
+    aurc_ir_code code = fn->code;
+    uint32_t *local_names = fn->local_names;
+    uint32_t local_cap = fn->local_cap;
+    memset(fn, 0, sizeof *fn);
+    fn->name = symbol;
+    fn->code = code;
+    fn->code.count = 0;
+    fn->local_names = local_names;
+    fn->local_cap = local_cap;
+    return fn;
+}
+
+static int lower_function_body(lowerer *lw, aurc_ir_function *fn, const aurc_function *ast) {
+    lw->fn = fn;
+    lw->ast_fn = ast;
+    lw->scope_count = 0;
+    lw->loop = NULL;
+
+    if (ast) {
+        value_type ret;
+        if (convert_type(lw, ast->return_type, ast->line, ast->column, &ret) != 0) {
+            return 1;
+        }
+        /* main's value is the exit status even when `-> int` is left off */
+        fn->returns_value = ret != VT_VOID || aurc_view_eq(ast->name, "main");
+        for (const aurc_param *param = ast->params; param; param = param->next) {
+            value_type type;
+            if (convert_type(lw, param->type, ast->line, ast->column, &type) != 0) {
+                return 1;
+            }
+            declare(lw, param->name, type);
+            fn->param_count++;
+        }
+        lower_block(lw, &ast->body);
+    } else {
+        fn->returns_value = 1;
+        lower_block(lw, &lw->program->body);
+    }
+    /* falling off the end returns 0 (main's exit status) */
+    emit(lw, AURC_IR_RET, AURC_IR_NONE, AURC_IR_NONE, AURC_IR_NONE, 0);
+    return lw->failed;
+}
+
+/* Shared initialisers must be integer constants: the slots are filled in before any code runs. */
+static int constant_init(const aurc_expr *expr, int64_t *value) {
+    if (expr->kind == AURC_EXPR_INT || expr->kind == AURC_EXPR_BOOL) {
+        *value = expr->kind == AURC_EXPR_INT ? expr->as.int_value : expr->as.bool_value;
+        return 0;
+    }
+    if (expr->kind == AURC_EXPR_UNARY && expr->as.unary.op == AURC_UN_NEG &&
+        constant_init(expr->as.unary.operand, value) == 0) {
+        *value = (int64_t)(0 - (uint64_t)*value);
+        return 0;
+    }
+    return 1;
+}
+
+static void lower_shared(lowerer *lw, const aurc_shared_decl *decl) {
+    aurc_ir_program *ir = lw->ir;
+    value_type type;
+    if (convert_type(lw, decl->type, decl->line, decl->column, &type) != 0) {
+        return;
+    }
+    if (type != VT_INT && type != VT_BOOL) {
+        lower_error(lw, decl->line, decl->column, "shared variable '%.*s' must be an int, not %s", (int)decl->name.len,
+                    decl->name.data, type_name(type));
+        return;
+    }
+    int64_t init = 0;
+    if (constant_init(decl->init, &init) != 0) {
+        lower_error(lw, decl->init->line, decl->init->column, "shared variable '%.*s' needs a constant initialiser",
+                    (int)decl->name.len, decl->name.data);
+        return;
+    }
+    uint32_t symbol = intern_symbol(lw, decl->name);
+    if (symbol == AURC_IR_NONE) {
+        return;
+    }
+    for (uint32_t i = 0; i < ir->shared_count; ++i) {
+        if (ir->shared[i].name == symbol) {
+            lower_error(lw, decl->line, decl->column, "duplicate shared variable '%.*s'", (int)decl->name.len,
+                        decl->name.data);
+            return;
+        }
+    }
+    if (ir->shared_count == ir->shared_cap) {
+        uint32_t cap = ir->shared_cap ? ir->shared_cap * 2 : 8;
+        aurc_ir_shared *grown = realloc(ir->shared, cap * sizeof *grown);
+        if (!grown) {
+            out_of_memory(lw);
+            return;
+        }
+        ir->shared = grown;
+        ir->shared_cap = cap;
+    }
+    ir->shared[ir->shared_count].name = symbol;
+    ir->shared[ir->shared_count].init = init;
+    ir->shared[ir->shared_count].sharded = 0;
+    ir->shared_count++;
+}
+
+/* Adds a function per AST function and the tables find_function and lower_call look them up in. */
+static int declare_functions(lowerer *lw) {
+    uint32_t count = 0;
+    for (const aurc_function *ast = lw->program->functions; ast; ast = ast->next) {
+        ++count;
+    }
+    lw->ast_functions = malloc((count ? count : 1) * sizeof *lw->ast_functions);
+    if (!lw->ast_functions) {
+        out_of_memory(lw);
+        return 1;
+    }
+    uint32_t index = 0;
+    for (const aurc_function *ast = lw->program->functions; ast; ast = ast->next) {
+        if (!add_function(lw, ast->name)) {
+            return 1;
+        }
+        lw->ast_functions[index++] = ast;
+    }
+
+    /* every function name is interned by now; names interned later cannot be functions */
+    uint32_t symbols = lw->ir->symbols.count;
+    lw->function_of = malloc((symbols ? symbols : 1) * sizeof *lw->function_of);
+    if (!lw->function_of) {
+        out_of_memory(lw);
+        return 1;
+    }
+    for (uint32_t i = 0; i < symbols; ++i) {
+        lw->function_of[i] = AURC_IR_NONE;
+    }
+    lw->function_symbols = symbols;
+    for (uint32_t i = 0; i < count; ++i) {
+        const aurc_function *ast = lw->ast_functions[i];
+        uint32_t symbol = lw->ir->functions[i].name;
+        if (lw->function_of[symbol] != AURC_IR_NONE) {
+            lower_error(lw, ast->line, ast->column, "duplicate function '%.*s'", (int)ast->name.len, ast->name.data);
+            return 1;
+        }
+        lw->function_of[symbol] = i;
+    }
+    return 0;
+}
+
+int aurc_ir_lower(const char *path, const aurc_program *program, aurc_ir_program *ir) {
+    lowerer lw;
+    memset(&lw, 0, sizeof lw);
+    lw.path = path;
+    lw.program = program;
+    lw.ir = ir;
+
+    for (const aurc_shared_decl *decl = program->shared; decl && !lw.failed; decl = decl->next) {
+        lower_shared(&lw, decl);
+    }
+    if (lw.failed) {
+        return 1;
+    }
+
+    int rc = 0;
+    if (program->form == AURC_PROGRAM_FLAT) {
+        aurc_ir_function *fn = add_function(&lw, aurc_view_of("main"));
+        ir->entry = 0;
+        rc = !fn || lower_function_body(&lw, fn, NULL) != 0;
+    } else {
+        /* declare every function first so calls may refer forward */
+        if (declare_functions(&lw) != 0) {
+            lw.failed = 1;
+        }
+        ir->entry = find_function(&lw, aurc_view_of("main"));
+        if (!lw.failed && ir->entry == AURC_IR_NONE) {
+            aurc_diag_printf("aurc-native: %s: no `fn main` to compile\n", path);
+            lw.failed = 1;
+        }
+        uint32_t index = 0;
+        for (const aurc_function *ast = program->functions; ast && !lw.failed; ast = ast->next, ++index) {
+            lower_function_body(&lw, &ir->functions[index], ast);
+        }
+        rc = lw.failed;
+    }
+
+    free(lw.scope);
+    free(lw.function_of);
+    free(lw.ast_functions);
+    return rc;
+}
@@ -0,0 +1,1201 @@
+#include "aurc_ir.h"
+#include "aurc_diag.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * IR optimizer, run between lowering and every backend. Each round works on
+ * one function at a time:
+ *
+ *   - code after a jump, ret or exit is dropped up to the next label, and
+ *     labels nothing branches to are dropped so their blocks merge;
+ *   - jumps and branches are threaded through blocks that only jump on,
+ *     branches to the next instruction disappear, and `br c X; jump Y; X:`
+ *     becomes `br !c Y; X:`;
+ *   - a forward walk over each block folds constants (with the VM's
+ *     wrap-around, shift masking and INT64_MIN / -1 results), applies
+ *     algebraic identities, forwards a local's last stored or loaded value to
+ *     later loads, drops stores that are overwritten or die with the frame,
+ *     and moves constant operands of commutative operators and comparisons
+ *     to b, where backends encode them as immediates;
+ *   - values nobody reads are deleted when computing them has no effect, as
+ *     are stores to locals nothing loads.
+ *
+ * Rounds repeat until nothing changes. Counted loops whose body only steps
+ * an induction variable and sums or assigns values linear in it are then
+ * replaced by their closed form (see "loop idioms" below), and the rounds
+ * run again over the result. The function's values and surviving
+ * locals (parameters keep their numbers) are then renumbered densely, so
+ * frames shrink along with the code.
+ */
+
+#define OPT_MAX_ROUNDS 8
+#define OPT_MAX_HOPS 16             /* threading gives up on longer chains, and on cycles */
+
+typedef struct opt_state {
+    aurc_ir_function *fn;
+    uint8_t *dead;                  /* per instruction, cleared by compact() */
+    uint32_t *label_at;             /* per label: its LABEL instruction, AURC_IR_NONE once gone */
+    uint32_t *label_refs;
+    uint32_t *alias;                /* per value: the value that replaced it, or itself */
+    uint8_t *known;                 /* per value: konst holds its value */
+    int64_t *konst;
+    uint32_t *def_at;               /* per value: defining instruction */
+    uint32_t *uses;
+    uint32_t *local_value;          /* per local: value equal to it, valid while local_block matches */
+    uint32_t *local_block;
+    uint32_t *local_store;          /* per local: store nothing has read yet, valid while store_epoch matches */
+    uint32_t *store_epoch;
+    uint32_t *local_loads;
+    int changed;
+} opt_state;
+
+static int is_terminator(aurc_ir_op op) {
+    return op == AURC_IR_JUMP || op == AURC_IR_RET || op == AURC_IR_EXIT;
+}
+
+static int is_commutative(aurc_ir_op op) {
+    return op == AURC_IR_ADD || op == AURC_IR_MUL || op == AURC_IR_AND || op == AURC_IR_OR || op == AURC_IR_XOR ||
+           op == AURC_IR_EQ || op == AURC_IR_NE || op == AURC_IR_BR_EQ || op == AURC_IR_BR_NE;
+}
+
+/* a OP b == b mirror(OP) a, for comparisons and branches alike */
+static aurc_ir_op mirrored(aurc_ir_op op) {
+    switch (op) {
+        case AURC_IR_LT: return AURC_IR_GT;
+        case AURC_IR_LE: return AURC_IR_GE;
+        case AURC_IR_GT: return AURC_IR_LT;
+        case AURC_IR_GE: return AURC_IR_LE;
+        case AURC_IR_BR_LT: return AURC_IR_BR_GT;
+        case AURC_IR_BR_LE: return AURC_IR_BR_GE;
+        case AURC_IR_BR_GT: return AURC_IR_BR_LT;
+        case AURC_IR_BR_GE: return AURC_IR_BR_LE;
+        default: return op;
+    }
+}
+
+static aurc_ir_op inverted_branch(aurc_ir_op op) {
+    switch (op) {
+        case AURC_IR_BR_EQ: return AURC_IR_BR_NE;
+        case AURC_IR_BR_NE: return AURC_IR_BR_EQ;
+        case AURC_IR_BR_LT: return AURC_IR_BR_GE;
+        case AURC_IR_BR_LE: return AURC_IR_BR_GT;
+        case AURC_IR_BR_GT: return AURC_IR_BR_LE;
+        default: return AURC_IR_BR_LT;
+    }
+}
+
+/* Comparison and branch conditions share their order: EQ NE LT LE GT GE. */
+static int compare_holds(unsigned condition, int64_t lhs, int64_t rhs) {
+    switch (condition) {
+        case 0: return lhs == rhs;
+        case 1: return lhs != rhs;
+        case 2: return lhs < rhs;
+        case 3: return lhs <= rhs;
+        case 4: return lhs > rhs;
+        default: return lhs >= rhs;
+    }
+}
+
+/* Same results as the VM's ALU; returns 0 for a division by zero, which is left to fault at run time. */
+static int fold_binary(aurc_ir_op op, int64_t lhs, int64_t rhs, int64_t *result) {
+    uint64_t l = (uint64_t)lhs;
+    uint64_t r = (uint64_t)rhs;
+    switch (op) {
+        case AURC_IR_ADD: *result = (int64_t)(l + r); return 1;
+        case AURC_IR_SUB: *result = (int64_t)(l - r); return 1;
+        case AURC_IR_MUL: *result = (int64_t)(l * r); return 1;
+        case AURC_IR_AND: *result = (int64_t)(l & r); return 1;
+        case AURC_IR_OR: *result = (int64_t)(l | r); return 1;
+        case AURC_IR_XOR: *result = (int64_t)(l ^ r); return 1;
+        case AURC_IR_SHL: *result = (int64_t)(l << (r & 63)); return 1;
+        case AURC_IR_SHR: *result = (int64_t)(lhs >= 0 ? l >> (r & 63) : ~(~l >> (r & 63))); return 1;
+        case AURC_IR_DIV:
+        case AURC_IR_MOD:
+            if (rhs == 0) {
+                return 0;
+            }
+            if (lhs == INT64_MIN && rhs == -1) {
+                *result = op == AURC_IR_DIV ? lhs : 0;
+            } else {
+                *result = op == AURC_IR_DIV ? lhs / rhs : lhs % rhs;
+            }
+            return 1;
+        default:
+            *result = compare_holds((unsigned)(op - AURC_IR_EQ), lhs, rhs);
+            return 1;
+    }
+}
+
+static void kill(opt_state *st, size_t i) {
+    st->dead[i] = 1;
+    st->changed = 1;
+}
+
+static void make_const(opt_state *st, size_t i, int64_t value) {
+    aurc_ir_code *code = &st->fn->code;
+    code->op[i] = AURC_IR_CONST;
+    code->a[i] = AURC_IR_NONE;
+    code->b[i] = AURC_IR_NONE;
+    code->imm[i] = value;
+    st->known[code->dst[i]] = 1;
+    st->konst[code->dst[i]] = value;
+    st->changed = 1;
+}
+
+/* Replaces instruction i's result by value everywhere after it. */
+static void replace(opt_state *st, size_t i, uint32_t value) {
+    st->alias[st->fn->code.dst[i]] = value;
+    kill(st, i);
+}
+
+static void compact(opt_state *st) {
+    aurc_ir_code *code = &st->fn->code;
+    size_t out = 0;
+    for (size_t i = 0; i < code->count; ++i) {
+        if (st->dead[i]) {
+            st->dead[i] = 0;
+            continue;
+        }
+        code->op[out] = code->op[i];
+        code->dst[out] = code->dst[i];
+        code->a[out] = code->a[i];
+        code->b[out] = code->b[i];
+        code->imm[out] = code->imm[i];
+        ++out;
+    }
+    code->count = out;
+}
+
+/* ---- control flow ------------------------------------------------------- */
+
+static void count_label_refs(opt_state *st) {
+    const aurc_ir_code *code = &st->fn->code;
+    memset(st->label_refs, 0, st->fn->label_count * sizeof *st->label_refs);
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (op == AURC_IR_JUMP || aurc_ir_op_is_branch(op)) {
+            st->label_refs[code->imm[i]]++;
+        }
+    }
+}
+
+static void drop_unreachable(opt_state *st) {
+    const aurc_ir_code *code = &st->fn->code;
+    count_label_refs(st);
+    int reachable = 1;
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (op == AURC_IR_LABEL) {
+            if (st->label_refs[code->imm[i]] > 0) {
+                reachable = 1;
+                continue;
+            }
+            kill(st, i);
+            continue;
+        }
+        if (!reachable) {
+            kill(st, i);
+        } else if (is_terminator(op)) {
+            reachable = 0;
+        }
+    }
+    compact(st);
+}
+
+/* First label a jump to label ends up at, following blocks that consist of nothing but a jump. */
+static uint32_t final_target(const opt_state *st, uint32_t label) {
+    const aurc_ir_code *code = &st->fn->code;
+    for (int hop = 0; hop < OPT_MAX_HOPS; ++hop) {
+        size_t i = st->label_at[label];
+        while (i < code->count && code->op[i] == AURC_IR_LABEL) {
+            ++i;
+        }
+        if (i >= code->count || code->op[i] != AURC_IR_JUMP || code->imm[i] == label) {
+            break;
+        }
+        label = (uint32_t)code->imm[i];
+    }
+    return label;
+}
+
+/* Whether falling through from instruction i reaches label without executing anything. */
+static int falls_to(const opt_state *st, size_t i, int64_t label) {
+    const aurc_ir_code *code = &st->fn->code;
+    for (size_t j = i + 1; j < code->count && code->op[j] == AURC_IR_LABEL; ++j) {
+        if (code->imm[j] == label) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void thread_jumps(opt_state *st) {
+    aurc_ir_code *code = &st->fn->code;
+    for (uint32_t l = 0; l < st->fn->label_count; ++l) {
+        st->label_at[l] = AURC_IR_NONE;
+    }
+    for (size_t i = 0; i < code->count; ++i) {
+        if (code->op[i] == AURC_IR_LABEL) {
+            st->label_at[code->imm[i]] = (uint32_t)i;
+        }
+    }
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (op != AURC_IR_JUMP && !aurc_ir_op_is_branch(op)) {
+            continue;
+        }
+        uint32_t target = final_target(st, (uint32_t)code->imm[i]);
+        if (target != code->imm[i]) {
+            code->imm[i] = target;
+            st->changed = 1;
+        }
+    }
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (st->dead[i] || (op != AURC_IR_JUMP && !aurc_ir_op_is_branch(op))) {
+            continue;
+        }
+        if (falls_to(st, i, code->imm[i])) {
+            kill(st, i);
+        } else if (aurc_ir_op_is_branch(op) && i + 1 < code->count && code->op[i + 1] == AURC_IR_JUMP &&
+                   falls_to(st, i + 1, code->imm[i])) {
+            code->op[i] = (uint8_t)inverted_branch(op);
+            code->imm[i] = code->imm[i + 1];
+            kill(st, i + 1);
+        }
+    }
+    compact(st);
+}
+
+/* ---- folding and forwarding --------------------------------------------- */
+
+static void fold_value(opt_state *st, size_t i) {
+    aurc_ir_code *code = &st->fn->code;
+    aurc_ir_op op = (aurc_ir_op)code->op[i];
+    uint32_t a = code->a[i];
+    uint32_t b = code->b[i];
+
+    if (op == AURC_IR_NEG || op == AURC_IR_NOT || op == AURC_IR_BITNOT) {
+        if (st->known[a]) {
+            int64_t k = st->konst[a];
+            make_const(st, i, op == AURC_IR_NEG ? (int64_t)(0 - (uint64_t)k) : op == AURC_IR_NOT ? k == 0 : ~k);
+        }
+        return;
+    }
+    if (st->known[a] && !st->known[b] && (is_commutative(op) || mirrored(op) != op)) {
+        code->a[i] = b;
+        code->b[i] = a;
+        code->op[i] = (uint8_t)mirrored(op);
+        op = mirrored(op);
+        a = code->a[i];
+        b = code->b[i];
+        st->changed = 1;
+    }
+    int64_t result;
+    if (st->known[a] && st->known[b]) {
+        if (fold_binary(op, st->konst[a], st->konst[b], &result)) {
+            make_const(st, i, result);
+        }
+        return;
+    }
+    if (a == b) {
+        switch (op) {
+            case AURC_IR_AND: case AURC_IR_OR: replace(st, i, a); return;
+            case AURC_IR_SUB: case AURC_IR_XOR: case AURC_IR_NE: case AURC_IR_LT: case AURC_IR_GT:
+                make_const(st, i, 0);
+                return;
+            case AURC_IR_EQ: case AURC_IR_LE: case AURC_IR_GE: make_const(st, i, 1); return;
+            default: return;
+        }
+    }
+    if (!st->known[b]) {
+        return;
+    }
+    int64_t k = st->konst[b];
+    switch (op) {
+        case AURC_IR_ADD: case AURC_IR_SUB: case AURC_IR_OR: case AURC_IR_XOR: case AURC_IR_SHL: case AURC_IR_SHR:
+            if ((op == AURC_IR_SHL || op == AURC_IR_SHR ? k & 63 : k) == 0) {
+                replace(st, i, a);
+            } else if (op == AURC_IR_OR && k == -1) {
+                make_const(st, i, -1);
+            }
+            return;
+        case AURC_IR_MUL: case AURC_IR_DIV:
+            if (k == 1) {
+                replace(st, i, a);
+            } else if (op == AURC_IR_MUL && k == 0) {
+                make_const(st, i, 0);
+            }
+            return;
+        case AURC_IR_MOD:
+            if (k == 1 || k == -1) {
+                make_const(st, i, 0);
+            }
+            return;
+        case AURC_IR_AND:
+            if (k == 0) {
+                make_const(st, i, 0);
+            } else if (k == -1) {
+                replace(st, i, a);
+            }
+            return;
+        default:
+            return;
+    }
+}
+
+static void fold_branch(opt_state *st, size_t i) {
+    aurc_ir_code *code = &st->fn->code;
+    aurc_ir_op op = (aurc_ir_op)code->op[i];
+    uint32_t a = code->a[i];
+    uint32_t b = code->b[i];
+    if (st->known[a] && !st->known[b]) {
+        code->a[i] = b;
+        code->b[i] = a;
+        code->op[i] = (uint8_t)mirrored(op);
+        st->changed = 1;
+        return;
+    }
+    int taken;
+    if (st->known[a] && st->known[b]) {
+        taken = compare_holds((unsigned)(op - AURC_IR_BR_EQ), st->konst[a], st->konst[b]);
+    } else if (a == b) {
+        taken = op == AURC_IR_BR_EQ || op == AURC_IR_BR_LE || op == AURC_IR_BR_GE;
+    } else {
+        return;
+    }
+    if (taken) {
+        code->op[i] = AURC_IR_JUMP;
+        code->a[i] = AURC_IR_NONE;
+        code->b[i] = AURC_IR_NONE;
+        st->changed = 1;
+    } else {
+        kill(st, i);
+    }
+}
+
+/*
+ * Blocks are stamped by the labels that start them; branches and calls leave
+ * locals alone, so a local's known value survives until the next label. An
+ * unread store stays a candidate for removal only until control may leave
+ * the block (a branch, jump or label).
+ */
+static void fold_blocks(opt_state *st) {
+    aurc_ir_code *code = &st->fn->code;
+    uint32_t locals = st->fn->local_count;
+    uint32_t block = 1;
+    uint32_t epoch = 1;
+    memset(st->local_block, 0, locals * sizeof *st->local_block);
+    memset(st->store_epoch, 0, locals * sizeof *st->store_epoch);
+    memset(st->known, 0, st->fn->value_count);
+    for (uint32_t v = 0; v < st->fn->value_count; ++v) {
+        st->alias[v] = v;
+    }
+
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        unsigned uses = aurc_ir_op_uses(op);
+        if ((uses & AURC_IR_USES_A) && code->a[i] != AURC_IR_NONE) {
+            code->a[i] = st->alias[code->a[i]];
+        }
+        if (uses & AURC_IR_USES_B) {
+            code->b[i] = st->alias[code->b[i]];
+        }
+        uint32_t l = code->a[i];
+
+        switch (op) {
+            case AURC_IR_CONST:
+                st->known[code->dst[i]] = 1;
+                st->konst[code->dst[i]] = code->imm[i];
+                break;
+            case AURC_IR_LOAD_LOCAL:
+                st->store_epoch[l] = 0;
+                if (st->local_block[l] == block) {
+                    replace(st, i, st->local_value[l]);
+                } else {
+                    st->local_value[l] = code->dst[i];
+                    st->local_block[l] = block;
+                }
+                break;
+            case AURC_IR_STORE_LOCAL:
+                if (st->store_epoch[l] == epoch) {
+                    kill(st, st->local_store[l]);
+                }
+                st->local_store[l] = (uint32_t)i;
+                st->store_epoch[l] = epoch;
+                st->local_value[l] = code->b[i];
+                st->local_block[l] = block;
+                break;
+            case AURC_IR_LABEL:
+                ++block;
+                ++epoch;
+                break;
+            case AURC_IR_JUMP:
+                ++epoch;
+                break;
+            case AURC_IR_RET:
+            case AURC_IR_EXIT:
+                /* the frame dies here, taking every unread store with it */
+                for (uint32_t k = 0; k < locals; ++k) {
+                    if (st->store_epoch[k] == epoch) {
+                        kill(st, st->local_store[k]);
+                    }
+                }
+                ++epoch;
+                break;
+            default:
+                if (aurc_ir_op_is_branch(op)) {
+                    fold_branch(st, i);
+                    ++epoch;
+                } else if ((op >= AURC_IR_ADD && op <= AURC_IR_GE) || op == AURC_IR_NEG || op == AURC_IR_NOT ||
+                           op == AURC_IR_BITNOT) {
+                    fold_value(st, i);
+                }
+                break;
+        }
+    }
+    compact(st);
+}
+
+/* ---- dead values -------------------------------------------------------- */
+
+static int is_pure(const opt_state *st, size_t i) {
+    const aurc_ir_code *code = &st->fn->code;
+    aurc_ir_op op = (aurc_ir_op)code->op[i];
+    if (op == AURC_IR_DIV || op == AURC_IR_MOD) {
+        /* only a known non-zero divisor cannot fault */
+        uint32_t def = st->def_at[code->b[i]];
+        return code->op[def] == AURC_IR_CONST && code->imm[def] != 0;
+    }
+    return op == AURC_IR_CONST || op == AURC_IR_STRING || op == AURC_IR_LOAD_LOCAL ||
+           (op >= AURC_IR_ADD && op <= AURC_IR_GE) || op == AURC_IR_NEG || op == AURC_IR_NOT ||
+           op == AURC_IR_BITNOT || op == AURC_IR_ATOMIC_LOAD;
+}
+
+static void drop_dead_values(opt_state *st) {
+    aurc_ir_code *code = &st->fn->code;
+    memset(st->uses, 0, st->fn->value_count * sizeof *st->uses);
+    memset(st->local_loads, 0, st->fn->local_count * sizeof *st->local_loads);
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        unsigned uses = aurc_ir_op_uses(op);
+        if ((uses & AURC_IR_USES_A) && code->a[i] != AURC_IR_NONE) {
+            st->uses[code->a[i]]++;
+        }
+        if (uses & AURC_IR_USES_B) {
+            st->uses[code->b[i]]++;
+        }
+        if (aurc_ir_op_has_dst(op)) {
+            st->def_at[code->dst[i]] = (uint32_t)i;
+        }
+        if (op == AURC_IR_LOAD_LOCAL) {
+            st->local_loads[code->a[i]]++;
+        }
+    }
+    /* definitions precede uses, so one backward sweep sees every use of a value go before the value */
+    for (size_t i = code->count; i-- > 0;) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        int remove = (op == AURC_IR_STORE_LOCAL && st->local_loads[code->a[i]] == 0) ||
+                     (aurc_ir_op_has_dst(op) && st->uses[code->dst[i]] == 0 && is_pure(st, i));
+        if (!remove) {
+            continue;
+        }
+        kill(st, i);
+        unsigned uses = aurc_ir_op_uses(op);
+        if ((uses & AURC_IR_USES_A) && code->a[i] != AURC_IR_NONE) {
+            st->uses[code->a[i]]--;
+        }
+        if (uses & AURC_IR_USES_B) {
+            st->uses[code->b[i]]--;
+        }
+    }
+    compact(st);
+}
+
+/* ---- loop idioms -------------------------------------------------------- */
+
+/*
+ * A loop the walk can read is `L: head; br c x, y -> X; body; jump L; X:`
+ * where nothing else branches to L, the head only loads and computes, and the
+ * body is straight-line loads, stores, constants and additions,
+ * subtractions, negations, shifts and multiplications by constants. Running
+ * the head and body symbolically gives every value and every stored local as
+ * a linear form over the locals' values when the iteration began.
+ *
+ * The exit test must compare a local i against a value the loop never
+ * changes, and the body must step i by a constant s: i is the induction
+ * variable and the trip count n follows from the test, s and i's entry value.
+ * Every other stored local must either add to itself something linear in i
+ * and invariant locals (an accumulator: its final value is an arithmetic
+ * series in closed form) or be overwritten with such a value (it ends with
+ * the last iteration's). The body and back jump are then replaced by code
+ * computing n and the final values once, after the head test has admitted
+ * the first iteration; multiplications by i become one multiplication by n
+ * and one by n(n-1)/2, and power-of-two steps divide with a shift. Once the
+ * head label has gone, the ordinary rounds fold all of it to constants when
+ * the bounds are.
+ *
+ * Wrap-around of the induction variable itself is not modelled: a loop that
+ * only stops by overflowing i is assumed not to exist. The trip count is
+ * computed unsigned, since the distance from i to the bound can exceed
+ * INT64_MAX, and is exact as long as i does not wrap; the final values are
+ * then exact modulo 2^64, as in the VM.
+ */
+
+#define LOOP_MAX_TERMS 4
+#define LOOP_MAX_PASSES 4           /* loops closed per pass let their enclosing loop close on the next */
+
+/* c + sum of k[t] times the value local var[t] held when the iteration began */
+typedef struct lin_form {
+    uint64_t c;
+    uint64_t k[LOOP_MAX_TERMS];
+    uint32_t var[LOOP_MAX_TERMS];
+    unsigned count;
+} lin_form;
+
+typedef struct loop_state {
+    aurc_ir_function *fn;
+    lin_form *value_form;           /* per value defined in the loop being read */
+    lin_form *local_form;           /* per local, while stored is set */
+    uint8_t *stored;
+    uint32_t *entry;                /* per local: its value loaded after the head test, or AURC_IR_NONE */
+    uint32_t *final;
+    uint32_t *label_at;
+    uint32_t *label_refs;
+    aurc_ir_code out;               /* the closed form being built */
+    int failed;
+} loop_state;
+
+static int reserve_code(aurc_ir_code *code, size_t need) {
+    if (need <= code->cap) {
+        return 0;
+    }
+    size_t cap = code->cap ? code->cap * 2 : 64;
+    while (cap < need) {
+        cap *= 2;
+    }
+    uint8_t *op = realloc(code->op, cap * sizeof *op);
+    if (!op) {
+        return 1;
+    }
+    code->op = op;
+    uint32_t *dst = realloc(code->dst, cap * sizeof *dst);
+    if (!dst) {
+        return 1;
+    }
+    code->dst = dst;
+    uint32_t *a = realloc(code->a, cap * sizeof *a);
+    if (!a) {
+        return 1;
+    }
+    code->a = a;
+    uint32_t *b = realloc(code->b, cap * sizeof *b);
+    if (!b) {
+        return 1;
+    }
+    code->b = b;
+    int64_t *imm = realloc(code->imm, cap * sizeof *imm);
+    if (!imm) {
+        return 1;
+    }
+    code->imm = imm;
+    code->cap = cap;
+    return 0;
+}
+
+static lin_form form_const(uint64_t c) {
+    lin_form f;
+    memset(&f, 0, sizeof f);
+    f.c = c;
+    return f;
+}
+
+static lin_form form_var(uint32_t local) {
+    lin_form f = form_const(0);
+    f.k[0] = 1;
+    f.var[0] = local;
+    f.count = 1;
+    return f;
+}
+
+static uint64_t form_coef(const lin_form *f, uint32_t local) {
+    for (unsigned t = 0; t < f->count; ++t) {
+        if (f->var[t] == local) {
+            return f->k[t];
+        }
+    }
+    return 0;
+}
+
+/* f += k * local; returns 0 when f runs out of terms */
+static int form_add_term(lin_form *f, uint32_t local, uint64_t k) {
+    for (unsigned t = 0; t < f->count; ++t) {
+        if (f->var[t] == local) {
+            f->k[t] += k;
+            if (f->k[t] == 0) {
+                --f->count;
+                f->k[t] = f->k[f->count];
+                f->var[t] = f->var[f->count];
+            }
+            return 1;
+        }
+    }
+    if (k == 0) {
+        return 1;
+    }
+    if (f->count == LOOP_MAX_TERMS) {
+        return 0;
+    }
+    f->k[f->count] = k;
+    f->var[f->count++] = local;
+    return 1;
+}
+
+/* *out = x + scale * y */
+static int form_combine(lin_form *out, const lin_form *x, const lin_form *y, uint64_t scale) {
+    lin_form sum = *x;
+    sum.c += scale * y->c;
+    for (unsigned t = 0; t < y->count; ++t) {
+        if (!form_add_term(&sum, y->var[t], scale * y->k[t])) {
+            return 0;
+        }
+    }
+    *out = sum;
+    return 1;
+}
+
+static int form_depends_on_stored(const loop_state *ls, const lin_form *f) {
+    for (unsigned t = 0; t < f->count; ++t) {
+        if (ls->stored[f->var[t]]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Reads code[from, to) into forms; returns 0 at the first instruction a form cannot describe. */
+static int read_straight_line(loop_state *ls, size_t from, size_t to, int allow_stores) {
+    const aurc_ir_code *code = &ls->fn->code;
+    lin_form zero = form_const(0);
+    for (size_t i = from; i < to; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        uint32_t dst = code->dst[i];
+        const lin_form *fa = NULL;
+        const lin_form *fb = NULL;
+        if (aurc_ir_op_uses(op) & AURC_IR_USES_A) {
+            fa = &ls->value_form[code->a[i]];
+        }
+        if (aurc_ir_op_uses(op) & AURC_IR_USES_B) {
+            fb = &ls->value_form[code->b[i]];
+        }
+        switch (op) {
+            case AURC_IR_CONST:
+                ls->value_form[dst] = form_const((uint64_t)code->imm[i]);
+                break;
+            case AURC_IR_LOAD_LOCAL:
+                ls->value_form[dst] = ls->stored[code->a[i]] ? ls->local_form[code->a[i]] : form_var(code->a[i]);
+                break;
+            case AURC_IR_STORE_LOCAL:
+                if (!allow_stores) {
+                    return 0;
+                }
+                ls->local_form[code->a[i]] = *fb;
+                ls->stored[code->a[i]] = 1;
+                break;
+            case AURC_IR_ADD:
+            case AURC_IR_SUB:
+                if (!form_combine(&ls->value_form[dst], fa, fb, op == AURC_IR_ADD ? 1 : UINT64_MAX)) {
+                    return 0;
+                }
+                break;
+            case AURC_IR_NEG:
+                if (!form_combine(&ls->value_form[dst], &zero, fa, UINT64_MAX)) {
+                    return 0;
+                }
+                break;
+            case AURC_IR_MUL:
+                if (fb->count != 0 && fa->count == 0) {
+                    const lin_form *t = fa;
+                    fa = fb;
+                    fb = t;
+                }
+                if (fb->count != 0 || !form_combine(&ls->value_form[dst], &zero, fa, fb->c)) {
+                    return 0;
+                }
+                break;
+            case AURC_IR_SHL:
+                if (fb->count != 0 || !form_combine(&ls->value_form[dst], &zero, fa, (uint64_t)1 << (fb->c & 63))) {
+                    return 0;
+                }
+                break;
+            default:
+                return 0;
+        }
+    }
+    return 1;
+}
+
+static uint32_t emit(loop_state *ls, aurc_ir_op op, uint32_t a, uint32_t b, int64_t imm) {
+    aurc_ir_code *out = &ls->out;
+    if (reserve_code(out, out->count + 1) != 0) {
+        ls->failed = 1;
+        return 0;
+    }
+    uint32_t dst = aurc_ir_op_has_dst(op) ? ls->fn->value_count++ : AURC_IR_NONE;
+    size_t i = out->count++;
+    out->op[i] = (uint8_t)op;
+    out->dst[i] = dst;
+    out->a[i] = a;
+    out->b[i] = b;
+    out->imm[i] = imm;
+    return dst;
+}
+
+static uint32_t emit_const(loop_state *ls, uint64_t k) {
+    return emit(ls, AURC_IR_CONST, AURC_IR_NONE, AURC_IR_NONE, (int64_t)k);
+}
+
+static uint32_t emit_binary(loop_state *ls, aurc_ir_op op, uint32_t a, uint64_t k) {
+    return emit(ls, op, a, emit_const(ls, k), 0);
+}
+
+static uint32_t entry_value(loop_state *ls, uint32_t local) {
+    if (ls->entry[local] == AURC_IR_NONE) {
+        ls->entry[local] = emit(ls, AURC_IR_LOAD_LOCAL, local, AURC_IR_NONE, 0);
+    }
+    return ls->entry[local];
+}
+
+/* f on the first iteration, with the induction variable at iv_value and the term for skip left out */
+static uint32_t emit_form(loop_state *ls, const lin_form *f, uint32_t iv, uint32_t iv_value, uint32_t skip) {
+    uint32_t sum = emit_const(ls, f->c);
+    for (unsigned t = 0; t < f->count; ++t) {
+        if (f->var[t] == skip) {
+            continue;
+        }
+        uint32_t x = f->var[t] == iv ? iv_value : entry_value(ls, f->var[t]);
+        sum = emit(ls, AURC_IR_ADD, sum, emit_binary(ls, AURC_IR_MUL, x, f->k[t]), 0);
+    }
+    return sum;
+}
+
+/* a >> shift with zeros shifted in: SHR is arithmetic, so mask off the copies of the sign */
+static uint32_t emit_shr_logical(loop_state *ls, uint32_t a, unsigned shift) {
+    return emit_binary(ls, AURC_IR_AND, emit_binary(ls, AURC_IR_SHR, a, shift), UINT64_MAX >> shift);
+}
+
+/*
+ * a / k with a read as unsigned; AURC_IR_NONE when k is neither a power of
+ * two nor below 2^62. Otherwise a/2 fits a signed division, and the
+ * remainder left after doubling its quotient is below 2k, so one signed
+ * comparison corrects it.
+ */
+static uint32_t emit_udiv(loop_state *ls, uint32_t a, uint64_t k) {
+    if ((k & (k - 1)) == 0) {
+        unsigned shift = 0;
+        while (((uint64_t)1 << shift) != k) {
+            ++shift;
+        }
+        return emit_shr_logical(ls, a, shift);
+    }
+    if (k >= (uint64_t)1 << 62) {
+        return AURC_IR_NONE;
+    }
+    uint32_t half = emit_binary(ls, AURC_IR_DIV, emit_shr_logical(ls, a, 1), k);
+    uint32_t twice = emit_binary(ls, AURC_IR_SHL, half, 1);
+    uint32_t rest = emit(ls, AURC_IR_SUB, a, emit_binary(ls, AURC_IR_MUL, twice, k), 0);
+    return emit(ls, AURC_IR_ADD, twice, emit_binary(ls, AURC_IR_GE, rest, k), 0);
+}
+
+/*
+ * Iterations of a loop that exits on `cmp i, bound` and steps i by step,
+ * given that the first test has already failed; AURC_IR_NONE when the test
+ * and step do not describe a counted loop.
+ *
+ * Once the test has admitted an iteration, the distance it measures is
+ * exact read as unsigned: below 2^64, but not necessarily below 2^63 when i
+ * and the bound have opposite signs, so it is only ever divided unsigned.
+ */
+static uint32_t emit_trip_count(loop_state *ls, aurc_ir_op exit_op, int64_t step, uint32_t iv, uint32_t bound) {
+    uint64_t magnitude = step > 0 ? (uint64_t)step : 0 - (uint64_t)step;
+    int strict;
+    uint32_t distance;
+    switch (exit_op) {
+        case AURC_IR_BR_GE:         /* while i < bound */
+        case AURC_IR_BR_GT:         /* while i <= bound */
+            if (step < 0) {
+                return AURC_IR_NONE;
+            }
+            strict = exit_op == AURC_IR_BR_GE;
+            distance = emit(ls, AURC_IR_SUB, bound, iv, 0);
+            break;
+        case AURC_IR_BR_LE:         /* while i > bound */
+        case AURC_IR_BR_LT:         /* while i >= bound */
+            if (step > 0) {
+                return AURC_IR_NONE;
+            }
+            strict = exit_op == AURC_IR_BR_LE;
+            distance = emit(ls, AURC_IR_SUB, iv, bound, 0);
+            break;
+        case AURC_IR_BR_EQ:         /* while i != bound */
+            if (magnitude != 1) {
+                return AURC_IR_NONE;
+            }
+            return step > 0 ? emit(ls, AURC_IR_SUB, bound, iv, 0) : emit(ls, AURC_IR_SUB, iv, bound, 0);
+        default:
+            return AURC_IR_NONE;
+    }
+    if (magnitude == 1) {
+        return strict ? distance : emit_binary(ls, AURC_IR_ADD, distance, 1);
+    }
+    /* the strict test leaves a distance of at least 1: ceil(d / s) = (d - 1) / s + 1, which cannot overflow */
+    if (strict) {
+        distance = emit_binary(ls, AURC_IR_SUB, distance, 1);
+    }
+    uint32_t trips = emit_udiv(ls, distance, magnitude);
+    return trips == AURC_IR_NONE ? AURC_IR_NONE : emit_binary(ls, AURC_IR_ADD, trips, 1);
+}
+
+/* n(n-1)/2 modulo 2^64: halve whichever of n and n-1 is even before multiplying */
+static uint32_t emit_triangle(loop_state *ls, uint32_t n) {
+    uint32_t n_minus_1 = emit_binary(ls, AURC_IR_SUB, n, 1);
+    uint32_t even_part = emit(ls, AURC_IR_MUL, emit_shr_logical(ls, n, 1), n_minus_1, 0);
+    uint32_t odd_part = emit(ls, AURC_IR_MUL, emit_binary(ls, AURC_IR_AND, n, 1), emit_shr_logical(ls, n_minus_1, 1), 0);
+    return emit(ls, AURC_IR_ADD, even_part, odd_part, 0);
+}
+
+/* Replaces code[from, to) by the closed form in ls->out. */
+static int splice(loop_state *ls, size_t from, size_t to) {
+    aurc_ir_code *code = &ls->fn->code;
+    const aurc_ir_code *out = &ls->out;
+    size_t tail = code->count - to;
+    size_t count = from + out->count + tail;
+    if (reserve_code(code, count) != 0) {
+        return 1;
+    }
+    size_t at = from + out->count;
+    memmove(code->op + at, code->op + to, tail * sizeof *code->op);
+    memmove(code->dst + at, code->dst + to, tail * sizeof *code->dst);
+    memmove(code->a + at, code->a + to, tail * sizeof *code->a);
+    memmove(code->b + at, code->b + to, tail * sizeof *code->b);
+    memmove(code->imm + at, code->imm + to, tail * sizeof *code->imm);
+    memcpy(code->op + from, out->op, out->count * sizeof *code->op);
+    memcpy(code->dst + from, out->dst, out->count * sizeof *code->dst);
+    memcpy(code->a + from, out->a, out->count * sizeof *code->a);
+    memcpy(code->b + from, out->b, out->count * sizeof *code->b);
+    memcpy(code->imm + from, out->imm, out->count * sizeof *code->imm);
+    code->count = count;
+    return 0;
+}
+
+/*
+ * Tries to close the loop whose back jump is code[back]; sets *closed when it
+ * did. Returns 1 only when out of memory.
+ */
+static int close_loop(loop_state *ls, size_t back, int *closed) {
+    aurc_ir_function *fn = ls->fn;
+    aurc_ir_code *code = &fn->code;
+    uint32_t head_label = (uint32_t)code->imm[back];
+    size_t head = ls->label_at[head_label];
+    if (head == AURC_IR_NONE || head >= back || ls->label_refs[head_label] != 1) {
+        return 0;
+    }
+    size_t test = head + 1;
+    while (test < back && !aurc_ir_op_is_branch((aurc_ir_op)code->op[test])) {
+        ++test;
+    }
+    if (test == back) {
+        return 0;
+    }
+    int exits_below = 0;
+    for (size_t i = back + 1; i < code->count && code->op[i] == AURC_IR_LABEL; ++i) {
+        exits_below |= code->imm[i] == code->imm[test];
+    }
+    if (!exits_below) {
+        return 0;
+    }
+
+    memset(ls->stored, 0, fn->local_count);
+    if (!read_straight_line(ls, head + 1, test, 0) || !read_straight_line(ls, test + 1, back, 1)) {
+        return 0;
+    }
+    aurc_ir_op exit_op = (aurc_ir_op)code->op[test];
+    uint32_t iv_value = code->a[test];
+    uint32_t bound = code->b[test];
+    const lin_form *fi = &ls->value_form[iv_value];
+    if (fi->count != 1 || fi->k[0] != 1 || fi->c != 0 || !ls->stored[fi->var[0]]) {
+        exit_op = mirrored(exit_op);
+        iv_value = code->b[test];
+        bound = code->a[test];
+        fi = &ls->value_form[iv_value];
+    }
+    if (fi->count != 1 || fi->k[0] != 1 || fi->c != 0 || form_depends_on_stored(ls, &ls->value_form[bound])) {
+        return 0;
+    }
+    uint32_t iv = fi->var[0];
+    const lin_form *next = &ls->local_form[iv];
+    if (!ls->stored[iv] || next->count != 1 || next->var[0] != iv || next->k[0] != 1 || next->c == 0 ||
+        next->c == (uint64_t)INT64_MIN) {
+        return 0;
+    }
+    int64_t step = (int64_t)next->c;
+    for (uint32_t l = 0; l < fn->local_count; ++l) {
+        if (!ls->stored[l] || l == iv) {
+            continue;
+        }
+        const lin_form *f = &ls->local_form[l];
+        uint64_t self = form_coef(f, l);
+        if (self > 1) {
+            return 0;
+        }
+        for (unsigned t = 0; t < f->count; ++t) {
+            if (f->var[t] != l && f->var[t] != iv && ls->stored[f->var[t]]) {
+                return 0;
+            }
+        }
+    }
+
+    ls->out.count = 0;
+    ls->failed = 0;
+    uint32_t first_value = fn->value_count;
+    for (uint32_t l = 0; l < fn->local_count; ++l) {
+        ls->entry[l] = AURC_IR_NONE;
+    }
+    ls->entry[iv] = iv_value;
+    uint32_t trips = emit_trip_count(ls, exit_op, step, iv_value, bound);
+    if (trips == AURC_IR_NONE) {
+        fn->value_count = first_value;
+        return 0;
+    }
+    uint32_t last = emit_binary(ls, AURC_IR_SUB, trips, 1);
+    uint32_t triangle = AURC_IR_NONE;
+    for (uint32_t l = 0; l < fn->local_count; ++l) {
+        if (!ls->stored[l]) {
+            continue;
+        }
+        const lin_form *f = &ls->local_form[l];
+        uint64_t per_step = form_coef(f, iv) * (uint64_t)step;
+        if (l == iv) {
+            ls->final[l] = emit(ls, AURC_IR_ADD, iv_value, emit_binary(ls, AURC_IR_MUL, trips, (uint64_t)step), 0);
+        } else if (form_coef(f, l) == 1) {
+            /* sum over k < n of (g0 + per_step * k) = n * g0 + per_step * n(n-1)/2 */
+            uint32_t total = emit(ls, AURC_IR_MUL, trips, emit_form(ls, f, iv, iv_value, l), 0);
+            if (per_step != 0) {
+                if (triangle == AURC_IR_NONE) {
+                    triangle = emit_triangle(ls, trips);
+                }
+                total = emit(ls, AURC_IR_ADD, total, emit_binary(ls, AURC_IR_MUL, triangle, per_step), 0);
+            }
+            ls->final[l] = emit(ls, AURC_IR_ADD, entry_value(ls, l), total, 0);
+        } else {
+            uint32_t value = emit_form(ls, f, iv, iv_value, AURC_IR_NONE);
+            ls->final[l] = emit(ls, AURC_IR_ADD, value, emit_binary(ls, AURC_IR_MUL, last, per_step), 0);
+        }
+    }
+    for (uint32_t l = 0; l < fn->local_count; ++l) {
+        if (ls->stored[l]) {
+            emit(ls, AURC_IR_STORE_LOCAL, l, ls->final[l], 0);
+        }
+    }
+    if (ls->failed || splice(ls, test + 1, back + 1) != 0) {
+        return 1;
+    }
+    *closed = 1;
+    return 0;
+}
+
+static void free_loop_state(loop_state *ls) {
+    free(ls->value_form);
+    free(ls->local_form);
+    free(ls->stored);
+    free(ls->entry);
+    free(ls->final);
+    free(ls->label_at);
+    free(ls->label_refs);
+    free(ls->out.op);
+    free(ls->out.dst);
+    free(ls->out.a);
+    free(ls->out.b);
+    free(ls->out.imm);
+}
+
+/* Closes every loop of fn it can read; sets *closed when there was one. Returns 1 only when out of memory. */
+static int close_loops(aurc_ir_function *fn, int *closed) {
+    *closed = 0;
+    if (fn->local_count == 0 || fn->label_count == 0) {
+        return 0;
+    }
+    loop_state ls;
+    memset(&ls, 0, sizeof ls);
+    ls.fn = fn;
+    size_t values = fn->value_count ? fn->value_count : 1;
+    ls.value_form = malloc(values * sizeof *ls.value_form);
+    ls.local_form = malloc(fn->local_count * sizeof *ls.local_form);
+    ls.stored = malloc(fn->local_count);
+    ls.entry = malloc(fn->local_count * sizeof *ls.entry);
+    ls.final = malloc(fn->local_count * sizeof *ls.final);
+    ls.label_at = malloc(fn->label_count * sizeof *ls.label_at);
+    ls.label_refs = calloc(fn->label_count, sizeof *ls.label_refs);
+    if (!ls.value_form || !ls.local_form || !ls.stored || !ls.entry || !ls.final || !ls.label_at || !ls.label_refs) {
+        free_loop_state(&ls);
+        return 1;
+    }
+    const aurc_ir_code *code = &fn->code;
+    for (uint32_t l = 0; l < fn->label_count; ++l) {
+        ls.label_at[l] = AURC_IR_NONE;
+    }
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        if (op == AURC_IR_LABEL) {
+            ls.label_at[code->imm[i]] = (uint32_t)i;
+        } else if (op == AURC_IR_JUMP || aurc_ir_op_is_branch(op)) {
+            ls.label_refs[code->imm[i]]++;
+        }
+    }
+    /* back to front, so closing a loop only moves code that has been looked at already */
+    for (size_t i = code->count; i-- > 0;) {
+        if (code->op[i] == AURC_IR_JUMP && close_loop(&ls, i, closed) != 0) {
+            free_loop_state(&ls);
+            return 1;
+        }
+    }
+    free_loop_state(&ls);
+    return 0;
+}
+
+static void renumber(opt_state *st) {
+    aurc_ir_function *fn = st->fn;
+    aurc_ir_code *code = &fn->code;
+    /* local_value doubles as the old -> new local map; locals only ever move down */
+    for (uint32_t l = 0; l < fn->local_count; ++l) {
+        st->local_value[l] = l < fn->param_count ? l : AURC_IR_NONE;
+    }
+    for (size_t i = 0; i < code->count; ++i) {
+        if ((code->op[i] == AURC_IR_LOAD_LOCAL || code->op[i] == AURC_IR_STORE_LOCAL) && code->a[i] >= fn->param_count) {
+            st->local_value[code->a[i]] = 0;
+        }
+    }
+    uint32_t locals = fn->param_count;
+    for (uint32_t l = fn->param_count; l < fn->local_count; ++l) {
+        if (st->local_value[l] != AURC_IR_NONE) {
+            fn->local_names[locals] = fn->local_names[l];
+            st->local_value[l] = locals++;
+        }
+    }
+    for (size_t i = 0; i < code->count; ++i) {
+        if (code->op[i] == AURC_IR_LOAD_LOCAL || code->op[i] == AURC_IR_STORE_LOCAL) {
+            code->a[i] = st->local_value[code->a[i]];
+        }
+    }
+    fn->local_count = locals;
+
+    for (uint32_t v = 0; v < fn->value_count; ++v) {
+        st->alias[v] = v;
+    }
+    uint32_t next = 0;
+    for (size_t i = 0; i < code->count; ++i) {
+        aurc_ir_op op = (aurc_ir_op)code->op[i];
+        unsigned uses = aurc_ir_op_uses(op);
+        if ((uses & AURC_IR_USES_A) && code->a[i] != AURC_IR_NONE) {
+            code->a[i] = st->alias[code->a[i]];
+        }
+        if (uses & AURC_IR_USES_B) {
+            code->b[i] = st->alias[code->b[i]];
+        }
+        if (aurc_ir_op_has_dst(op)) {
+            st->alias[code->dst[i]] = next;
+            code->dst[i] = next++;
+        }
+    }
+    fn->value_count = next;
+}
+
+static void free_state(opt_state *st) {
+    free(st->dead);
+    free(st->label_at);
+    free(st->label_refs);
+    free(st->alias);
+    free(st->known);
+    free(st->konst);
+    free(st->def_at);
+    free(st->uses);
+    free(st->local_value);
+    free(st->local_block);
+    free(st->local_store);
+    free(st->store_epoch);
+    free(st->local_loads);
+}
+
+static int alloc_state(opt_state *st, aurc_ir_function *fn) {
+    memset(st, 0, sizeof *st);
+    st->fn = fn;
+    size_t count = fn->code.count ? fn->code.count : 1;
+    size_t values = fn->value_count ? fn->value_count : 1;
+    size_t labels = fn->label_count ? fn->label_count : 1;
+    size_t locals = fn->local_count ? fn->local_count : 1;
+    st->dead = calloc(count, 1);
+    st->label_at = malloc(labels * sizeof *st->label_at);
+    st->label_refs = malloc(labels * sizeof *st->label_refs);
+    st->alias = malloc(values * sizeof *st->alias);
+    st->known = malloc(values);
+    st->konst = malloc(values * sizeof *st->konst);
+    st->def_at = malloc(values * sizeof *st->def_at);
+    st->uses = malloc(values * sizeof *st->uses);
+    st->local_value = malloc(locals * sizeof *st->local_value);
+    st->local_block = malloc(locals * sizeof *st->local_block);
+    st->local_store = malloc(locals * sizeof *st->local_store);
+    st->store_epoch = malloc(locals * sizeof *st->store_epoch);
+    st->local_loads = malloc(locals * sizeof *st->local_loads);
+    if (!st->dead || !st->label_at || !st->label_refs || !st->alias || !st->known || !st->konst || !st->def_at ||
+        !st->uses || !st->local_value || !st->local_block || !st->local_store || !st->store_epoch ||
+        !st->local_loads) {
+        free_state(st);
+        return 1;
+    }
+    return 0;
+}
+
+static int optimize_function(aurc_ir_function *fn) {
+    opt_state st;
+    for (int pass = 0;; ++pass) {
+        /* closing a loop adds code and values, so the state is sized afresh for every pass */
+        if (alloc_state(&st, fn) != 0) {
+            aurc_diag_printf("aurc-native: out of memory optimizing IR\n");
+            return 1;
+        }
+        for (int round = 0; round < OPT_MAX_ROUNDS; ++round) {
+            st.changed = 0;
+            drop_unreachable(&st);
+            thread_jumps(&st);
+            fold_blocks(&st);
+            drop_dead_values(&st);
+            if (!st.changed) {
+                break;
+            }
+        }
+        int closed = 0;
+        if (pass < LOOP_MAX_PASSES && close_loops(fn, &closed) != 0) {
+            aurc_diag_printf("aurc-native: out of memory optimizing IR\n");
+            free_state(&st);
+            return 1;
+        }
+        if (!closed) {
+            break;
+        }
+        free_state(&st);
+    }
+    renumber(&st);
+    free_state(&st);
+    return 0;
+}
+
+int aurc_ir_optimize(aurc_ir_program *ir) {
+    for (uint32_t i = 0; i < ir->function_count; ++i) {
+        if (optimize_function(&ir->functions[i]) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,318 @@
+#include "aurc_emit.h"
+#include "aurc_diag.h"
+#include "aurc_image.h"
+#include "aurc_isa.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---- text sink ---------------------------------------------------------- */
+
+static void text_word(aurc_isa_sink *sink, uint64_t word, const char *target, const char *comment) {
+    (void)target; /* the assembler reads the target back out of the comment */
+    FILE *out = ((aurc_isa_text_sink *)sink)->out;
+    ++sink->word_count;
+    fprintf(out, "bytes 0x%016llX  ; %s\n", (unsigned long long)word, comment);
+}
+
+static void text_label(aurc_isa_sink *sink, const char *name) {
+    fprintf(((aurc_isa_text_sink *)sink)->out, "label %s\n", name);
+}
+
+static void text_quoted(aurc_isa_sink *sink, const char *directive, aurc_view text) {
+    FILE *out = ((aurc_isa_text_sink *)sink)->out;
+    fprintf(out, "%s \"", directive);
+    for (size_t i = 0; i < text.len; ++i) {
+        char c = text.data[i];
+        switch (c) {
+            case '"': fputs("\\\"", out); break;
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\r': fputs("\\r", out); break;
+            case '\t': fputs("\\t", out); break;
+            case '\0': fputs("\\0", out); break;
+            default: fputc(c, out); break;
+        }
+    }
+    fputs("\"\n", out);
+}
+
+static void text_string(aurc_isa_sink *sink, aurc_view text) {
+    text_quoted(sink, "string", text);
+}
+
+static void text_bytes(aurc_isa_sink *sink, aurc_view text) {
+    text_quoted(sink, "ascii", text);
+}
+
+static void text_directive(aurc_isa_sink *sink, const char *line) {
+    FILE *out = ((aurc_isa_text_sink *)sink)->out;
+    fputs(line, out);
+    fputc('\n', out);
+}
+
+static void text_shared(aurc_isa_sink *sink, uint32_t id, const char *name, int64_t init, int sharded) {
+    fprintf(((aurc_isa_text_sink *)sink)->out, "shared %u %s %" PRId64 "%s\n", (unsigned)id, name, init,
+            sharded ? " sharded" : "");
+}
+
+void aurc_isa_text_sink_init(aurc_isa_text_sink *sink, FILE *out) {
+    memset(sink, 0, sizeof *sink);
+    sink->base.word = text_word;
+    sink->base.label = text_label;
+    sink->base.string = text_string;
+    sink->base.bytes = text_bytes;
+    sink->base.directive = text_directive;
+    sink->base.shared = text_shared;
+    sink->base.wants_comments = 1;
+    sink->out = out;
+}
+
+/* ---- image sink --------------------------------------------------------- */
+
+static void image_oom(aurc_isa_image_sink *sink) {
+    if (!sink->base.failed) {
+        aurc_diag_printf("aurc-native: out of memory building ISA image\n");
+    }
+    sink->base.failed = 1;
+}
+
+/* Interns name and makes sure it has an address slot. */
+static uint32_t image_label_id(aurc_isa_image_sink *sink, const char *name) {
+    aurc_view view = {name, strlen(name)};
+    uint32_t id = aurc_intern(&sink->labels, view);
+    if (id == AURC_IR_NONE) {
+        image_oom(sink);
+        return AURC_IR_NONE;
+    }
+    if (id >= sink->address_cap) {
+        uint32_t cap = sink->address_cap ? sink->address_cap * 2 : 64;
+        uint32_t *addresses = realloc(sink->addresses, cap * sizeof *addresses);
+        if (!addresses) {
+            image_oom(sink);
+            return AURC_IR_NONE;
+        }
+        for (uint32_t i = sink->address_cap; i < cap; ++i) {
+            addresses[i] = AURC_ISA_UNBOUND;
+        }
+        sink->addresses = addresses;
+        sink->address_cap = cap;
+    }
+    return id;
+}
+
+static void image_word(aurc_isa_sink *base, uint64_t word, const char *target, const char *comment) {
+    (void)comment;
+    aurc_isa_image_sink *sink = (aurc_isa_image_sink *)base;
+    size_t offset = sink->image.len;
+    ++base->word_count;
+    if (aurc_bytes_reserve(&sink->image, ISA_WORD_SIZE) != 0) {
+        image_oom(sink);
+        return;
+    }
+    uint8_t *dst = sink->image.data + offset;
+    for (int i = 0; i < ISA_WORD_SIZE; ++i) {
+        dst[i] = (uint8_t)(word >> (8 * (ISA_WORD_SIZE - 1 - i)));
+    }
+    sink->image.len += ISA_WORD_SIZE;
+    sink->code_end = sink->image.len;
+    if (!target) {
+        return;
+    }
+
+    uint32_t label = image_label_id(sink, target);
+    if (label == AURC_IR_NONE) {
+        return;
+    }
+    if (sink->fixup_count == sink->fixup_cap) {
+        size_t cap = sink->fixup_cap ? sink->fixup_cap * 2 : 64;
+        aurc_isa_label_fixup *fixups = realloc(sink->fixups, cap * sizeof *fixups);
+        if (!fixups) {
+            image_oom(sink);
+            return;
+        }
+        sink->fixups = fixups;
+        sink->fixup_cap = cap;
+    }
+    sink->fixups[sink->fixup_count].offset = (uint32_t)offset;
+    sink->fixups[sink->fixup_count].label = label;
+    sink->fixup_count++;
+}
+
+static void image_label(aurc_isa_sink *base, const char *name) {
+    aurc_isa_image_sink *sink = (aurc_isa_image_sink *)base;
+    uint32_t label = image_label_id(sink, name);
+    if (label == AURC_IR_NONE) {
+        return;
+    }
+    if (sink->addresses[label] != AURC_ISA_UNBOUND) {
+        aurc_diag_printf("aurc-native: duplicate label '%s'\n", name);
+        base->failed = 1;
+        return;
+    }
+    sink->addresses[label] = (uint32_t)sink->image.len;
+}
+
+static void image_string(aurc_isa_sink *base, aurc_view text) {
+    aurc_isa_image_sink *sink = (aurc_isa_image_sink *)base;
+    if (aurc_bytes_append(&sink->image, text.data, text.len) != 0 || aurc_bytes_append_u8(&sink->image, 0) != 0) {
+        image_oom(sink);
+    }
+}
+
+static void image_bytes(aurc_isa_sink *base, aurc_view text) {
+    aurc_isa_image_sink *sink = (aurc_isa_image_sink *)base;
+    if (aurc_bytes_append(&sink->image, text.data, text.len) != 0) {
+        image_oom(sink);
+    }
+}
+
+static void image_directive(aurc_isa_sink *base, const char *line) {
+    /* the image always starts at org 0 and has no header */
+    (void)base;
+    (void)line;
+}
+
+/* The generator already sets ISA_ATOMIC_SHARDED on the words of sharded slots. */
+static void image_shared(aurc_isa_sink *base, uint32_t id, const char *name, int64_t init, int sharded) {
+    aurc_isa_image_sink *sink = (aurc_isa_image_sink *)base;
+    (void)sharded;
+    if (id != sink->shared_count) {
+        aurc_diag_printf("aurc-native: shared slot %u declared out of order\n", (unsigned)id);
+        base->failed = 1;
+        return;
+    }
+    uint32_t label = image_label_id(sink, name);
+    if (label == AURC_IR_NONE) {
+        return;
+    }
+    if (sink->shared_count == sink->shared_cap) {
+        uint32_t cap = sink->shared_cap ? sink->shared_cap * 2 : 8;
+        uint32_t *labels = realloc(sink->shared_labels, cap * sizeof *labels);
+        if (!labels) {
+            image_oom(sink);
+            return;
+        }
+        sink->shared_labels = labels;
+        int64_t *inits = realloc(sink->shared_inits, cap * sizeof *inits);
+        if (!inits) {
+            image_oom(sink);
+            return;
+        }
+        sink->shared_inits = inits;
+        sink->shared_cap = cap;
+    }
+    sink->shared_labels[sink->shared_count] = label;
+    sink->shared_inits[sink->shared_count] = init;
+    sink->shared_count++;
+}
+
+/* Same layout as the assembler: one line-aligned ISA_SHARED_STRIDE slot each, after the rest of the image. */
+static int layout_shared(aurc_isa_image_sink *sink) {
+    sink->data_end = sink->image.len;
+    sink->shared_base = sink->image.len;
+    if (sink->shared_count == 0) {
+        return 0;
+    }
+    size_t pad = (ISA_SHARED_STRIDE - sink->image.len % ISA_SHARED_STRIDE) % ISA_SHARED_STRIDE;
+    if (aurc_bytes_append_zeros(&sink->image, pad) != 0) {
+        image_oom(sink);
+        return 1;
+    }
+    sink->shared_base = sink->image.len;
+    for (uint32_t i = 0; i < sink->shared_count; ++i) {
+        uint32_t label = sink->shared_labels[i];
+        if (sink->addresses[label] != AURC_ISA_UNBOUND) {
+            aurc_diag_printf("aurc-native: duplicate label '%s'\n", aurc_interner_cstr(&sink->labels, label));
+            return 1;
+        }
+        sink->addresses[label] = (uint32_t)sink->image.len;
+        uint64_t bits = (uint64_t)sink->shared_inits[i];
+        uint8_t slot[ISA_SHARED_STRIDE] = {0};
+        for (int b = 0; b < 8; ++b) {
+            slot[b] = (uint8_t)(bits >> (8 * b));
+        }
+        if (aurc_bytes_append(&sink->image, slot, sizeof slot) != 0) {
+            image_oom(sink);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void aurc_isa_image_sink_init(aurc_isa_image_sink *sink) {
+    memset(sink, 0, sizeof *sink);
+    sink->base.word = image_word;
+    sink->base.label = image_label;
+    sink->base.string = image_string;
+    sink->base.bytes = image_bytes;
+    sink->base.directive = image_directive;
+    sink->base.shared = image_shared;
+    aurc_bytes_init(&sink->image);
+    aurc_interner_init(&sink->labels);
+}
+
+void aurc_isa_image_sink_free(aurc_isa_image_sink *sink) {
+    aurc_bytes_free(&sink->image);
+    aurc_interner_free(&sink->labels);
+    free(sink->addresses);
+    free(sink->fixups);
+    free(sink->shared_labels);
+    free(sink->shared_inits);
+    memset(sink, 0, sizeof *sink);
+}
+
+int aurc_isa_image_sink_finish(aurc_isa_image_sink *sink) {
+    if (sink->base.failed || layout_shared(sink) != 0) {
+        return 1;
+    }
+    int rc = 0;
+    for (size_t i = 0; i < sink->fixup_count; ++i) {
+        const aurc_isa_label_fixup *fixup = &sink->fixups[i];
+        uint32_t address = sink->addresses[fixup->label];
+        if (address == AURC_ISA_UNBOUND) {
+            aurc_diag_printf("aurc-native: undefined label '%s'\n", aurc_interner_cstr(&sink->labels, fixup->label));
+            rc = 1;
+            continue;
+        }
+        uint8_t *dst = sink->image.data + fixup->offset;
+        for (int b = 0; b < 4; ++b) {
+            dst[4 + b] = (uint8_t)(address >> (8 * (3 - b)));
+        }
+    }
+    return rc;
+}
+
+int aurc_isa_image_sink_encode(aurc_isa_image_sink *sink, aurc_bytes *out) {
+    uint32_t bound = 0;
+    for (uint32_t id = 0; id < sink->labels.count; ++id) {
+        bound += sink->addresses[id] != AURC_ISA_UNBOUND;
+    }
+    aurc_image_symbol *symbols = calloc(bound ? bound : 1, sizeof *symbols);
+    aurc_image_reloc *relocs = calloc(sink->fixup_count ? sink->fixup_count : 1, sizeof *relocs);
+    if (!symbols || !relocs) {
+        free(symbols);
+        free(relocs);
+        image_oom(sink);
+        return 1;
+    }
+    size_t count = 0;
+    for (uint32_t id = 0; id < sink->labels.count; ++id) {
+        if (sink->addresses[id] != AURC_ISA_UNBOUND) {
+            aurc_view name = aurc_interner_get(&sink->labels, id);
+            symbols[count++] = (aurc_image_symbol){name.data, name.len, sink->addresses[id]};
+        }
+    }
+    for (size_t i = 0; i < sink->fixup_count; ++i) {
+        relocs[i] = (aurc_image_reloc){sink->fixups[i].offset, AURC_RELOC_IMM32};
+    }
+    aurc_image_layout layout = {sink->image.data, sink->image.len, sink->code_end, sink->data_end,
+                                sink->shared_base, sink->image.len - sink->shared_base,
+                                symbols, count, relocs, sink->fixup_count};
+    int rc = aurc_image_encode(&layout, out);
+    free(symbols);
+    free(relocs);
+    return rc;
+}
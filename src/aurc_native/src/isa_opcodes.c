@@ -0,0 +1,41 @@
+#include "aurc_isa.h"
+
+/*
+ * The opcode descriptor table, expanded from aurc_opcodes.def, and the checks
+ * that keep its rows consistent, all resolved when this file compiles.
+ */
+
+#define KIND(kind) ISA_OPERAND_KIND_##kind
+#define HAS_OPERAND(kind, op0, op1, op2) (KIND(op0) == KIND(kind) || KIND(op1) == KIND(kind) || KIND(op2) == KIND(kind))
+
+/* every opcode fits its byte, branches name their target and atomics their slot */
+#define AURC_ISA_OPCODE(name, value, mnemonic, op0, op1, op2, effects)                                          \
+    _Static_assert((value) >= 0 && (value) <= 0xFF, "opcode " #name " does not fit a byte");                  \
+    _Static_assert(sizeof(mnemonic) > 1, "opcode " #name " has no mnemonic");                                 \
+    _Static_assert(!((effects) & ISA_EFFECT_BRANCH) || HAS_OPERAND(LABEL, op0, op1, op2),                    \
+                   "branch " #name " has no label operand");                                                  \
+    _Static_assert(!((effects) & ISA_EFFECT_ATOMIC) || HAS_OPERAND(SLOT, op0, op1, op2),                     \
+                   "atomic " #name " has no slot operand");                                                   \
+    _Static_assert(!((effects) & ISA_EFFECT_READS_COMPARE) || HAS_OPERAND(COND, op0, op1, op2),              \
+                   #name " reads the compare flags without a condition");
+#include "aurc_opcodes.def"
+#undef AURC_ISA_OPCODE
+
+/* an opcode value listed twice is a duplicate case label */
+static inline int opcode_defined(uint8_t opcode) {
+    switch (opcode) {
+#define AURC_ISA_OPCODE(name, value, mnemonic, op0, op1, op2, effects) case value:
+#include "aurc_opcodes.def"
+#undef AURC_ISA_OPCODE
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+const isa_opcode_desc isa_opcode_table[256] = {
+#define AURC_ISA_OPCODE(name, value, mnemonic, op0, op1, op2, effects) \
+    [value] = {mnemonic, {KIND(op0), KIND(op1), KIND(op2)}, (uint8_t)(effects)},
+#include "aurc_opcodes.def"
+#undef AURC_ISA_OPCODE
+};
@@ -0,0 +1,518 @@
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE         /* MAP_ANONYMOUS */
+#endif
+
+#include "aurc_jit.h"
+#include "aurc_isa.h"
+#include "aurc_vm.h"
+#include "aurc_x86.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JIT_X86_64 1
+#endif
+
+typedef uint32_t (*jit_entry)(aurc_jit_frame *frame);
+
+struct aurc_jit_loop {
+    void *memory;
+    size_t size;
+    jit_entry entry;
+};
+
+int aurc_jit_supported(void) {
+#ifdef JIT_X86_64
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+uint32_t aurc_jit_run(const aurc_jit_loop *loop, aurc_jit_frame *frame) {
+    return loop->entry(frame);
+}
+
+/* ---- executable memory -------------------------------------------------- */
+
+/* Copies code into fresh pages and makes them read-only and executable. */
+static void *exec_copy(const uint8_t *code, size_t len, size_t *size) {
+#ifdef _WIN32
+    void *memory = VirtualAlloc(NULL, len, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    DWORD old;
+    if (!memory) {
+        return NULL;
+    }
+    memcpy(memory, code, len);
+    if (!VirtualProtect(memory, len, PAGE_EXECUTE_READ, &old)) {
+        VirtualFree(memory, 0, MEM_RELEASE);
+        return NULL;
+    }
+    FlushInstructionCache(GetCurrentProcess(), memory, len);
+    *size = len;
+    return memory;
+#else
+    long page = sysconf(_SC_PAGESIZE);
+    size_t rounded = page > 0 ? (len + (size_t)page - 1) / (size_t)page * (size_t)page : len;
+#ifdef MAP_ANONYMOUS
+    void *memory = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#else
+    void *memory = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+#endif
+    if (memory == MAP_FAILED) {
+        return NULL;
+    }
+    memcpy(memory, code, len);
+    if (mprotect(memory, rounded, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, rounded);
+        return NULL;
+    }
+    *size = rounded;
+    return memory;
+#endif
+}
+
+void aurc_jit_free(aurc_jit_loop *loop) {
+    if (!loop) {
+        return;
+    }
+#ifdef _WIN32
+    VirtualFree(loop->memory, 0, MEM_RELEASE);
+#else
+    munmap(loop->memory, loop->size);
+#endif
+    free(loop);
+}
+
+/* ---- loop compiler ------------------------------------------------------ */
+
+/*
+ * The loop keeps r0-r7 and sp in host registers from entry to exit: they are
+ * loaded from the frame's register file in the prologue and stored back in
+ * the one epilogue every exit goes through. r14 holds the frame and r13 the
+ * register file; rax, rcx and rdx are scratch. The code makes no calls, so
+ * the stack is never realigned.
+ */
+#define JIT_FRAME X86_R14
+#define JIT_REGS X86_R13
+#define FRAME_AT(field) ((int32_t)offsetof(aurc_jit_frame, field))
+
+static const x86_reg JIT_HOST[ISA_REG_SP + 1] = {
+    X86_RBX, X86_RBP, X86_RSI, X86_RDI, X86_R8, X86_R9, X86_R10, X86_R11, X86_R12,
+};
+
+/* registers the loop clobbers that the host calling convention wants back */
+#ifdef _WIN32
+static const x86_reg JIT_SAVED[] = {X86_RBX, X86_RBP, X86_RSI, X86_RDI, X86_R12, X86_R13, X86_R14};
+#else
+static const x86_reg JIT_SAVED[] = {X86_RBX, X86_RBP, X86_R12, X86_R13, X86_R14};
+#endif
+#define JIT_SAVED_COUNT (sizeof JIT_SAVED / sizeof JIT_SAVED[0])
+
+typedef struct jit_exit {
+    uint32_t address;
+    uint32_t label;
+} jit_exit;
+
+typedef struct jit_compiler {
+    aurc_x86_asm as;
+    const aurc_jit_image *image;
+    uint32_t head;              /* word indices, both inside the loop */
+    uint32_t tail;
+    uint32_t *labels;           /* one per word of the loop */
+    uint8_t *targeted;          /* words some branch of the loop jumps to */
+    jit_exit *exits;
+    size_t exit_count;
+    size_t exit_cap;
+    int failed;
+} jit_compiler;
+
+/* The stub that leaves the loop for address, shared by every exit to it. */
+static uint32_t exit_to(jit_compiler *c, uint32_t address) {
+    for (size_t i = 0; i < c->exit_count; ++i) {
+        if (c->exits[i].address == address) {
+            return c->exits[i].label;
+        }
+    }
+    if (c->exit_count == c->exit_cap) {
+        size_t cap = c->exit_cap ? c->exit_cap * 2 : 16;
+        jit_exit *exits = realloc(c->exits, cap * sizeof *exits);
+        if (!exits) {
+            c->failed = 1;
+            return 0;
+        }
+        c->exits = exits;
+        c->exit_cap = cap;
+    }
+    c->exits[c->exit_count] = (jit_exit){address, x86_new_label(&c->as)};
+    return c->exits[c->exit_count++].label;
+}
+
+static isa_instruction word_at(const jit_compiler *c, uint32_t index) {
+    return unpack_instruction_word(isa_read_word(c->image->code + (size_t)index * ISA_WORD_SIZE));
+}
+
+/* Word index of a branch target inside the loop, or UINT32_MAX. */
+static uint32_t loop_word(const jit_compiler *c, uint32_t address) {
+    if (address % ISA_WORD_SIZE != 0 || address / ISA_WORD_SIZE < c->head || address / ISA_WORD_SIZE > c->tail) {
+        return UINT32_MAX;
+    }
+    return address / ISA_WORD_SIZE;
+}
+
+static int condition_code(uint8_t cond, x86_cond *cc) {
+    switch (cond) {
+        case ISA_COND_EQ: *cc = X86_CC_E; return 0;
+        case ISA_COND_NE: *cc = X86_CC_NE; return 0;
+        case ISA_COND_LT: *cc = X86_CC_L; return 0;
+        case ISA_COND_LE: *cc = X86_CC_LE; return 0;
+        case ISA_COND_GT: *cc = X86_CC_G; return 0;
+        case ISA_COND_GE: *cc = X86_CC_GE; return 0;
+        default: return 1;
+    }
+}
+
+/*
+ * jmp (conditional when cc is given) from word `from` to address. Back edges
+ * inside the loop spend one unit of the slice budget and leave for the
+ * interpreter when it is gone; forward ones are plain jumps.
+ */
+static void emit_branch(jit_compiler *c, uint32_t from, const x86_cond *cc, uint32_t address) {
+    aurc_x86_asm *as = &c->as;
+    uint32_t to = loop_word(c, address);
+    if (to == UINT32_MAX || to > from) {
+        uint32_t label = to == UINT32_MAX ? exit_to(c, address) : c->labels[to - c->head];
+        if (cc) {
+            x86_jcc(as, *cc, label);
+        } else {
+            x86_jmp(as, label);
+        }
+        return;
+    }
+    uint32_t skip = 0;
+    if (cc) {
+        skip = x86_new_label(as);
+        x86_jcc(as, (x86_cond)(*cc ^ 1), skip);   /* inverse condition: the low bit of the Jcc code */
+    }
+    x86_mov_reg_mem(as, X86_RAX, JIT_FRAME, FRAME_AT(budget));
+    x86_alu_reg_imm(as, X86_ALU_SUB, X86_RAX, 1);
+    x86_mov_mem_reg(as, JIT_FRAME, FRAME_AT(budget), X86_RAX);
+    x86_jcc(as, X86_CC_E, exit_to(c, address));
+    x86_jmp(as, c->labels[to - c->head]);
+    if (cc) {
+        x86_bind_label(as, skip);
+    }
+}
+
+/* mov dst, src unless they are the same VM register */
+static void copy_reg(jit_compiler *c, uint8_t dst, uint8_t src) {
+    if (dst != src) {
+        x86_mov_reg_reg(&c->as, JIT_HOST[dst], JIT_HOST[src]);
+    }
+}
+
+/* rax = sp + offset and rcx its host address; outside the stack, leaves for the interpreter to fault. */
+static void emit_stack_slot(jit_compiler *c, uint32_t index, int32_t offset) {
+    aurc_x86_asm *as = &c->as;
+    uint32_t fault = exit_to(c, index * ISA_WORD_SIZE);
+    x86_mov_reg_reg(as, X86_RAX, JIT_HOST[ISA_REG_SP]);
+    if (offset != 0) {
+        x86_alu_reg_imm(as, X86_ALU_ADD, X86_RAX, offset);
+    }
+    x86_mov_reg_mem(as, X86_RCX, JIT_FRAME, FRAME_AT(stack_low));
+    x86_alu_reg_reg(as, X86_ALU_CMP, X86_RAX, X86_RCX);
+    x86_jcc(as, X86_CC_B, fault);
+    x86_alu_reg_imm(as, X86_ALU_CMP, X86_RAX, (int32_t)(AURC_VM_ARENA_SIZE - ISA_WORD_SIZE));
+    x86_jcc(as, X86_CC_A, fault);
+    x86_mov_reg_mem(as, X86_RCX, JIT_FRAME, FRAME_AT(stack_bias));
+    x86_alu_reg_reg(as, X86_ALU_ADD, X86_RCX, X86_RAX);
+}
+
+/*
+ * Compiles word index; *compare_live says the previous word was a cmp whose
+ * flags are still set. Returns 1 for a word compiled code does not run.
+ */
+static int compile_word(jit_compiler *c, uint32_t index, int *compare_live) {
+    aurc_x86_asm *as = &c->as;
+    isa_instruction insn = word_at(c, index);
+    int64_t imm = isa_signed_imm(insn.imm32);
+    int flags = *compare_live && !c->targeted[index - c->head];
+    *compare_live = 0;
+    /* calls, services, tasks and anything the table does not know stay with the interpreter */
+    if (!isa_mnemonic(insn.opcode) || (isa_opcode_table[insn.opcode].effects & ISA_EFFECT_RUNTIME) ||
+        !isa_registers_valid(insn)) {
+        return 1;
+    }
+    switch (insn.opcode) {
+        case ISA_OPCODE_NOP:
+            return 0;
+
+        case ISA_OPCODE_MOV:
+            if (insn.op1 == ISA_OPERAND_IMMEDIATE || insn.op1 == ISA_OPERAND_LABEL) {
+                x86_mov_reg_imm(as, JIT_HOST[insn.op0], insn.op1 == ISA_OPERAND_LABEL ? (int64_t)insn.imm32 : imm);
+            } else {
+                copy_reg(c, insn.op0, insn.op1);
+            }
+            return 0;
+
+        case ISA_OPCODE_NOT:
+            copy_reg(c, insn.op0, insn.op1);
+            x86_unary(as, X86_UNARY_NOT, JIT_HOST[insn.op0]);
+            return 0;
+
+        case ISA_OPCODE_ADD:
+        case ISA_OPCODE_SUB:
+        case ISA_OPCODE_AND:
+        case ISA_OPCODE_OR:
+        case ISA_OPCODE_XOR:
+        case ISA_OPCODE_MUL:
+        case ISA_OPCODE_SHL:
+        case ISA_OPCODE_SHR: {
+            int immediate = insn.op2 == ISA_OPERAND_IMMEDIATE;
+            x86_alu_op alu = insn.opcode == ISA_OPCODE_ADD   ? X86_ALU_ADD
+                             : insn.opcode == ISA_OPCODE_SUB ? X86_ALU_SUB
+                             : insn.opcode == ISA_OPCODE_AND ? X86_ALU_AND
+                             : insn.opcode == ISA_OPCODE_OR  ? X86_ALU_OR
+                                                             : X86_ALU_XOR;
+            x86_shift_op shift = insn.opcode == ISA_OPCODE_SHL ? X86_SHIFT_SHL : X86_SHIFT_SAR;
+            int is_shift = insn.opcode == ISA_OPCODE_SHL || insn.opcode == ISA_OPCODE_SHR;
+            x86_reg dst = JIT_HOST[insn.op0];
+            /* the second operand goes to rcx first, so dst may be either source */
+            if (!immediate) {
+                x86_mov_reg_reg(as, X86_RCX, JIT_HOST[insn.op2]);
+            } else if (insn.opcode == ISA_OPCODE_MUL) {
+                x86_mov_reg_imm(as, X86_RCX, imm);
+            }
+            copy_reg(c, insn.op0, insn.op1);
+            if (immediate && is_shift) {
+                x86_shift_imm(as, shift, dst, (uint8_t)(imm & 63));
+            } else if (is_shift) {
+                x86_shift_cl(as, shift, dst);    /* counts wrap at 64, as the interpreter has them */
+            } else if (insn.opcode == ISA_OPCODE_MUL) {
+                x86_imul_reg_reg(as, dst, X86_RCX);
+            } else if (immediate) {
+                x86_alu_reg_imm(as, alu, dst, (int32_t)imm);
+            } else {
+                x86_alu_reg_reg(as, alu, dst, X86_RCX);
+            }
+            return 0;
+        }
+
+        case ISA_OPCODE_DIV:
+        case ISA_OPCODE_REM: {
+            int immediate = insn.op2 == ISA_OPERAND_IMMEDIATE;
+            if (immediate && (imm == 0 || imm == -1)) {
+                break;
+            }
+            if (immediate) {
+                x86_mov_reg_imm(as, X86_RCX, imm);
+            } else {
+                /* zero faults and -1 may overflow: both are the interpreter's business */
+                uint32_t slow = exit_to(c, index * ISA_WORD_SIZE);
+                x86_mov_reg_reg(as, X86_RCX, JIT_HOST[insn.op2]);
+                x86_test_reg_reg(as, X86_RCX, X86_RCX);
+                x86_jcc(as, X86_CC_E, slow);
+                x86_alu_reg_imm(as, X86_ALU_CMP, X86_RCX, -1);
+                x86_jcc(as, X86_CC_E, slow);
+            }
+            x86_mov_reg_reg(as, X86_RAX, JIT_HOST[insn.op1]);
+            x86_cqo(as);
+            x86_unary(as, X86_UNARY_IDIV, X86_RCX);
+            x86_mov_reg_reg(as, JIT_HOST[insn.op0], insn.opcode == ISA_OPCODE_DIV ? X86_RAX : X86_RDX);
+            return 0;
+        }
+
+        case ISA_OPCODE_CMP: {
+            int immediate = insn.op1 == ISA_OPERAND_IMMEDIATE;
+            x86_reg lhs = JIT_HOST[insn.op0];
+            x86_mov_mem_reg(as, JIT_FRAME, FRAME_AT(compare_lhs), lhs);
+            if (immediate) {
+                x86_mov_mem_imm(as, JIT_FRAME, FRAME_AT(compare_rhs), (int32_t)imm);
+                x86_alu_reg_imm(as, X86_ALU_CMP, lhs, (int32_t)imm);
+            } else {
+                x86_mov_mem_reg(as, JIT_FRAME, FRAME_AT(compare_rhs), JIT_HOST[insn.op1]);
+                x86_alu_reg_reg(as, X86_ALU_CMP, lhs, JIT_HOST[insn.op1]);
+            }
+            *compare_live = 1;
+            return 0;
+        }
+
+        case ISA_OPCODE_JMP:
+            emit_branch(c, index, NULL, insn.imm32);
+            return 0;
+
+        case ISA_OPCODE_CJMP: {
+            x86_cond cc;
+            if (condition_code(insn.op0, &cc) != 0) {
+                break;
+            }
+            if (!flags) {
+                x86_mov_reg_mem(as, X86_RAX, JIT_FRAME, FRAME_AT(compare_lhs));
+                x86_mov_reg_mem(as, X86_RCX, JIT_FRAME, FRAME_AT(compare_rhs));
+                x86_alu_reg_reg(as, X86_ALU_CMP, X86_RAX, X86_RCX);
+            }
+            emit_branch(c, index, &cc, insn.imm32);
+            return 0;
+        }
+
+        case ISA_OPCODE_PUSH:
+            /* the slot below sp, with the interpreter's bounds */
+            emit_stack_slot(c, index, -ISA_WORD_SIZE);
+            x86_mov_mem_reg(as, X86_RCX, 0, JIT_HOST[insn.op0]);
+            x86_mov_reg_reg(as, JIT_HOST[ISA_REG_SP], X86_RAX);
+            return 0;
+
+        case ISA_OPCODE_POP:
+            emit_stack_slot(c, index, 0);
+            x86_alu_reg_imm(as, X86_ALU_ADD, JIT_HOST[ISA_REG_SP], ISA_WORD_SIZE);
+            x86_mov_reg_mem(as, JIT_HOST[insn.op0], X86_RCX, 0);
+            return 0;
+
+        case ISA_OPCODE_STORE_STACK:
+        case ISA_OPCODE_LOAD_STACK:
+            emit_stack_slot(c, index, (int32_t)imm);
+            if (insn.opcode == ISA_OPCODE_STORE_STACK) {
+                x86_mov_mem_reg(as, X86_RCX, 0, JIT_HOST[insn.op0]);
+            } else {
+                x86_mov_reg_mem(as, JIT_HOST[insn.op0], X86_RCX, 0);
+            }
+            return 0;
+
+        case ISA_OPCODE_ATOMIC_LOAD:
+        case ISA_OPCODE_ATOMIC_STORE:
+        case ISA_OPCODE_ATOMIC_ADD: {
+            /* sharded counters need the worker's row: left to the interpreter */
+            uint8_t reg = insn.opcode == ISA_OPCODE_ATOMIC_LOAD ? insn.op0 : insn.op1;
+            uint32_t addr = insn.imm32;
+            if ((insn.op2 & ISA_ATOMIC_SHARDED) || addr % ISA_WORD_SIZE != 0 ||
+                addr < c->image->shared_low || (uint64_t)addr + ISA_WORD_SIZE > c->image->image_size) {
+                break;
+            }
+            x86_mov_reg_mem(as, X86_RCX, JIT_FRAME, FRAME_AT(arena));
+            if (insn.opcode == ISA_OPCODE_ATOMIC_LOAD) {
+                x86_mov_reg_mem(as, JIT_HOST[reg], X86_RCX, (int32_t)addr);
+            } else if (insn.opcode == ISA_OPCODE_ATOMIC_ADD) {
+                x86_lock_add_mem_reg(as, X86_RCX, (int32_t)addr, JIT_HOST[reg]);
+            } else {
+                /* xchg is the sequentially consistent store */
+                x86_mov_reg_reg(as, X86_RAX, JIT_HOST[reg]);
+                x86_xchg_mem_reg(as, X86_RCX, (int32_t)addr, X86_RAX);
+            }
+            return 0;
+        }
+
+        default:
+            break;
+    }
+    return 1;
+}
+
+static void mark_targets(jit_compiler *c) {
+    for (uint32_t i = c->head; i <= c->tail; ++i) {
+        isa_instruction insn = word_at(c, i);
+        if (isa_opcode_table[insn.opcode].effects & ISA_EFFECT_BRANCH) {
+            uint32_t to = loop_word(c, insn.imm32);
+            if (to != UINT32_MAX) {
+                c->targeted[to - c->head] = 1;
+            }
+        }
+    }
+}
+
+aurc_jit_loop *aurc_jit_compile_loop(const aurc_jit_image *image, uint32_t head, uint32_t tail) {
+#ifndef JIT_X86_64
+    (void)image;
+    (void)head;
+    (void)tail;
+    return NULL;
+#else
+    if (head % ISA_WORD_SIZE != 0 || tail % ISA_WORD_SIZE != 0 || head > tail ||
+        (uint64_t)tail + ISA_WORD_SIZE > image->code_size) {
+        return NULL;
+    }
+    jit_compiler c;
+    memset(&c, 0, sizeof c);
+    aurc_x86_init(&c.as);
+    c.image = image;
+    c.head = head / ISA_WORD_SIZE;
+    c.tail = tail / ISA_WORD_SIZE;
+    size_t words = (size_t)c.tail - c.head + 1;
+    c.labels = malloc(words * sizeof *c.labels);
+    c.targeted = calloc(words, 1);
+    aurc_jit_loop *loop = NULL;
+    if (!c.labels || !c.targeted) {
+        goto done;
+    }
+    mark_targets(&c);
+    for (size_t i = 0; i < words; ++i) {
+        c.labels[i] = x86_new_label(&c.as);
+    }
+    uint32_t epilogue = x86_new_label(&c.as);
+
+    for (size_t i = 0; i < JIT_SAVED_COUNT; ++i) {
+        x86_push(&c.as, JIT_SAVED[i]);
+    }
+#ifdef _WIN32
+    x86_mov_reg_reg(&c.as, JIT_FRAME, X86_RCX);
+#else
+    x86_mov_reg_reg(&c.as, JIT_FRAME, X86_RDI);
+#endif
+    x86_mov_reg_mem(&c.as, JIT_REGS, JIT_FRAME, FRAME_AT(regs));
+    for (uint8_t reg = 0; reg <= ISA_REG_SP; ++reg) {
+        x86_mov_reg_mem(&c.as, JIT_HOST[reg], JIT_REGS, reg * 8);
+    }
+    int compare_live = 0;
+    for (uint32_t i = c.head; i <= c.tail; ++i) {
+        x86_bind_label(&c.as, c.labels[i - c.head]);
+        if (compile_word(&c, i, &compare_live) != 0) {
+            goto done;
+        }
+    }
+    x86_jmp(&c.as, exit_to(&c, (c.tail + 1) * ISA_WORD_SIZE));
+    for (size_t i = 0; i < c.exit_count; ++i) {
+        x86_bind_label(&c.as, c.exits[i].label);
+        x86_mov_reg_imm(&c.as, X86_RAX, c.exits[i].address);
+        x86_jmp(&c.as, epilogue);
+    }
+    x86_bind_label(&c.as, epilogue);
+    for (uint8_t reg = 0; reg <= ISA_REG_SP; ++reg) {
+        x86_mov_mem_reg(&c.as, JIT_REGS, reg * 8, JIT_HOST[reg]);
+    }
+    for (size_t i = JIT_SAVED_COUNT; i-- > 0;) {
+        x86_pop(&c.as, JIT_SAVED[i]);
+    }
+    x86_ret(&c.as);
+
+    if (c.failed || aurc_x86_link(&c.as, 0, 0, NULL) != 0) {
+        goto done;
+    }
+    loop = malloc(sizeof *loop);
+    if (!loop) {
+        goto done;
+    }
+    loop->memory = exec_copy(c.as.code.data, c.as.code.len, &loop->size);
+    if (!loop->memory) {
+        free(loop);
+        loop = NULL;
+        goto done;
+    }
+    /* object to function pointer: not ISO C, but what every host with executable memory allows */
+    memcpy(&loop->entry, &loop->memory, sizeof loop->entry);
+
+done:
+    free(c.labels);
+    free(c.targeted);
+    free(c.exits);
+    aurc_x86_free(&c.as);
+    return loop;
+#endif
+}
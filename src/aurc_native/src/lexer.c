@@ -0,0 +1,401 @@
+#include "aurc_lexer.h"
+#include "aurc_diag.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct keyword {
+    const char *spelling;
+    aurc_token_kind kind;
+} keyword;
+
+static const keyword KEYWORDS[] = {
+    {"module", AURC_TOK_MODULE},     {"fn", AURC_TOK_FN},
+    {"let", AURC_TOK_LET},           {"if", AURC_TOK_IF},
+    {"else", AURC_TOK_ELSE},         {"while", AURC_TOK_WHILE},
+    {"for", AURC_TOK_FOR},           {"in", AURC_TOK_IN},
+    {"break", AURC_TOK_BREAK},       {"continue", AURC_TOK_CONTINUE},
+    {"step", AURC_TOK_STEP},         {"return", AURC_TOK_RETURN},
+    {"request", AURC_TOK_REQUEST},   {"service", AURC_TOK_SERVICE},
+    {"true", AURC_TOK_TRUE},         {"false", AURC_TOK_FALSE},
+    {"shared", AURC_TOK_SHARED},     {"atomic", AURC_TOK_ATOMIC},
+    {"int", AURC_TOK_KW_INT},        {"float", AURC_TOK_KW_FLOAT},
+    {"string", AURC_TOK_KW_STRING},  {"bool", AURC_TOK_KW_BOOL},
+    {"thread", AURC_TOK_KW_THREAD},  {"spawn", AURC_TOK_SPAWN},
+    {"join", AURC_TOK_JOIN},         {"print", AURC_TOK_PRINT},
+    {"input", AURC_TOK_INPUT},       {"as", AURC_TOK_AS},
+};
+
+typedef struct lexer {
+    const char *path;
+    const char *cur;
+    const char *end;
+    const char *line_start;
+    uint32_t line;
+    aurc_arena *arena;
+    aurc_token_list *out;
+} lexer;
+
+static uint32_t column_of(const lexer *lx, const char *at) {
+    return (uint32_t)(at - lx->line_start) + 1;
+}
+
+static int lex_error(const lexer *lx, const char *at, const char *message) {
+    aurc_diag_printf("aurc-native: %s:%u:%u: %s\n", lx->path, lx->line, column_of(lx, at), message);
+    return 1;
+}
+
+static int is_ident_start(int c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static int is_digit(int c) {
+    return c >= '0' && c <= '9';
+}
+
+static aurc_token *push_token(lexer *lx, aurc_token_kind kind, const char *start, const char *stop) {
+    aurc_token_list *list = lx->out;
+    if (list->count == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 256;
+        aurc_token *grown = realloc(list->items, cap * sizeof *grown);
+        if (!grown) {
+            aurc_diag_printf("aurc-native: out of memory lexing %s\n", lx->path);
+            return NULL;
+        }
+        list->items = grown;
+        list->cap = cap;
+    }
+    aurc_token *tok = &list->items[list->count++];
+    memset(tok, 0, sizeof *tok);
+    tok->kind = kind;
+    tok->line = lx->line;
+    tok->column = column_of(lx, start);
+    tok->text.data = start;
+    tok->text.len = (size_t)(stop - start);
+    return tok;
+}
+
+static int skip_trivia(lexer *lx) {
+    while (lx->cur < lx->end) {
+        char c = *lx->cur;
+        if (c == ' ' || c == '\t' || c == '\r') {
+            lx->cur++;
+        } else if (c == '\n') {
+            lx->cur++;
+            lx->line++;
+            lx->line_start = lx->cur;
+        } else if (c == '/' && lx->cur + 1 < lx->end && lx->cur[1] == '/') {
+            while (lx->cur < lx->end && *lx->cur != '\n') {
+                lx->cur++;
+            }
+        } else if (c == '/' && lx->cur + 1 < lx->end && lx->cur[1] == '*') {
+            const char *open = lx->cur;
+            uint32_t open_line = lx->line;
+            const char *open_line_start = lx->line_start;
+            lx->cur += 2;
+            for (;;) {
+                if (lx->cur >= lx->end) {
+                    lexer at_open = *lx;
+                    at_open.line = open_line;
+                    at_open.line_start = open_line_start;
+                    return lex_error(&at_open, open, "unterminated block comment");
+                }
+                if (lx->cur[0] == '*' && lx->cur + 1 < lx->end && lx->cur[1] == '/') {
+                    lx->cur += 2;
+                    break;
+                }
+                if (*lx->cur == '\n') {
+                    lx->line++;
+                    lx->line_start = lx->cur + 1;
+                }
+                lx->cur++;
+            }
+        } else {
+            break;
+        }
+    }
+    return 0;
+}
+
+static int lex_string(lexer *lx) {
+    const char *start = lx->cur++;
+    const char *body = lx->cur;
+    int escaped = 0;
+    while (lx->cur < lx->end && *lx->cur != '"') {
+        if (*lx->cur == '\n') {
+            break;
+        }
+        if (*lx->cur == '\\' && lx->cur + 1 < lx->end) {
+            escaped = 1;
+            lx->cur++;
+        }
+        lx->cur++;
+    }
+    if (lx->cur >= lx->end || *lx->cur != '"') {
+        return lex_error(lx, start, "unterminated string literal");
+    }
+    const char *body_end = lx->cur++;
+    aurc_token *tok = push_token(lx, AURC_TOK_STRING, start, lx->cur);
+    if (!tok) {
+        return 1;
+    }
+    size_t raw_len = (size_t)(body_end - body);
+    if (!escaped) {
+        tok->as.string_value.data = body;
+        tok->as.string_value.len = raw_len;
+        return 0;
+    }
+    char *decoded = aurc_arena_alloc(lx->arena, raw_len + 1);
+    if (!decoded) {
+        return 1;
+    }
+    size_t len = 0;
+    for (const char *p = body; p < body_end; ++p) {
+        if (*p != '\\') {
+            decoded[len++] = *p;
+            continue;
+        }
+        switch (*++p) {
+        case 'n': decoded[len++] = '\n'; break;
+        case 't': decoded[len++] = '\t'; break;
+        case 'r': decoded[len++] = '\r'; break;
+        case '0': decoded[len++] = '\0'; break;
+        default: decoded[len++] = *p; break; /* \\, \" and unknown escapes keep the character */
+        }
+    }
+    decoded[len] = '\0';
+    tok->as.string_value.data = decoded;
+    tok->as.string_value.len = len;
+    return 0;
+}
+
+static int lex_number(lexer *lx) {
+    const char *start = lx->cur;
+    int is_float = 0;
+    while (lx->cur < lx->end && is_digit(*lx->cur)) {
+        lx->cur++;
+    }
+    /* `1..5` is a range, so a dot only starts a fraction when a digit follows */
+    if (lx->cur + 1 < lx->end && lx->cur[0] == '.' && is_digit(lx->cur[1])) {
+        is_float = 1;
+        lx->cur++;
+        while (lx->cur < lx->end && is_digit(*lx->cur)) {
+            lx->cur++;
+        }
+    }
+    if (lx->cur < lx->end && (*lx->cur == 'e' || *lx->cur == 'E')) {
+        const char *exp = lx->cur + 1;
+        if (exp < lx->end && (*exp == '+' || *exp == '-')) {
+            exp++;
+        }
+        if (exp < lx->end && is_digit(*exp)) {
+            is_float = 1;
+            lx->cur = exp;
+            while (lx->cur < lx->end && is_digit(*lx->cur)) {
+                lx->cur++;
+            }
+        }
+    }
+    if (lx->cur < lx->end && is_ident_start(*lx->cur)) {
+        return lex_error(lx, start, "malformed number literal");
+    }
+
+    aurc_token *tok = push_token(lx, is_float ? AURC_TOK_FLOAT : AURC_TOK_INT, start, lx->cur);
+    if (!tok) {
+        return 1;
+    }
+    if (is_float) {
+        char buf[64];
+        if (aurc_view_copy(tok->text, buf, sizeof buf) != 0) {
+            return lex_error(lx, start, "float literal too long");
+        }
+        errno = 0;
+        tok->as.float_value = strtod(buf, NULL);
+        if (errno == ERANGE && (tok->as.float_value > 1.0 || tok->as.float_value < -1.0)) {
+            return lex_error(lx, start, "float literal out of range");
+        }
+        return 0;
+    }
+    uint64_t value;
+    if (aurc_view_parse_u64(tok->text, &value) != 0 || value > (uint64_t)INT64_MAX + 1u) {
+        return lex_error(lx, start, "integer literal out of range");
+    }
+    /* INT64_MAX + 1 is only meaningful under unary minus; the parser rejects it elsewhere */
+    tok->as.int_value = (int64_t)value;
+    return 0;
+}
+
+static int lex_word(lexer *lx) {
+    const char *start = lx->cur;
+    while (lx->cur < lx->end && (is_ident_start(*lx->cur) || is_digit(*lx->cur))) {
+        lx->cur++;
+    }
+    aurc_view word = {start, (size_t)(lx->cur - start)};
+    aurc_token_kind kind = AURC_TOK_IDENT;
+    for (size_t i = 0; i < sizeof KEYWORDS / sizeof KEYWORDS[0]; ++i) {
+        if (aurc_view_eq(word, KEYWORDS[i].spelling)) {
+            kind = KEYWORDS[i].kind;
+            break;
+        }
+    }
+    return push_token(lx, kind, start, lx->cur) ? 0 : 1;
+}
+
+static int lex_operator(lexer *lx) {
+    const char *start = lx->cur;
+    char c = lx->cur[0];
+    char n = lx->cur + 1 < lx->end ? lx->cur[1] : '\0';
+    aurc_token_kind kind;
+    size_t width = 2;
+
+    if (c == '-' && n == '>') {
+        kind = AURC_TOK_ARROW;
+    } else if (c == '.' && n == '.') {
+        kind = AURC_TOK_DOTDOT;
+    } else if (c == '&' && n == '&') {
+        kind = AURC_TOK_AND_AND;
+    } else if (c == '|' && n == '|') {
+        kind = AURC_TOK_OR_OR;
+    } else if (c == '=' && n == '=') {
+        kind = AURC_TOK_EQ;
+    } else if (c == '!' && n == '=') {
+        kind = AURC_TOK_NE;
+    } else if (c == '<' && n == '=') {
+        kind = AURC_TOK_LE;
+    } else if (c == '>' && n == '=') {
+        kind = AURC_TOK_GE;
+    } else if (c == '<' && n == '<') {
+        kind = AURC_TOK_SHL;
+    } else if (c == '>' && n == '>') {
+        kind = AURC_TOK_SHR;
+    } else {
+        width = 1;
+        switch (c) {
+        case '+': kind = AURC_TOK_PLUS; break;
+        case '-': kind = AURC_TOK_MINUS; break;
+        case '*': kind = AURC_TOK_STAR; break;
+        case '/': kind = AURC_TOK_SLASH; break;
+        case '%': kind = AURC_TOK_PERCENT; break;
+        case '=': kind = AURC_TOK_ASSIGN; break;
+        case '<': kind = AURC_TOK_LT; break;
+        case '>': kind = AURC_TOK_GT; break;
+        case '!': kind = AURC_TOK_BANG; break;
+        case '&': kind = AURC_TOK_AMP; break;
+        case '|': kind = AURC_TOK_PIPE; break;
+        case '^': kind = AURC_TOK_CARET; break;
+        case '~': kind = AURC_TOK_TILDE; break;
+        case '(': kind = AURC_TOK_LPAREN; break;
+        case ')': kind = AURC_TOK_RPAREN; break;
+        case '{': kind = AURC_TOK_LBRACE; break;
+        case '}': kind = AURC_TOK_RBRACE; break;
+        case '[': kind = AURC_TOK_LBRACKET; break;
+        case ']': kind = AURC_TOK_RBRACKET; break;
+        case ',': kind = AURC_TOK_COMMA; break;
+        case ':': kind = AURC_TOK_COLON; break;
+        case ';': kind = AURC_TOK_SEMICOLON; break;
+        case '.': kind = AURC_TOK_DOT; break;
+        default: {
+            char message[48];
+            if (c >= 0x20 && c < 0x7F) {
+                snprintf(message, sizeof message, "unexpected character '%c'", c);
+            } else {
+                snprintf(message, sizeof message, "unexpected byte 0x%02X", (unsigned)(unsigned char)c);
+            }
+            return lex_error(lx, start, message);
+        }
+        }
+    }
+    lx->cur += width;
+    return push_token(lx, kind, start, lx->cur) ? 0 : 1;
+}
+
+int aurc_lex(const char *path, aurc_view source, aurc_arena *arena, aurc_token_list *out) {
+    lexer lx = {path, source.data, source.data + source.len, source.data, 1, arena, out};
+    out->items = NULL;
+    out->count = 0;
+    out->cap = 0;
+
+    for (;;) {
+        if (skip_trivia(&lx) != 0) {
+            return 1;
+        }
+        if (lx.cur >= lx.end) {
+            break;
+        }
+        int c = (unsigned char)*lx.cur;
+        int rc;
+        if (c == '"') {
+            rc = lex_string(&lx);
+        } else if (is_digit(c)) {
+            rc = lex_number(&lx);
+        } else if (is_ident_start(c)) {
+            rc = lex_word(&lx);
+        } else {
+            rc = lex_operator(&lx);
+        }
+        if (rc != 0) {
+            return 1;
+        }
+    }
+    return push_token(&lx, AURC_TOK_EOF, lx.cur, lx.cur) ? 0 : 1;
+}
+
+void aurc_token_list_free(aurc_token_list *tokens) {
+    free(tokens->items);
+    tokens->items = NULL;
+    tokens->count = 0;
+    tokens->cap = 0;
+}
+
+const char *aurc_token_kind_name(aurc_token_kind kind) {
+    switch (kind) {
+    case AURC_TOK_EOF: return "end of file";
+    case AURC_TOK_IDENT: return "identifier";
+    case AURC_TOK_INT: return "integer literal";
+    case AURC_TOK_FLOAT: return "float literal";
+    case AURC_TOK_STRING: return "string literal";
+    case AURC_TOK_PLUS: return "'+'";
+    case AURC_TOK_MINUS: return "'-'";
+    case AURC_TOK_STAR: return "'*'";
+    case AURC_TOK_SLASH: return "'/'";
+    case AURC_TOK_PERCENT: return "'%'";
+    case AURC_TOK_ASSIGN: return "'='";
+    case AURC_TOK_EQ: return "'=='";
+    case AURC_TOK_NE: return "'!='";
+    case AURC_TOK_LT: return "'<'";
+    case AURC_TOK_GT: return "'>'";
+    case AURC_TOK_LE: return "'<='";
+    case AURC_TOK_GE: return "'>='";
+    case AURC_TOK_AND_AND: return "'&&'";
+    case AURC_TOK_OR_OR: return "'||'";
+    case AURC_TOK_BANG: return "'!'";
+    case AURC_TOK_AMP: return "'&'";
+    case AURC_TOK_PIPE: return "'|'";
+    case AURC_TOK_CARET: return "'^'";
+    case AURC_TOK_TILDE: return "'~'";
+    case AURC_TOK_SHL: return "'<<'";
+    case AURC_TOK_SHR: return "'>>'";
+    case AURC_TOK_LPAREN: return "'('";
+    case AURC_TOK_RPAREN: return "')'";
+    case AURC_TOK_LBRACE: return "'{'";
+    case AURC_TOK_RBRACE: return "'}'";
+    case AURC_TOK_LBRACKET: return "'['";
+    case AURC_TOK_RBRACKET: return "']'";
+    case AURC_TOK_COMMA: return "','";
+    case AURC_TOK_COLON: return "':'";
+    case AURC_TOK_SEMICOLON: return "';'";
+    case AURC_TOK_ARROW: return "'->'";
+    case AURC_TOK_DOTDOT: return "'..'";
+    case AURC_TOK_DOT: return "'.'";
+    default:
+        break;
+    }
+    for (size_t i = 0; i < sizeof KEYWORDS / sizeof KEYWORDS[0]; ++i) {
+        if (KEYWORDS[i].kind == kind) {
+            return KEYWORDS[i].spelling;
+        }
+    }
+    return "token";
+}
@@ -2,86 +2,102 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "aurc_batch.h"
 #include "aurc_native.h"
 
 static void usage(const char *program) {
-    fprintf(stderr, "Usage: %s compile <input.aur> [-o output.aurs] [--emit-bin output.bin] [--emit-exe output.exe]\n", program);
+    fprintf(stderr, "Usage: %s compile <input.aur> [-o output.aurs] [--emit-bin output.bin] [--emit-exe output.exe] [-O0|-O1|-O2] [--target-cpu x86-64|x86-64-v3] [--target-os windows|linux] [--shard-counters] [--time-report] [--stats-json stats.json] [--cache-dir dir]\n", program);
+    fprintf(stderr, "       %s compile-many <dir|list.txt> [--out-dir dir] [-j n] [--aurs] [--bin] [--exe] [-O0|-O1|-O2] [--target-cpu x86-64|x86-64-v3] [--target-os windows|linux] [--shard-counters] [--time-report] [--cache-dir dir]\n", program);
+    fprintf(stderr, "       %s --serve   (jobs on stdin: <input.aur> [compile options])\n", program);
+    fprintf(stderr, "       %s assemble <manifest.aurs> -o <image.bin>\n", program);
+    fprintf(stderr, "       %s run <image.bin> [-j workers] [--pair-profile] [--no-jit] [--profile prefix]\n", program);
 }
 
-int main(int argc, char **argv) {
-    if (argc < 3) {
-        usage(argv[0]);
+static int run_image(const char *image_path, const aurc_run_options *options) {
+    int exit_status = 0;
+    if (aurc_run_image(image_path, options, &exit_status) != 0) {
+        fprintf(stderr, "aurc-native: execution failed\n");
         return EXIT_FAILURE;
     }
+    return exit_status;
+}
 
-    if (strcmp(argv[1], "compile") != 0) {
+int main(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "--serve") == 0) {
+        return aurc_serve(stdin, stdout) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (argc < 3) {
         usage(argv[0]);
         return EXIT_FAILURE;
     }
 
-    const char *input_path = argv[2];
-    const char *output_path = NULL;
-    const char *binary_path = NULL;
-    const char *exe_path = NULL;
-
-    for (int i = 3; i < argc; ++i) {
-        if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
-            if (i + 1 >= argc) {
-                fprintf(stderr, "Missing argument for %s\n", argv[i]);
+    if (strcmp(argv[1], "run") == 0) {
+        aurc_run_options options = {0, 0, 0, NULL};
+        for (int i = 3; i < argc; ++i) {
+            if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+                char *end = NULL;
+                unsigned long value = strtoul(argv[++i], &end, 10);
+                if (*end != '\0' || value < 1 || value > 1024) {
+                    fprintf(stderr, "-j expects a worker count between 1 and 1024\n");
+                    return EXIT_FAILURE;
+                }
+                options.workers = (unsigned)value;
+            } else if (strcmp(argv[i], "--pair-profile") == 0) {
+                options.pair_profile = 1;
+            } else if (strcmp(argv[i], "--no-jit") == 0) {
+                options.no_jit = 1;
+            } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+                options.profile = argv[++i];
+            } else {
+                usage(argv[0]);
                 return EXIT_FAILURE;
             }
-            output_path = argv[i + 1];
-            ++i;
-        } else if (strcmp(argv[i], "--emit-bin") == 0) {
-            if (i + 1 >= argc) {
-                fprintf(stderr, "Missing argument for %s\n", argv[i]);
-                return EXIT_FAILURE;
-            }
-            binary_path = argv[i + 1];
-            ++i;
-        } else if (strcmp(argv[i], "--emit-exe") == 0) {
-            if (i + 1 >= argc) {
-                fprintf(stderr, "Missing argument for %s\n", argv[i]);
-                return EXIT_FAILURE;
-            }
-            exe_path = argv[i + 1];
-            ++i;
-        } else {
-            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+        }
+        return run_image(argv[2], &options);
+    }
+
+    if (strcmp(argv[1], "assemble") == 0) {
+        if (argc != 5 || (strcmp(argv[3], "-o") != 0 && strcmp(argv[3], "--output") != 0)) {
             usage(argv[0]);
             return EXIT_FAILURE;
         }
+        if (aurc_assemble_manifest(argv[2], argv[4]) != 0) {
+            fprintf(stderr, "aurc-native: assembling manifest failed\n");
+            return EXIT_FAILURE;
+        }
+        printf("[aurc-native] wrote binary to %s\n", argv[4]);
+        return EXIT_SUCCESS;
+    }
+
+    if (strcmp(argv[1], "compile-many") == 0) {
+        return aurc_compile_many(argv[2], argc - 3, argv + 3) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (strcmp(argv[1], "compile") != 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
     }
 
-    if (output_path == NULL) {
-        fprintf(stderr, "Output path required for now.\n");
+    aurc_compile_options options;
+    if (aurc_parse_compile_options(argc - 3, argv + 3, &options) != 0) {
+        usage(argv[0]);
         return EXIT_FAILURE;
     }
 
-    int rc = aurc_compile_file(input_path, output_path);
+    int rc = aurc_compile_file(argv[2], &options);
     if (rc != 0) {
         fprintf(stderr, "aurc-native: compilation failed (code %d)\n", rc);
         return EXIT_FAILURE;
     }
 
-    printf("[aurc-native] wrote manifest to %s\n", output_path);
-
-    if (binary_path != NULL) {
-        rc = aurc_assemble_manifest(output_path, binary_path);
-        if (rc != 0) {
-            fprintf(stderr, "aurc-native: assembling manifest failed (code %d)\n", rc);
-            return EXIT_FAILURE;
-        }
-        printf("[aurc-native] wrote binary to %s\n", binary_path);
+    if (options.manifest_path) {
+        printf("[aurc-native] wrote manifest to %s\n", options.manifest_path);
     }
-
-    if (exe_path != NULL) {
-        rc = aurc_compile_to_exe(input_path, exe_path);
-        if (rc != 0) {
-            fprintf(stderr, "aurc-native: exe generation failed (code %d)\n", rc);
-            return EXIT_FAILURE;
-        }
-        printf("[aurc-native] wrote executable to %s\n", exe_path);
+    if (options.binary_path) {
+        printf("[aurc-native] wrote binary to %s\n", options.binary_path);
+    }
+    if (options.exe_path) {
+        printf("[aurc-native] wrote executable to %s\n", options.exe_path);
     }
 
     return EXIT_SUCCESS;
@@ -0,0 +1,858 @@
+#include "aurc_ast.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "aurc_diag.h"
+#include "aurc_lexer.h"
+
+/*
+ * Recursive-descent parser over the token array. Like the x86 encoder, it
+ * keeps a sticky `failed` flag: the first error is reported and every
+ * production after it unwinds by returning NULL.
+ */
+
+typedef struct parser {
+    const char *path;
+    const aurc_token *tok;
+    aurc_arena *arena;
+    int failed;
+} parser;
+
+/* Binary precedence levels, loosest first; comparisons sit at one non-associative level. */
+enum {
+    LEVEL_LOGICAL_OR = 0,
+    LEVEL_LOGICAL_AND,
+    LEVEL_COMPARISON,
+    LEVEL_BIT_OR,
+    LEVEL_BIT_XOR,
+    LEVEL_BIT_AND,
+    LEVEL_SHIFT,
+    LEVEL_ADDITIVE,
+    LEVEL_TERM,
+    LEVEL_COUNT
+};
+
+static aurc_expr *parse_expression(parser *p);
+static int parse_block(parser *p, aurc_block *out);
+
+static void parse_error(parser *p, const aurc_token *at, const char *fmt, ...) {
+    if (p->failed) {
+        return;
+    }
+    p->failed = 1;
+    aurc_diag_printf("aurc-native: %s:%u:%u: ", p->path, at->line, at->column);
+    va_list args;
+    va_start(args, fmt);
+    aurc_diag_vprintf(fmt, args);
+    va_end(args);
+    aurc_diag_printf("\n");
+}
+
+static void describe(const aurc_token *tok, char *buf, size_t cap) {
+    if (tok->kind == AURC_TOK_EOF) {
+        snprintf(buf, cap, "end of file");
+    } else if (tok->text.len > 32) {
+        snprintf(buf, cap, "'%.32s...'", tok->text.data);
+    } else {
+        snprintf(buf, cap, "'%.*s'", (int)tok->text.len, tok->text.data);
+    }
+}
+
+static int check(const parser *p, aurc_token_kind kind) {
+    return p->tok->kind == kind;
+}
+
+static const aurc_token *advance(parser *p) {
+    const aurc_token *tok = p->tok;
+    if (tok->kind != AURC_TOK_EOF) {
+        p->tok++;
+    }
+    return tok;
+}
+
+static int match(parser *p, aurc_token_kind kind) {
+    if (!check(p, kind)) {
+        return 0;
+    }
+    advance(p);
+    return 1;
+}
+
+static const aurc_token *expect(parser *p, aurc_token_kind kind, const char *context) {
+    if (p->failed) {
+        return NULL;
+    }
+    if (check(p, kind)) {
+        return advance(p);
+    }
+    char found[48];
+    describe(p->tok, found, sizeof found);
+    parse_error(p, p->tok, "expected %s %s, found %s", aurc_token_kind_name(kind), context, found);
+    return NULL;
+}
+
+static void *new_node(parser *p, size_t size) {
+    void *node = aurc_arena_zalloc(p->arena, size);
+    if (!node) {
+        p->failed = 1;
+    }
+    return node;
+}
+
+static aurc_expr *new_expr(parser *p, aurc_expr_kind kind, const aurc_token *at) {
+    aurc_expr *expr = new_node(p, sizeof *expr);
+    if (expr) {
+        expr->kind = kind;
+        expr->line = at->line;
+        expr->column = at->column;
+    }
+    return expr;
+}
+
+static aurc_stmt *new_stmt(parser *p, aurc_stmt_kind kind, const aurc_token *at) {
+    aurc_stmt *stmt = new_node(p, sizeof *stmt);
+    if (stmt) {
+        stmt->kind = kind;
+        stmt->line = at->line;
+        stmt->column = at->column;
+    }
+    return stmt;
+}
+
+static int parse_scalar_type(parser *p, aurc_type_kind *kind) {
+    switch (p->tok->kind) {
+    case AURC_TOK_KW_INT: *kind = AURC_TYPE_INT; break;
+    case AURC_TOK_KW_FLOAT: *kind = AURC_TYPE_FLOAT; break;
+    case AURC_TOK_KW_STRING: *kind = AURC_TYPE_STRING; break;
+    case AURC_TOK_KW_BOOL: *kind = AURC_TYPE_BOOL; break;
+    case AURC_TOK_KW_THREAD: *kind = AURC_TYPE_THREAD; break;
+    default: return 0;
+    }
+    advance(p);
+    return 1;
+}
+
+static int parse_type(parser *p, aurc_type *out) {
+    out->kind = AURC_TYPE_VOID;
+    out->elem = AURC_TYPE_VOID;
+    if (p->failed) {
+        return 1;
+    }
+    if (parse_scalar_type(p, &out->kind)) {
+        return 0;
+    }
+    if (check(p, AURC_TOK_IDENT) && aurc_view_eq(p->tok->text, "array")) {
+        advance(p);
+        if (!expect(p, AURC_TOK_LT, "after 'array'")) {
+            return 1;
+        }
+        if (!parse_scalar_type(p, &out->elem)) {
+            char found[48];
+            describe(p->tok, found, sizeof found);
+            parse_error(p, p->tok, "expected array element type, found %s", found);
+            return 1;
+        }
+        out->kind = AURC_TYPE_ARRAY;
+        return expect(p, AURC_TOK_GT, "after array element type") ? 0 : 1;
+    }
+    char found[48];
+    describe(p->tok, found, sizeof found);
+    parse_error(p, p->tok, "expected type, found %s", found);
+    return 1;
+}
+
+/* Parses `expr, expr, ...` up to (and including) the closing token. */
+static int parse_expr_list(parser *p, aurc_token_kind close, aurc_expr **first, size_t *count) {
+    aurc_expr **tail = first;
+    *first = NULL;
+    *count = 0;
+    if (!check(p, close)) {
+        do {
+            aurc_expr *item = parse_expression(p);
+            if (!item) {
+                return 1;
+            }
+            *tail = item;
+            tail = &item->next;
+            (*count)++;
+        } while (match(p, AURC_TOK_COMMA));
+    }
+    return expect(p, close, close == AURC_TOK_RPAREN ? "to close argument list" : "to close list") ? 0 : 1;
+}
+
+static aurc_expr *parse_call(parser *p, aurc_expr_kind kind, const aurc_token *at, const aurc_token *callee) {
+    aurc_expr *call = new_expr(p, kind, at);
+    if (!call || !expect(p, AURC_TOK_LPAREN, "before arguments")) {
+        return NULL;
+    }
+    call->as.call.callee = callee->text;
+    if (parse_expr_list(p, AURC_TOK_RPAREN, &call->as.call.args, &call->as.call.arg_count) != 0) {
+        return NULL;
+    }
+    return call;
+}
+
+static aurc_expr *parse_primary(parser *p) {
+    if (p->failed) {
+        return NULL;
+    }
+    const aurc_token *tok = p->tok;
+    aurc_expr *expr;
+    switch (tok->kind) {
+    case AURC_TOK_INT:
+        advance(p);
+        if (tok->as.int_value < 0) {
+            parse_error(p, tok, "integer literal out of range");
+            return NULL;
+        }
+        expr = new_expr(p, AURC_EXPR_INT, tok);
+        if (expr) {
+            expr->as.int_value = tok->as.int_value;
+        }
+        return expr;
+    case AURC_TOK_FLOAT:
+        advance(p);
+        expr = new_expr(p, AURC_EXPR_FLOAT, tok);
+        if (expr) {
+            expr->as.float_value = tok->as.float_value;
+        }
+        return expr;
+    case AURC_TOK_TRUE:
+    case AURC_TOK_FALSE:
+        advance(p);
+        expr = new_expr(p, AURC_EXPR_BOOL, tok);
+        if (expr) {
+            expr->as.bool_value = tok->kind == AURC_TOK_TRUE;
+        }
+        return expr;
+    case AURC_TOK_STRING:
+        advance(p);
+        expr = new_expr(p, AURC_EXPR_STRING, tok);
+        if (expr) {
+            expr->as.string_value = tok->as.string_value;
+        }
+        return expr;
+    case AURC_TOK_INPUT:
+        advance(p);
+        if (!expect(p, AURC_TOK_LPAREN, "after 'input'") || !expect(p, AURC_TOK_RPAREN, "after 'input('")) {
+            return NULL;
+        }
+        return new_expr(p, AURC_EXPR_INPUT, tok);
+    case AURC_TOK_SPAWN: {
+        advance(p);
+        const aurc_token *callee = expect(p, AURC_TOK_IDENT, "after 'spawn'");
+        return callee ? parse_call(p, AURC_EXPR_SPAWN, tok, callee) : NULL;
+    }
+    case AURC_TOK_JOIN: {
+        advance(p);
+        const aurc_token *handle = expect(p, AURC_TOK_IDENT, "after 'join'");
+        expr = handle ? new_expr(p, AURC_EXPR_JOIN, tok) : NULL;
+        if (expr) {
+            expr->as.name = handle->text;
+        }
+        return expr;
+    }
+    case AURC_TOK_ATOMIC: {
+        advance(p);
+        if (!expect(p, AURC_TOK_DOT, "after 'atomic'")) {
+            return NULL;
+        }
+        const aurc_token *op = expect(p, AURC_TOK_IDENT, "after 'atomic.'");
+        if (!op) {
+            return NULL;
+        }
+        if (!aurc_view_eq(op->text, "load")) {
+            parse_error(p, op, "atomic.%.*s cannot be used as an expression; only atomic.load can", (int)op->text.len,
+                        op->text.data);
+            return NULL;
+        }
+        const aurc_token *target;
+        if (!expect(p, AURC_TOK_LPAREN, "after 'atomic.load'") ||
+            !(target = expect(p, AURC_TOK_IDENT, "as atomic.load target")) ||
+            !expect(p, AURC_TOK_RPAREN, "after atomic.load target")) {
+            return NULL;
+        }
+        expr = new_expr(p, AURC_EXPR_ATOMIC_LOAD, tok);
+        if (expr) {
+            expr->as.name = target->text;
+        }
+        return expr;
+    }
+    case AURC_TOK_LBRACKET:
+        advance(p);
+        expr = new_expr(p, AURC_EXPR_ARRAY, tok);
+        if (!expr || parse_expr_list(p, AURC_TOK_RBRACKET, &expr->as.array.items, &expr->as.array.count) != 0) {
+            return NULL;
+        }
+        return expr;
+    case AURC_TOK_IDENT:
+        advance(p);
+        if (check(p, AURC_TOK_LPAREN)) {
+            return parse_call(p, AURC_EXPR_CALL, tok, tok);
+        }
+        if (match(p, AURC_TOK_LBRACKET)) {
+            expr = new_expr(p, AURC_EXPR_INDEX, tok);
+            if (!expr) {
+                return NULL;
+            }
+            expr->as.index.array = tok->text;
+            expr->as.index.index = parse_expression(p);
+            if (!expr->as.index.index || !expect(p, AURC_TOK_RBRACKET, "after index")) {
+                return NULL;
+            }
+            return expr;
+        }
+        expr = new_expr(p, AURC_EXPR_VAR, tok);
+        if (expr) {
+            expr->as.name = tok->text;
+        }
+        return expr;
+    case AURC_TOK_LPAREN:
+        advance(p);
+        expr = parse_expression(p);
+        if (!expr || !expect(p, AURC_TOK_RPAREN, "to close parenthesised expression")) {
+            return NULL;
+        }
+        return expr;
+    default: {
+        char found[48];
+        describe(tok, found, sizeof found);
+        parse_error(p, tok, "expected expression, found %s", found);
+        return NULL;
+    }
+    }
+}
+
+static aurc_expr *parse_casts(parser *p, aurc_expr *expr) {
+    while (expr && check(p, AURC_TOK_AS)) {
+        const aurc_token *as = advance(p);
+        aurc_type target = {AURC_TYPE_VOID, AURC_TYPE_VOID};
+        if (match(p, AURC_TOK_KW_INT)) {
+            target.kind = AURC_TYPE_INT;
+        } else if (match(p, AURC_TOK_KW_FLOAT)) {
+            target.kind = AURC_TYPE_FLOAT;
+        } else {
+            char found[48];
+            describe(p->tok, found, sizeof found);
+            parse_error(p, p->tok, "expected 'int' or 'float' after 'as', found %s", found);
+            return NULL;
+        }
+        aurc_expr *cast = new_expr(p, AURC_EXPR_CAST, as);
+        if (!cast) {
+            return NULL;
+        }
+        cast->as.cast.target = target;
+        cast->as.cast.operand = expr;
+        expr = cast;
+    }
+    return expr;
+}
+
+static aurc_expr *parse_unary(parser *p) {
+    if (p->failed) {
+        return NULL;
+    }
+    const aurc_token *tok = p->tok;
+    aurc_unary_op op;
+    switch (tok->kind) {
+    case AURC_TOK_MINUS: op = AURC_UN_NEG; break;
+    case AURC_TOK_BANG: op = AURC_UN_NOT; break;
+    case AURC_TOK_TILDE: op = AURC_UN_BITNOT; break;
+    default: return parse_casts(p, parse_primary(p));
+    }
+    advance(p);
+
+    /* fold `-literal` so the full int64 range (including INT64_MIN) is writable */
+    if (op == AURC_UN_NEG && (check(p, AURC_TOK_INT) || check(p, AURC_TOK_FLOAT))) {
+        const aurc_token *lit = advance(p);
+        aurc_expr *expr = new_expr(p, lit->kind == AURC_TOK_INT ? AURC_EXPR_INT : AURC_EXPR_FLOAT, tok);
+        if (!expr) {
+            return NULL;
+        }
+        if (lit->kind == AURC_TOK_INT) {
+            expr->as.int_value = (int64_t)(0u - (uint64_t)lit->as.int_value);
+        } else {
+            expr->as.float_value = -lit->as.float_value;
+        }
+        return parse_casts(p, expr);
+    }
+
+    aurc_expr *operand = parse_unary(p);
+    if (!operand) {
+        return NULL;
+    }
+    aurc_expr *expr = new_expr(p, AURC_EXPR_UNARY, tok);
+    if (expr) {
+        expr->as.unary.op = op;
+        expr->as.unary.operand = operand;
+    }
+    return expr;
+}
+
+static int binary_op_at(aurc_token_kind kind, int level, aurc_binary_op *op) {
+    switch (level) {
+    case LEVEL_LOGICAL_OR:
+        if (kind == AURC_TOK_OR_OR) { *op = AURC_BIN_LOGICAL_OR; return 1; }
+        return 0;
+    case LEVEL_LOGICAL_AND:
+        if (kind == AURC_TOK_AND_AND) { *op = AURC_BIN_LOGICAL_AND; return 1; }
+        return 0;
+    case LEVEL_COMPARISON:
+        switch (kind) {
+        case AURC_TOK_EQ: *op = AURC_BIN_EQ; return 1;
+        case AURC_TOK_NE: *op = AURC_BIN_NE; return 1;
+        case AURC_TOK_LT: *op = AURC_BIN_LT; return 1;
+        case AURC_TOK_LE: *op = AURC_BIN_LE; return 1;
+        case AURC_TOK_GT: *op = AURC_BIN_GT; return 1;
+        case AURC_TOK_GE: *op = AURC_BIN_GE; return 1;
+        default: return 0;
+        }
+    case LEVEL_BIT_OR:
+        if (kind == AURC_TOK_PIPE) { *op = AURC_BIN_OR; return 1; }
+        return 0;
+    case LEVEL_BIT_XOR:
+        if (kind == AURC_TOK_CARET) { *op = AURC_BIN_XOR; return 1; }
+        return 0;
+    case LEVEL_BIT_AND:
+        if (kind == AURC_TOK_AMP) { *op = AURC_BIN_AND; return 1; }
+        return 0;
+    case LEVEL_SHIFT:
+        if (kind == AURC_TOK_SHL) { *op = AURC_BIN_SHL; return 1; }
+        if (kind == AURC_TOK_SHR) { *op = AURC_BIN_SHR; return 1; }
+        return 0;
+    case LEVEL_ADDITIVE:
+        if (kind == AURC_TOK_PLUS) { *op = AURC_BIN_ADD; return 1; }
+        if (kind == AURC_TOK_MINUS) { *op = AURC_BIN_SUB; return 1; }
+        return 0;
+    case LEVEL_TERM:
+        if (kind == AURC_TOK_STAR) { *op = AURC_BIN_MUL; return 1; }
+        if (kind == AURC_TOK_SLASH) { *op = AURC_BIN_DIV; return 1; }
+        if (kind == AURC_TOK_PERCENT) { *op = AURC_BIN_MOD; return 1; }
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+static aurc_expr *parse_binary(parser *p, int level) {
+    if (level == LEVEL_COUNT) {
+        return parse_unary(p);
+    }
+    aurc_expr *lhs = parse_binary(p, level + 1);
+    aurc_binary_op op;
+    while (lhs && binary_op_at(p->tok->kind, level, &op)) {
+        const aurc_token *tok = advance(p);
+        aurc_expr *rhs = parse_binary(p, level + 1);
+        if (!rhs) {
+            return NULL;
+        }
+        aurc_expr *expr = new_expr(p, AURC_EXPR_BINARY, tok);
+        if (!expr) {
+            return NULL;
+        }
+        expr->as.binary.op = op;
+        expr->as.binary.lhs = lhs;
+        expr->as.binary.rhs = rhs;
+        lhs = expr;
+        if (level == LEVEL_COMPARISON) {
+            break; /* `a < b < c` is rejected by the caller's terminator check */
+        }
+    }
+    return lhs;
+}
+
+static aurc_expr *parse_expression(parser *p) {
+    return p->failed ? NULL : parse_binary(p, LEVEL_LOGICAL_OR);
+}
+
+static int end_statement(parser *p) {
+    return expect(p, AURC_TOK_SEMICOLON, "after statement") ? 0 : 1;
+}
+
+static aurc_stmt *parse_let(parser *p) {
+    const aurc_token *tok = advance(p);
+    aurc_stmt *stmt = new_stmt(p, AURC_STMT_LET, tok);
+    const aurc_token *name = expect(p, AURC_TOK_IDENT, "after 'let'");
+    if (!stmt || !name || !expect(p, AURC_TOK_COLON, "after variable name") ||
+        parse_type(p, &stmt->as.let.type) != 0 || !expect(p, AURC_TOK_ASSIGN, "after variable type")) {
+        return NULL;
+    }
+    stmt->as.let.name = name->text;
+    stmt->as.let.value = parse_expression(p);
+    return stmt->as.let.value && end_statement(p) == 0 ? stmt : NULL;
+}
+
+static aurc_stmt *parse_if(parser *p) {
+    const aurc_token *tok = advance(p);
+    aurc_stmt *stmt = new_stmt(p, AURC_STMT_IF, tok);
+    if (!stmt) {
+        return NULL;
+    }
+    stmt->as.if_stmt.cond = parse_expression(p);
+    if (!stmt->as.if_stmt.cond || parse_block(p, &stmt->as.if_stmt.then_block) != 0) {
+        return NULL;
+    }
+    if (match(p, AURC_TOK_ELSE)) {
+        stmt->as.if_stmt.has_else = 1;
+        if (check(p, AURC_TOK_IF)) {
+            /* `else if` nests as a one-statement else block */
+            aurc_stmt *nested = parse_if(p);
+            if (!nested) {
+                return NULL;
+            }
+            stmt->as.if_stmt.else_block.first = nested;
+            stmt->as.if_stmt.else_block.count = 1;
+        } else if (parse_block(p, &stmt->as.if_stmt.else_block) != 0) {
+            return NULL;
+        }
+    }
+    return stmt;
+}
+
+static aurc_stmt *parse_while(parser *p) {
+    const aurc_token *tok = advance(p);
+    aurc_stmt *stmt = new_stmt(p, AURC_STMT_WHILE, tok);
+    if (!stmt) {
+        return NULL;
+    }
+    stmt->as.while_stmt.cond = parse_expression(p);
+    if (!stmt->as.while_stmt.cond || parse_block(p, &stmt->as.while_stmt.body) != 0) {
+        return NULL;
+    }
+    return stmt;
+}
+
+static aurc_stmt *parse_for(parser *p) {
+    const aurc_token *tok = advance(p);
+    aurc_stmt *stmt = new_stmt(p, AURC_STMT_FOR, tok);
+    const aurc_token *var = expect(p, AURC_TOK_IDENT, "after 'for'");
+    if (!stmt || !var || !expect(p, AURC_TOK_IN, "after loop variable")) {
+        return NULL;
+    }
+    stmt->as.for_stmt.var = var->text;
+    if (!(stmt->as.for_stmt.start = parse_expression(p)) || !expect(p, AURC_TOK_DOTDOT, "in range") ||
+        !(stmt->as.for_stmt.end = parse_expression(p))) {
+        return NULL;
+    }
+    if (match(p, AURC_TOK_STEP) && !(stmt->as.for_stmt.step = parse_expression(p))) {
+        return NULL;
+    }
+    return parse_block(p, &stmt->as.for_stmt.body) == 0 ? stmt : NULL;
+}
+
+static aurc_stmt *parse_request(parser *p) {
+    const aurc_token *tok = advance(p);
+    aurc_stmt *stmt = new_stmt(p, AURC_STMT_REQUEST, tok);
+    if (!stmt) {
+        return NULL;
+    }
+    const aurc_token *service = NULL;
+    if (tok->kind == AURC_TOK_PRINT) {
+        service = tok;
+    } else if (expect(p, AURC_TOK_SERVICE, "after 'request'")) {
+        /* `print` is a keyword, so accept it explicitly as a service name */
+        service = check(p, AURC_TOK_PRINT) ? advance(p) : expect(p, AURC_TOK_IDENT, "as service name");
+    }
+    if (!service || !expect(p, AURC_TOK_LPAREN, "after service name")) {
+        return NULL;
+    }
+    stmt->as.request.service = service->text;
+    if (parse_expr_list(p, AURC_TOK_RPAREN, &stmt->as.request.args, &stmt->as.request.arg_count) != 0) {
+        return NULL;
+    }
+    return end_statement(p) == 0 ? stmt : NULL;
+}
+
+static aurc_stmt *parse_return(parser *p) {
+    const aurc_token *tok = advance(p);
+    aurc_stmt *stmt = new_stmt(p, AURC_STMT_RETURN, tok);
+    if (!stmt) {
+        return NULL;
+    }
+    if (!check(p, AURC_TOK_SEMICOLON) && !(stmt->as.ret_value = parse_expression(p))) {
+        return NULL;
+    }
+    return end_statement(p) == 0 ? stmt : NULL;
+}
+
+static aurc_stmt *parse_atomic(parser *p) {
+    const aurc_token *tok = advance(p);
+    aurc_stmt *stmt = new_stmt(p, AURC_STMT_ATOMIC, tok);
+    const aurc_token *op;
+    if (!stmt || !expect(p, AURC_TOK_DOT, "after 'atomic'") || !(op = expect(p, AURC_TOK_IDENT, "after 'atomic.'"))) {
+        return NULL;
+    }
+    int operands;
+    if (aurc_view_eq(op->text, "add")) {
+        stmt->as.atomic.op = AURC_ATOMIC_ADD;
+        operands = 1;
+    } else if (aurc_view_eq(op->text, "sub")) {
+        stmt->as.atomic.op = AURC_ATOMIC_SUB;
+        operands = 1;
+    } else if (aurc_view_eq(op->text, "fadd")) {
+        stmt->as.atomic.op = AURC_ATOMIC_FADD;
+        operands = 1;
+    } else if (aurc_view_eq(op->text, "store")) {
+        stmt->as.atomic.op = AURC_ATOMIC_STORE;
+        operands = 1;
+    } else if (aurc_view_eq(op->text, "load")) {
+        stmt->as.atomic.op = AURC_ATOMIC_LOAD;
+        operands = 0;
+    } else if (aurc_view_eq(op->text, "cas")) {
+        stmt->as.atomic.op = AURC_ATOMIC_CAS;
+        operands = 2;
+    } else {
+        parse_error(p, op, "unknown atomic operation '%.*s' (expected add, sub, fadd, store, load or cas)",
+                    (int)op->text.len, op->text.data);
+        return NULL;
+    }
+    const aurc_token *target;
+    if (!expect(p, AURC_TOK_LPAREN, "after atomic operation") ||
+        !(target = expect(p, AURC_TOK_IDENT, "as atomic target"))) {
+        return NULL;
+    }
+    stmt->as.atomic.target = target->text;
+    if (operands == 2) {
+        if (!expect(p, AURC_TOK_COMMA, "after atomic target") || !(stmt->as.atomic.expected = parse_expression(p))) {
+            return NULL;
+        }
+    }
+    if (operands >= 1) {
+        if (!expect(p, AURC_TOK_COMMA, "before atomic operand") || !(stmt->as.atomic.value = parse_expression(p))) {
+            return NULL;
+        }
+    }
+    if (!expect(p, AURC_TOK_RPAREN, "after atomic operands")) {
+        return NULL;
+    }
+    return end_statement(p) == 0 ? stmt : NULL;
+}
+
+static aurc_stmt *parse_identifier_statement(parser *p) {
+    const aurc_token *name = p->tok;
+    if (p->tok[1].kind == AURC_TOK_LPAREN) {
+        aurc_stmt *stmt = new_stmt(p, AURC_STMT_CALL, name);
+        advance(p);
+        if (!stmt || !(stmt->as.call = parse_call(p, AURC_EXPR_CALL, name, name))) {
+            return NULL;
+        }
+        return end_statement(p) == 0 ? stmt : NULL;
+    }
+
+    advance(p);
+    aurc_stmt *stmt = new_stmt(p, AURC_STMT_ASSIGN, name);
+    if (!stmt) {
+        return NULL;
+    }
+    stmt->as.assign.name = name->text;
+    if (match(p, AURC_TOK_LBRACKET)) {
+        if (!(stmt->as.assign.index = parse_expression(p)) || !expect(p, AURC_TOK_RBRACKET, "after index")) {
+            return NULL;
+        }
+    }
+    if (!expect(p, AURC_TOK_ASSIGN, "in assignment") || !(stmt->as.assign.value = parse_expression(p))) {
+        return NULL;
+    }
+    return end_statement(p) == 0 ? stmt : NULL;
+}
+
+static aurc_stmt *parse_statement(parser *p) {
+    const aurc_token *tok = p->tok;
+    switch (tok->kind) {
+    case AURC_TOK_LET: return parse_let(p);
+    case AURC_TOK_IF: return parse_if(p);
+    case AURC_TOK_WHILE: return parse_while(p);
+    case AURC_TOK_FOR: return parse_for(p);
+    case AURC_TOK_REQUEST:
+    case AURC_TOK_PRINT: return parse_request(p);
+    case AURC_TOK_RETURN: return parse_return(p);
+    case AURC_TOK_ATOMIC: return parse_atomic(p);
+    case AURC_TOK_IDENT: return parse_identifier_statement(p);
+    case AURC_TOK_BREAK:
+    case AURC_TOK_CONTINUE: {
+        advance(p);
+        aurc_stmt *stmt = new_stmt(p, tok->kind == AURC_TOK_BREAK ? AURC_STMT_BREAK : AURC_STMT_CONTINUE, tok);
+        return stmt && end_statement(p) == 0 ? stmt : NULL;
+    }
+    case AURC_TOK_JOIN: {
+        advance(p);
+        aurc_stmt *stmt = new_stmt(p, AURC_STMT_JOIN, tok);
+        const aurc_token *handle = expect(p, AURC_TOK_IDENT, "after 'join'");
+        if (!stmt || !handle) {
+            return NULL;
+        }
+        stmt->as.join_handle = handle->text;
+        return end_statement(p) == 0 ? stmt : NULL;
+    }
+    default: {
+        char found[48];
+        describe(tok, found, sizeof found);
+        parse_error(p, tok, "expected statement, found %s", found);
+        return NULL;
+    }
+    }
+}
+
+/* Statements up to (not including) `close`. */
+static int parse_statements(parser *p, aurc_token_kind close, aurc_block *out) {
+    aurc_stmt **tail = &out->first;
+    out->first = NULL;
+    out->count = 0;
+    while (!p->failed && !check(p, close) && !check(p, AURC_TOK_EOF)) {
+        aurc_stmt *stmt = parse_statement(p);
+        if (!stmt) {
+            return 1;
+        }
+        *tail = stmt;
+        tail = &stmt->next;
+        out->count++;
+    }
+    return p->failed;
+}
+
+static int parse_block(parser *p, aurc_block *out) {
+    if (!expect(p, AURC_TOK_LBRACE, "to open block") || parse_statements(p, AURC_TOK_RBRACE, out) != 0) {
+        return 1;
+    }
+    return expect(p, AURC_TOK_RBRACE, "to close block") ? 0 : 1;
+}
+
+static aurc_function *parse_function(parser *p) {
+    const aurc_token *tok = advance(p);
+    aurc_function *fn = new_node(p, sizeof *fn);
+    const aurc_token *name = expect(p, AURC_TOK_IDENT, "after 'fn'");
+    if (!fn || !name || !expect(p, AURC_TOK_LPAREN, "after function name")) {
+        return NULL;
+    }
+    fn->name = name->text;
+    fn->line = tok->line;
+    fn->column = tok->column;
+
+    aurc_param **tail = &fn->params;
+    if (!check(p, AURC_TOK_RPAREN)) {
+        do {
+            aurc_param *param = new_node(p, sizeof *param);
+            const aurc_token *param_name = expect(p, AURC_TOK_IDENT, "as parameter name");
+            if (!param || !param_name || !expect(p, AURC_TOK_COLON, "after parameter name") ||
+                parse_type(p, &param->type) != 0) {
+                return NULL;
+            }
+            param->name = param_name->text;
+            *tail = param;
+            tail = &param->next;
+            fn->param_count++;
+        } while (match(p, AURC_TOK_COMMA));
+    }
+    if (!expect(p, AURC_TOK_RPAREN, "after parameters")) {
+        return NULL;
+    }
+    if (match(p, AURC_TOK_ARROW) && parse_type(p, &fn->return_type) != 0) {
+        return NULL;
+    }
+    return parse_block(p, &fn->body) == 0 ? fn : NULL;
+}
+
+static aurc_shared_decl *parse_shared(parser *p) {
+    const aurc_token *tok = advance(p);
+    aurc_shared_decl *decl = new_node(p, sizeof *decl);
+    const aurc_token *name = expect(p, AURC_TOK_IDENT, "after 'shared'");
+    if (!decl || !name || !expect(p, AURC_TOK_COLON, "after shared name") || parse_type(p, &decl->type) != 0 ||
+        !expect(p, AURC_TOK_ASSIGN, "after shared type")) {
+        return NULL;
+    }
+    decl->name = name->text;
+    decl->line = tok->line;
+    decl->column = tok->column;
+    decl->init = parse_expression(p);
+    return decl->init && end_statement(p) == 0 ? decl : NULL;
+}
+
+/* fn and shared declarations up to `close` (`}` of a module, or end of file). */
+static int parse_declarations(parser *p, aurc_token_kind close, aurc_program *out) {
+    aurc_function **fn_tail = &out->functions;
+    aurc_shared_decl **shared_tail = &out->shared;
+    while (!p->failed && !check(p, close) && !check(p, AURC_TOK_EOF)) {
+        if (check(p, AURC_TOK_FN)) {
+            aurc_function *fn = parse_function(p);
+            if (!fn) {
+                return 1;
+            }
+            *fn_tail = fn;
+            fn_tail = &fn->next;
+            out->function_count++;
+        } else if (check(p, AURC_TOK_SHARED)) {
+            aurc_shared_decl *decl = parse_shared(p);
+            if (!decl) {
+                return 1;
+            }
+            *shared_tail = decl;
+            shared_tail = &decl->next;
+            out->shared_count++;
+        } else {
+            char found[48];
+            describe(p->tok, found, sizeof found);
+            parse_error(p, p->tok, "expected 'fn' or 'shared' declaration, found %s", found);
+            return 1;
+        }
+    }
+    return p->failed;
+}
+
+static int parse_program(parser *p, aurc_program *out) {
+    if (match(p, AURC_TOK_MODULE)) {
+        out->form = AURC_PROGRAM_MODULE;
+        const aurc_token *name = expect(p, AURC_TOK_IDENT, "after 'module'");
+        if (!name || !expect(p, AURC_TOK_LBRACE, "after module name") ||
+            parse_declarations(p, AURC_TOK_RBRACE, out) != 0 || !expect(p, AURC_TOK_RBRACE, "to close module")) {
+            return 1;
+        }
+        out->module_name = name->text;
+    } else if (check(p, AURC_TOK_FN) || check(p, AURC_TOK_SHARED)) {
+        out->form = AURC_PROGRAM_IMPLICIT;
+        out->module_name = aurc_view_of("main");
+        if (parse_declarations(p, AURC_TOK_EOF, out) != 0) {
+            return 1;
+        }
+    } else {
+        out->form = AURC_PROGRAM_FLAT;
+        if (parse_statements(p, AURC_TOK_EOF, &out->body) != 0) {
+            return 1;
+        }
+    }
+    if (!check(p, AURC_TOK_EOF)) {
+        char found[48];
+        describe(p->tok, found, sizeof found);
+        parse_error(p, p->tok, "unexpected %s after end of program", found);
+        return 1;
+    }
+    return 0;
+}
+
+int aurc_parse(const char *path, aurc_view source, aurc_arena *arena, aurc_program *out) {
+    memset(out, 0, sizeof *out);
+    aurc_token_list tokens;
+    if (aurc_lex(path, source, arena, &tokens) != 0) {
+        aurc_token_list_free(&tokens);
+        return 1;
+    }
+    int rc = aurc_parse_tokens(path, &tokens, arena, out);
+    aurc_token_list_free(&tokens);
+    return rc;
+}
+
+int aurc_parse_tokens(const char *path, const aurc_token_list *tokens, aurc_arena *arena, aurc_program *out) {
+    memset(out, 0, sizeof *out);
+    parser p = {path, tokens->items, arena, 0};
+    return parse_program(&p, out);
+}
+
+const aurc_function *aurc_program_find_function(const aurc_program *program, const char *name) {
+    for (const aurc_function *fn = program->functions; fn; fn = fn->next) {
+        if (aurc_view_eq(fn->name, name)) {
+            return fn;
+        }
+    }
+    return NULL;
+}
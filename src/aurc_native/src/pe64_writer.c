@@ -0,0 +1,207 @@
+#include "aurc_x86.h"
+#include "aurc_diag.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Minimal PE32+ console image: .text, .rdata (kernel32 import table) and
+ * .data, laid out like pipeline/src/backend/pe64_generator.js but with section
+ * RVAs derived from the actual section sizes.
+ */
+
+#define PE_IMAGE_BASE 0x140000000ull
+#define PE_SECTION_ALIGNMENT 0x1000u
+#define PE_FILE_ALIGNMENT 0x200u
+#define PE_HEADER_OFFSET 0x80u
+#define PE_HEADERS_SIZE 0x200u
+#define PE_SECTION_COUNT 3
+
+static const char *const import_names[AURC_IMPORT_COUNT] = {
+    "ExitProcess",
+    "GetStdHandle",
+    "WriteFile",
+};
+
+static uint32_t align_up(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/* Builds the import directory for kernel32.dll placed at rdata_rva and records each IAT slot RVA. */
+static int build_import_section(aurc_bytes *rdata, uint32_t rdata_rva, uint64_t *slots, uint32_t *iat_rva, uint32_t *iat_size) {
+    const uint32_t count = AURC_IMPORT_COUNT;
+    const uint32_t idt_size = 2 * 20;
+    const uint32_t thunk_size = (count + 1) * 8;
+    const uint32_t ilt_offset = idt_size;
+    const uint32_t iat_offset = ilt_offset + thunk_size;
+    const char dll_name[] = "kernel32.dll";
+
+    uint32_t name_offset = iat_offset + thunk_size;
+    uint32_t hint_offsets[AURC_IMPORT_COUNT];
+    uint32_t cursor = align_up(name_offset + (uint32_t)sizeof dll_name, 2);
+    for (uint32_t i = 0; i < count; ++i) {
+        hint_offsets[i] = cursor;
+        cursor = align_up(cursor + 2 + (uint32_t)strlen(import_names[i]) + 1, 2);
+    }
+
+    if (aurc_bytes_append_zeros(rdata, cursor) != 0) {
+        return 1;
+    }
+    uint8_t *base = rdata->data;
+
+    aurc_bytes_patch_le32(rdata, 0, rdata_rva + ilt_offset);   /* OriginalFirstThunk */
+    aurc_bytes_patch_le32(rdata, 12, rdata_rva + name_offset); /* Name */
+    aurc_bytes_patch_le32(rdata, 16, rdata_rva + iat_offset);  /* FirstThunk */
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t hint_rva = rdata_rva + hint_offsets[i];
+        aurc_bytes_patch_le32(rdata, ilt_offset + i * 8, hint_rva);
+        aurc_bytes_patch_le32(rdata, iat_offset + i * 8, hint_rva);
+        base[hint_offsets[i]] = (uint8_t)i;
+        memcpy(base + hint_offsets[i] + 2, import_names[i], strlen(import_names[i]));
+        slots[i] = rdata_rva + iat_offset + i * 8;
+    }
+    memcpy(base + name_offset, dll_name, sizeof dll_name);
+
+    *iat_rva = rdata_rva + iat_offset;
+    *iat_size = thunk_size;
+    return 0;
+}
+
+static int write_section_header(aurc_bytes *out, const char *name, uint32_t virtual_size, uint32_t rva, uint32_t raw_size, uint32_t raw_pointer, uint32_t characteristics) {
+    char padded[8] = {0};
+    memcpy(padded, name, strlen(name));
+    int rc = aurc_bytes_append(out, padded, sizeof padded);
+    rc |= aurc_bytes_append_le32(out, virtual_size);
+    rc |= aurc_bytes_append_le32(out, rva);
+    rc |= aurc_bytes_append_le32(out, raw_size);
+    rc |= aurc_bytes_append_le32(out, raw_pointer);
+    rc |= aurc_bytes_append_zeros(out, 12); /* relocations / line numbers */
+    rc |= aurc_bytes_append_le32(out, characteristics);
+    return rc;
+}
+
+int aurc_write_pe64(aurc_x86_asm *as, const char *path, size_t *size) {
+    if (as->data.len == 0) {
+        x86_add_data(as, "\0\0\0\0\0\0\0\0", 8);
+    }
+
+    const uint32_t text_rva = PE_SECTION_ALIGNMENT;
+    const uint32_t text_size = (uint32_t)as->code.len;
+    const uint32_t rdata_rva = align_up(text_rva + text_size, PE_SECTION_ALIGNMENT);
+
+    aurc_bytes rdata;
+    aurc_bytes_init(&rdata);
+    uint64_t slots[AURC_IMPORT_COUNT];
+    uint32_t iat_rva = 0;
+    uint32_t iat_size = 0;
+    if (build_import_section(&rdata, rdata_rva, slots, &iat_rva, &iat_size) != 0) {
+        aurc_bytes_free(&rdata);
+        return 1;
+    }
+
+    const uint32_t rdata_size = (uint32_t)rdata.len;
+    const uint32_t data_rva = align_up(rdata_rva + rdata_size, PE_SECTION_ALIGNMENT);
+    const uint32_t data_size = (uint32_t)as->data.len;
+    const uint32_t image_size = align_up(data_rva + data_size, PE_SECTION_ALIGNMENT);
+
+    if (aurc_x86_link(as, text_rva, data_rva, slots) != 0) {
+        aurc_bytes_free(&rdata);
+        return 1;
+    }
+
+    const uint32_t text_raw = align_up(text_size, PE_FILE_ALIGNMENT);
+    const uint32_t rdata_raw = align_up(rdata_size, PE_FILE_ALIGNMENT);
+    const uint32_t data_raw = align_up(data_size, PE_FILE_ALIGNMENT);
+
+    aurc_bytes out;
+    aurc_bytes_init(&out);
+    int rc = 0;
+
+    /* DOS header: only e_magic and e_lfanew matter to the loader */
+    rc |= aurc_bytes_append(&out, "MZ", 2);
+    rc |= aurc_bytes_append_zeros(&out, 0x3C - 2);
+    rc |= aurc_bytes_append_le32(&out, PE_HEADER_OFFSET);
+    rc |= aurc_bytes_append_zeros(&out, PE_HEADER_OFFSET - 0x40);
+
+    /* PE signature + COFF header */
+    rc |= aurc_bytes_append(&out, "PE\0\0", 4);
+    rc |= aurc_bytes_append_le16(&out, 0x8664);          /* AMD64 */
+    rc |= aurc_bytes_append_le16(&out, PE_SECTION_COUNT);
+    rc |= aurc_bytes_append_zeros(&out, 12);             /* timestamp, symbol table */
+    rc |= aurc_bytes_append_le16(&out, 240);             /* SizeOfOptionalHeader */
+    rc |= aurc_bytes_append_le16(&out, 0x0022);          /* EXECUTABLE_IMAGE | LARGE_ADDRESS_AWARE */
+
+    /* Optional header (PE32+) */
+    rc |= aurc_bytes_append_le16(&out, 0x020B);
+    rc |= aurc_bytes_append_u8(&out, 14);
+    rc |= aurc_bytes_append_u8(&out, 0);
+    rc |= aurc_bytes_append_le32(&out, text_raw);         /* SizeOfCode */
+    rc |= aurc_bytes_append_le32(&out, rdata_raw + data_raw);
+    rc |= aurc_bytes_append_le32(&out, 0);                /* SizeOfUninitializedData */
+    rc |= aurc_bytes_append_le32(&out, text_rva);         /* AddressOfEntryPoint */
+    rc |= aurc_bytes_append_le32(&out, text_rva);         /* BaseOfCode */
+    rc |= aurc_bytes_append_le64(&out, PE_IMAGE_BASE);
+    rc |= aurc_bytes_append_le32(&out, PE_SECTION_ALIGNMENT);
+    rc |= aurc_bytes_append_le32(&out, PE_FILE_ALIGNMENT);
+    rc |= aurc_bytes_append_le16(&out, 6);                /* OS version */
+    rc |= aurc_bytes_append_le16(&out, 0);
+    rc |= aurc_bytes_append_le32(&out, 0);                /* image version */
+    rc |= aurc_bytes_append_le16(&out, 6);                /* subsystem version */
+    rc |= aurc_bytes_append_le16(&out, 0);
+    rc |= aurc_bytes_append_le32(&out, 0);                /* Win32VersionValue */
+    rc |= aurc_bytes_append_le32(&out, image_size);
+    rc |= aurc_bytes_append_le32(&out, PE_HEADERS_SIZE);
+    rc |= aurc_bytes_append_le32(&out, 0);                /* CheckSum */
+    rc |= aurc_bytes_append_le16(&out, 3);                /* CONSOLE */
+    rc |= aurc_bytes_append_le16(&out, 0x8100);           /* NX_COMPAT | TERMINAL_SERVER_AWARE */
+    rc |= aurc_bytes_append_le64(&out, 0x100000);         /* stack reserve */
+    rc |= aurc_bytes_append_le64(&out, 0x1000);           /* stack commit */
+    rc |= aurc_bytes_append_le64(&out, 0x100000);         /* heap reserve */
+    rc |= aurc_bytes_append_le64(&out, 0x1000);           /* heap commit */
+    rc |= aurc_bytes_append_le32(&out, 0);                /* LoaderFlags */
+    rc |= aurc_bytes_append_le32(&out, 16);               /* NumberOfRvaAndSizes */
+    for (int dir = 0; dir < 16; ++dir) {
+        uint32_t rva = 0;
+        uint32_t size = 0;
+        if (dir == 1) {
+            rva = rdata_rva;
+            size = 40;
+        } else if (dir == 12) {
+            rva = iat_rva;
+            size = iat_size;
+        }
+        rc |= aurc_bytes_append_le32(&out, rva);
+        rc |= aurc_bytes_append_le32(&out, size);
+    }
+
+    uint32_t file_offset = PE_HEADERS_SIZE;
+    rc |= write_section_header(&out, ".text", text_size, text_rva, text_raw, file_offset, 0x60000020);
+    file_offset += text_raw;
+    rc |= write_section_header(&out, ".rdata", rdata_size, rdata_rva, rdata_raw, file_offset, 0x40000040);
+    file_offset += rdata_raw;
+    rc |= write_section_header(&out, ".data", data_size, data_rva, data_raw, file_offset, 0xC0000040);
+
+    if (rc == 0 && out.len > PE_HEADERS_SIZE) {
+        aurc_diag_printf("aurc-native: PE headers overflow reserved space\n");
+        rc = 1;
+    }
+    if (rc == 0) {
+        rc |= aurc_bytes_append_zeros(&out, PE_HEADERS_SIZE - out.len);
+        rc |= aurc_bytes_append(&out, as->code.data, text_size);
+        rc |= aurc_bytes_append_zeros(&out, text_raw - text_size);
+        rc |= aurc_bytes_append(&out, rdata.data, rdata_size);
+        rc |= aurc_bytes_append_zeros(&out, rdata_raw - rdata_size);
+        rc |= aurc_bytes_append(&out, as->data.data, data_size);
+        rc |= aurc_bytes_append_zeros(&out, data_raw - data_size);
+    }
+    if (rc == 0) {
+        rc = aurc_bytes_write_file(&out, path);
+    }
+    if (rc == 0 && size) {
+        *size = out.len;
+    }
+
+    aurc_bytes_free(&out);
+    aurc_bytes_free(&rdata);
+    return rc != 0 ? 1 : 0;
+}
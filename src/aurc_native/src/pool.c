@@ -0,0 +1,130 @@
+#include "aurc_pool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define POOL_MIN_CLASS 4            /* 16 bytes: room for the free-list link */
+#define POOL_SMALL_CLASS 18         /* classes up to 256 KiB keep more blocks */
+#define POOL_DEPOT_SMALL 64         /* blocks the depot keeps per small class */
+#define POOL_DEPOT_LARGE 4
+#define POOL_CACHE_SMALL 16         /* blocks a cache keeps per small class */
+#define POOL_CACHE_LARGE 2
+
+static unsigned size_class(size_t size) {
+    unsigned c = POOL_MIN_CLASS;
+    while (c < AURC_POOL_CLASSES && ((size_t)1 << c) < size) {
+        ++c;
+    }
+    return c;
+}
+
+static unsigned depot_keep(unsigned c) {
+    return c <= POOL_SMALL_CLASS ? POOL_DEPOT_SMALL : POOL_DEPOT_LARGE;
+}
+
+static unsigned cache_keep(unsigned c) {
+    return c <= POOL_SMALL_CLASS ? POOL_CACHE_SMALL : POOL_CACHE_LARGE;
+}
+
+static void *pop(void **list) {
+    void *block = *list;
+    memcpy(list, block, sizeof block);
+    return block;
+}
+
+static void push(void **list, void *block) {
+    memcpy(block, list, sizeof *list);
+    *list = block;
+}
+
+int aurc_pool_init(aurc_pool *pool) {
+    memset(pool->free_list, 0, sizeof pool->free_list);
+    memset(pool->cached, 0, sizeof pool->cached);
+    return aurc_mutex_init(&pool->lock);
+}
+
+void aurc_pool_free(aurc_pool *pool) {
+    for (unsigned c = 0; c < AURC_POOL_CLASSES; ++c) {
+        while (pool->free_list[c]) {
+            free(pop(&pool->free_list[c]));
+        }
+        pool->cached[c] = 0;
+    }
+    aurc_mutex_destroy(&pool->lock);
+}
+
+void aurc_pool_cache_init(aurc_pool_cache *cache, aurc_pool *pool) {
+    cache->pool = pool;
+    memset(cache->free_list, 0, sizeof cache->free_list);
+    memset(cache->cached, 0, sizeof cache->cached);
+}
+
+/* Moves up to count blocks of class c from the cache to the depot, freeing what the depot has no room for. */
+static void spill(aurc_pool_cache *cache, unsigned c, unsigned count) {
+    aurc_pool *pool = cache->pool;
+    void *excess = NULL;
+    aurc_mutex_lock(&pool->lock);
+    for (; count > 0 && cache->free_list[c]; --count) {
+        void *block = pop(&cache->free_list[c]);
+        cache->cached[c]--;
+        if (pool->cached[c] < depot_keep(c)) {
+            push(&pool->free_list[c], block);
+            pool->cached[c]++;
+        } else {
+            push(&excess, block);
+        }
+    }
+    aurc_mutex_unlock(&pool->lock);
+    while (excess) {
+        free(pop(&excess));
+    }
+}
+
+void aurc_pool_cache_flush(aurc_pool_cache *cache) {
+    for (unsigned c = 0; c < AURC_POOL_CLASSES; ++c) {
+        spill(cache, c, cache->cached[c]);
+    }
+}
+
+void *aurc_pool_take(aurc_pool_cache *cache, size_t size, size_t *cap) {
+    unsigned c = size_class(size);
+    if (c >= AURC_POOL_CLASSES) {
+        return NULL;
+    }
+    if (!cache->free_list[c]) {
+        /* refill half a cache's worth at once so the next takes stay off the lock */
+        aurc_pool *pool = cache->pool;
+        unsigned batch = cache_keep(c) / 2;
+        aurc_mutex_lock(&pool->lock);
+        for (; batch > 0 && pool->free_list[c]; --batch) {
+            push(&cache->free_list[c], pop(&pool->free_list[c]));
+            pool->cached[c]--;
+            cache->cached[c]++;
+        }
+        aurc_mutex_unlock(&pool->lock);
+    }
+    void *block;
+    if (cache->free_list[c]) {
+        block = pop(&cache->free_list[c]);
+        cache->cached[c]--;
+    } else {
+        block = malloc((size_t)1 << c);
+    }
+    if (block && cap) {
+        *cap = (size_t)1 << c;
+    }
+    return block;
+}
+
+void aurc_pool_give(aurc_pool_cache *cache, void *block, size_t size) {
+    if (!block) {
+        return;
+    }
+    unsigned c = size_class(size);
+    if (cache->cached[c] == cache_keep(c)) {
+        spill(cache, c, (cache_keep(c) + 1) / 2);
+    }
+    push(&cache->free_list[c], block);
+    cache->cached[c]++;
+}
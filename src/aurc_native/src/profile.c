@@ -0,0 +1,477 @@
+#include "aurc_profile.h"
+#include "aurc_diag.h"
+#include "aurc_isa.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OPCODE_LIMIT 256u
+
+/* ---- setup -------------------------------------------------------------- */
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* Keeps the well-formed entries of the symbol section; a damaged one only costs names. */
+static int load_symbols(aurc_profile *profile, const uint8_t *section, uint32_t size) {
+    if (!section || size < 4) {
+        return 0;
+    }
+    uint32_t count = read_le32(section);
+    if ((uint64_t)4 + (uint64_t)count * 8 > size) {
+        return 0;
+    }
+    const char *names = (const char *)section + 4 + (size_t)count * 8;
+    size_t names_size = size - 4 - (size_t)count * 8;
+    profile->symbols = malloc((count ? count : 1) * sizeof *profile->symbols);
+    if (!profile->symbols) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t offset = read_le32(section + 8 + (size_t)i * 8);
+        if (offset < names_size && memchr(names + offset, 0, names_size - offset)) {
+            profile->symbols[profile->symbol_count++] =
+                (aurc_profile_symbol){read_le32(section + 4 + (size_t)i * 8), names + offset};
+        }
+    }
+    return 0;
+}
+
+aurc_profile *aurc_profile_create(const uint8_t *code, uint32_t words, const uint8_t *symbols, uint32_t symbols_size,
+                                  unsigned workers, uint32_t tasks, uint32_t lines) {
+    aurc_profile *profile = calloc(1, sizeof *profile);
+    if (!profile || aurc_mutex_init(&profile->lock) != 0) {
+        aurc_diag_printf("aurc-native: out of memory allocating profile\n");
+        free(profile);
+        return NULL;
+    }
+    profile->code = code;
+    profile->words = words;
+    profile->worker_count = workers;
+    profile->task_count = tasks;
+    profile->line_count = lines;
+    profile->stack_cap = 256;
+    profile->workers = calloc(workers, sizeof *profile->workers);
+    profile->tasks = calloc(tasks, sizeof *profile->tasks);
+    profile->line_owner = calloc(lines, sizeof *profile->line_owner);
+    profile->stacks = calloc(profile->stack_cap, sizeof *profile->stacks);
+    if (!profile->workers || !profile->tasks || !profile->line_owner || !profile->stacks ||
+        load_symbols(profile, symbols, symbols_size) != 0) {
+        aurc_diag_printf("aurc-native: out of memory allocating profile\n");
+        if (!profile->workers || !profile->stacks) {
+            profile->worker_count = 0;
+            profile->stack_cap = 0;
+        }
+        aurc_profile_destroy(profile);
+        return NULL;
+    }
+    return profile;
+}
+
+void aurc_profile_destroy(aurc_profile *profile) {
+    if (!profile) {
+        return;
+    }
+    for (unsigned w = 0; w < profile->worker_count; ++w) {
+        free(profile->workers[w].counts);
+        free(profile->workers[w].sampled);
+        aurc_bytes_free(&profile->workers[w].scratch);
+    }
+    for (uint32_t t = 0; profile->tasks && t < profile->task_count; ++t) {
+        free(profile->tasks[t].calls);
+    }
+    for (size_t i = 0; i < profile->stack_cap; ++i) {
+        free(profile->stacks[i].text);
+    }
+    aurc_mutex_destroy(&profile->lock);
+    free(profile->workers);
+    free(profile->tasks);
+    free(profile->line_owner);
+    free(profile->stacks);
+    free(profile->symbols);
+    free(profile);
+}
+
+/* ---- collection --------------------------------------------------------- */
+
+static int sampler_main(void *arg) {
+    aurc_profile *profile = arg;
+    while (!aurc_atomic_load64(&profile->done)) {
+        aurc_sleep_us(AURC_PROFILE_INTERVAL_US);
+        aurc_atomic_add64(&profile->tick, 1);
+    }
+    return 0;
+}
+
+int aurc_profile_start(aurc_profile *profile) {
+    if (aurc_thread_start(&profile->sampler, sampler_main, profile) != 0) {
+        aurc_diag_printf("aurc-native: cannot start profile sampler\n");
+        return 1;
+    }
+    profile->sampling = 1;
+    return 0;
+}
+
+void aurc_profile_stop(aurc_profile *profile) {
+    if (profile->sampling) {
+        aurc_atomic_store64(&profile->done, 1);
+        aurc_thread_join(&profile->sampler, NULL);
+        profile->sampling = 0;
+    }
+}
+
+aurc_profile_worker *aurc_profile_worker_for(aurc_profile *profile, unsigned worker) {
+    aurc_profile_worker *w = &profile->workers[worker];
+    if (!w->counts) {
+        w->counts = calloc((size_t)profile->words + 1, sizeof *w->counts);
+        w->sampled = calloc((size_t)profile->words + 1, sizeof *w->sampled);
+        if (!w->counts || !w->sampled) {
+            free(w->counts);
+            free(w->sampled);
+            w->counts = w->sampled = NULL;
+            return NULL;
+        }
+        w->tick = aurc_atomic_load64(&profile->tick);
+    }
+    return w;
+}
+
+void aurc_profile_task_start(aurc_profile *profile, uint32_t task, uint32_t entry) {
+    profile->tasks[task].entry = entry;
+    profile->tasks[task].depth = 0;
+}
+
+void aurc_profile_call(aurc_profile *profile, uint32_t task, uint32_t target) {
+    aurc_profile_frames *frames = &profile->tasks[task];
+    if (frames->depth == frames->cap) {
+        uint32_t cap = frames->cap ? frames->cap * 2 : 16;
+        uint32_t *calls = realloc(frames->calls, cap * sizeof *calls);
+        if (!calls) {
+            ++frames->depth;    /* counted, not named: samples show the frames that fit */
+            return;
+        }
+        frames->calls = calls;
+        frames->cap = cap;
+    }
+    if (frames->depth < frames->cap) {
+        frames->calls[frames->depth] = target;
+    }
+    ++frames->depth;
+}
+
+void aurc_profile_return(aurc_profile *profile, uint32_t task) {
+    if (profile->tasks[task].depth > 0) {
+        --profile->tasks[task].depth;
+    }
+}
+
+/* The last symbol at or below address; with exact, the first one at address. NULL when there is none. */
+static const aurc_profile_symbol *symbol_at(const aurc_profile *profile, uint32_t address, int exact) {
+    size_t lo = 0, hi = profile->symbol_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (exact ? profile->symbols[mid].address < address : profile->symbols[mid].address <= address) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (exact) {
+        return lo < profile->symbol_count && profile->symbols[lo].address == address ? &profile->symbols[lo] : NULL;
+    }
+    return lo > 0 ? &profile->symbols[lo - 1] : NULL;
+}
+
+static int append_name(aurc_bytes *out, const aurc_profile_symbol *symbol, uint32_t address) {
+    if (symbol) {
+        return aurc_bytes_append(out, symbol->name, strlen(symbol->name));
+    }
+    char hex[16];
+    int len = snprintf(hex, sizeof hex, "0x%04X", (unsigned)address);
+    return aurc_bytes_append(out, hex, (size_t)len);
+}
+
+static uint64_t hash_text(const char *text) {
+    uint64_t hash = 0xcbf29ce484222325u;    /* FNV-1a */
+    for (const unsigned char *p = (const unsigned char *)text; *p; ++p) {
+        hash = (hash ^ *p) * 0x100000001b3u;
+    }
+    return hash;
+}
+
+static aurc_profile_stack *find_stack(aurc_profile_stack *stacks, size_t cap, const char *text, uint64_t hash) {
+    size_t i = (size_t)hash & (cap - 1);
+    while (stacks[i].text && (stacks[i].hash != hash || strcmp(stacks[i].text, text) != 0)) {
+        i = (i + 1) & (cap - 1);
+    }
+    return &stacks[i];
+}
+
+/* Counts one more sample of text; caller holds the lock. */
+static void count_stack(aurc_profile *profile, const char *text, size_t len) {
+    if (profile->stack_count * 2 >= profile->stack_cap) {
+        size_t cap = profile->stack_cap * 2;
+        aurc_profile_stack *stacks = calloc(cap, sizeof *stacks);
+        if (!stacks) {
+            return;
+        }
+        for (size_t i = 0; i < profile->stack_cap; ++i) {
+            if (profile->stacks[i].text) {
+                *find_stack(stacks, cap, profile->stacks[i].text, profile->stacks[i].hash) = profile->stacks[i];
+            }
+        }
+        free(profile->stacks);
+        profile->stacks = stacks;
+        profile->stack_cap = cap;
+    }
+    uint64_t hash = hash_text(text);
+    aurc_profile_stack *slot = find_stack(profile->stacks, profile->stack_cap, text, hash);
+    if (!slot->text) {
+        slot->text = malloc(len + 1);
+        if (!slot->text) {
+            return;
+        }
+        memcpy(slot->text, text, len + 1);
+        slot->hash = hash;
+        profile->stack_count++;
+    }
+    slot->count++;
+}
+
+void aurc_profile_sample(aurc_profile *profile, aurc_profile_worker *worker, uint32_t task, uint32_t word) {
+    const aurc_profile_frames *frames = &profile->tasks[task];
+    uint32_t named = frames->depth < frames->cap ? frames->depth : frames->cap;
+    aurc_bytes *out = &worker->scratch;
+    out->len = 0;
+    worker->samples++;
+    worker->sampled[word]++;
+
+    uint32_t function = frames->entry * ISA_WORD_SIZE;
+    int rc = append_name(out, symbol_at(profile, function, 1), function);
+    for (uint32_t i = 0; i < named; ++i) {
+        function = frames->calls[i] * ISA_WORD_SIZE;
+        rc |= aurc_bytes_append_u8(out, ';');
+        rc |= append_name(out, symbol_at(profile, function, 1), function);
+    }
+    /* the label inside the function, or the bare address when the image has no symbols */
+    const aurc_profile_symbol *leaf = symbol_at(profile, word * ISA_WORD_SIZE, 0);
+    if (!profile->symbol_count || (leaf && leaf->address != function)) {
+        rc |= aurc_bytes_append_u8(out, ';');
+        rc |= append_name(out, leaf, word * ISA_WORD_SIZE);
+    }
+    rc |= aurc_bytes_append_u8(out, 0);
+    if (rc != 0) {
+        return;
+    }
+    aurc_mutex_lock(&profile->lock);
+    count_stack(profile, (const char *)out->data, out->len - 1);
+    aurc_mutex_unlock(&profile->lock);
+}
+
+void aurc_profile_atomic(aurc_profile *profile, aurc_profile_worker *worker, unsigned self, uint32_t line) {
+    int64_t mine = (int64_t)self + 1;
+    int64_t last = aurc_atomic_load64(&profile->line_owner[line]);
+    worker->atomic_ops++;
+    if (last != mine) {
+        worker->atomic_transfers += last != 0;
+        aurc_atomic_store64(&profile->line_owner[line], mine);
+    }
+}
+
+/* ---- output ------------------------------------------------------------- */
+
+static void json_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *)text; *p; ++p) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if (*p < 0x20) {
+            fprintf(out, "\\u%04x", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static int compare_stacks(const void *a, const void *b) {
+    const aurc_profile_stack *x = *(const aurc_profile_stack *const *)a;
+    const aurc_profile_stack *y = *(const aurc_profile_stack *const *)b;
+    return strcmp(x->text, y->text);
+}
+
+typedef struct opcode_count {
+    unsigned opcode;
+    uint64_t count;
+} opcode_count;
+
+static int compare_opcode_counts(const void *a, const void *b) {
+    const opcode_count *x = a;
+    const opcode_count *y = b;
+    if (x->count != y->count) {
+        return x->count > y->count ? -1 : 1;
+    }
+    return (x->opcode > y->opcode) - (x->opcode < y->opcode);
+}
+
+static FILE *open_output(const char *prefix, const char *suffix) {
+    size_t len = strlen(prefix);
+    char *path = malloc(len + strlen(suffix) + 1);
+    if (!path) {
+        aurc_diag_printf("aurc-native: out of memory writing profile\n");
+        return NULL;
+    }
+    memcpy(path, prefix, len);
+    strcpy(path + len, suffix);
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        aurc_diag_printf("aurc-native: cannot open %s for writing: %s\n", path, strerror(errno));
+    }
+    free(path);
+    return out;
+}
+
+static int close_output(FILE *out, const char *prefix, const char *suffix) {
+    int rc = 0;
+    if (ferror(out)) {
+        aurc_diag_printf("aurc-native: cannot write %s%s: %s\n", prefix, suffix, strerror(errno));
+        rc = 1;
+    }
+    if (fclose(out) != 0) {
+        rc = 1;
+    }
+    return rc;
+}
+
+static int write_folded(const aurc_profile *profile, const char *prefix) {
+    const aurc_profile_stack **sorted = malloc((profile->stack_count ? profile->stack_count : 1) * sizeof *sorted);
+    if (!sorted) {
+        aurc_diag_printf("aurc-native: out of memory writing profile\n");
+        return 1;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < profile->stack_cap; ++i) {
+        if (profile->stacks[i].text) {
+            sorted[count++] = &profile->stacks[i];
+        }
+    }
+    qsort(sorted, count, sizeof *sorted, compare_stacks);
+    FILE *out = open_output(prefix, ".folded");
+    if (!out) {
+        free(sorted);
+        return 1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        fprintf(out, "%s %" PRIu64 "\n", sorted[i]->text, sorted[i]->count);
+    }
+    free(sorted);
+    return close_output(out, prefix, ".folded");
+}
+
+static int write_json(const aurc_profile *profile, const char *image, const char *prefix) {
+    uint64_t *counts = calloc((size_t)profile->words + 1, sizeof *counts);
+    uint64_t *sampled = calloc((size_t)profile->words + 1, sizeof *sampled);
+    opcode_count opcodes[OPCODE_LIMIT];
+    if (!counts || !sampled) {
+        free(counts);
+        free(sampled);
+        aurc_diag_printf("aurc-native: out of memory writing profile\n");
+        return 1;
+    }
+    uint64_t instructions = 0, samples = 0;
+    for (unsigned w = 0; w < profile->worker_count; ++w) {
+        const aurc_profile_worker *worker = &profile->workers[w];
+        for (uint32_t i = 0; worker->counts && i < profile->words; ++i) {
+            counts[i] += worker->counts[i];
+            sampled[i] += worker->sampled[i];
+        }
+        samples += worker->samples;
+    }
+    for (unsigned op = 0; op < OPCODE_LIMIT; ++op) {
+        opcodes[op] = (opcode_count){op, 0};
+    }
+    for (uint32_t i = 0; i < profile->words; ++i) {
+        opcodes[profile->code[(size_t)i * ISA_WORD_SIZE]].count += counts[i];
+        instructions += counts[i];
+    }
+    qsort(opcodes, OPCODE_LIMIT, sizeof opcodes[0], compare_opcode_counts);
+
+    FILE *out = open_output(prefix, ".json");
+    if (!out) {
+        free(counts);
+        free(sampled);
+        return 1;
+    }
+    fputs("{\n  \"image\": ", out);
+    json_string(out, image);
+    fprintf(out, ",\n  \"sample_interval_us\": %u,\n", AURC_PROFILE_INTERVAL_US);
+    fprintf(out, "  \"instructions\": %" PRIu64 ",\n  \"samples\": %" PRIu64 ",\n", instructions, samples);
+    fputs("  \"opcodes\": [", out);
+    const char *sep = "\n";
+    for (unsigned i = 0; i < OPCODE_LIMIT && opcodes[i].count; ++i) {
+        unsigned op = opcodes[i].opcode;
+        char unknown[8];
+        const char *name = isa_mnemonic((uint8_t)op);
+        if (!name) {
+            snprintf(unknown, sizeof unknown, "0x%02X", op);
+            name = unknown;
+        }
+        fprintf(out, "%s    {\"opcode\": \"%s\", \"count\": %" PRIu64 "}", sep, name, opcodes[i].count);
+        sep = ",\n";
+    }
+    fputs("\n  ],\n  \"labels\": [", out);
+    sep = "\n";
+    for (size_t s = 0; s < profile->symbol_count; ++s) {
+        /* a label covers the words up to the next one; labels sharing an address leave them to the last */
+        const aurc_profile_symbol *symbol = &profile->symbols[s];
+        uint32_t first = (symbol->address + ISA_WORD_SIZE - 1) / ISA_WORD_SIZE;
+        uint32_t end = s + 1 < profile->symbol_count ? (profile->symbols[s + 1].address + ISA_WORD_SIZE - 1) / ISA_WORD_SIZE
+                                                    : profile->words;
+        if (first >= profile->words) {
+            continue;           /* data */
+        }
+        uint64_t executed = 0, hits = 0;
+        for (uint32_t i = first; i < end && i < profile->words; ++i) {
+            executed += counts[i];
+            hits += sampled[i];
+        }
+        fprintf(out, "%s    {\"label\": ", sep);
+        json_string(out, symbol->name);
+        fprintf(out, ", \"address\": %u, \"instructions\": %" PRIu64 ", \"samples\": %" PRIu64 "}",
+                (unsigned)symbol->address, executed, hits);
+        sep = ",\n";
+    }
+    fputs("\n  ],\n  \"workers\": [", out);
+    sep = "\n";
+    for (unsigned w = 0; w < profile->worker_count; ++w) {
+        const aurc_profile_worker *worker = &profile->workers[w];
+        if (!worker->counts) {
+            continue;
+        }
+        uint64_t ran = 0;
+        for (uint32_t i = 0; i < profile->words; ++i) {
+            ran += worker->counts[i];
+        }
+        fprintf(out,
+                "%s    {\"worker\": %u, \"instructions\": %" PRIu64 ", \"samples\": %" PRIu64 ", \"spawns\": %" PRIu64
+                ", \"joins\": %" PRIu64 ", \"joins_waited\": %" PRIu64 ", \"atomic_ops\": %" PRIu64
+                ", \"atomic_line_transfers\": %" PRIu64 ", \"sharded_ops\": %" PRIu64 "}",
+                sep, w, ran, worker->samples, worker->spawns, worker->joins, worker->joins_waited, worker->atomic_ops,
+                worker->atomic_transfers, worker->sharded_ops);
+        sep = ",\n";
+    }
+    fputs("\n  ]\n}\n", out);
+    free(counts);
+    free(sampled);
+    return close_output(out, prefix, ".json");
+}
+
+int aurc_profile_write(const aurc_profile *profile, const char *image, const char *prefix) {
+    int rc = write_folded(profile, prefix);
+    rc |= write_json(profile, image, prefix);
+    return rc;
+}
@@ -0,0 +1,314 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "aurc_source.h"
+#include "aurc_diag.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Slurps a stream that cannot be mapped (pipe, character device) into one heap block. */
+static int read_fallback(aurc_source *src, FILE *fp) {
+    size_t cap = 1 << 16;
+    size_t len = 0;
+    char *data = malloc(cap);
+    if (!data) {
+        aurc_diag_printf("aurc-native: out of memory reading %s\n", src->path);
+        return 1;
+    }
+    for (;;) {
+        len += fread(data + len, 1, cap - len, fp);
+        if (len < cap) {
+            break;
+        }
+        char *grown = realloc(data, cap * 2);
+        if (!grown) {
+            free(data);
+            aurc_diag_printf("aurc-native: out of memory reading %s\n", src->path);
+            return 1;
+        }
+        data = grown;
+        cap *= 2;
+    }
+    if (ferror(fp)) {
+        aurc_diag_printf("aurc-native: cannot read %s: %s\n", src->path, strerror(errno));
+        free(data);
+        return 1;
+    }
+    src->base = data;
+    src->size = len;
+    src->text.data = data;
+    src->text.len = len;
+    return 0;
+}
+
+static int open_fallback(aurc_source *src) {
+    FILE *fp = fopen(src->path, "rb");
+    if (!fp) {
+        aurc_diag_printf("aurc-native: cannot open %s: %s\n", src->path, strerror(errno));
+        return 1;
+    }
+    int rc = read_fallback(src, fp);
+    fclose(fp);
+    return rc;
+}
+
+#ifdef _WIN32
+
+int aurc_source_open(aurc_source *src, const char *path) {
+    memset(src, 0, sizeof *src);
+    src->path = path;
+    src->text.data = "";
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        aurc_diag_printf("aurc-native: cannot open %s (error %lu)\n", path, (unsigned long)GetLastError());
+        return 1;
+    }
+    LARGE_INTEGER size;
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return open_fallback(src);
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        return 0;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return open_fallback(src);
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); /* the view keeps the section alive */
+    if (view == NULL) {
+        return open_fallback(src);
+    }
+    src->base = view;
+    src->size = (size_t)size.QuadPart;
+    src->mapped = 1;
+    src->text.data = view;
+    src->text.len = src->size;
+    return 0;
+}
+
+void aurc_source_close(aurc_source *src) {
+    if (src->mapped) {
+        UnmapViewOfFile(src->base);
+    } else {
+        free(src->base);
+    }
+    memset(src, 0, sizeof *src);
+}
+
+#else
+
+int aurc_source_open(aurc_source *src, const char *path) {
+    memset(src, 0, sizeof *src);
+    src->path = path;
+    src->text.data = "";
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        aurc_diag_printf("aurc-native: cannot open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return open_fallback(src);
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return open_fallback(src);
+    }
+    src->base = view;
+    src->size = (size_t)st.st_size;
+    src->mapped = 1;
+    src->text.data = view;
+    src->text.len = src->size;
+    return 0;
+}
+
+void aurc_source_close(aurc_source *src) {
+    if (src->mapped) {
+        munmap(src->base, src->size);
+    } else {
+        free(src->base);
+    }
+    memset(src, 0, sizeof *src);
+}
+
+#endif
+
+aurc_view aurc_view_of(const char *cstr) {
+    aurc_view view = {cstr, strlen(cstr)};
+    return view;
+}
+
+aurc_view aurc_view_skip_space(aurc_view view) {
+    while (view.len > 0 && isspace((unsigned char)view.data[0])) {
+        view.data++;
+        view.len--;
+    }
+    return view;
+}
+
+aurc_view aurc_view_trim(aurc_view view) {
+    view = aurc_view_skip_space(view);
+    while (view.len > 0 && isspace((unsigned char)view.data[view.len - 1])) {
+        view.len--;
+    }
+    return view;
+}
+
+aurc_view aurc_view_drop(aurc_view view, size_t count) {
+    if (count > view.len) {
+        count = view.len;
+    }
+    view.data += count;
+    view.len -= count;
+    return view;
+}
+
+aurc_view aurc_view_take(aurc_view view, size_t count) {
+    if (count < view.len) {
+        view.len = count;
+    }
+    return view;
+}
+
+int aurc_view_eq(aurc_view view, const char *literal) {
+    size_t len = strlen(literal);
+    return view.len == len && memcmp(view.data, literal, len) == 0;
+}
+
+int aurc_view_equal(aurc_view a, aurc_view b) {
+    return a.len == b.len && (a.len == 0 || memcmp(a.data, b.data, a.len) == 0);
+}
+
+int aurc_view_starts_with(aurc_view view, const char *prefix) {
+    size_t len = strlen(prefix);
+    return view.len >= len && memcmp(view.data, prefix, len) == 0;
+}
+
+size_t aurc_view_find(aurc_view view, const char *needle) {
+    size_t len = strlen(needle);
+    if (len == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i + len <= view.len; ++i) {
+        if (view.data[i] == needle[0] && memcmp(view.data + i, needle, len) == 0) {
+            return i;
+        }
+    }
+    return AURC_VIEW_NPOS;
+}
+
+size_t aurc_view_find_char(aurc_view view, char c) {
+    const char *hit = view.len ? memchr(view.data, c, view.len) : NULL;
+    return hit ? (size_t)(hit - view.data) : AURC_VIEW_NPOS;
+}
+
+size_t aurc_view_rfind_char(aurc_view view, char c) {
+    for (size_t i = view.len; i > 0; --i) {
+        if (view.data[i - 1] == c) {
+            return i - 1;
+        }
+    }
+    return AURC_VIEW_NPOS;
+}
+
+int aurc_view_next_line(aurc_view *rest, aurc_view *line) {
+    if (rest->len == 0) {
+        return 0;
+    }
+    size_t end = aurc_view_find_char(*rest, '\n');
+    if (end == AURC_VIEW_NPOS) {
+        *line = *rest;
+        *rest = aurc_view_drop(*rest, rest->len);
+    } else {
+        *line = aurc_view_take(*rest, end);
+        *rest = aurc_view_drop(*rest, end + 1);
+    }
+    if (line->len > 0 && line->data[line->len - 1] == '\r') {
+        line->len--;
+    }
+    return 1;
+}
+
+int aurc_view_parse_u64(aurc_view view, uint64_t *value) {
+    unsigned base = 10;
+    if (view.len > 2 && view.data[0] == '0' && (view.data[1] == 'x' || view.data[1] == 'X')) {
+        base = 16;
+        view = aurc_view_drop(view, 2);
+    }
+    if (view.len == 0) {
+        return 1;
+    }
+    uint64_t result = 0;
+    for (size_t i = 0; i < view.len; ++i) {
+        int c = (unsigned char)view.data[i];
+        unsigned digit;
+        if (c >= '0' && c <= '9') {
+            digit = (unsigned)(c - '0');
+        } else if (base == 16 && isxdigit(c)) {
+            digit = (unsigned)(tolower(c) - 'a' + 10);
+        } else if (c == '_') {
+            continue;
+        } else {
+            return 1;
+        }
+        if (result > (UINT64_MAX - digit) / base) {
+            return 1;
+        }
+        result = result * base + digit;
+    }
+    *value = result;
+    return 0;
+}
+
+int aurc_view_parse_int(aurc_view view, long long *value) {
+    int negative = 0;
+    if (view.len > 0 && (view.data[0] == '-' || view.data[0] == '+')) {
+        negative = view.data[0] == '-';
+        view = aurc_view_drop(view, 1);
+    }
+    uint64_t magnitude;
+    if (aurc_view_parse_u64(view, &magnitude) != 0) {
+        return 1;
+    }
+    if (magnitude > (uint64_t)LLONG_MAX + (negative ? 1u : 0u)) {
+        return 1;
+    }
+    *value = negative ? (long long)(0 - magnitude) : (long long)magnitude;
+    return 0;
+}
+
+int aurc_view_copy(aurc_view view, char *dst, size_t cap) {
+    if (view.len >= cap) {
+        return 1;
+    }
+    memcpy(dst, view.data, view.len);
+    dst[view.len] = '\0';
+    return 0;
+}
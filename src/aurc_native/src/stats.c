@@ -0,0 +1,163 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "aurc_stats.h"
+#include "aurc_diag.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static const char *const PHASE_NAMES[AURC_PHASE_COUNT] = {
+    "read", "cache", "lex", "parse", "lower", "optimize", "manifest", "image", "exe",
+};
+
+const char *aurc_phase_name(aurc_phase phase) {
+    return phase < AURC_PHASE_COUNT ? PHASE_NAMES[phase] : "?";
+}
+
+#ifdef _WIN32
+
+void aurc_clock_sample_now(aurc_clock_sample *sample) {
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    uint64_t ticks = (uint64_t)counter.QuadPart;
+    uint64_t hz = (uint64_t)frequency.QuadPart;
+    sample->wall_ns = ticks / hz * 1000000000u + ticks % hz * 1000000000u / hz;
+
+    FILETIME created, exited, kernel, user;
+    sample->cpu_ns = 0;
+    if (GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) {
+        uint64_t k = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+        uint64_t u = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+        sample->cpu_ns = (k + u) * 100u;   /* FILETIME counts 100 ns units */
+    }
+}
+
+#else
+
+static uint64_t clock_ns(clockid_t id) {
+    struct timespec ts;
+    if (clock_gettime(id, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void aurc_clock_sample_now(aurc_clock_sample *sample) {
+    sample->wall_ns = clock_ns(CLOCK_MONOTONIC);
+    sample->cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+#endif
+
+void aurc_stats_lap(aurc_compile_stats *stats, aurc_phase phase, aurc_clock_sample *start) {
+    aurc_clock_sample now;
+    aurc_clock_sample_now(&now);
+    stats->wall_ns[phase] += now.wall_ns - start->wall_ns;
+    stats->cpu_ns[phase] += now.cpu_ns - start->cpu_ns;
+    *start = now;
+}
+
+static int phase_ran(const aurc_compile_stats *stats, unsigned phase) {
+    return stats->wall_ns[phase] != 0 || stats->cpu_ns[phase] != 0;
+}
+
+/* ---- --time-report ------------------------------------------------------ */
+
+void aurc_stats_report(const aurc_compile_stats *stats, const char *input) {
+    uint64_t wall = 0;
+    uint64_t cpu = 0;
+    aurc_diag_printf("aurc-native: time report for %s\n", input);
+    aurc_diag_printf("  %-10s %12s %12s\n", "phase", "wall ms", "cpu ms");
+    for (unsigned phase = 0; phase < AURC_PHASE_COUNT; ++phase) {
+        if (!phase_ran(stats, phase)) {
+            continue;
+        }
+        wall += stats->wall_ns[phase];
+        cpu += stats->cpu_ns[phase];
+        aurc_diag_printf("  %-10s %12.3f %12.3f\n", PHASE_NAMES[phase], stats->wall_ns[phase] / 1e6,
+                         stats->cpu_ns[phase] / 1e6);
+    }
+    aurc_diag_printf("  %-10s %12.3f %12.3f\n", "total", wall / 1e6, cpu / 1e6);
+    aurc_diag_printf("  source     %" PRIu64 " bytes, %" PRIu64 " lines, %" PRIu64 " tokens\n", stats->source_bytes,
+                     stats->lines, stats->tokens);
+    aurc_diag_printf("  ir         %" PRIu64 " functions, %" PRIu64 " instructions lowered, %" PRIu64 " optimized\n",
+                     stats->functions, stats->ir_lowered, stats->ir_optimized);
+    aurc_diag_printf("  output     %" PRIu64 " ISA words, %" PRIu64 " x86-64 code bytes, %" PRIu64 " bytes written\n",
+                     stats->isa_words, stats->x86_bytes, stats->bytes_written);
+    if (stats->cache_hits || stats->cache_stores) {
+        aurc_diag_printf("  cache      %s, %" PRIu64 " outputs stored\n", stats->cache_hits ? "hit" : "miss",
+                         stats->cache_stores);
+    }
+}
+
+/* ---- --stats-json ------------------------------------------------------- */
+
+static void json_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *)text; *p; ++p) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if (*p < 0x20) {
+            fprintf(out, "\\u%04x", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+int aurc_stats_write_json(const aurc_compile_stats *stats, const char *input, const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        aurc_diag_printf("aurc-native: cannot open %s for writing: %s\n", path, strerror(errno));
+        return 1;
+    }
+    fputs("{\n  \"input\": ", out);
+    json_string(out, input);
+    fputs(",\n  \"phases\": {", out);
+    const char *sep = "\n";
+    for (unsigned phase = 0; phase < AURC_PHASE_COUNT; ++phase) {
+        if (!phase_ran(stats, phase)) {
+            continue;
+        }
+        fprintf(out, "%s    \"%s\": {\"wall_ns\": %" PRIu64 ", \"cpu_ns\": %" PRIu64 "}", sep, PHASE_NAMES[phase],
+                stats->wall_ns[phase], stats->cpu_ns[phase]);
+        sep = ",\n";
+    }
+    fputs("\n  },\n  \"counters\": {\n", out);
+    fprintf(out, "    \"source_bytes\": %" PRIu64 ",\n", stats->source_bytes);
+    fprintf(out, "    \"lines\": %" PRIu64 ",\n", stats->lines);
+    fprintf(out, "    \"tokens\": %" PRIu64 ",\n", stats->tokens);
+    fprintf(out, "    \"functions\": %" PRIu64 ",\n", stats->functions);
+    fprintf(out, "    \"ir_lowered\": %" PRIu64 ",\n", stats->ir_lowered);
+    fprintf(out, "    \"ir_optimized\": %" PRIu64 ",\n", stats->ir_optimized);
+    fprintf(out, "    \"isa_words\": %" PRIu64 ",\n", stats->isa_words);
+    fprintf(out, "    \"x86_bytes\": %" PRIu64 ",\n", stats->x86_bytes);
+    fprintf(out, "    \"bytes_written\": %" PRIu64 ",\n", stats->bytes_written);
+    fprintf(out, "    \"cache_hits\": %" PRIu64 ",\n", stats->cache_hits);
+    fprintf(out, "    \"cache_stores\": %" PRIu64 "\n", stats->cache_stores);
+    fputs("  }\n}\n", out);
+    int rc = 0;
+    if (ferror(out)) {
+        aurc_diag_printf("aurc-native: cannot write %s: %s\n", path, strerror(errno));
+        rc = 1;
+    }
+    if (fclose(out) != 0) {
+        rc = 1;
+    }
+    return rc;
+}
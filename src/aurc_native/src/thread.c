@@ -0,0 +1,161 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "aurc_thread.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_entry(LPVOID param) {
+    aurc_thread *thread = param;
+    thread->result = thread->fn(thread->arg);
+    return 0;
+}
+
+int aurc_thread_start(aurc_thread *thread, aurc_thread_fn fn, void *arg) {
+    thread->fn = fn;
+    thread->arg = arg;
+    thread->result = 0;
+    thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+    return thread->handle == NULL;
+}
+
+int aurc_thread_join(aurc_thread *thread, int *result) {
+    if (WaitForSingleObject(thread->handle, INFINITE) != WAIT_OBJECT_0) {
+        return 1;
+    }
+    CloseHandle(thread->handle);
+    if (result) {
+        *result = thread->result;
+    }
+    return 0;
+}
+
+int aurc_mutex_init(aurc_mutex *mutex) {
+    InitializeCriticalSection(&mutex->cs);
+    return 0;
+}
+
+void aurc_mutex_destroy(aurc_mutex *mutex) {
+    DeleteCriticalSection(&mutex->cs);
+}
+
+void aurc_mutex_lock(aurc_mutex *mutex) {
+    EnterCriticalSection(&mutex->cs);
+}
+
+void aurc_mutex_unlock(aurc_mutex *mutex) {
+    LeaveCriticalSection(&mutex->cs);
+}
+
+int aurc_cond_init(aurc_cond *cond) {
+    InitializeConditionVariable(&cond->cv);
+    return 0;
+}
+
+void aurc_cond_destroy(aurc_cond *cond) {
+    (void)cond; /* Win32 condition variables own no resources */
+}
+
+void aurc_cond_wait(aurc_cond *cond, aurc_mutex *mutex) {
+    SleepConditionVariableCS(&cond->cv, &mutex->cs, INFINITE);
+}
+
+void aurc_cond_signal(aurc_cond *cond) {
+    WakeConditionVariable(&cond->cv);
+}
+
+void aurc_cond_broadcast(aurc_cond *cond) {
+    WakeAllConditionVariable(&cond->cv);
+}
+
+unsigned aurc_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (unsigned)info.dwNumberOfProcessors : 1u;
+}
+
+void aurc_sleep_us(unsigned us) {
+    Sleep((us + 999) / 1000);
+}
+
+#else
+
+static void *thread_entry(void *param) {
+    aurc_thread *thread = param;
+    thread->result = thread->fn(thread->arg);
+    return NULL;
+}
+
+int aurc_thread_start(aurc_thread *thread, aurc_thread_fn fn, void *arg) {
+    thread->fn = fn;
+    thread->arg = arg;
+    thread->result = 0;
+    return pthread_create(&thread->handle, NULL, thread_entry, thread) != 0;
+}
+
+int aurc_thread_join(aurc_thread *thread, int *result) {
+    if (pthread_join(thread->handle, NULL) != 0) {
+        return 1;
+    }
+    if (result) {
+        *result = thread->result;
+    }
+    return 0;
+}
+
+int aurc_mutex_init(aurc_mutex *mutex) {
+    return pthread_mutex_init(&mutex->mutex, NULL) != 0;
+}
+
+void aurc_mutex_destroy(aurc_mutex *mutex) {
+    pthread_mutex_destroy(&mutex->mutex);
+}
+
+void aurc_mutex_lock(aurc_mutex *mutex) {
+    pthread_mutex_lock(&mutex->mutex);
+}
+
+void aurc_mutex_unlock(aurc_mutex *mutex) {
+    pthread_mutex_unlock(&mutex->mutex);
+}
+
+int aurc_cond_init(aurc_cond *cond) {
+    return pthread_cond_init(&cond->cv, NULL) != 0;
+}
+
+void aurc_cond_destroy(aurc_cond *cond) {
+    pthread_cond_destroy(&cond->cv);
+}
+
+void aurc_cond_wait(aurc_cond *cond, aurc_mutex *mutex) {
+    pthread_cond_wait(&cond->cv, &mutex->mutex);
+}
+
+void aurc_cond_signal(aurc_cond *cond) {
+    pthread_cond_signal(&cond->cv);
+}
+
+void aurc_cond_broadcast(aurc_cond *cond) {
+    pthread_cond_broadcast(&cond->cv);
+}
+
+unsigned aurc_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (unsigned)count : 1u;
+}
+
+void aurc_sleep_us(unsigned us) {
+    struct timespec delay = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+        /* interrupted: sleep the rest */
+    }
+}
+
+#endif
@@ -0,0 +1,2013 @@
+#include "aurc_native.h"
+#include "aurc_bignum.h"
+#include "aurc_image.h"
+#include "aurc_jit.h"
+#include "aurc_pool.h"
+#include "aurc_profile.h"
+#include "aurc_source.h"
+#include "aurc_thread.h"
+#include "aurc_vm.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Scheduler. A fixed pool of workers (the calling thread is worker 0) runs
+ * tasks M:N: spawn is a push onto the spawning worker's deque, so it costs a
+ * lock and a ring slot, never a thread creation. A worker pops its own deque
+ * from the bottom (the most recently spawned task, still warm) and, when that
+ * runs dry, steals from the top of the others'. Workers with nothing to steal
+ * sleep on one condition variable; `queued` counts tasks sitting in deques
+ * and `sleepers` the workers waiting for one, which is enough for a pusher to
+ * skip the wake-up when nobody sleeps without ever losing one.
+ *
+ * join on a task that has not finished parks the joiner on the target's
+ * waiter list under the scheduler lock; the finishing task puts its waiters
+ * back on its worker's deque. Task records are never reused, so a handle
+ * stays valid for the whole run; finished tasks give their stack back to
+ * their worker's pool cache, where the next spawn on that worker finds it. A
+ * stack access below a task's stack grows it (grow_stack): the contents move
+ * to the top of a block twice the size, so addresses stay put. A task that
+ * runs for a whole slice while others wait in the deques goes to the back of
+ * the line.
+ *
+ * Sharded counters (atomic words flagged ISA_ATOMIC_SHARDED) get one partial
+ * sum per worker and shared line: atomic_add only touches the adding
+ * worker's own row, with a plain load and store since nobody else writes it,
+ * and atomic_load adds the slot itself to every row. Rows are a multiple of
+ * a cache line apart and line-aligned, so concurrent adders never share a
+ * line. Before the first spawn there is only one task and sharded words act
+ * on the slot directly. A sharded load is not a snapshot: adds that race
+ * with it may or may not be counted, but once every adder has been joined
+ * the sum is exact.
+ *
+ * Bignums live in slots allocated in fixed chunks, like task records, so a
+ * slot never moves. Each slot counts references: one for the table entry
+ * behind its handle and one per service call currently reading it. Calls
+ * take their operands' references under the table lock, compute with the
+ * lock released, and put the result in a fresh slot; bignum_free unlists the
+ * handle and drops the table's reference, and whoever drops the last one
+ * recycles the slot.
+ */
+
+#define VM_SLICE 1024u          /* taken branches between checks for other work or a stop */
+#define VM_TASK_CHUNK 256u
+#define VM_TASK_CHUNKS 256u     /* at most 64 Ki tasks per run */
+#define VM_MAX_WORKERS 64u
+#define VM_OUT_BUFFER 4096u     /* stdout bytes a task collects before writing them out */
+#define VM_PAIR_REPORT 24u      /* pairs `run --pair-profile` lists */
+#define VM_BIGNUM_CHUNK 1024u
+#define VM_BIGNUM_CHUNKS 1024u  /* at most 1 Mi live bignums per run */
+#define VM_JIT_THRESHOLD 1000u  /* back edges one worker takes to a loop head before the loop is compiled */
+#define VM_JIT_FAILED (-1)      /* loops entry for a head that did not compile */
+
+typedef enum vm_outcome {
+    VM_TASK_YIELD,              /* slice used up; still runnable */
+    VM_TASK_PARKED,             /* blocked in join */
+    VM_TASK_FINISHED,
+    VM_TASK_STOPPED             /* the whole program stopped */
+} vm_outcome;
+
+typedef struct vm_deque {
+    aurc_mutex lock;
+    uint32_t *items;            /* ring of task ids, capacity a power of two */
+    size_t cap;
+    size_t top;                 /* thieves take from here */
+    size_t bottom;              /* the owner pushes and pops here */
+} vm_deque;
+
+typedef struct vm_worker {
+    aurc_vm *vm;
+    unsigned index;
+    aurc_thread thread;
+    vm_deque deque;
+} vm_worker;
+
+struct aurc_vm_sched {
+    aurc_mutex lock;            /* task table, join/finish hand-off and sleeping */
+    aurc_cond idle;
+    vm_worker *workers;
+    unsigned worker_count;
+    unsigned started;           /* workers running, worker 0 included */
+    int64_t queued;             /* atomic */
+    int64_t sleepers;           /* atomic, only changed under lock */
+    aurc_vm_task *chunks[VM_TASK_CHUNKS];
+    uint32_t task_count;        /* ids handed out so far, the main task included */
+    uint32_t shard_lines;       /* shared lines in the image */
+    int64_t *shards;            /* worker_count rows of shard_lines partial sums */
+    void *shards_block;
+};
+
+typedef struct vm_bignum {
+    aurc_bn value;
+    uint32_t refs;              /* 0 for a free slot */
+    uint32_t next_free;
+    int listed;                 /* the handle still names it: bignum_free not called yet */
+} vm_bignum;
+
+struct aurc_vm_bignums {
+    aurc_mutex lock;            /* slot allocation and reference counts */
+    vm_bignum *chunks[VM_BIGNUM_CHUNKS];
+    uint32_t count;             /* slots handed out so far */
+    uint32_t free_head;         /* UINT32_MAX when no slot is free */
+};
+
+struct aurc_vm_heap {
+    aurc_pool pool;
+    aurc_pool_cache caches[VM_MAX_WORKERS]; /* each used only by its worker */
+};
+
+struct aurc_vm_jit {
+    aurc_mutex lock;            /* compiles, one at a time */
+    aurc_jit_image image;
+    int64_t *loops;             /* atomic, per op: 0 untried, VM_JIT_FAILED, or the aurc_jit_loop headed there */
+    uint32_t *hot[VM_MAX_WORKERS]; /* per worker, allocated by it: back edges taken to each op */
+};
+
+/* Zeroed allocation starting on a cache line; *block receives the pointer to free. */
+static void *alloc_lines(size_t size, void **block) {
+    uint8_t *raw = calloc(1, size + ISA_SHARED_STRIDE - 1);
+    *block = raw;
+    if (!raw) {
+        return NULL;
+    }
+    return raw + (ISA_SHARED_STRIDE - (uintptr_t)raw % ISA_SHARED_STRIDE) % ISA_SHARED_STRIDE;
+}
+
+/* Writes out what the task's prints collected so far. */
+static int task_flush(aurc_vm_task *task) {
+    if (task->out_len == 0) {
+        return 0;
+    }
+    size_t len = task->out_len;
+    task->out_len = 0;
+    if (fwrite(task->out, 1, len, stdout) != len || fflush(stdout) != 0) {
+        perror("aurc-native: vm write");
+        return 1;
+    }
+    return 0;
+}
+
+/* Appends print output to the task's buffer, writing it out when it fills. */
+static int task_write(aurc_vm *vm, unsigned self, aurc_vm_task *task, const void *data, size_t len) {
+    if (!task->out) {
+        task->out = aurc_pool_take(&vm->heap->caches[self], VM_OUT_BUFFER, NULL);
+    }
+    if (task->out && len <= VM_OUT_BUFFER - task->out_len) {
+        memcpy(task->out + task->out_len, data, len);
+        task->out_len += (uint32_t)len;
+        return 0;
+    }
+    if (task_flush(task) != 0) {
+        return 1;
+    }
+    if (task->out && len < VM_OUT_BUFFER) {
+        memcpy(task->out, data, len);
+        task->out_len = (uint32_t)len;
+        return 0;
+    }
+    /* too long to buffer, or no memory for a buffer: straight through */
+    if (fwrite(data, 1, len, stdout) != len || fflush(stdout) != 0) {
+        perror("aurc-native: vm write");
+        return 1;
+    }
+    return 0;
+}
+
+/* Flushes the task's output and gives its buffer back through cache. */
+static int task_release_out(aurc_pool_cache *cache, aurc_vm_task *task) {
+    int status = task_flush(task);
+    aurc_pool_give(cache, task->out, VM_OUT_BUFFER);
+    task->out = NULL;
+    return status;
+}
+
+static int vm_fault(aurc_vm_task *task, const char *message) {
+    /* the fault message follows everything the task printed */
+    task_flush(task);
+    fprintf(stderr, "aurc-native: vm fault at 0x%04X: %s\n", (unsigned)task->pc, message);
+    return 1;
+}
+
+static void task_reset(aurc_vm_task *task, uint8_t *stack, uint32_t stack_low, uint32_t pc) {
+    memset(task->regs, 0, sizeof task->regs);
+    task->regs[ISA_REG_SP] = AURC_VM_ARENA_SIZE;
+    task->pc = pc;
+    task->compare = 0;
+    task->state = AURC_VM_TASK_RUNNABLE;
+    task->stack = stack;
+    task->stack_low = stack_low;
+    task->waiters = AURC_VM_NO_TASK;
+    task->next_waiter = AURC_VM_NO_TASK;
+    task->out = NULL;
+    task->out_len = 0;
+}
+
+/* The shared lines [0, image_size) spans. */
+static uint32_t shard_lines(const aurc_vm *vm) {
+    return (vm->image_size + ISA_SHARED_STRIDE - 1) / ISA_SHARED_STRIDE;
+}
+
+/* Backs [0, image_size) with a zeroed arena and gives the main task its first stack. */
+static int vm_reset(aurc_vm *vm, size_t image_size, const char *path) {
+    vm->image_size = (uint32_t)image_size;
+    vm->stopped = 0;
+    vm->exit_status = 0;
+    vm->faulted = 0;
+    vm->worker_limit = 0;
+    vm->sched = NULL;
+    vm->bignums = NULL;
+    vm->arena = alloc_lines(image_size, &vm->arena_block);
+    vm->heap = calloc(1, sizeof *vm->heap);
+    if (!vm->arena || !vm->heap || aurc_pool_init(&vm->heap->pool) != 0) {
+        fprintf(stderr, "aurc-native: out of memory loading image %s\n", path);
+        free(vm->heap);
+        vm->heap = NULL;
+        return 1;
+    }
+    for (unsigned w = 0; w < VM_MAX_WORKERS; ++w) {
+        aurc_pool_cache_init(&vm->heap->caches[w], &vm->heap->pool);
+    }
+    uint32_t size = AURC_VM_ARENA_SIZE - (uint32_t)image_size < AURC_VM_TASK_STACK ? AURC_VM_ARENA_SIZE - (uint32_t)image_size
+                                                                                   : AURC_VM_TASK_STACK;
+    uint8_t *stack = aurc_pool_take(&vm->heap->caches[0], size, NULL);
+    if (!stack) {
+        fprintf(stderr, "aurc-native: out of memory loading image %s\n", path);
+        return 1;
+    }
+    memset(stack, 0, size);
+    task_reset(&vm->main, stack, AURC_VM_ARENA_SIZE - size, 0);
+    return 0;
+}
+
+/*
+ * Grows task's stack down to cover [low, AURC_VM_ARENA_SIZE), doubling it;
+ * fails when low lies above the stack or below the image, or memory runs out.
+ */
+static int grow_stack(aurc_vm *vm, unsigned self, aurc_vm_task *task, uint64_t low) {
+    if (low >= task->stack_low || low < vm->image_size) {
+        return 1;
+    }
+    aurc_pool_cache *cache = &vm->heap->caches[self];
+    size_t size = AURC_VM_ARENA_SIZE - task->stack_low;
+    size_t grown = size * 2;
+    while (AURC_VM_ARENA_SIZE - grown > low && grown < AURC_VM_ARENA_SIZE) {
+        grown *= 2;
+    }
+    if (grown > AURC_VM_ARENA_SIZE - vm->image_size) {
+        grown = AURC_VM_ARENA_SIZE - vm->image_size;
+    }
+    uint8_t *stack = aurc_pool_take(cache, grown, NULL);
+    if (!stack) {
+        return 1;
+    }
+    memset(stack, 0, grown - size);
+    memcpy(stack + (grown - size), task->stack, size);
+    aurc_pool_give(cache, task->stack, size);
+    task->stack = stack;
+    task->stack_low = (uint32_t)(AURC_VM_ARENA_SIZE - grown);
+    return 0;
+}
+
+static int vm_decode(aurc_vm *vm);
+
+int aurc_vm_load(aurc_vm *vm, const uint8_t *image, size_t size, const char *path) {
+    if (!aurc_image_is_container(image, size)) {
+        if (size > AURC_VM_ARENA_SIZE - AURC_VM_TASK_STACK) {
+            fprintf(stderr, "aurc-native: image %s exceeds %u-byte arena\n", path, AURC_VM_ARENA_SIZE - AURC_VM_TASK_STACK);
+            return 1;
+        }
+        if (vm_reset(vm, size, path) != 0) {
+            return 1;
+        }
+        if (size > 0) {
+            memcpy(vm->arena, image, size);
+        }
+        vm->rom = vm->arena;
+        vm->rom_size = (uint32_t)size;
+        vm->code_size = (uint32_t)size;
+        vm->shared_low = 0;
+        vm->symbols = NULL;
+        vm->symbols_size = 0;
+        return vm_decode(vm);
+    }
+
+    aurc_image_view view;
+    if (aurc_image_parse(image, size, path, &view) != 0) {
+        return 1;
+    }
+    if (view.address_space > AURC_VM_ARENA_SIZE - AURC_VM_TASK_STACK) {
+        fprintf(stderr, "aurc-native: image %s needs %u bytes, more than the %u-byte arena\n", path,
+                (unsigned)view.address_space, AURC_VM_ARENA_SIZE - AURC_VM_TASK_STACK);
+        return 1;
+    }
+    if (vm_reset(vm, view.address_space, path) != 0) {
+        return 1;
+    }
+    if (view.shared) {
+        memcpy(vm->arena + view.shared_base, view.shared, view.shared_size);
+    }
+    vm->rom = view.rom;
+    vm->rom_size = view.rom_size;
+    vm->code_size = view.code_size;
+    vm->shared_low = view.shared ? view.shared_base : view.address_space;
+    vm->main.pc = view.entry;
+    vm->symbols = view.symbols;
+    vm->symbols_size = view.symbols_size;
+    return vm_decode(vm);
+}
+
+static aurc_vm_task *task_at(aurc_vm *vm, uint32_t id) {
+    if (id == AURC_VM_MAIN_TASK) {
+        return &vm->main;
+    }
+    return &vm->sched->chunks[id / VM_TASK_CHUNK][id % VM_TASK_CHUNK];
+}
+
+/* Ends the program; the first stop decides the exit status. */
+static void vm_stop(aurc_vm *vm, int exit_status, int fault) {
+    aurc_vm_sched *sched = vm->sched;
+    if (sched) {
+        aurc_mutex_lock(&sched->lock);
+    }
+    if (!aurc_atomic_load64(&vm->stopped)) {
+        vm->exit_status = exit_status;
+        vm->faulted = fault;
+        aurc_atomic_store64(&vm->stopped, 1);
+    }
+    if (sched) {
+        aurc_cond_broadcast(&sched->idle);
+        aurc_mutex_unlock(&sched->lock);
+    }
+}
+
+/* ---- run queues --------------------------------------------------------- */
+
+static int deque_push(vm_deque *deque, uint32_t id) {
+    aurc_mutex_lock(&deque->lock);
+    if (deque->bottom - deque->top == deque->cap) {
+        size_t cap = deque->cap ? deque->cap * 2 : 64;
+        uint32_t *items = malloc(cap * sizeof *items);
+        if (!items) {
+            aurc_mutex_unlock(&deque->lock);
+            return 1;
+        }
+        for (size_t i = deque->top; i < deque->bottom; ++i) {
+            items[i & (cap - 1)] = deque->items[i & (deque->cap - 1)];
+        }
+        free(deque->items);
+        deque->items = items;
+        deque->cap = cap;
+    }
+    deque->items[deque->bottom++ & (deque->cap - 1)] = id;
+    aurc_mutex_unlock(&deque->lock);
+    return 0;
+}
+
+static uint32_t deque_pop(vm_deque *deque) {
+    uint32_t id = AURC_VM_NO_TASK;
+    aurc_mutex_lock(&deque->lock);
+    if (deque->top < deque->bottom) {
+        id = deque->items[--deque->bottom & (deque->cap - 1)];
+    }
+    aurc_mutex_unlock(&deque->lock);
+    return id;
+}
+
+static uint32_t deque_steal(vm_deque *deque) {
+    uint32_t id = AURC_VM_NO_TASK;
+    aurc_mutex_lock(&deque->lock);
+    if (deque->top < deque->bottom) {
+        id = deque->items[deque->top++ & (deque->cap - 1)];
+    }
+    aurc_mutex_unlock(&deque->lock);
+    return id;
+}
+
+static int push_task(aurc_vm *vm, unsigned self, uint32_t id) {
+    aurc_vm_sched *sched = vm->sched;
+    if (deque_push(&sched->workers[self].deque, id) != 0) {
+        fprintf(stderr, "aurc-native: out of memory queueing vm task\n");
+        return 1;
+    }
+    aurc_atomic_add64(&sched->queued, 1);
+    if (aurc_atomic_load64(&sched->sleepers) > 0) {
+        aurc_mutex_lock(&sched->lock);
+        aurc_cond_signal(&sched->idle);
+        aurc_mutex_unlock(&sched->lock);
+    }
+    return 0;
+}
+
+/* Own deque first, then every other worker's in turn. */
+static uint32_t try_take(aurc_vm_sched *sched, unsigned self) {
+    uint32_t id = deque_pop(&sched->workers[self].deque);
+    for (unsigned k = 1; id == AURC_VM_NO_TASK && k < sched->worker_count; ++k) {
+        id = deque_steal(&sched->workers[(self + k) % sched->worker_count].deque);
+    }
+    if (id != AURC_VM_NO_TASK) {
+        aurc_atomic_add64(&sched->queued, -1);
+    }
+    return id;
+}
+
+/* Blocks until a task is available; AURC_VM_NO_TASK once the program stops. */
+static uint32_t take_task(aurc_vm *vm, unsigned self) {
+    aurc_vm_sched *sched = vm->sched;
+    for (;;) {
+        if (aurc_atomic_load64(&vm->stopped)) {
+            return AURC_VM_NO_TASK;
+        }
+        uint32_t id = try_take(sched, self);
+        if (id != AURC_VM_NO_TASK) {
+            return id;
+        }
+        aurc_mutex_lock(&sched->lock);
+        int64_t sleepers = aurc_atomic_add64(&sched->sleepers, 1) + 1;
+        if (aurc_atomic_load64(&sched->queued) == 0 && !aurc_atomic_load64(&vm->stopped)) {
+            if (sleepers == (int64_t)sched->started) {
+                /* nobody is running and nothing is queued: every task left waits in join */
+                aurc_mutex_unlock(&sched->lock);
+                fprintf(stderr, "aurc-native: vm deadlock: every task is blocked in join\n");
+                vm_stop(vm, 0, 1);
+                aurc_mutex_lock(&sched->lock);
+            } else {
+                aurc_cond_wait(&sched->idle, &sched->lock);
+            }
+        }
+        aurc_atomic_add64(&sched->sleepers, -1);
+        aurc_mutex_unlock(&sched->lock);
+    }
+}
+
+/* ---- tasks -------------------------------------------------------------- */
+
+static int start_sched(aurc_vm *vm);
+
+static int vm_spawn(aurc_vm *vm, unsigned self, aurc_vm_task *parent, uint32_t pc, uint32_t *handle) {
+    if (!vm->sched && start_sched(vm) != 0) {
+        return vm_fault(parent, "cannot start vm workers");
+    }
+    aurc_vm_sched *sched = vm->sched;
+    aurc_mutex_lock(&sched->lock);
+    uint32_t id = sched->task_count;
+    uint32_t chunk = id / VM_TASK_CHUNK;
+    if (chunk >= VM_TASK_CHUNKS) {
+        aurc_mutex_unlock(&sched->lock);
+        return vm_fault(parent, "too many tasks spawned");
+    }
+    if (!sched->chunks[chunk]) {
+        sched->chunks[chunk] = calloc(VM_TASK_CHUNK, sizeof **sched->chunks);
+    }
+    uint8_t *stack = aurc_pool_take(&vm->heap->caches[self], AURC_VM_TASK_STACK, NULL);
+    if (!sched->chunks[chunk] || !stack) {
+        aurc_pool_give(&vm->heap->caches[self], stack, AURC_VM_TASK_STACK);
+        aurc_mutex_unlock(&sched->lock);
+        return vm_fault(parent, "out of memory spawning task");
+    }
+    aurc_vm_task *task = task_at(vm, id);
+    task_reset(task, stack, AURC_VM_ARENA_SIZE - AURC_VM_TASK_STACK, pc);
+    memcpy(&task->regs[ISA_REG_R1], &parent->regs[ISA_REG_R1], (ISA_REGISTER_COUNT - 1) * sizeof task->regs[0]);
+    sched->task_count++;
+    aurc_mutex_unlock(&sched->lock);
+
+    *handle = id;
+    if (vm->profile) {
+        aurc_profile_task_start(vm->profile, id, pc / ISA_WORD_SIZE);
+    }
+    return push_task(vm, self, id) != 0 ? vm_fault(parent, "cannot queue spawned task") : 0;
+}
+
+/* Parks the joiner unless target already finished; *parked tells which. */
+static int vm_join(aurc_vm *vm, uint32_t self_id, aurc_vm_task *joiner, uint64_t handle, int *parked) {
+    aurc_vm_sched *sched = vm->sched;
+    *parked = 0;
+    if (handle == self_id) {
+        return vm_fault(joiner, "task joins itself");
+    }
+    if (!sched) {
+        return vm_fault(joiner, "join on an invalid task handle");
+    }
+    aurc_mutex_lock(&sched->lock);
+    if (handle >= sched->task_count) {
+        aurc_mutex_unlock(&sched->lock);
+        return vm_fault(joiner, "join on an invalid task handle");
+    }
+    aurc_vm_task *target = task_at(vm, (uint32_t)handle);
+    if (target->state != AURC_VM_TASK_DONE) {
+        joiner->state = AURC_VM_TASK_BLOCKED;
+        joiner->next_waiter = target->waiters;
+        target->waiters = self_id;
+        *parked = 1;
+    } else {
+        joiner->regs[ISA_REG_R0] = target->regs[ISA_REG_R0];
+    }
+    aurc_mutex_unlock(&sched->lock);
+    return 0;
+}
+
+static int finish_task(aurc_vm *vm, unsigned self, aurc_vm_task *task) {
+    aurc_vm_sched *sched = vm->sched;
+    /* a joiner's prints come after the task's, so they go out before it is marked done */
+    if (task_release_out(&vm->heap->caches[self], task) != 0) {
+        return 1;
+    }
+    aurc_mutex_lock(&sched->lock);
+    task->state = AURC_VM_TASK_DONE;
+    uint32_t waiter = task->waiters;
+    task->waiters = AURC_VM_NO_TASK;
+    for (uint32_t w = waiter; w != AURC_VM_NO_TASK; w = task_at(vm, w)->next_waiter) {
+        /* join hands over the return value the task's outermost ret left in r0 */
+        task_at(vm, w)->regs[ISA_REG_R0] = task->regs[ISA_REG_R0];
+        task_at(vm, w)->state = AURC_VM_TASK_RUNNABLE;
+    }
+    aurc_mutex_unlock(&sched->lock);
+    /* nobody reads a finished task's stack: join only takes its r0 */
+    aurc_pool_give(&vm->heap->caches[self], task->stack, AURC_VM_ARENA_SIZE - task->stack_low);
+    task->stack = NULL;
+
+    /* the waiters are off every list now, nobody else touches them until they are queued */
+    while (waiter != AURC_VM_NO_TASK) {
+        uint32_t next = task_at(vm, waiter)->next_waiter;
+        if (push_task(vm, self, waiter) != 0) {
+            return 1;
+        }
+        waiter = next;
+    }
+    return 0;
+}
+
+/* ---- decoded code ------------------------------------------------------- */
+
+/*
+ * aurc_vm_load decodes the code section once, into one aurc_vm_op per
+ * instruction word: operands unpacked, immediates sign-extended, branch
+ * targets turned into op indices, and registers, conditions and atomic slots
+ * checked. An encoding the interpreter would refuse becomes a VM_OP_INVALID
+ * op holding the reason, so it still faults only if it runs. run_task then goes straight
+ * from op to op: under GCC and Clang each op holds the address of its handler
+ * (computed goto); elsewhere, or with AURC_VM_SWITCH_DISPATCH defined, a
+ * switch on the op kind does the same job. Targets that are not on an
+ * instruction word inside the code resolve to the VM_OP_END op past the last
+ * one, which faults.
+ *
+ * Superinstructions: where a pair listed in VM_FUSED_PAIRS appears in the
+ * code, the first op of the pair takes the fused kind, whose handler does the
+ * work of both and continues two ops on. The second op keeps its own kind, so
+ * a jump to it still runs it alone. The pairs are the most frequent ones `run
+ * --pair-profile` counts over the examples; where the second half of a pair
+ * could fault, its handler checks first and otherwise runs the first op on
+ * its own, so faults still name the instruction that raised them.
+ */
+
+#if defined(__GNUC__) && !defined(AURC_VM_SWITCH_DISPATCH)
+#define VM_THREADED 1
+#endif
+
+#define VM_OP_KINDS(X)                                                                                        \
+    X(NOP, "nop") X(MOV_IMM, "mov_ri") X(MOV_REG, "mov_rr") X(NOT, "not")                                     \
+    X(ADD_REG, "add_rr") X(ADD_IMM, "add_ri") X(SUB_REG, "sub_rr") X(SUB_IMM, "sub_ri")                       \
+    X(MUL_REG, "mul_rr") X(MUL_IMM, "mul_ri") X(DIV_REG, "div_rr") X(DIV_IMM, "div_ri")                       \
+    X(REM_REG, "rem_rr") X(REM_IMM, "rem_ri") X(AND_REG, "and_rr") X(AND_IMM, "and_ri")                       \
+    X(OR_REG, "or_rr") X(OR_IMM, "or_ri") X(XOR_REG, "xor_rr") X(XOR_IMM, "xor_ri")                           \
+    X(SHL_REG, "shl_rr") X(SHL_IMM, "shl_ri") X(SHR_REG, "shr_rr") X(SHR_IMM, "shr_ri")                       \
+    X(PUSH, "push") X(POP, "pop") X(STORE_STACK, "store_stack") X(LOAD_STACK, "load_stack")                   \
+    X(CMP_REG, "cmp_rr") X(CMP_IMM, "cmp_ri") X(JMP, "jmp") X(CJMP, "cjmp") X(CALL, "call") X(RET, "ret")     \
+    X(SVC, "svc") X(HALT, "halt") X(SPAWN, "spawn") X(JOIN, "join")                                           \
+    X(ATOMIC_LOAD, "atomic_load") X(ATOMIC_STORE, "atomic_store") X(ATOMIC_ADD, "atomic_add")                 \
+    X(SHARDED_LOAD, "atomic_load.sharded") X(SHARDED_ADD, "atomic_add.sharded")                               \
+    X(INVALID, "invalid") X(END, "end")                                                                       \
+    X(CMP_IMM_CJMP, "cmp_ri+cjmp") X(CMP_REG_CJMP, "cmp_rr+cjmp") X(ADD_IMM_JMP, "add_ri+jmp")                \
+    X(MOV_REG_MOV_REG, "mov_rr+mov_rr") X(MUL_IMM_ADD_IMM, "mul_ri+add_ri")                                   \
+    X(PUSH_PUSH, "push+push") X(POP_POP, "pop+pop")                                                           \
+    X(PROFILE, "profile")
+
+typedef enum vm_op_kind {
+#define VM_OP_ENUM(name, text) VM_OP_##name,
+    VM_OP_KINDS(VM_OP_ENUM)
+#undef VM_OP_ENUM
+    VM_OP_KIND_COUNT
+} vm_op_kind;
+
+static const char *const VM_OP_NAMES[VM_OP_KIND_COUNT] = {
+#define VM_OP_NAME(name, text) text,
+    VM_OP_KINDS(VM_OP_NAME)
+#undef VM_OP_NAME
+};
+
+typedef enum vm_invalid_reason {
+    VM_BAD_REGISTER = 0,
+    VM_BAD_CONDITION,
+    VM_BAD_OPCODE,              /* the opcode is in imm */
+    VM_BAD_SHARED_SLOT,
+    VM_BAD_SHARDED_STORE
+} vm_invalid_reason;
+
+struct aurc_vm_op {
+    const void *handler;        /* threaded dispatch: the label of kind's handler in run_task */
+    int64_t imm;                /* immediate, shared slot address, spawn pc or opcode of an invalid op */
+    uint32_t target;            /* branch target as an op index */
+    uint8_t kind;               /* what runs: the op, a superinstruction starting with it, or VM_OP_PROFILE */
+    uint8_t op;                 /* the op itself, never fused */
+    uint8_t a, b, c;            /* registers in operand order; cjmp keeps its condition mask in c */
+};
+
+typedef struct vm_fused_pair {
+    uint8_t first;
+    uint8_t second;
+    uint8_t fused;
+} vm_fused_pair;
+
+static const vm_fused_pair VM_FUSED_PAIRS[] = {
+    {VM_OP_CMP_IMM, VM_OP_CJMP, VM_OP_CMP_IMM_CJMP},     /* loop and if tests */
+    {VM_OP_CMP_REG, VM_OP_CJMP, VM_OP_CMP_REG_CJMP},
+    {VM_OP_ADD_IMM, VM_OP_JMP, VM_OP_ADD_IMM_JMP},       /* induction step and back edge */
+    {VM_OP_MOV_REG, VM_OP_MOV_REG, VM_OP_MOV_REG_MOV_REG}, /* argument and result shuffles around calls */
+    {VM_OP_MUL_IMM, VM_OP_ADD_IMM, VM_OP_MUL_IMM_ADD_IMM},
+    {VM_OP_PUSH, VM_OP_PUSH, VM_OP_PUSH_PUSH},           /* saving callee registers */
+    {VM_OP_POP, VM_OP_POP, VM_OP_POP_POP},
+};
+
+/* cjmp conditions as a mask over the compare sign: bit 0 below, bit 1 equal, bit 2 above */
+static uint8_t condition_mask(uint8_t cond) {
+    switch (cond) {
+        case ISA_COND_EQ: return 2;
+        case ISA_COND_NE: return 5;
+        case ISA_COND_LT: return 1;
+        case ISA_COND_LE: return 3;
+        case ISA_COND_GT: return 4;
+        case ISA_COND_GE: return 6;
+        default: return 0;
+    }
+}
+
+static void invalid_op(aurc_vm_op *op, vm_invalid_reason reason) {
+    op->kind = VM_OP_INVALID;
+    op->a = (uint8_t)reason;
+}
+
+static uint32_t decode_target(const aurc_vm *vm, uint32_t address) {
+    return address % ISA_WORD_SIZE == 0 && address / ISA_WORD_SIZE < vm->op_count ? address / ISA_WORD_SIZE
+                                                                                   : vm->op_count;
+}
+
+static void decode_op(const aurc_vm *vm, uint32_t index, aurc_vm_op *op) {
+    isa_instruction insn = unpack_instruction_word(isa_read_word(vm->rom + (size_t)index * ISA_WORD_SIZE));
+    memset(op, 0, sizeof *op);
+    op->imm = isa_signed_imm(insn.imm32);
+    op->a = insn.op0;
+    op->b = insn.op1;
+    op->c = insn.op2;
+    switch (insn.opcode) {
+        case ISA_OPCODE_NOP:
+            op->kind = VM_OP_NOP;
+            break;
+        case ISA_OPCODE_MOV:
+            if (insn.op1 == ISA_OPERAND_IMMEDIATE || insn.op1 == ISA_OPERAND_LABEL) {
+                op->kind = VM_OP_MOV_IMM;
+                if (insn.op1 == ISA_OPERAND_LABEL) {
+                    op->imm = insn.imm32;
+                }
+            } else {
+                op->kind = VM_OP_MOV_REG;
+            }
+            break;
+        case ISA_OPCODE_ADD:
+        case ISA_OPCODE_SUB:
+        case ISA_OPCODE_MUL:
+        case ISA_OPCODE_DIV:
+        case ISA_OPCODE_REM:
+        case ISA_OPCODE_AND:
+        case ISA_OPCODE_OR:
+        case ISA_OPCODE_XOR:
+        case ISA_OPCODE_SHL:
+        case ISA_OPCODE_SHR: {
+            static const uint8_t REG_KIND[] = {
+                [ISA_OPCODE_ADD] = VM_OP_ADD_REG, [ISA_OPCODE_SUB] = VM_OP_SUB_REG, [ISA_OPCODE_MUL] = VM_OP_MUL_REG,
+                [ISA_OPCODE_DIV] = VM_OP_DIV_REG, [ISA_OPCODE_REM] = VM_OP_REM_REG, [ISA_OPCODE_AND] = VM_OP_AND_REG,
+                [ISA_OPCODE_OR] = VM_OP_OR_REG,   [ISA_OPCODE_XOR] = VM_OP_XOR_REG, [ISA_OPCODE_SHL] = VM_OP_SHL_REG,
+                [ISA_OPCODE_SHR] = VM_OP_SHR_REG,
+            };
+            /* every _IMM kind directly follows its _REG kind */
+            int immediate = insn.op2 == ISA_OPERAND_IMMEDIATE;
+            op->kind = (uint8_t)(REG_KIND[insn.opcode] + immediate);
+            break;
+        }
+        case ISA_OPCODE_NOT:
+            op->kind = VM_OP_NOT;
+            break;
+        case ISA_OPCODE_PUSH:
+        case ISA_OPCODE_POP:
+        case ISA_OPCODE_STORE_STACK:
+        case ISA_OPCODE_LOAD_STACK:
+            op->kind = insn.opcode == ISA_OPCODE_PUSH         ? VM_OP_PUSH
+                       : insn.opcode == ISA_OPCODE_POP        ? VM_OP_POP
+                       : insn.opcode == ISA_OPCODE_STORE_STACK ? VM_OP_STORE_STACK
+                                                               : VM_OP_LOAD_STACK;
+            break;
+        case ISA_OPCODE_CMP:
+            op->kind = insn.op1 == ISA_OPERAND_IMMEDIATE ? VM_OP_CMP_IMM : VM_OP_CMP_REG;
+            break;
+        case ISA_OPCODE_JMP:
+        case ISA_OPCODE_CALL:
+            op->kind = insn.opcode == ISA_OPCODE_JMP ? VM_OP_JMP : VM_OP_CALL;
+            op->target = decode_target(vm, insn.imm32);
+            break;
+        case ISA_OPCODE_CJMP:
+            op->kind = VM_OP_CJMP;
+            op->c = condition_mask(insn.op0);
+            op->target = decode_target(vm, insn.imm32);
+            if (op->c == 0) {
+                invalid_op(op, VM_BAD_CONDITION);
+            }
+            break;
+        case ISA_OPCODE_RET:
+            op->kind = VM_OP_RET;
+            break;
+        case ISA_OPCODE_SVC:
+            op->kind = VM_OP_SVC;
+            break;
+        case ISA_OPCODE_HALT:
+            op->kind = VM_OP_HALT;
+            break;
+        case ISA_OPCODE_SPAWN:
+            op->kind = VM_OP_SPAWN;
+            op->imm = insn.imm32;
+            break;
+        case ISA_OPCODE_JOIN:
+            op->kind = VM_OP_JOIN;
+            break;
+        case ISA_OPCODE_ATOMIC_LOAD:
+        case ISA_OPCODE_ATOMIC_STORE:
+        case ISA_OPCODE_ATOMIC_ADD: {
+            /* the slot id in op0/op1 only matters to the assembler; the register goes to a, imm32 is the slot address */
+            int sharded = (insn.op2 & ISA_ATOMIC_SHARDED) != 0;
+            op->a = insn.opcode == ISA_OPCODE_ATOMIC_LOAD ? insn.op0 : insn.op1;
+            op->imm = insn.imm32;
+            op->kind = insn.opcode == ISA_OPCODE_ATOMIC_LOAD    ? (sharded ? VM_OP_SHARDED_LOAD : VM_OP_ATOMIC_LOAD)
+                       : insn.opcode == ISA_OPCODE_ATOMIC_ADD ? (sharded ? VM_OP_SHARDED_ADD : VM_OP_ATOMIC_ADD)
+                                                              : VM_OP_ATOMIC_STORE;
+            /* shared slots are naturally aligned words inside the image; sharded ones start a line, which indexes their shards */
+            uint32_t align = sharded ? ISA_SHARED_STRIDE : ISA_WORD_SIZE;
+            /* an out-of-range register is reported as such below, not as a bad slot */
+            if (op->a <= ISA_REG_SP) {
+                if ((insn.imm32 & (align - 1)) != 0 || insn.imm32 < vm->shared_low ||
+                    (uint64_t)insn.imm32 + ISA_WORD_SIZE > vm->image_size) {
+                    invalid_op(op, VM_BAD_SHARED_SLOT);
+                } else if (sharded && insn.opcode == ISA_OPCODE_ATOMIC_STORE) {
+                    invalid_op(op, VM_BAD_SHARDED_STORE);
+                }
+            }
+            break;
+        }
+        default:
+            invalid_op(op, VM_BAD_OPCODE);
+            op->imm = insn.opcode;
+            break;
+    }
+    /* register operands are checked against the opcode table, over whatever was found above */
+    if (!isa_registers_valid(insn)) {
+        invalid_op(op, VM_BAD_REGISTER);
+    }
+    op->op = op->kind;
+}
+
+static int vm_decode(aurc_vm *vm) {
+    vm->op_count = vm->code_size / ISA_WORD_SIZE;
+    vm->ops = malloc(((size_t)vm->op_count + 1) * sizeof *vm->ops);
+    if (!vm->ops) {
+        fprintf(stderr, "aurc-native: out of memory decoding image\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < vm->op_count; ++i) {
+        decode_op(vm, i, &vm->ops[i]);
+    }
+    memset(&vm->ops[vm->op_count], 0, sizeof vm->ops[0]);
+    vm->ops[vm->op_count].kind = vm->ops[vm->op_count].op = VM_OP_END;
+    for (uint32_t i = 0; i + 1 < vm->op_count; ++i) {
+        for (size_t p = 0; p < sizeof VM_FUSED_PAIRS / sizeof VM_FUSED_PAIRS[0]; ++p) {
+            if (vm->ops[i].op == VM_FUSED_PAIRS[p].first && vm->ops[i + 1].op == VM_FUSED_PAIRS[p].second) {
+                vm->ops[i].kind = VM_FUSED_PAIRS[p].fused;
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+/* ---- compiled loops ----------------------------------------------------- */
+
+/*
+ * Tiering: every taken jmp or cjmp whose target is not past it counts one
+ * back edge to the target in the running worker's row of counters. When a
+ * head reaches VM_JIT_THRESHOLD, the words from it to that branch are
+ * compiled once (aurc_jit.h), and from then on the back edge enters the
+ * compiled loop instead of dispatching. Compiled code runs on the task's own
+ * registers and leaves at the address to go on interpreting from: before an
+ * instruction that would fault, at a branch out of the loop, or when the
+ * slice runs out. A head that does not compile (the loop calls, say) is
+ * remembered and counted again from zero, so the interpreter only looks it
+ * up once every VM_JIT_THRESHOLD back edges.
+ */
+
+int aurc_vm_enable_jit(aurc_vm *vm) {
+    if (!aurc_jit_supported() || vm->op_count == 0) {
+        return 0;
+    }
+    aurc_vm_jit *jit = calloc(1, sizeof *jit);
+    if (!jit || !(jit->loops = calloc((size_t)vm->op_count + 1, sizeof *jit->loops))) {
+        free(jit);
+        fprintf(stderr, "aurc-native: out of memory allocating jit tables\n");
+        return 1;
+    }
+    if (aurc_mutex_init(&jit->lock) != 0) {
+        free(jit->loops);
+        free(jit);
+        fprintf(stderr, "aurc-native: failed to create jit lock\n");
+        return 1;
+    }
+    jit->image = (aurc_jit_image){vm->rom, vm->code_size, vm->shared_low, vm->image_size};
+    vm->jit = jit;
+    return 0;
+}
+
+/* The worker's back-edge counters, NULL when the JIT is off or they cannot be allocated. */
+static uint32_t *jit_counters(aurc_vm *vm, unsigned self) {
+    aurc_vm_jit *jit = vm->jit;
+    if (!jit || vm->pair_counts || vm->profile) {
+        return NULL;
+    }
+    if (!jit->hot[self]) {
+        jit->hot[self] = calloc((size_t)vm->op_count + 1, sizeof *jit->hot[self]);
+    }
+    return jit->hot[self];
+}
+
+/* The loop from op head to the back edge at op tail, compiled by whichever worker gets there first. */
+static const aurc_jit_loop *jit_loop(aurc_vm *vm, uint32_t head, uint32_t tail) {
+    aurc_vm_jit *jit = vm->jit;
+    int64_t entry = aurc_atomic_load64(&jit->loops[head]);
+    if (entry == 0) {
+        aurc_mutex_lock(&jit->lock);
+        entry = aurc_atomic_load64(&jit->loops[head]);
+        if (entry == 0) {
+            aurc_jit_loop *loop = aurc_jit_compile_loop(&jit->image, head * ISA_WORD_SIZE, tail * ISA_WORD_SIZE);
+            entry = loop ? (int64_t)(intptr_t)loop : VM_JIT_FAILED;
+            aurc_atomic_store64(&jit->loops[head], entry);
+        }
+        aurc_mutex_unlock(&jit->lock);
+    }
+    return entry == VM_JIT_FAILED ? NULL : (const aurc_jit_loop *)(intptr_t)entry;
+}
+
+static void jit_free(aurc_vm *vm) {
+    aurc_vm_jit *jit = vm->jit;
+    if (!jit) {
+        return;
+    }
+    for (uint32_t i = 0; i <= vm->op_count; ++i) {
+        if (jit->loops[i] != 0 && jit->loops[i] != VM_JIT_FAILED) {
+            aurc_jit_free((aurc_jit_loop *)(intptr_t)jit->loops[i]);
+        }
+    }
+    for (unsigned w = 0; w < VM_MAX_WORKERS; ++w) {
+        free(jit->hot[w]);
+    }
+    aurc_mutex_destroy(&jit->lock);
+    free(jit->loops);
+    free(jit);
+    vm->jit = NULL;
+}
+
+/* ---- interpreter -------------------------------------------------------- */
+
+static int64_t sharded_load(const aurc_vm *vm, uint32_t addr) {
+    int64_t sum = aurc_atomic_load64((volatile int64_t *)(void *)(vm->arena + addr));
+    const aurc_vm_sched *sched = vm->sched;
+    if (sched) {
+        for (unsigned w = 0; w < sched->worker_count; ++w) {
+            sum += aurc_atomic_load64(&sched->shards[(size_t)w * sched->shard_lines + addr / ISA_SHARED_STRIDE]);
+        }
+    }
+    return sum;
+}
+
+static void sharded_add(aurc_vm *vm, unsigned self, uint32_t addr, int64_t value) {
+    if (!vm->sched) {
+        aurc_atomic_add64((volatile int64_t *)(void *)(vm->arena + addr), value);
+        return;
+    }
+    int64_t *shard = &vm->sched->shards[(size_t)self * vm->sched->shard_lines + addr / ISA_SHARED_STRIDE];
+    aurc_atomic_store64(shard, aurc_atomic_load64(shard) + value);
+}
+
+/* ---- bignums ----------------------------------------------------------- */
+
+static vm_bignum *bignum_slot(aurc_vm_bignums *table, uint32_t index) {
+    return &table->chunks[index / VM_BIGNUM_CHUNK][index % VM_BIGNUM_CHUNK];
+}
+
+/* Takes a reference to the number behind handle; UINT32_MAX for 0, a freed or a made-up handle. */
+static uint32_t bignum_acquire(aurc_vm_bignums *table, uint64_t handle) {
+    uint32_t index = UINT32_MAX;
+    aurc_mutex_lock(&table->lock);
+    if (handle >= 1 && handle <= table->count && bignum_slot(table, (uint32_t)(handle - 1))->listed) {
+        index = (uint32_t)(handle - 1);
+        bignum_slot(table, index)->refs++;
+    }
+    aurc_mutex_unlock(&table->lock);
+    return index;
+}
+
+/* Drops a reference; unlist also drops the table's (bignum_free), failing when the handle no longer names a number. */
+static int bignum_release(aurc_vm_bignums *table, aurc_bn_pool *pool, uint32_t index, int unlist) {
+    if (index == UINT32_MAX) {
+        return 0;
+    }
+    aurc_bn dead;
+    aurc_bn_init(&dead);
+    aurc_mutex_lock(&table->lock);
+    vm_bignum *slot = bignum_slot(table, index);
+    if (unlist) {
+        if (!slot->listed) {
+            aurc_mutex_unlock(&table->lock);
+            return 1;
+        }
+        slot->listed = 0;
+    }
+    if (--slot->refs == 0) {
+        dead = slot->value;
+        aurc_bn_init(&slot->value);
+        slot->next_free = table->free_head;
+        table->free_head = index;
+    }
+    aurc_mutex_unlock(&table->lock);
+    aurc_bn_clear(pool, &dead);
+    return 0;
+}
+
+/* Moves value into a free slot and returns its handle; 0 when the table is full or out of memory. */
+static uint64_t bignum_insert(aurc_vm_bignums *table, aurc_bn *value) {
+    uint32_t index = UINT32_MAX;
+    aurc_mutex_lock(&table->lock);
+    if (table->free_head != UINT32_MAX) {
+        index = table->free_head;
+        table->free_head = bignum_slot(table, index)->next_free;
+    } else if (table->count < VM_BIGNUM_CHUNK * VM_BIGNUM_CHUNKS) {
+        vm_bignum **chunk = &table->chunks[table->count / VM_BIGNUM_CHUNK];
+        if (!*chunk) {
+            *chunk = calloc(VM_BIGNUM_CHUNK, sizeof **chunk);
+        }
+        if (*chunk) {
+            index = table->count++;
+        }
+    }
+    if (index != UINT32_MAX) {
+        vm_bignum *slot = bignum_slot(table, index);
+        slot->value = *value;
+        slot->refs = 1;
+        slot->listed = 1;
+        aurc_bn_init(value);
+    }
+    aurc_mutex_unlock(&table->lock);
+    return index == UINT32_MAX ? 0 : (uint64_t)index + 1;
+}
+
+static aurc_vm_bignums *bignum_table_new(void) {
+    aurc_vm_bignums *table = calloc(1, sizeof *table);
+    if (!table) {
+        return NULL;
+    }
+    if (aurc_mutex_init(&table->lock) != 0) {
+        free(table);
+        return NULL;
+    }
+    table->free_head = UINT32_MAX;
+    return table;
+}
+
+static void bignum_table_free(aurc_vm_bignums *table, aurc_bn_pool *pool) {
+    for (uint32_t i = 0; i < table->count; ++i) {
+        aurc_bn_clear(pool, &bignum_slot(table, i)->value);
+    }
+    for (uint32_t c = 0; c < VM_BIGNUM_CHUNKS; ++c) {
+        free(table->chunks[c]);
+    }
+    aurc_mutex_destroy(&table->lock);
+    free(table);
+}
+
+/* svc ISA_SERVICE_BIGNUM: operation `operation` (aurc_bn_op) on r0 and r1, answer in r0. */
+static int bignum_service(aurc_vm *vm, unsigned self, aurc_vm_task *task, uint8_t operation) {
+    aurc_vm_bignums *table = vm->bignums;
+    aurc_bn_pool *pool = &vm->heap->caches[self];
+    uint64_t r0 = task->regs[ISA_REG_R0];
+    int64_t r1 = (int64_t)task->regs[ISA_REG_R1];
+    if (operation >= AURC_BN_OP_COUNT) {
+        return vm_fault(task, "unknown bignum operation");
+    }
+    aurc_bn_op op = (aurc_bn_op)operation;
+    if (op == AURC_BN_FREE) {
+        uint32_t index = bignum_acquire(table, r0);
+        /* a racing bignum_free of the same handle may unlist it first */
+        if (index == UINT32_MAX || bignum_release(table, pool, index, 1) != 0) {
+            bignum_release(table, pool, index, 0);
+            return vm_fault(task, "invalid bignum handle");
+        }
+        bignum_release(table, pool, index, 0);
+        task->regs[ISA_REG_R0] = 0;
+        return 0;
+    }
+
+    aurc_bn result;
+    aurc_bn_init(&result);
+    const char *fault = NULL;
+    int failed = 0;
+    int makes_number = op != AURC_BN_CMP && op != AURC_BN_TO_INT && op != AURC_BN_PRINT;
+    int64_t answer = 0;
+    uint32_t a = UINT32_MAX, b = UINT32_MAX;
+    if (op == AURC_BN_FROM_INT) {
+        failed = aurc_bn_set_i64(pool, &result, (int64_t)r0);
+    } else {
+        /* the second operand of pow and the shifts is a plain int */
+        int two_numbers = aurc_bn_op_arity(op) == 2 && op != AURC_BN_POW && op != AURC_BN_SHL && op != AURC_BN_SHR;
+        a = bignum_acquire(table, r0);
+        b = two_numbers ? bignum_acquire(table, (uint64_t)r1) : UINT32_MAX;
+        if (a == UINT32_MAX || (two_numbers && b == UINT32_MAX)) {
+            fault = "invalid bignum handle";
+        }
+    }
+    if (!fault && op != AURC_BN_FROM_INT) {
+        const aurc_bn *x = &bignum_slot(table, a)->value;
+        const aurc_bn *y = b != UINT32_MAX ? &bignum_slot(table, b)->value : NULL;
+        switch (op) {
+            case AURC_BN_ADD:
+                failed = aurc_bn_add(pool, &result, x, y);
+                break;
+            case AURC_BN_SUB:
+                failed = aurc_bn_sub(pool, &result, x, y);
+                break;
+            case AURC_BN_MUL:
+                failed = aurc_bn_mul(pool, &result, x, y);
+                break;
+            case AURC_BN_DIV:
+            case AURC_BN_MOD:
+                if (aurc_bn_is_zero(y)) {
+                    fault = "bignum division by zero";
+                } else {
+                    failed = aurc_bn_divmod(pool, op == AURC_BN_DIV ? &result : NULL, op == AURC_BN_MOD ? &result : NULL,
+                                            x, y);
+                }
+                break;
+            case AURC_BN_POW:
+                if (r1 < 0) {
+                    fault = "negative bignum exponent";
+                } else {
+                    failed = aurc_bn_pow(pool, &result, x, (uint64_t)r1);
+                }
+                break;
+            case AURC_BN_SHL:
+            case AURC_BN_SHR:
+                if (r1 < 0) {
+                    fault = "negative bignum shift";
+                } else if (op == AURC_BN_SHL) {
+                    failed = aurc_bn_shl(pool, &result, x, (uint64_t)r1);
+                } else {
+                    failed = aurc_bn_shr(pool, &result, x, (uint64_t)r1);
+                }
+                break;
+            case AURC_BN_SQRT:
+                if (x->neg) {
+                    fault = "square root of a negative bignum";
+                } else {
+                    failed = aurc_bn_sqrt(pool, &result, x);
+                }
+                break;
+            case AURC_BN_CMP:
+                answer = aurc_bn_cmp(x, y);
+                break;
+            case AURC_BN_TO_INT:
+                answer = aurc_bn_to_i64(x);
+                break;
+            case AURC_BN_PRINT: {
+                size_t len;
+                char *text = aurc_bn_to_decimal(pool, x, &len);
+                if (!text) {
+                    failed = 1;
+                    break;
+                }
+                text[len] = '\n';
+                if (task_write(vm, self, task, text, len + 1) != 0) {
+                    failed = 1;
+                }
+                free(text);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    bignum_release(table, pool, a, 0);
+    bignum_release(table, pool, b, 0);
+    if (!fault && failed) {
+        fault = "out of memory in bignum service";
+    }
+    if (!fault && makes_number) {
+        answer = (int64_t)bignum_insert(table, &result);
+        if (answer == 0) {
+            fault = "bignum table full";
+        }
+    }
+    aurc_bn_clear(pool, &result);
+    if (fault) {
+        return vm_fault(task, fault);
+    }
+    task->regs[ISA_REG_R0] = (uint64_t)answer;
+    return 0;
+}
+
+/* svc service, arg (operands 0 and 1); sets *stop when the service ends the program. */
+static int vm_service(aurc_vm *vm, unsigned self, aurc_vm_task *task, uint8_t service, uint8_t arg, int *stop) {
+    switch (service) {
+        case ISA_SERVICE_WRITE: {
+            uint64_t addr = task->regs[ISA_REG_R1];
+            /* text ends with the read-only range, the rest of the image or the task's stack at the latest */
+            const uint8_t *start;
+            size_t avail;
+            if (addr < vm->rom_size) {
+                start = vm->rom + addr;
+                avail = vm->rom_size - (size_t)addr;
+            } else if (addr < vm->image_size) {
+                start = vm->arena + addr;
+                avail = vm->image_size - (size_t)addr;
+            } else if (addr >= task->stack_low && addr < AURC_VM_ARENA_SIZE) {
+                start = task->stack + (addr - task->stack_low);
+                avail = AURC_VM_ARENA_SIZE - (size_t)addr;
+            } else {
+                return vm_fault(task, "write service address outside arena");
+            }
+            const uint8_t *end = memchr(start, '\0', avail);
+            size_t len = end ? (size_t)(end - start) : avail;
+            if (arg != 2) {
+                return task_write(vm, self, task, start, len);
+            }
+            /* stderr is unbuffered, and follows what the task printed before */
+            if (task_flush(task) != 0 || fwrite(start, 1, len, stderr) != len) {
+                perror("aurc-native: vm write");
+                return 1;
+            }
+            return 0;
+        }
+        case ISA_SERVICE_EXIT:
+            vm_stop(vm, (int)(int64_t)task->regs[ISA_REG_R0], 0);
+            *stop = 1;
+            return 0;
+        case ISA_SERVICE_PRINT_INT: {
+            char text[24];
+            int len = snprintf(text, sizeof text, "%" PRId64 "\n", (int64_t)task->regs[ISA_REG_R0]);
+            return task_write(vm, self, task, text, (size_t)len);
+        }
+        case ISA_SERVICE_FLUSH:
+            return task_flush(task);
+        case ISA_SERVICE_INPUT_INT: {
+            long long value = 0;
+            /* a prompt printed before has to be out before the program waits */
+            if (task_flush(task) != 0) {
+                return 1;
+            }
+            /* end of input or a non-number reads as 0, like the pipeline runtime */
+            if (scanf("%lld", &value) != 1) {
+                value = 0;
+            }
+            task->regs[ISA_REG_R0] = (uint64_t)value;
+            return 0;
+        }
+        case ISA_SERVICE_BIGNUM:
+            return bignum_service(vm, self, task, arg);
+        default:
+            return vm_fault(task, "unknown service number");
+    }
+}
+
+/* --profile: accounts for op, about to run for task id on worker self */
+static void profile_op(aurc_vm *vm, aurc_profile_worker *worker, unsigned self, uint32_t id, const aurc_vm_op *op) {
+    aurc_profile *profile = vm->profile;
+    uint32_t word = (uint32_t)(op - vm->ops);
+    int64_t tick = aurc_atomic_load64(&profile->tick);
+    worker->counts[word]++;
+    if (tick != worker->tick) {
+        worker->tick = tick;
+        aurc_profile_sample(profile, worker, id, word);
+    }
+    switch (op->op) {
+        case VM_OP_CALL:
+            aurc_profile_call(profile, id, op->target);
+            break;
+        case VM_OP_RET:
+            aurc_profile_return(profile, id);
+            break;
+        case VM_OP_SPAWN:
+            worker->spawns++;
+            break;
+        case VM_OP_JOIN:
+            worker->joins++;
+            break;
+        case VM_OP_ATOMIC_LOAD:
+        case VM_OP_ATOMIC_STORE:
+        case VM_OP_ATOMIC_ADD:
+            aurc_profile_atomic(profile, worker, self, (uint32_t)op->imm / ISA_SHARED_STRIDE);
+            break;
+        case VM_OP_SHARDED_LOAD:
+        case VM_OP_SHARDED_ADD:
+            worker->sharded_ops++;
+            break;
+        default:
+            break;
+    }
+}
+
+#ifdef VM_THREADED
+#define VM_HANDLER(kind) op_##kind:
+#define VM_NEXT() goto *ip->handler
+#define VM_UNFUSED(base) goto op_##base
+#else
+#define VM_HANDLER(kind) case VM_OP_##kind:
+#define VM_NEXT() goto dispatch
+#define VM_UNFUSED(base)         \
+    do {                         \
+        kind = VM_OP_##base;     \
+        goto redispatch;         \
+    } while (0)
+#endif
+#define VM_SYNC() (task->pc = (uint32_t)(ip - ops) * ISA_WORD_SIZE, task->compare = compare)
+#define VM_FAULT(message) \
+    do { VM_SYNC(); return vm_fault(task, message); } while (0)
+/* an access at low fell outside the stack: grow the stack to cover it, or fault */
+#define VM_STACK_REACH(low, message)                   \
+    do {                                               \
+        if (grow_stack(vm, self, task, (low)) != 0) {  \
+            VM_FAULT(message);                         \
+        }                                              \
+        stack_low = task->stack_low;                   \
+    } while (0)
+/* taken branches, calls and returns count down the slice */
+#define VM_BRANCH(to)             \
+    do {                          \
+        ip = (to);                \
+        if (--budget == 0) {      \
+            goto slice_end;       \
+        }                         \
+        VM_NEXT();                \
+    } while (0)
+/* a taken jmp or cjmp at op edge: back edges count towards compiling the loop they close */
+#define VM_LOOP_BRANCH(to, edge)                                                 \
+    do {                                                                         \
+        const aurc_vm_op *to_ = (to);                                            \
+        if (hot && to_ <= (edge) && ++hot[to_ - ops] >= VM_JIT_THRESHOLD) {      \
+            loop_edge = (edge);                                                  \
+            ip = to_;                                                            \
+            goto hot_loop;                                                       \
+        }                                                                        \
+        VM_BRANCH(to_);                                                          \
+    } while (0)
+#define VM_ARITH(kind, expr)                                                 \
+    VM_HANDLER(kind##_REG) {                                                 \
+        uint64_t x = r[ip->b], y = r[ip->c];                                 \
+        r[ip->a] = (expr);                                                   \
+        ++ip;                                                                \
+        VM_NEXT();                                                           \
+    }                                                                        \
+    VM_HANDLER(kind##_IMM) {                                                 \
+        uint64_t x = r[ip->b], y = (uint64_t)ip->imm;                        \
+        r[ip->a] = (expr);                                                   \
+        ++ip;                                                                \
+        VM_NEXT();                                                           \
+    }
+
+
+/*
+ * Runs task id on worker self until it finishes, parks, stops the program or,
+ * with other tasks waiting, uses up its slice. Returns 1 on a fault. Called
+ * with AURC_VM_NO_TASK before the first run, it only stores each op's handler
+ * address, which is a label in here.
+ */
+#ifdef VM_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+static int run_task(aurc_vm *vm, unsigned self, uint32_t id, vm_outcome *outcome) {
+    aurc_vm_op *const ops = vm->ops;
+#ifdef VM_THREADED
+    static const void *const HANDLERS[VM_OP_KIND_COUNT] = {
+#define VM_OP_LABEL(name, text) [VM_OP_##name] = &&op_##name,
+        VM_OP_KINDS(VM_OP_LABEL)
+#undef VM_OP_LABEL
+    };
+    if (id == AURC_VM_NO_TASK) {
+        for (uint32_t i = 0; i <= vm->op_count; ++i) {
+            ops[i].handler = HANDLERS[ops[i].kind];
+        }
+        return 0;
+    }
+#else
+    if (id == AURC_VM_NO_TASK) {
+        return 0;
+    }
+    unsigned kind;
+#endif
+    aurc_vm_task *const task = task_at(vm, id);
+    uint64_t *const r = task->regs;
+    uint32_t stack_low = task->stack_low;
+    int compare = task->compare;
+    uint32_t budget = VM_SLICE;
+    uint64_t *const pairs = vm->pair_counts ? vm->pair_counts + (size_t)self * VM_OP_KIND_COUNT * VM_OP_KIND_COUNT : NULL;
+    const aurc_vm_op *previous = NULL;
+    uint32_t *const hot = jit_counters(vm, self);
+    aurc_profile_worker *const profiled = vm->profile ? aurc_profile_worker_for(vm->profile, self) : NULL;
+    const aurc_vm_op *loop_edge = NULL;
+    if (task->pc % ISA_WORD_SIZE != 0 || task->pc / ISA_WORD_SIZE >= vm->op_count) {
+        return vm_fault(task, "program counter outside code");
+    }
+    const aurc_vm_op *ip = ops + task->pc / ISA_WORD_SIZE;
+    uint64_t jump;              /* a return address, checked at bad_return */
+
+#ifdef VM_THREADED
+    VM_NEXT();
+#else
+dispatch:
+    kind = ip->kind;
+redispatch:
+    switch (kind) {
+#endif
+
+    VM_HANDLER(NOP) {
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(MOV_IMM) {
+        r[ip->a] = (uint64_t)ip->imm;
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(MOV_REG) {
+        r[ip->a] = r[ip->b];
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(NOT) {
+        r[ip->a] = ~r[ip->b];
+        ++ip;
+        VM_NEXT();
+    }
+    VM_ARITH(ADD, x + y)
+    VM_ARITH(SUB, x - y)
+    VM_ARITH(MUL, x * y)
+    VM_ARITH(AND, x & y)
+    VM_ARITH(OR, x | y)
+    VM_ARITH(XOR, x ^ y)
+    /* shift counts wrap at 64 the way x86 masks them */
+    VM_ARITH(SHL, x << (y & 63))
+    VM_ARITH(SHR, (int64_t)x >= 0 ? x >> (y & 63) : ~(~x >> (y & 63)))
+    VM_HANDLER(DIV_REG)
+    VM_HANDLER(DIV_IMM)
+    VM_HANDLER(REM_REG)
+    VM_HANDLER(REM_IMM) {
+        int64_t x = (int64_t)r[ip->b];
+        int64_t y = ip->op == VM_OP_DIV_IMM || ip->op == VM_OP_REM_IMM ? ip->imm : (int64_t)r[ip->c];
+        int div = ip->op == VM_OP_DIV_REG || ip->op == VM_OP_DIV_IMM;
+        if (y == 0) {
+            VM_FAULT("division by zero");
+        }
+        if (x == INT64_MIN && y == -1) {
+            r[ip->a] = div ? (uint64_t)x : 0;
+        } else {
+            r[ip->a] = (uint64_t)(div ? x / y : x % y);
+        }
+        ++ip;
+        VM_NEXT();
+    }
+
+    VM_HANDLER(PUSH) {
+        uint64_t sp = r[ISA_REG_SP];
+        uint64_t value = r[ip->a];
+        if (sp > AURC_VM_ARENA_SIZE || sp < (uint64_t)stack_low + ISA_WORD_SIZE) {
+            VM_STACK_REACH(sp - ISA_WORD_SIZE, "stack overflow");
+        }
+        r[ISA_REG_SP] = sp - ISA_WORD_SIZE;
+        memcpy(task->stack + (sp - ISA_WORD_SIZE - stack_low), &value, sizeof value);
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(POP) {
+        uint64_t sp = r[ISA_REG_SP];
+        uint64_t value;
+        if (sp < stack_low || sp > AURC_VM_ARENA_SIZE - ISA_WORD_SIZE) {
+            VM_STACK_REACH(sp, "stack access outside arena");
+        }
+        memcpy(&value, task->stack + (sp - stack_low), sizeof value);
+        r[ISA_REG_SP] = sp + ISA_WORD_SIZE;
+        r[ip->a] = value;
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(STORE_STACK)
+    VM_HANDLER(LOAD_STACK) {
+        /* the 8-byte slot at sp + offset must lie inside the task's stack */
+        uint64_t addr = r[ISA_REG_SP] + (uint64_t)ip->imm;
+        if (addr < stack_low || addr > AURC_VM_ARENA_SIZE - ISA_WORD_SIZE) {
+            VM_STACK_REACH(addr, "stack access outside arena");
+        }
+        uint8_t *slot = task->stack + (addr - stack_low);
+        if (ip->op == VM_OP_STORE_STACK) {
+            memcpy(slot, &r[ip->a], sizeof r[0]);
+        } else {
+            memcpy(&r[ip->a], slot, sizeof r[0]);
+        }
+        ++ip;
+        VM_NEXT();
+    }
+
+    VM_HANDLER(CMP_REG) {
+        int64_t x = (int64_t)r[ip->a], y = (int64_t)r[ip->b];
+        compare = (x > y) - (x < y);
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(CMP_IMM) {
+        int64_t x = (int64_t)r[ip->a], y = ip->imm;
+        compare = (x > y) - (x < y);
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(JMP) {
+        VM_LOOP_BRANCH(ops + ip->target, ip);
+    }
+    VM_HANDLER(CJMP) {
+        if (ip->c >> (compare + 1) & 1) {
+            VM_LOOP_BRANCH(ops + ip->target, ip);
+        }
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(CALL) {
+        uint64_t sp = r[ISA_REG_SP];
+        uint64_t value = (uint64_t)(ip - ops + 1) * ISA_WORD_SIZE;
+        if (sp > AURC_VM_ARENA_SIZE || sp < (uint64_t)stack_low + ISA_WORD_SIZE) {
+            VM_STACK_REACH(sp - ISA_WORD_SIZE, "stack overflow");
+        }
+        r[ISA_REG_SP] = sp - ISA_WORD_SIZE;
+        memcpy(task->stack + (sp - ISA_WORD_SIZE - stack_low), &value, sizeof value);
+        VM_BRANCH(ops + ip->target);
+    }
+    VM_HANDLER(RET) {
+        uint64_t sp = r[ISA_REG_SP];
+        if (sp >= AURC_VM_ARENA_SIZE) {
+            /* returning from the outermost frame ends the task, and the program for the main task */
+            VM_SYNC();
+            if (id == AURC_VM_MAIN_TASK) {
+                vm_stop(vm, (int)(int64_t)r[ISA_REG_R0], 0);
+                *outcome = VM_TASK_STOPPED;
+            } else {
+                *outcome = VM_TASK_FINISHED;
+            }
+            return 0;
+        }
+        if (sp < stack_low || sp > AURC_VM_ARENA_SIZE - ISA_WORD_SIZE) {
+            VM_STACK_REACH(sp, "stack access outside arena");
+        }
+        memcpy(&jump, task->stack + (sp - stack_low), sizeof jump);
+        r[ISA_REG_SP] = sp + ISA_WORD_SIZE;
+        if (jump % ISA_WORD_SIZE != 0 || jump / ISA_WORD_SIZE >= vm->op_count) {
+            goto bad_return;
+        }
+        VM_BRANCH(ops + jump / ISA_WORD_SIZE);
+    }
+
+    VM_HANDLER(SVC) {
+        int stop = 0;
+        VM_SYNC();
+        if (vm_service(vm, self, task, ip->a, ip->b, &stop) != 0) {
+            return 1;
+        }
+        if (stop) {
+            *outcome = VM_TASK_STOPPED;
+            return 0;
+        }
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(HALT) {
+        VM_SYNC();
+        vm_stop(vm, (int)(int64_t)r[ISA_REG_R0], 0);
+        *outcome = VM_TASK_STOPPED;
+        return 0;
+    }
+    VM_HANDLER(SPAWN) {
+        uint32_t handle;
+        VM_SYNC();
+        /* the child may print on another worker right away, after what the parent printed */
+        if (task_flush(task) != 0) {
+            return 1;
+        }
+        if (vm_spawn(vm, self, task, (uint32_t)ip->imm, &handle) != 0) {
+            return 1;
+        }
+        r[ip->a] = handle;
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(JOIN) {
+        /* a parked task may resume on another worker as soon as the lock drops */
+        ++ip;
+        VM_SYNC();
+        int parked = 0;
+        if (task_flush(task) != 0) {
+            task->pc -= ISA_WORD_SIZE;
+            return 1;
+        }
+        if (vm_join(vm, id, task, r[ip[-1].a], &parked) != 0) {
+            task->pc -= ISA_WORD_SIZE;
+            return 1;
+        }
+        if (parked) {
+            if (profiled) {
+                profiled->joins_waited++;
+            }
+            *outcome = VM_TASK_PARKED;
+            return 0;
+        }
+        VM_NEXT();
+    }
+
+    VM_HANDLER(ATOMIC_LOAD) {
+        r[ip->a] = (uint64_t)aurc_atomic_load64((volatile int64_t *)(void *)(vm->arena + ip->imm));
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(ATOMIC_STORE) {
+        aurc_atomic_store64((volatile int64_t *)(void *)(vm->arena + ip->imm), (int64_t)r[ip->a]);
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(ATOMIC_ADD) {
+        aurc_atomic_add64((volatile int64_t *)(void *)(vm->arena + ip->imm), (int64_t)r[ip->a]);
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(SHARDED_LOAD) {
+        r[ip->a] = (uint64_t)sharded_load(vm, (uint32_t)ip->imm);
+        ++ip;
+        VM_NEXT();
+    }
+    VM_HANDLER(SHARDED_ADD) {
+        sharded_add(vm, self, (uint32_t)ip->imm, (int64_t)r[ip->a]);
+        ++ip;
+        VM_NEXT();
+    }
+
+    VM_HANDLER(INVALID) {
+        switch (ip->a) {
+            case VM_BAD_REGISTER: VM_FAULT("invalid register operand");
+            case VM_BAD_CONDITION: VM_FAULT("invalid branch condition");
+            case VM_BAD_SHARED_SLOT: VM_FAULT("atomic access outside shared data");
+            case VM_BAD_SHARDED_STORE: VM_FAULT("atomic_store to a sharded counter");
+            default: {
+                char message[64];
+                snprintf(message, sizeof message, "unsupported opcode 0x%02X", (unsigned)ip->imm);
+                VM_FAULT(message);
+            }
+        }
+    }
+    VM_HANDLER(END) {
+        VM_FAULT("program counter outside code");
+    }
+
+    /* superinstructions: ip[1] is the second op of the pair */
+    VM_HANDLER(CMP_IMM_CJMP) {
+        int64_t x = (int64_t)r[ip->a], y = ip->imm;
+        compare = (x > y) - (x < y);
+        if (ip[1].c >> (compare + 1) & 1) {
+            VM_LOOP_BRANCH(ops + ip[1].target, ip + 1);
+        }
+        ip += 2;
+        VM_NEXT();
+    }
+    VM_HANDLER(CMP_REG_CJMP) {
+        int64_t x = (int64_t)r[ip->a], y = (int64_t)r[ip->b];
+        compare = (x > y) - (x < y);
+        if (ip[1].c >> (compare + 1) & 1) {
+            VM_LOOP_BRANCH(ops + ip[1].target, ip + 1);
+        }
+        ip += 2;
+        VM_NEXT();
+    }
+    VM_HANDLER(ADD_IMM_JMP) {
+        r[ip->a] = r[ip->b] + (uint64_t)ip->imm;
+        VM_LOOP_BRANCH(ops + ip[1].target, ip + 1);
+    }
+    VM_HANDLER(MOV_REG_MOV_REG) {
+        r[ip->a] = r[ip->b];
+        r[ip[1].a] = r[ip[1].b];
+        ip += 2;
+        VM_NEXT();
+    }
+    VM_HANDLER(MUL_IMM_ADD_IMM) {
+        r[ip->a] = r[ip->b] * (uint64_t)ip->imm;
+        r[ip[1].a] = r[ip[1].b] + (uint64_t)ip[1].imm;
+        ip += 2;
+        VM_NEXT();
+    }
+    VM_HANDLER(PUSH_PUSH) {
+        uint64_t sp = r[ISA_REG_SP];
+        if (sp > AURC_VM_ARENA_SIZE || sp < (uint64_t)stack_low + 2 * ISA_WORD_SIZE) {
+            VM_UNFUSED(PUSH);   /* one of the two grows the stack or faults: let the plain ops see to it */
+        }
+        uint64_t value = r[ip->a];
+        memcpy(task->stack + (sp - ISA_WORD_SIZE - stack_low), &value, sizeof value);
+        r[ISA_REG_SP] = sp - ISA_WORD_SIZE;
+        value = r[ip[1].a];
+        memcpy(task->stack + (sp - 2 * ISA_WORD_SIZE - stack_low), &value, sizeof value);
+        r[ISA_REG_SP] = sp - 2 * ISA_WORD_SIZE;
+        ip += 2;
+        VM_NEXT();
+    }
+    VM_HANDLER(POP_POP) {
+        uint64_t sp = r[ISA_REG_SP];
+        if (sp < stack_low || sp > AURC_VM_ARENA_SIZE - 2 * ISA_WORD_SIZE || ip->a == ISA_REG_SP) {
+            VM_UNFUSED(POP);
+        }
+        uint64_t first, second;
+        memcpy(&first, task->stack + (sp - stack_low), sizeof first);
+        memcpy(&second, task->stack + (sp + ISA_WORD_SIZE - stack_low), sizeof second);
+        r[ip->a] = first;
+        r[ISA_REG_SP] = sp + 2 * ISA_WORD_SIZE;
+        r[ip[1].a] = second;
+        ip += 2;
+        VM_NEXT();
+    }
+
+
+    VM_HANDLER(PROFILE) {
+        /* --pair-profile and --profile: every op comes here first */
+        if (pairs) {
+            /* only neighbours in the code could be fused */
+            if (previous && ip == previous + 1) {
+                pairs[previous->op * VM_OP_KIND_COUNT + ip->op]++;
+            }
+            previous = ip;
+        }
+        if (profiled) {
+            profile_op(vm, profiled, self, id, ip);
+        }
+#ifdef VM_THREADED
+        goto *HANDLERS[ip->op];
+#else
+        kind = ip->op;
+        goto redispatch;
+#endif
+    }
+
+#ifndef VM_THREADED
+        default:
+            VM_FAULT("corrupt decoded op");
+    }
+#endif
+
+slice_end:
+    budget = VM_SLICE;
+    if (aurc_atomic_load64(&vm->stopped)) {
+        VM_SYNC();
+        *outcome = VM_TASK_STOPPED;
+        return 0;
+    }
+    if (vm->sched && aurc_atomic_load64(&vm->sched->queued) > 0) {
+        VM_SYNC();
+        *outcome = VM_TASK_YIELD;
+        return 0;
+    }
+    VM_NEXT();
+
+hot_loop: {
+    /* ip is the head of a hot loop closed by the branch at loop_edge, which is still a taken branch */
+    if (--budget == 0) {
+        goto slice_end;
+    }
+    const aurc_jit_loop *loop = jit_loop(vm, (uint32_t)(ip - ops), (uint32_t)(loop_edge - ops));
+    if (!loop) {
+        hot[ip - ops] = 0;
+        VM_NEXT();
+    }
+    aurc_jit_frame frame = {r, compare, 0, budget, stack_low, (uint64_t)(uintptr_t)task->stack - stack_low, vm->arena};
+    uint32_t resume = aurc_jit_run(loop, &frame);
+    compare = (frame.compare_lhs > frame.compare_rhs) - (frame.compare_lhs < frame.compare_rhs);
+    budget = (uint32_t)frame.budget;
+    /* an exit through a branch to nowhere lands on the end op, as the branch itself would */
+    ip = ops + decode_target(vm, resume);
+    if (budget == 0) {
+        goto slice_end;
+    }
+    VM_NEXT();
+}
+
+bad_return:
+    task->pc = (uint32_t)jump;
+    task->compare = compare;
+    return vm_fault(task, "program counter outside code");
+}
+#ifdef VM_THREADED
+#pragma GCC diagnostic pop
+#endif
+
+#undef VM_HANDLER
+#undef VM_NEXT
+#undef VM_UNFUSED
+#undef VM_SYNC
+#undef VM_FAULT
+#undef VM_BRANCH
+#undef VM_LOOP_BRANCH
+#undef VM_ARITH
+
+/* Runs tasks until the program stops, starting with current (or a queued one for AURC_VM_NO_TASK). */
+static void worker_loop(aurc_vm *vm, unsigned self, uint32_t current) {
+    for (;;) {
+        if (current == AURC_VM_NO_TASK) {
+            current = take_task(vm, self);
+            if (current == AURC_VM_NO_TASK) {
+                return;
+            }
+        }
+        vm_outcome outcome;
+        if (run_task(vm, self, current, &outcome) != 0) {
+            vm_stop(vm, 0, 1);
+            return;
+        }
+        switch (outcome) {
+            case VM_TASK_YIELD: {
+                uint32_t next = try_take(vm->sched, self);
+                if (next != AURC_VM_NO_TASK) {
+                    if (push_task(vm, self, current) != 0) {
+                        vm_stop(vm, 0, 1);
+                        return;
+                    }
+                    current = next;
+                }
+                break;
+            }
+            case VM_TASK_PARKED:
+                current = AURC_VM_NO_TASK;
+                break;
+            case VM_TASK_FINISHED:
+                if (finish_task(vm, self, task_at(vm, current)) != 0) {
+                    vm_stop(vm, 0, 1);
+                    return;
+                }
+                current = AURC_VM_NO_TASK;
+                break;
+            case VM_TASK_STOPPED:
+                return;
+        }
+    }
+}
+
+static int worker_main(void *arg) {
+    vm_worker *worker = arg;
+    worker_loop(worker->vm, worker->index, AURC_VM_NO_TASK);
+    return 0;
+}
+
+/* Called from the main task's first spawn, on the calling thread (worker 0). */
+static int start_sched(aurc_vm *vm) {
+    unsigned workers = vm->worker_limit ? vm->worker_limit : aurc_cpu_count();
+    if (workers > VM_MAX_WORKERS) {
+        workers = VM_MAX_WORKERS;
+    }
+    aurc_vm_sched *sched = calloc(1, sizeof *sched);
+    vm_worker *pool = calloc(workers, sizeof *pool);
+    if (!sched || !pool || aurc_mutex_init(&sched->lock) != 0) {
+        free(sched);
+        free(pool);
+        return 1;
+    }
+    /* rows a whole number of lines long, so no two workers' rows share one */
+    sched->shard_lines = (shard_lines(vm) + ISA_SHARED_STRIDE / sizeof *sched->shards - 1) &
+                         ~(uint32_t)(ISA_SHARED_STRIDE / sizeof *sched->shards - 1);
+    sched->shards = alloc_lines((size_t)workers * sched->shard_lines * sizeof *sched->shards, &sched->shards_block);
+    if (!sched->shards || aurc_cond_init(&sched->idle) != 0) {
+        aurc_mutex_destroy(&sched->lock);
+        free(sched->shards_block);
+        free(sched);
+        free(pool);
+        return 1;
+    }
+    for (unsigned w = 0; w < workers; ++w) {
+        aurc_mutex_init(&pool[w].deque.lock);
+        pool[w].vm = vm;
+        pool[w].index = w;
+    }
+    sched->workers = pool;
+    sched->worker_count = workers;
+    sched->task_count = 1;
+    sched->started = 1;
+    vm->sched = sched;
+
+    /* a worker that fails to start just leaves more to steal for the rest */
+    aurc_mutex_lock(&sched->lock);
+    while (sched->started < workers && aurc_thread_start(&pool[sched->started].thread, worker_main, &pool[sched->started]) == 0) {
+        sched->started++;
+    }
+    aurc_mutex_unlock(&sched->lock);
+    return 0;
+}
+
+static void stop_sched(aurc_vm *vm) {
+    aurc_vm_sched *sched = vm->sched;
+    for (unsigned w = 1; w < sched->started; ++w) {
+        aurc_thread_join(&sched->workers[w].thread, NULL);
+    }
+    for (unsigned w = 0; w < sched->worker_count; ++w) {
+        aurc_mutex_destroy(&sched->workers[w].deque.lock);
+        free(sched->workers[w].deque.items);
+    }
+    /* main may have stopped on another worker, so its output waits until they are all joined;
+       what the tasks the stop cut short had printed follows in spawn order */
+    task_release_out(&vm->heap->caches[0], &vm->main);
+    for (uint32_t id = 1; id < sched->task_count; ++id) {
+        aurc_vm_task *task = task_at(vm, id);
+        task_release_out(&vm->heap->caches[0], task);
+        if (task->stack) {
+            aurc_pool_give(&vm->heap->caches[0], task->stack, AURC_VM_ARENA_SIZE - task->stack_low);
+        }
+    }
+    for (unsigned c = 0; c < VM_TASK_CHUNKS; ++c) {
+        free(sched->chunks[c]);
+    }
+    free(sched->shards_block);
+    aurc_cond_destroy(&sched->idle);
+    aurc_mutex_destroy(&sched->lock);
+    free(sched->workers);
+    free(sched);
+    vm->sched = NULL;
+}
+
+int aurc_vm_run(aurc_vm *vm) {
+    vm->bignums = bignum_table_new();
+    if (!vm->bignums) {
+        fprintf(stderr, "aurc-native: out of memory allocating bignum table\n");
+        return 1;
+    }
+    if (vm->pair_counts || vm->profile) {
+        for (uint32_t i = 0; i < vm->op_count; ++i) {
+            vm->ops[i].kind = VM_OP_PROFILE;
+        }
+    }
+    if (vm->profile) {
+        aurc_profile_task_start(vm->profile, AURC_VM_MAIN_TASK, vm->main.pc / ISA_WORD_SIZE);
+        if (aurc_profile_start(vm->profile) != 0) {
+            bignum_table_free(vm->bignums, &vm->heap->caches[0]);
+            vm->bignums = NULL;
+            return 1;
+        }
+    }
+    run_task(vm, 0, AURC_VM_NO_TASK, NULL);
+    worker_loop(vm, 0, AURC_VM_MAIN_TASK);
+    if (vm->sched) {
+        stop_sched(vm);
+    } else {
+        task_release_out(&vm->heap->caches[0], &vm->main);
+    }
+    if (vm->profile) {
+        aurc_profile_stop(vm->profile);
+    }
+    bignum_table_free(vm->bignums, &vm->heap->caches[0]);
+    vm->bignums = NULL;
+    return vm->faulted;
+}
+
+int aurc_vm_profile(aurc_vm *vm) {
+    vm->profile = aurc_profile_create(vm->rom, vm->op_count, vm->symbols, vm->symbols_size, VM_MAX_WORKERS,
+                                      VM_TASK_CHUNK * VM_TASK_CHUNKS, shard_lines(vm));
+    return vm->profile ? 0 : 1;
+}
+
+int aurc_vm_profile_pairs(aurc_vm *vm) {
+    vm->pair_counts = calloc((size_t)VM_MAX_WORKERS * VM_OP_KIND_COUNT * VM_OP_KIND_COUNT, sizeof *vm->pair_counts);
+    if (!vm->pair_counts) {
+        fprintf(stderr, "aurc-native: out of memory allocating pair profile\n");
+        return 1;
+    }
+    return 0;
+}
+
+typedef struct vm_pair_count {
+    uint64_t count;
+    unsigned first;
+    unsigned second;
+} vm_pair_count;
+
+static int compare_pair_counts(const void *a, const void *b) {
+    const vm_pair_count *x = a;
+    const vm_pair_count *y = b;
+    if (x->count != y->count) {
+        return x->count > y->count ? -1 : 1;
+    }
+    return x->first != y->first ? (x->first < y->first ? -1 : 1) : (x->second > y->second) - (x->second < y->second);
+}
+
+static int pair_is_fused(unsigned first, unsigned second) {
+    for (size_t p = 0; p < sizeof VM_FUSED_PAIRS / sizeof VM_FUSED_PAIRS[0]; ++p) {
+        if (VM_FUSED_PAIRS[p].first == first && VM_FUSED_PAIRS[p].second == second) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void aurc_vm_report_pairs(const aurc_vm *vm, unsigned top) {
+    vm_pair_count pairs[VM_OP_KIND_COUNT * VM_OP_KIND_COUNT];
+    uint64_t total = 0;
+    for (unsigned i = 0; i < VM_OP_KIND_COUNT * VM_OP_KIND_COUNT; ++i) {
+        pairs[i] = (vm_pair_count){0, i / VM_OP_KIND_COUNT, i % VM_OP_KIND_COUNT};
+        for (unsigned w = 0; w < VM_MAX_WORKERS; ++w) {
+            pairs[i].count += vm->pair_counts[(size_t)w * VM_OP_KIND_COUNT * VM_OP_KIND_COUNT + i];
+        }
+        total += pairs[i].count;
+    }
+    qsort(pairs, VM_OP_KIND_COUNT * VM_OP_KIND_COUNT, sizeof pairs[0], compare_pair_counts);
+    fprintf(stderr, "aurc-native: pair profile, %" PRIu64 " consecutive op pairs executed\n", total);
+    fprintf(stderr, "  %14s %7s  pair\n", "count", "share");
+    for (unsigned i = 0; i < top && i < VM_OP_KIND_COUNT * VM_OP_KIND_COUNT && pairs[i].count; ++i) {
+        fprintf(stderr, "  %14" PRIu64 " %6.2f%%  %s, %s%s\n", pairs[i].count, 100.0 * (double)pairs[i].count / (double)total,
+                VM_OP_NAMES[pairs[i].first], VM_OP_NAMES[pairs[i].second],
+                pair_is_fused(pairs[i].first, pairs[i].second) ? "  (fused)" : "");
+    }
+}
+
+void aurc_vm_unload(aurc_vm *vm) {
+    jit_free(vm);
+    if (vm->heap) {
+        aurc_pool_give(&vm->heap->caches[0], vm->main.stack, AURC_VM_ARENA_SIZE - vm->main.stack_low);
+        for (unsigned w = 0; w < VM_MAX_WORKERS; ++w) {
+            aurc_pool_cache_flush(&vm->heap->caches[w]);
+        }
+        aurc_pool_free(&vm->heap->pool);
+        free(vm->heap);
+        vm->heap = NULL;
+    }
+    vm->main.stack = NULL;
+    free(vm->arena_block);
+    vm->arena = NULL;
+    vm->arena_block = NULL;
+    aurc_profile_destroy(vm->profile);
+    vm->profile = NULL;
+    free(vm->ops);
+    free(vm->pair_counts);
+    vm->ops = NULL;
+    vm->pair_counts = NULL;
+    vm->op_count = 0;
+}
+
+int aurc_run_image(const char *image_path, const aurc_run_options *options, int *exit_status) {
+    /* mapped read-only: a container runs from the mapping, sharing its pages with other runs */
+    aurc_source image;
+    if (aurc_source_open(&image, image_path) != 0) {
+        return 1;
+    }
+
+    void *block;
+    aurc_vm *vm = alloc_lines(sizeof *vm, &block);
+    if (!vm) {
+        fprintf(stderr, "aurc-native: out of memory allocating vm\n");
+        aurc_source_close(&image);
+        return 1;
+    }
+    int rc = aurc_vm_load(vm, (const uint8_t *)image.text.data, image.text.len, image_path);
+    if (rc == 0 && options->pair_profile) {
+        rc = aurc_vm_profile_pairs(vm);
+    }
+    if (rc == 0 && options->profile) {
+        rc = aurc_vm_profile(vm);
+    }
+    if (rc == 0 && !options->pair_profile && !options->profile && !options->no_jit) {
+        rc = aurc_vm_enable_jit(vm);
+    }
+    if (rc == 0) {
+        vm->worker_limit = options->workers;
+        rc = aurc_vm_run(vm);
+    }
+    if (vm->pair_counts) {
+        fflush(stdout);
+        aurc_vm_report_pairs(vm, VM_PAIR_REPORT);
+    }
+    if (vm->profile && aurc_profile_write(vm->profile, image_path, options->profile) != 0) {
+        rc = 1;
+    }
+    if (rc == 0 && exit_status != NULL) {
+        *exit_status = vm->exit_status;
+    }
+    aurc_vm_unload(vm);
+    free(block);
+    aurc_source_close(&image);
+    return rc;
+}
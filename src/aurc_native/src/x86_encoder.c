@@ -0,0 +1,460 @@
+#include "aurc_x86.h"
+#include "aurc_diag.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void aurc_x86_init(aurc_x86_asm *as) {
+    aurc_bytes_init(&as->code);
+    aurc_bytes_init(&as->data);
+    as->labels = NULL;
+    as->label_count = 0;
+    as->label_cap = 0;
+    as->fixups = NULL;
+    as->fixup_count = 0;
+    as->fixup_cap = 0;
+    as->failed = 0;
+}
+
+void aurc_x86_free(aurc_x86_asm *as) {
+    aurc_bytes_free(&as->code);
+    aurc_bytes_free(&as->data);
+    free(as->labels);
+    free(as->fixups);
+    aurc_x86_init(as);
+}
+
+static void emit_bytes(aurc_x86_asm *as, const uint8_t *bytes, size_t len) {
+    if (aurc_bytes_append(&as->code, bytes, len) != 0) {
+        as->failed = 1;
+    }
+}
+
+static void emit_u8(aurc_x86_asm *as, uint8_t value) {
+    emit_bytes(as, &value, 1);
+}
+
+static void emit_le32(aurc_x86_asm *as, uint32_t value) {
+    if (aurc_bytes_append_le32(&as->code, value) != 0) {
+        as->failed = 1;
+    }
+}
+
+static void emit_rex(aurc_x86_asm *as, int wide, unsigned reg, unsigned rm) {
+    uint8_t rex = (uint8_t)(0x40 | (wide ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((rm & 8) ? 0x01 : 0));
+    if (rex != 0x40) {
+        emit_u8(as, rex);
+    }
+}
+
+static void emit_modrm(aurc_x86_asm *as, unsigned mod, unsigned reg, unsigned rm) {
+    emit_u8(as, (uint8_t)((mod << 6) | ((reg & 7) << 3) | (rm & 7)));
+}
+
+static void add_fixup(aurc_x86_asm *as, x86_fixup_kind kind, uint32_t target, uint8_t trailing) {
+    if (as->fixup_count == as->fixup_cap) {
+        size_t cap = as->fixup_cap ? as->fixup_cap * 2 : 32;
+        x86_fixup *fixups = realloc(as->fixups, cap * sizeof *fixups);
+        if (!fixups) {
+            as->failed = 1;
+            return;
+        }
+        as->fixups = fixups;
+        as->fixup_cap = cap;
+    }
+    x86_fixup *fixup = &as->fixups[as->fixup_count++];
+    fixup->offset = as->code.len;
+    fixup->target = target;
+    fixup->trailing = trailing;
+    fixup->kind = kind;
+    emit_le32(as, 0);
+}
+
+uint32_t x86_new_label(aurc_x86_asm *as) {
+    if (as->label_count == as->label_cap) {
+        size_t cap = as->label_cap ? as->label_cap * 2 : 16;
+        size_t *labels = realloc(as->labels, cap * sizeof *labels);
+        if (!labels) {
+            as->failed = 1;
+            return 0;
+        }
+        as->labels = labels;
+        as->label_cap = cap;
+    }
+    as->labels[as->label_count] = X86_LABEL_UNBOUND;
+    return (uint32_t)as->label_count++;
+}
+
+void x86_bind_label(aurc_x86_asm *as, uint32_t label) {
+    if (label < as->label_count) {
+        as->labels[label] = as->code.len;
+    }
+}
+
+uint32_t x86_add_data(aurc_x86_asm *as, const void *bytes, size_t len) {
+    /* keep every data item 8-byte aligned */
+    size_t pad = (8 - (as->data.len & 7)) & 7;
+    if (aurc_bytes_append_zeros(&as->data, pad) != 0) {
+        as->failed = 1;
+        return 0;
+    }
+    uint32_t offset = (uint32_t)as->data.len;
+    if (aurc_bytes_append(&as->data, bytes, len) != 0) {
+        as->failed = 1;
+    }
+    return offset;
+}
+
+void x86_mov_reg_imm(aurc_x86_asm *as, x86_reg dst, int64_t value) {
+    if (value >= 0 && value <= (int64_t)UINT32_MAX) {
+        /* mov r32, imm32 zero-extends into the full register */
+        emit_rex(as, 0, 0, dst);
+        emit_u8(as, (uint8_t)(0xB8 + (dst & 7)));
+        emit_le32(as, (uint32_t)value);
+    } else if (value >= INT32_MIN && value <= INT32_MAX) {
+        emit_rex(as, 1, 0, dst);
+        emit_u8(as, 0xC7);
+        emit_modrm(as, 3, 0, dst);
+        emit_le32(as, (uint32_t)(int32_t)value);
+    } else {
+        emit_rex(as, 1, 0, dst);
+        emit_u8(as, (uint8_t)(0xB8 + (dst & 7)));
+        emit_le32(as, (uint32_t)((uint64_t)value & 0xFFFFFFFFu));
+        emit_le32(as, (uint32_t)((uint64_t)value >> 32));
+    }
+}
+
+void x86_mov_reg_reg(aurc_x86_asm *as, x86_reg dst, x86_reg src) {
+    emit_rex(as, 1, src, dst);
+    emit_u8(as, 0x89);
+    emit_modrm(as, 3, src, dst);
+}
+
+void x86_alu_reg_reg(aurc_x86_asm *as, x86_alu_op op, x86_reg dst, x86_reg src) {
+    emit_rex(as, 1, src, dst);
+    emit_u8(as, (uint8_t)((op << 3) | 0x01));
+    emit_modrm(as, 3, src, dst);
+}
+
+void x86_alu_reg_imm(aurc_x86_asm *as, x86_alu_op op, x86_reg dst, int32_t imm) {
+    emit_rex(as, 1, 0, dst);
+    if (imm >= -128 && imm <= 127) {
+        emit_u8(as, 0x83);
+        emit_modrm(as, 3, op, dst);
+        emit_u8(as, (uint8_t)(int8_t)imm);
+    } else {
+        emit_u8(as, 0x81);
+        emit_modrm(as, 3, op, dst);
+        emit_le32(as, (uint32_t)imm);
+    }
+}
+
+void x86_imul_reg_reg(aurc_x86_asm *as, x86_reg dst, x86_reg src) {
+    emit_rex(as, 1, dst, src);
+    emit_u8(as, 0x0F);
+    emit_u8(as, 0xAF);
+    emit_modrm(as, 3, dst, src);
+}
+
+void x86_test_reg_reg(aurc_x86_asm *as, x86_reg lhs, x86_reg rhs) {
+    emit_rex(as, 1, rhs, lhs);
+    emit_u8(as, 0x85);
+    emit_modrm(as, 3, rhs, lhs);
+}
+
+void x86_unary(aurc_x86_asm *as, x86_unary_op op, x86_reg reg) {
+    emit_rex(as, 1, 0, reg);
+    emit_u8(as, 0xF7);
+    emit_modrm(as, 3, op, reg);
+}
+
+void x86_shift_cl(aurc_x86_asm *as, x86_shift_op op, x86_reg reg) {
+    emit_rex(as, 1, 0, reg);
+    emit_u8(as, 0xD3);
+    emit_modrm(as, 3, op, reg);
+}
+
+void x86_shift_imm(aurc_x86_asm *as, x86_shift_op op, x86_reg reg, uint8_t count) {
+    emit_rex(as, 1, 0, reg);
+    emit_u8(as, 0xC1);
+    emit_modrm(as, 3, op, reg);
+    emit_u8(as, count);
+}
+
+void x86_cqo(aurc_x86_asm *as) {
+    emit_u8(as, 0x48);
+    emit_u8(as, 0x99);
+}
+
+void x86_setcc(aurc_x86_asm *as, x86_cond cond, x86_reg reg) {
+    /* any REX prefix selects spl/bpl/sil/dil instead of ah/ch/dh/bh */
+    if (reg >= X86_RSP) {
+        emit_u8(as, (uint8_t)(0x40 | ((reg & 8) ? 0x01 : 0)));
+    }
+    emit_u8(as, 0x0F);
+    emit_u8(as, (uint8_t)(0x90 | cond));
+    emit_modrm(as, 3, 0, reg);
+}
+
+void x86_push(aurc_x86_asm *as, x86_reg reg) {
+    emit_rex(as, 0, 0, reg);
+    emit_u8(as, (uint8_t)(0x50 + (reg & 7)));
+}
+
+void x86_pop(aurc_x86_asm *as, x86_reg reg) {
+    emit_rex(as, 0, 0, reg);
+    emit_u8(as, (uint8_t)(0x58 + (reg & 7)));
+}
+
+/* ModR/M (+SIB, +disp) for [base + disp]; rbp/r13 always need a displacement, rsp/r12 a SIB byte. */
+static void emit_mem(aurc_x86_asm *as, unsigned reg, x86_reg base, int32_t disp) {
+    unsigned mod = 2;
+    if (disp == 0 && (base & 7) != X86_RBP) {
+        mod = 0;
+    } else if (disp >= -128 && disp <= 127) {
+        mod = 1;
+    }
+    emit_modrm(as, mod, reg, base);
+    if ((base & 7) == X86_RSP) {
+        emit_u8(as, 0x24);
+    }
+    if (mod == 1) {
+        emit_u8(as, (uint8_t)(int8_t)disp);
+    } else if (mod == 2) {
+        emit_le32(as, (uint32_t)disp);
+    }
+}
+
+void x86_mov_reg_mem(aurc_x86_asm *as, x86_reg dst, x86_reg base, int32_t disp) {
+    emit_rex(as, 1, dst, base);
+    emit_u8(as, 0x8B);
+    emit_mem(as, dst, base, disp);
+}
+
+void x86_mov_mem_reg(aurc_x86_asm *as, x86_reg base, int32_t disp, x86_reg src) {
+    emit_rex(as, 1, src, base);
+    emit_u8(as, 0x89);
+    emit_mem(as, src, base, disp);
+}
+
+void x86_mov_mem_imm(aurc_x86_asm *as, x86_reg base, int32_t disp, int32_t imm) {
+    emit_rex(as, 1, 0, base);
+    emit_u8(as, 0xC7);
+    emit_mem(as, 0, base, disp);
+    emit_le32(as, (uint32_t)imm);
+}
+
+void x86_mov_mem8_reg(aurc_x86_asm *as, x86_reg base, int32_t disp, x86_reg src) {
+    if (src >= X86_RSP || base >= X86_R8) {
+        emit_u8(as, (uint8_t)(0x40 | ((src & 8) ? 0x04 : 0) | ((base & 8) ? 0x01 : 0)));
+    }
+    emit_u8(as, 0x88);
+    emit_mem(as, src, base, disp);
+}
+
+void x86_mov_mem8_imm(aurc_x86_asm *as, x86_reg base, int32_t disp, uint8_t imm) {
+    emit_rex(as, 0, 0, base);
+    emit_u8(as, 0xC6);
+    emit_mem(as, 0, base, disp);
+    emit_u8(as, imm);
+}
+
+void x86_lock_add_mem_reg(aurc_x86_asm *as, x86_reg base, int32_t disp, x86_reg src) {
+    emit_u8(as, 0xF0);
+    emit_rex(as, 1, src, base);
+    emit_u8(as, 0x01);
+    emit_mem(as, src, base, disp);
+}
+
+/* xchg with memory is implicitly locked: a sequentially consistent store */
+void x86_xchg_mem_reg(aurc_x86_asm *as, x86_reg base, int32_t disp, x86_reg reg) {
+    emit_rex(as, 1, reg, base);
+    emit_u8(as, 0x87);
+    emit_mem(as, reg, base, disp);
+}
+
+void x86_lea_mem(aurc_x86_asm *as, x86_reg dst, x86_reg base, int32_t disp) {
+    emit_rex(as, 1, dst, base);
+    emit_u8(as, 0x8D);
+    emit_mem(as, dst, base, disp);
+}
+
+void x86_lea_data(aurc_x86_asm *as, x86_reg dst, uint32_t data_offset) {
+    emit_rex(as, 1, dst, 0);
+    emit_u8(as, 0x8D);
+    emit_modrm(as, 0, dst, 5); /* [rip + disp32] */
+    add_fixup(as, X86_FIXUP_DATA, data_offset, 0);
+}
+
+void x86_lea_rsp(aurc_x86_asm *as, x86_reg dst, int8_t disp) {
+    emit_rex(as, 1, dst, 0);
+    emit_u8(as, 0x8D);
+    emit_modrm(as, 1, dst, 4);
+    emit_u8(as, 0x24); /* SIB: base = rsp */
+    emit_u8(as, (uint8_t)disp);
+}
+
+void x86_mov_rsp_imm(aurc_x86_asm *as, int8_t disp, int32_t imm) {
+    emit_rex(as, 1, 0, 0);
+    emit_u8(as, 0xC7);
+    emit_modrm(as, 1, 0, 4);
+    emit_u8(as, 0x24);
+    emit_u8(as, (uint8_t)disp);
+    emit_le32(as, (uint32_t)imm);
+}
+
+void x86_jmp(aurc_x86_asm *as, uint32_t label) {
+    emit_u8(as, 0xE9);
+    add_fixup(as, X86_FIXUP_LABEL, label, 0);
+}
+
+void x86_jcc(aurc_x86_asm *as, x86_cond cond, uint32_t label) {
+    emit_u8(as, 0x0F);
+    emit_u8(as, (uint8_t)(0x80 | cond));
+    add_fixup(as, X86_FIXUP_LABEL, label, 0);
+}
+
+void x86_call(aurc_x86_asm *as, uint32_t label) {
+    emit_u8(as, 0xE8);
+    add_fixup(as, X86_FIXUP_LABEL, label, 0);
+}
+
+void x86_call_import(aurc_x86_asm *as, aurc_import import) {
+    emit_u8(as, 0xFF);
+    emit_modrm(as, 0, 2, 5); /* call qword [rip + disp32] */
+    add_fixup(as, X86_FIXUP_IMPORT, (uint32_t)import, 0);
+}
+
+void x86_ret(aurc_x86_asm *as) {
+    emit_u8(as, 0xC3);
+}
+
+void x86_syscall(aurc_x86_asm *as) {
+    emit_u8(as, 0x0F);
+    emit_u8(as, 0x05);
+}
+
+/* ---- packed integer instructions ---------------------------------------- */
+
+#define VEC_MAP_0F 1u
+#define VEC_MAP_0F38 2u
+#define VEC_MAP_0F3A 3u
+#define VEC_PP_66 1u
+#define VEC_PP_F3 2u
+
+/*
+ * One packed instruction: prefix, map and opcode, then ModR/M with reg in the
+ * reg field and rm either a register or, when base is not negative, the
+ * memory operand [base + disp]. vvvv is the extra VEX source (ignored by the
+ * legacy encoding).
+ */
+static void emit_vec(aurc_x86_asm *as, x86_vec_mode mode, unsigned pp, unsigned map, int wide, uint8_t opcode,
+                     unsigned reg, unsigned vvvv, unsigned rm, int base, int32_t disp) {
+    unsigned rm_reg = base >= 0 ? (unsigned)base : rm;
+    if (mode == X86_VEC_SSE) {
+        emit_u8(as, pp == VEC_PP_66 ? 0x66 : 0xF3);
+        emit_rex(as, wide, reg, rm_reg);
+        emit_u8(as, 0x0F);
+        if (map == VEC_MAP_0F38) {
+            emit_u8(as, 0x38);
+        } else if (map == VEC_MAP_0F3A) {
+            emit_u8(as, 0x3A);
+        }
+    } else {
+        /* three-byte VEX: inverted R, X, B, then W, inverted vvvv, L and pp */
+        emit_u8(as, 0xC4);
+        emit_u8(as, (uint8_t)(((reg & 8) ? 0 : 0x80) | 0x40 | ((rm_reg & 8) ? 0 : 0x20) | map));
+        emit_u8(as, (uint8_t)((wide ? 0x80 : 0) | ((~vvvv & 15u) << 3) | (mode == X86_VEC_VEX256 ? 0x04 : 0) | pp));
+    }
+    emit_u8(as, opcode);
+    if (base >= 0) {
+        emit_mem(as, reg, (x86_reg)base, disp);
+    } else {
+        emit_modrm(as, 3, reg, rm);
+    }
+}
+
+void x86_vec_alu(aurc_x86_asm *as, x86_vec_mode mode, x86_vec_op op, unsigned dst, unsigned lhs, unsigned rhs) {
+    emit_vec(as, mode, VEC_PP_66, VEC_MAP_0F, 0, (uint8_t)op, dst, lhs, rhs, -1, 0);
+}
+
+void x86_vec_shift_imm(aurc_x86_asm *as, x86_vec_mode mode, x86_vec_shift op, unsigned dst, unsigned src, uint8_t count) {
+    /* the legacy form shifts its rm operand in place; VEX writes vvvv */
+    emit_vec(as, mode, VEC_PP_66, VEC_MAP_0F, 0, 0x73, op, dst, mode == X86_VEC_SSE ? dst : src, -1, 0);
+    emit_u8(as, count);
+}
+
+void x86_vec_mov(aurc_x86_asm *as, x86_vec_mode mode, unsigned dst, unsigned src) {
+    emit_vec(as, mode, VEC_PP_66, VEC_MAP_0F, 0, 0x6F, dst, 0, src, -1, 0);
+}
+
+void x86_vec_load(aurc_x86_asm *as, x86_vec_mode mode, unsigned dst, x86_reg base, int32_t disp) {
+    emit_vec(as, mode, VEC_PP_F3, VEC_MAP_0F, 0, 0x6F, dst, 0, 0, (int)base, disp);
+}
+
+void x86_vec_shuffle32(aurc_x86_asm *as, x86_vec_mode mode, unsigned dst, unsigned src, uint8_t order) {
+    emit_vec(as, mode, VEC_PP_66, VEC_MAP_0F, 0, 0x70, dst, 0, src, -1, 0);
+    emit_u8(as, order);
+}
+
+void x86_vec_from_reg(aurc_x86_asm *as, x86_vec_mode mode, unsigned dst, x86_reg src) {
+    emit_vec(as, mode == X86_VEC_SSE ? X86_VEC_SSE : X86_VEC_VEX128, VEC_PP_66, VEC_MAP_0F, 1, 0x6E, dst, 0, src, -1, 0);
+}
+
+void x86_vec_to_reg(aurc_x86_asm *as, x86_vec_mode mode, x86_reg dst, unsigned src) {
+    emit_vec(as, mode == X86_VEC_SSE ? X86_VEC_SSE : X86_VEC_VEX128, VEC_PP_66, VEC_MAP_0F, 1, 0x7E, src, 0, dst, -1, 0);
+}
+
+void x86_vec_broadcast(aurc_x86_asm *as, unsigned dst, unsigned src) {
+    emit_vec(as, X86_VEC_VEX256, VEC_PP_66, VEC_MAP_0F38, 0, 0x59, dst, 0, src, -1, 0);
+}
+
+void x86_vec_extract_high(aurc_x86_asm *as, unsigned dst, unsigned src) {
+    emit_vec(as, X86_VEC_VEX256, VEC_PP_66, VEC_MAP_0F3A, 0, 0x39, src, 0, dst, -1, 0);
+    emit_u8(as, 1);
+}
+
+void x86_vzeroupper(aurc_x86_asm *as) {
+    static const uint8_t bytes[] = {0xC5, 0xF8, 0x77};
+    emit_bytes(as, bytes, sizeof bytes);
+}
+
+int aurc_x86_link(aurc_x86_asm *as, uint64_t code_base, uint64_t data_base, const uint64_t *import_slots) {
+    if (as->failed) {
+        aurc_diag_printf("aurc-native: out of memory while encoding x86-64 code\n");
+        return 1;
+    }
+    for (size_t i = 0; i < as->fixup_count; ++i) {
+        const x86_fixup *fixup = &as->fixups[i];
+        uint64_t target;
+        switch (fixup->kind) {
+            case X86_FIXUP_LABEL:
+                if (fixup->target >= as->label_count || as->labels[fixup->target] == X86_LABEL_UNBOUND) {
+                    aurc_diag_printf("aurc-native: unbound x86 label %u\n", fixup->target);
+                    return 1;
+                }
+                target = code_base + as->labels[fixup->target];
+                break;
+            case X86_FIXUP_DATA:
+                target = data_base + fixup->target;
+                break;
+            case X86_FIXUP_IMPORT:
+                if (import_slots == NULL || fixup->target >= AURC_IMPORT_COUNT) {
+                    aurc_diag_printf("aurc-native: import reference not supported by target container\n");
+                    return 1;
+                }
+                target = import_slots[fixup->target];
+                break;
+            default:
+                return 1;
+        }
+        uint64_t next = code_base + fixup->offset + 4 + fixup->trailing;
+        int64_t rel = (int64_t)(target - next);
+        if (rel < INT32_MIN || rel > INT32_MAX) {
+            aurc_diag_printf("aurc-native: x86 displacement out of rel32 range\n");
+            return 1;
+        }
+        aurc_bytes_patch_le32(&as->code, fixup->offset, (uint32_t)(int32_t)rel);
+    }
+    return 0;
+}
@@ -0,0 +1,363 @@
+#!/usr/bin/env python3
+"""Regression tests for aurc-native (`make test` / `ctest`).
+
+Every program of the corpus (examples/, pipeline/examples/ and the fixtures
+next to this file) is compiled at -O0, -O1 and -O2 and checked for:
+- manifest/image parity: assembling the `-o` manifest gives the same bytes
+  as `--emit-bin`, which packs the words directly;
+- optimizer parity: the VM prints the same output and exits with the same
+  status at every level, and matches `<fixture>.expected` when there is one;
+- JIT parity: the interpreter alone (`run --no-jit`) behaves as the default
+  run, which compiles hot loops;
+- scheduler parity: programs that spawn behave the same on one worker and
+  on eight (`run -j 1`, `run -j 8`) as with one per processor;
+- executables: `--emit-exe` for the host compiles at every level, and on an
+  x86-64 Linux or Windows host the executable behaves as the VM image does
+  (programs using what executables cannot do yet only run in the VM);
+- the cache: a second compile with `--cache-dir` hits and reproduces the
+  first one's .aurs, .bin and .exe byte for byte, while another -O level or
+  --target-os misses.
+
+A damaged `--cache-dir` entry must be discarded and recompiled, never copied
+out as output. Smoke tests drive `compile-many` over a directory with one
+bad input and a `--serve` session with a good job, a missing file and an
+unknown flag.
+
+Manifests the compiler must reproduce exactly live in fixtures/manifests/,
+named after the program; `--update-manifests` rewrites them from the
+current compiler. Programs using features the native backend does not
+support yet (floats, arrays) are skipped, and the run says how many.
+
+Usage:
+    python run_tests.py --compiler ./aurc-native [--work-dir build/tests] [--update-manifests]
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import platform
+import shutil
+import subprocess
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+from typing import List, Optional
+
+ROOT = Path(__file__).resolve().parents[3]
+FIXTURES = Path(__file__).resolve().parent / "fixtures"
+LEVELS = ["-O0", "-O1", "-O2"]
+WORKER_COUNTS = ["1", "8"]      # run -j for programs that spawn, besides the default of one per processor
+# Every program gets the same input; the ones that read integers see these.
+STDIN = "12\n34\n56\n"
+TIMEOUT_S = 60
+UNSUPPORTED = "not supported by the native backend yet"
+EXE_UNSUPPORTED = "not supported by --emit-exe yet"     # input, threads, bignums: VM only
+
+# Programs the corpus globs pick up that are not meant to compile here.
+EXCLUDED = {
+    "pipeline/examples/pause_test.aur": "uses the pipeline's pause service",
+}
+
+# ---------------------------------------------------------------------------
+# Corpus
+# ---------------------------------------------------------------------------
+
+@dataclass
+class Program:
+    name: str
+    source: Path
+    expected: Optional[Path] = None     # exact stdout, then a final `exit <status>` line
+
+    @property
+    def spawns(self) -> bool:
+        return "spawn" in self.source.read_text(encoding="utf-8")
+
+
+def corpus() -> List[Program]:
+    programs = []
+    for directory in (ROOT / "examples", ROOT / "pipeline" / "examples"):
+        for source in sorted(directory.glob("*.aur")):
+            relative = source.relative_to(ROOT).as_posix()
+            if relative not in EXCLUDED:
+                programs.append(Program(relative, source))
+    for source in sorted(FIXTURES.glob("*.aur")):
+        expected = source.with_suffix(".expected")
+        programs.append(Program(f"fixtures/{source.name}", source, expected if expected.exists() else None))
+    return programs
+
+
+def native_target() -> Optional[str]:
+    """The --target-os whose executables this host runs, if any."""
+    if platform.machine().lower() not in ("x86_64", "amd64"):
+        return None
+    if sys.platform.startswith("linux"):
+        return "linux"
+    if sys.platform == "win32":
+        return "windows"
+    return None
+
+# ---------------------------------------------------------------------------
+# Checks
+# ---------------------------------------------------------------------------
+
+def run(command: List[str], stdin: str = "") -> subprocess.CompletedProcess:
+    try:
+        return subprocess.run(command, input=stdin, capture_output=True, text=True, timeout=TIMEOUT_S)
+    except subprocess.TimeoutExpired:
+        return subprocess.CompletedProcess(command, -1, "", f"timed out after {TIMEOUT_S} s")
+
+
+def outcome(done: subprocess.CompletedProcess) -> str:
+    return f"{done.stdout}exit {done.returncode}\n"
+
+
+def check_program(compiler: str, program: Program, work: Path, target: Optional[str]) -> Optional[List[str]]:
+    """The failures found for program, or None when the native backend does not support it."""
+    failures = []
+    stem = program.name.replace("/", "_").rsplit(".", 1)[0]
+    outcomes = {}
+    for level in LEVELS:
+        manifest = work / f"{stem}{level}.aurs"
+        image = work / f"{stem}{level}.bin"
+        done = run([compiler, "compile", str(program.source), level, "-o", str(manifest), "--emit-bin", str(image)])
+        if done.returncode != 0:
+            if UNSUPPORTED in done.stderr:
+                return None
+            failures.append(f"{level}: compile failed (status {done.returncode})\n{done.stderr}")
+            continue
+
+        assembled = work / f"{stem}{level}.assembled.bin"
+        done = run([compiler, "assemble", str(manifest), "-o", str(assembled)])
+        if done.returncode != 0:
+            failures.append(f"{level}: assembling the manifest failed\n{done.stderr}")
+        elif assembled.read_bytes() != image.read_bytes():
+            failures.append(f"{level}: the assembled manifest differs from --emit-bin")
+        outcomes[level] = outcome(run([compiler, "run", str(image)], STDIN))
+        interpreted = outcome(run([compiler, "run", str(image), "--no-jit"], STDIN))
+        if interpreted != outcomes[level]:
+            failures.append(f"{level}: run --no-jit gives\n{interpreted}but the JIT\n{outcomes[level]}")
+        for workers in WORKER_COUNTS if program.spawns else []:
+            scheduled = outcome(run([compiler, "run", str(image), "-j", workers], STDIN))
+            if scheduled != outcomes[level]:
+                failures.append(f"{level}: run -j {workers} gives\n{scheduled}but the default run\n{outcomes[level]}")
+
+        exe = work / f"{stem}{level}.exe"
+        done = run([compiler, "compile", str(program.source), level, "--emit-exe", str(exe)] +
+                   (["--target-os", target] if target else []))
+        if done.returncode != 0:
+            if EXE_UNSUPPORTED not in done.stderr:
+                failures.append(f"{level}: --emit-exe failed (status {done.returncode})\n{done.stderr}")
+        elif target:
+            native = outcome(run([str(exe.resolve())], STDIN))
+            if native != outcomes[level]:
+                failures.append(f"{level}: the executable gives\n{native}but the VM\n{outcomes[level]}")
+
+    reference = outcomes.get(LEVELS[0])
+    for level, result in outcomes.items():
+        if reference is not None and result != reference:
+            failures.append(f"{level} gives\n{result}but {LEVELS[0]}\n{reference}")
+    if program.expected and reference is not None:
+        expected = program.expected.read_text(encoding="utf-8")
+        if reference != expected:
+            failures.append(f"{LEVELS[0]} gives\n{reference}but {program.expected.name} expects\n{expected}")
+    return failures + check_cache(compiler, program, work, target)
+
+
+def check_manifests(compiler: str, work: Path, update: bool) -> List[str]:
+    """fixtures/manifests/<name>.aurs is the manifest examples/<name>.aur compiles to at the default level."""
+    failures = []
+    for golden in sorted((FIXTURES / "manifests").glob("*.aurs")):
+        source = ROOT / "examples" / f"{golden.stem}.aur"
+        manifest = work / f"manifest_{golden.name}"
+        done = run([compiler, "compile", str(source), "-o", str(manifest)])
+        if done.returncode != 0:
+            failures.append(f"{golden.name}: compile failed\n{done.stderr}")
+        elif update:
+            golden.write_bytes(manifest.read_bytes())
+        elif manifest.read_bytes() != golden.read_bytes():
+            failures.append(f"{golden.name}: examples/{source.name} no longer compiles to this manifest "
+                            f"(rerun with --update-manifests if the change is intended)")
+    return failures
+
+
+# ---------------------------------------------------------------------------
+# Cache
+# ---------------------------------------------------------------------------
+
+def cache_compile(compiler: str, source: Path, outputs: List[str], cache: Path, stats: Path) -> Optional[int]:
+    """Compile through the cache; the cache_hits counter, or None when the compile failed."""
+    done = run([compiler, "compile", str(source)] + outputs + ["--cache-dir", str(cache), "--stats-json", str(stats)])
+    if done.returncode != 0:
+        return None
+    return json.loads(stats.read_text(encoding="utf-8"))["counters"]["cache_hits"]
+
+
+def check_cache(compiler: str, program: Program, work: Path, target: Optional[str]) -> List[str]:
+    """Compiling twice into one cache hits with identical outputs; another -O or --target-os misses."""
+    stem = program.name.replace("/", "_").rsplit(".", 1)[0]
+    cache = work / f"cache_{stem}"
+    shutil.rmtree(cache, ignore_errors=True)
+    stats = work / f"cache_{stem}.json"
+    target_os = target or "linux"
+
+    def outputs(tag: str, exe: bool) -> List[Path]:
+        paths = [work / f"cache_{stem}_{tag}.aurs", work / f"cache_{stem}_{tag}.bin"]
+        return paths + [work / f"cache_{stem}_{tag}.exe"] if exe else paths
+
+    def flags(paths: List[Path], level: str, os_name: str) -> List[str]:
+        result = [level, "--target-os", os_name, "-o", str(paths[0]), "--emit-bin", str(paths[1])]
+        return result + ["--emit-exe", str(paths[2])] if len(paths) == 3 else result
+
+    exe = True
+    first = outputs("first", exe)
+    hits = cache_compile(compiler, program.source, flags(first, "-O1", target_os), cache, stats)
+    if hits is None:
+        # programs --emit-exe cannot compile yet cache their manifest and image only
+        exe = False
+        first = outputs("first", exe)
+        hits = cache_compile(compiler, program.source, flags(first, "-O1", target_os), cache, stats)
+    if hits != 0:
+        return [f"cache: the first compile gave cache_hits {hits}, expected 0"]
+    second = outputs("second", exe)
+    hits = cache_compile(compiler, program.source, flags(second, "-O1", target_os), cache, stats)
+    if hits != 1:
+        return [f"cache: the second compile gave cache_hits {hits}, expected 1"]
+    failures = [f"cache: the hit's {b.suffix} differs from the compile's" for a, b in zip(first, second)
+                if a.read_bytes() != b.read_bytes()]
+    other_os = "windows" if target_os == "linux" else "linux"
+    for level, os_name in (("-O2", target_os), ("-O1", other_os)):
+        hits = cache_compile(compiler, program.source, flags(outputs("other", exe), level, os_name), cache, stats)
+        if hits != 0:
+            failures.append(f"cache: {level} --target-os {os_name} gave cache_hits {hits}, expected a miss")
+    return failures
+
+
+def check_cache_damage(compiler: str, work: Path) -> List[str]:
+    """Entries overwritten, emptied or with one content byte flipped are misses, and the compile stores good ones."""
+    failures = []
+    source = ROOT / "examples" / "loop_sum.aur"
+    cache = work / "cache_damage"
+    stats = work / "cache_damage.json"
+    fresh = [work / "cache_damage_fresh.aurs", work / "cache_damage_fresh.bin"]
+
+    def garbage(data: bytes) -> bytes:
+        return b"garbage"
+
+    def empty(data: bytes) -> bytes:
+        return b""
+
+    def flipped(data: bytes) -> bytes:
+        return data[:-1] + bytes([data[-1] ^ 1])
+
+    for damage in (garbage, empty, flipped):
+        shutil.rmtree(cache, ignore_errors=True)
+        hits = cache_compile(compiler, source, ["-o", str(fresh[0]), "--emit-bin", str(fresh[1])], cache, stats)
+        if hits != 0:
+            return [f"the first compile into an empty cache gave cache_hits {hits}"]
+        for entry in cache.iterdir():
+            entry.write_bytes(damage(entry.read_bytes()))
+        copies = [work / f"cache_damage_{damage.__name__}{path.suffix}" for path in fresh]
+        outputs = ["-o", str(copies[0]), "--emit-bin", str(copies[1])]
+        hits = cache_compile(compiler, source, outputs, cache, stats)
+        if hits != 0:
+            failures.append(f"{damage.__name__} entries: cache_hits {hits}, expected a recompile")
+        elif any(copy.read_bytes() != path.read_bytes() for copy, path in zip(copies, fresh)):
+            failures.append(f"{damage.__name__} entries: the recompiled outputs differ from the first compile")
+        elif cache_compile(compiler, source, outputs, cache, stats) != 1:
+            failures.append(f"{damage.__name__} entries: the recompile did not store entries that hit")
+    return failures
+
+
+def check_compile_many(compiler: str, work: Path) -> List[str]:
+    """compile-many over a directory with one bad input compiles the rest into a new nested --out-dir and fails."""
+    inputs = work / "compile_many"
+    out_dir = inputs / "out" / "nested"
+    shutil.rmtree(inputs, ignore_errors=True)
+    inputs.mkdir(parents=True)
+    good = ["hello_world", "loop_sum"]
+    for name in good:
+        shutil.copy(ROOT / "examples" / f"{name}.aur", inputs / f"{name}.aur")
+    (inputs / "broken.aur").write_text("fn main( -> int {\n", encoding="utf-8")
+    done = run([compiler, "compile-many", str(inputs), "--out-dir", str(out_dir), "-j", "2"])
+    failures = []
+    if done.returncode == 0:
+        failures.append("compile-many exited 0 although one input does not compile")
+    if f"compiled {len(good)} of {len(good) + 1} inputs" not in done.stdout:
+        failures.append(f"compile-many did not report {len(good)} of {len(good) + 1} compiled: {done.stdout.strip()!r}")
+    if "broken.aur: compilation failed" not in done.stderr:
+        failures.append("compile-many did not name the input that failed")
+    missing = [name for name in good if not (out_dir / f"{name}.bin").is_file()]
+    if missing:
+        failures.append(f"compile-many left no {', '.join(missing)} .bin in the --out-dir it creates")
+    return failures
+
+
+def check_serve(compiler: str, work: Path) -> List[str]:
+    """--serve answers ok or error per job line and stops at `quit`."""
+    source = ROOT / "examples" / "loop_sum.aur"
+    image = work / "serve_loop_sum.bin"
+    missing = work / "serve_missing.aur"
+    after = work / "serve_after_quit.bin"
+    for path in (image, after):
+        path.unlink(missing_ok=True)
+    jobs = [f"{source} --emit-bin {image}", f"{missing} --emit-bin {work / 'serve_missing.bin'}",
+            f"{source} --no-such-flag", "quit", f"{source} --emit-bin {after}"]
+    done = run([compiler, "--serve"], "\n".join(jobs) + "\n")
+    expected = [f"ok {source}", f"error {missing}", f"error {source}"]
+    failures = []
+    if done.returncode != 0:
+        failures.append(f"--serve exited {done.returncode}")
+    if done.stdout.splitlines() != expected:
+        failures.append(f"--serve answered {done.stdout.splitlines()}, expected {expected}")
+    if not image.is_file():
+        failures.append("--serve answered ok but wrote no image")
+    if after.exists():
+        failures.append("--serve ran a job after quit")
+    return failures
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Run the aurc-native regression tests")
+    parser.add_argument("--compiler", required=True, help="path to the aurc-native executable")
+    parser.add_argument("--work-dir", type=Path, default=Path("test-work"), help="scratch directory for outputs")
+    parser.add_argument("--update-manifests", action="store_true", help="rewrite fixtures/manifests/ instead of "
+                        "comparing against it")
+    args = parser.parse_args()
+
+    args.work_dir.mkdir(parents=True, exist_ok=True)
+    compiler = str(Path(args.compiler).resolve())
+    target = native_target()
+    failed = 0
+    checked = 0
+    skipped = 0
+    for program in corpus():
+        failures = check_program(compiler, program, args.work_dir, target)
+        if failures is None:
+            skipped += 1
+            continue
+        checked += 1
+        if failures:
+            failed += 1
+            print(f"FAIL {program.name}", *failures, sep="\n  ")
+    failures = check_manifests(compiler, args.work_dir, args.update_manifests)
+    if failures:
+        failed += 1
+        print("FAIL manifests", *failures, sep="\n  ")
+    failures = check_cache_damage(compiler, args.work_dir)
+    if failures:
+        failed += 1
+        print("FAIL cache damage", *failures, sep="\n  ")
+    for name, check in (("compile-many", check_compile_many), ("serve", check_serve)):
+        failures = check(compiler, args.work_dir)
+        if failures:
+            failed += 1
+            print(f"FAIL {name}", *failures, sep="\n  ")
+
+    executables = f"executables run as {target}" if target else "executables compiled but not run on this host"
+    print(f"{checked} programs checked at {', '.join(LEVELS)} ({executables}), {skipped} skipped as unsupported, "
+          f"{failed} failed")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
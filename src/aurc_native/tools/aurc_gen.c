@@ -0,0 +1,301 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * aurc-gen: synthetic inputs for scaling tests of the parser, the backends
+ * and the assembler (bench/aurc_bench.py charts compile time against their
+ * size). Output depends only on the options and --seed.
+ *
+ *   aurc-gen module  [-o out.aur]  [--functions n] [--depth d] [--statements s] [--strings k] [--shared m]
+ *   aurc-gen manifest [-o out.aurs] [--words n] [--labels l] [--strings k] [--shared m]
+ *
+ * `module` writes an Aurora module of n functions whose bodies nest d levels
+ * of if/else, for and while blocks (loops only in the outer three levels, so
+ * run time stays bounded), each level made of s statements, with k string
+ * bindings printed from their own function and m shared counters bumped by
+ * atomic.add. Every generated module compiles, terminates and prints its
+ * strings; main returns a checksum of all calls.
+ *
+ * `manifest` writes a Minimal ISA manifest straight away, for the assembler
+ * alone: n instruction words split over l labels, jumps back-patched to
+ * random labels in both directions, k strings and m shared slots. Its entry
+ * jump skips everything, so an image small enough for the VM's arena runs
+ * and exits 0.
+ */
+
+typedef struct gen_options {
+    const char *output;
+    unsigned long functions;
+    unsigned long depth;
+    unsigned long statements;
+    unsigned long strings;
+    unsigned long shared;
+    unsigned long words;
+    unsigned long labels;
+    unsigned long seed;
+} gen_options;
+
+typedef struct gen {
+    FILE *out;
+    const gen_options *options;
+    uint64_t rng;
+} gen;
+
+/* ---- helpers ------------------------------------------------------------ */
+
+static uint64_t next_random(gen *g) {
+    /* xorshift64* */
+    g->rng ^= g->rng >> 12;
+    g->rng ^= g->rng << 25;
+    g->rng ^= g->rng >> 27;
+    return g->rng * 2685821657736338717ull;
+}
+
+static unsigned random_below(gen *g, unsigned bound) {
+    return (unsigned)(next_random(g) % bound);
+}
+
+static void indent(gen *g, unsigned level) {
+    fprintf(g->out, "%*s", (int)(4 * level), "");
+}
+
+/* ---- Aurora modules ----------------------------------------------------- */
+
+static void module_statement(gen *g, unsigned level) {
+    indent(g, level);
+    switch (random_below(g, 4)) {
+        case 0:
+            fprintf(g->out, "v = (v * %u + %u) & 65535;\n", random_below(g, 7) + 2, random_below(g, 1000));
+            break;
+        case 1:
+            fprintf(g->out, "v = v ^ (x + %u);\n", random_below(g, 4096));
+            break;
+        case 2:
+            fprintf(g->out, "v = (v + (x << %u)) & 65535;\n", random_below(g, 8));
+            break;
+        default:
+            fprintf(g->out, "v = (v | %u) - (v & %u);\n", random_below(g, 256), random_below(g, 256));
+            break;
+    }
+}
+
+/* One nesting level: s statements, then a nested block while depth lasts; body at indentation level + 1. */
+static void module_block(gen *g, unsigned level, unsigned nest) {
+    for (unsigned long i = 0; i < g->options->statements; ++i) {
+        module_statement(g, level);
+    }
+    if (nest >= g->options->depth) {
+        return;
+    }
+    unsigned kind = nest < 3 ? random_below(g, 3) : 0;
+    switch (kind) {
+        case 0:
+            indent(g, level);
+            fprintf(g->out, "if v > %u {\n", random_below(g, 65536));
+            module_block(g, level + 1, nest + 1);
+            indent(g, level);
+            fprintf(g->out, "} else {\n");
+            module_statement(g, level + 1);
+            indent(g, level);
+            fprintf(g->out, "}\n");
+            break;
+        case 1:
+            indent(g, level);
+            fprintf(g->out, "for i%u in 0..%u {\n", nest, random_below(g, 3) + 2);
+            module_block(g, level + 1, nest + 1);
+            indent(g, level + 1);
+            fprintf(g->out, "v = (v + i%u) & 65535;\n", nest);
+            indent(g, level);
+            fprintf(g->out, "}\n");
+            break;
+        default:
+            indent(g, level);
+            fprintf(g->out, "let w%u: int = %u;\n", nest, random_below(g, 3) + 2);
+            indent(g, level);
+            fprintf(g->out, "while w%u > 0 {\n", nest);
+            indent(g, level + 1);
+            fprintf(g->out, "w%u = w%u - 1;\n", nest, nest);
+            module_block(g, level + 1, nest + 1);
+            indent(g, level);
+            fprintf(g->out, "}\n");
+            break;
+    }
+}
+
+static void write_module(gen *g) {
+    const gen_options *o = g->options;
+    fprintf(g->out, "// generated by aurc-gen module --functions %lu --depth %lu --statements %lu --strings %lu "
+                    "--shared %lu --seed %lu\n",
+            o->functions, o->depth, o->statements, o->strings, o->shared, o->seed);
+    fprintf(g->out, "module synthetic {\n");
+    for (unsigned long i = 0; i < o->shared; ++i) {
+        fprintf(g->out, "    shared counter_%lu: int = 0;\n", i);
+    }
+    if (o->shared) {
+        fputc('\n', g->out);
+    }
+
+    for (unsigned long f = 0; f < o->functions; ++f) {
+        fprintf(g->out, "    fn f_%lu(x: int) -> int {\n", f);
+        fprintf(g->out, "        let v: int = x + %lu;\n", f);
+        module_block(g, 2, 0);
+        if (o->shared) {
+            fprintf(g->out, "        atomic.add(counter_%lu, 1);\n", f % o->shared);
+        }
+        fprintf(g->out, "        return v & 255;\n    }\n\n");
+    }
+
+    if (o->strings) {
+        fprintf(g->out, "    fn strings() {\n");
+        for (unsigned long i = 0; i < o->strings; ++i) {
+            fprintf(g->out, "        let s_%lu: string = \"line %lu of the synthetic module\\n\";\n", i, i);
+            fprintf(g->out, "        print(s_%lu);\n", i);
+        }
+        fprintf(g->out, "    }\n\n");
+    }
+
+    fprintf(g->out, "    fn main() -> int {\n        let t: int = 0;\n");
+    for (unsigned long f = 0; f < o->functions; ++f) {
+        fprintf(g->out, "        t = (t + f_%lu(%lu)) & 1023;\n", f, f);
+    }
+    if (o->strings) {
+        fprintf(g->out, "        strings();\n");
+    }
+    for (unsigned long i = 0; i < o->shared; ++i) {
+        fprintf(g->out, "        t = (t + atomic.load(counter_%lu)) & 1023;\n", i);
+    }
+    fprintf(g->out, "        return t & 127;\n    }\n}\n");
+}
+
+/* ---- manifests ---------------------------------------------------------- */
+
+static void write_manifest(gen *g) {
+    const gen_options *o = g->options;
+    unsigned long labels = o->labels ? o->labels : 1;
+    fprintf(g->out, "# generated by aurc-gen manifest --words %lu --labels %lu --strings %lu --shared %lu --seed %lu\n",
+            o->words, labels, o->strings, o->shared, o->seed);
+    fprintf(g->out, "header minimal_isa\norg 0x0000\n");
+    for (unsigned long i = 0; i < o->shared; ++i) {
+        fprintf(g->out, "shared %lu slot_%lu %lu\n", i, i, i);
+    }
+    fprintf(g->out, "bytes 0x07FE000000000000  ; jmp gen_end\n");
+
+    unsigned long per_label = o->words / labels;
+    unsigned long extra = o->words % labels;
+    for (unsigned long l = 0; l < labels; ++l) {
+        fprintf(g->out, "label block_%lu\n", l);
+        unsigned long count = per_label + (l < extra);
+        for (unsigned long w = 0; w < count; ++w) {
+            unsigned r = random_below(g, 8);
+            unsigned dst = 1 + random_below(g, 7);
+            unsigned src = 1 + random_below(g, 7);
+            if (r == 0) {
+                fprintf(g->out, "bytes 0x07FE000000000000  ; jmp block_%u\n", random_below(g, (unsigned)labels));
+            } else if (r == 1 && o->strings) {
+                fprintf(g->out, "bytes 0x01%02XFE0000000000  ; mov r%u, #addr(text_%u)\n", dst, dst,
+                        random_below(g, (unsigned)o->strings));
+            } else if (r == 2 && o->shared) {
+                unsigned slot = random_below(g, (unsigned)o->shared);
+                fprintf(g->out, "bytes 0x3400%02X0000000000  ; atomic_add shared[%u], r%u ; slot_%u\n", src, slot, src,
+                        slot);
+            } else if (r < 5) {
+                unsigned imm = random_below(g, 100000);
+                fprintf(g->out, "bytes 0x01%02XFF00%08X  ; mov r%u, #%u\n", dst, imm, dst, imm);
+            } else {
+                fprintf(g->out, "bytes 0x04%02X%02X%02X00000000  ; add r%u, r%u, r%u\n", dst, dst, src, dst, dst, src);
+            }
+        }
+    }
+    for (unsigned long i = 0; i < o->strings; ++i) {
+        fprintf(g->out, "label text_%lu\nstring \"generated string %lu\\n\"\n", i, i);
+    }
+    fprintf(g->out, "label gen_end\nbytes 0x0C00000000000000  ; halt\n");
+}
+
+/* ---- driver ------------------------------------------------------------- */
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s module [-o out.aur] [--functions n] [--depth d] [--statements s] [--strings k] "
+                    "[--shared m] [--seed x]\n", program);
+    fprintf(stderr, "       %s manifest [-o out.aurs] [--words n] [--labels l] [--strings k] [--shared m] "
+                    "[--seed x]\n", program);
+}
+
+static int parse_count(const char *flag, const char *text, unsigned long max, unsigned long *out) {
+    char *end = NULL;
+    errno = 0;
+    unsigned long value = text ? strtoul(text, &end, 10) : 0;
+    if (!text || *text == '\0' || *end != '\0' || errno != 0 || value > max) {
+        fprintf(stderr, "%s expects a count between 0 and %lu\n", flag, max);
+        return 1;
+    }
+    *out = value;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || (strcmp(argv[1], "module") != 0 && strcmp(argv[1], "manifest") != 0)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    int manifest = strcmp(argv[1], "manifest") == 0;
+    gen_options options = {NULL, 100, 3, 2, 16, 4, 100000, 1000, 1};
+    struct {
+        const char *flag;
+        unsigned long *slot;
+        unsigned long max;
+    } const flags[] = {
+        {"--functions", &options.functions, 10000000},
+        {"--depth", &options.depth, 10000},
+        {"--statements", &options.statements, 10000},
+        {"--strings", &options.strings, 10000000},
+        {"--shared", &options.shared, 100000},
+        {"--words", &options.words, 100000000},
+        {"--labels", &options.labels, 10000000},
+        {"--seed", &options.seed, ~0ul},
+    };
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            options.output = argv[++i];
+            continue;
+        }
+        size_t f = 0;
+        while (f < sizeof flags / sizeof flags[0] && strcmp(argv[i], flags[f].flag) != 0) {
+            ++f;
+        }
+        if (f == sizeof flags / sizeof flags[0]) {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (parse_count(argv[i], i + 1 < argc ? argv[i + 1] : NULL, flags[f].max, flags[f].slot) != 0) {
+            return EXIT_FAILURE;
+        }
+        ++i;
+    }
+
+    FILE *out = options.output ? fopen(options.output, "w") : stdout;
+    if (!out) {
+        perror("aurc-gen: fopen output");
+        return EXIT_FAILURE;
+    }
+    gen g = {out, &options, (uint64_t)options.seed * 0x9E3779B97F4A7C15ull + 1};
+    if (manifest) {
+        write_manifest(&g);
+    } else {
+        write_module(&g);
+    }
+    int failed = ferror(out);
+    if (options.output && fclose(out) != 0) {
+        failed = 1;
+    }
+    if (failed) {
+        perror("aurc-gen: write output");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}